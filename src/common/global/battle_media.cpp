@@ -110,7 +110,7 @@ void BattleMedia::Update()
 
 void BattleMedia::SetBackgroundImage(const std::string& filename)
 {
-    if(background_image.Load(filename) == false) {
+    if(background_image.LoadAsync(filename) == false) {
         PRINT_WARNING << "Failed to load background image: " << filename << std::endl;
     }
 }
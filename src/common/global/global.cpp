@@ -767,7 +767,7 @@ void GameGlobal::SetMap(const std::string &map_data_filename,
     _map_data_filename = map_data_filename;
     _map_script_filename = map_script_filename;
 
-    if(!_map_image.Load(map_image_filename))
+    if(!_map_image.LoadAsync(map_image_filename))
         IF_PRINT_WARNING(GLOBAL_DEBUG) << "failed to load map image: " << map_image_filename << std::endl;
 
     // Updates the map hud names info.
@@ -416,7 +416,7 @@ public:
         _viewable_world_locations.clear();
         _current_world_location_id.clear();
         _world_map_image = new vt_video::StillImage();
-        _world_map_image->Load(world_map_filename);
+        _world_map_image->LoadAsync(world_map_filename);
     }
 
     /** \brief Sets the current location id
@@ -1301,6 +1301,8 @@ bool GameOptionsMenuHandler::_SaveSettingsFile(const std::string& filename)
     settings_lua.WriteBool("full_screen", VideoManager->IsFullscreen());
     settings_lua.WriteComment("Get the desired VSync mode. 0: No VSync, 1: VSync, 2: Swap Tearing");
     settings_lua.WriteUInt("vsync_mode", VideoManager->GetVSyncMode());
+    settings_lua.WriteComment("The video memory the textures may use, in MiB. 0: No limit");
+    settings_lua.WriteUInt("texture_memory_budget", VideoManager->GetTextureMemoryBudget());
     settings_lua.WriteComment("The UI Theme to load.");
     settings_lua.WriteString("ui_theme", GUIManager->GetDefaultMenuSkinId());
     settings_lua.EndTable(); // video_settings
@@ -81,6 +81,8 @@ InputEngine::InputEngine()
     _quit_press           = false;
     _help_press           = false;
 
+    _low_memory           = false;
+
     // Fill the _key struct with 0 values.
     memset(&_key, 0, sizeof(_key));
 
@@ -258,6 +260,8 @@ void InputEngine::EventHandler()
     _help_press           = false;
     _help_release         = false;
 
+    _low_memory           = false;
+
     // NOTE: We don't reinit the D-Pad/hat values on purpose here.
 
     // Loops until there are no remaining events to process
@@ -266,6 +270,8 @@ void InputEngine::EventHandler()
         if(event.type == SDL_QUIT) {
             _quit_press = true;
             break;
+        } else if(event.type == SDL_APP_LOWMEMORY) {
+            _low_memory = true;
         } else if(event.type == SDL_KEYUP || event.type == SDL_KEYDOWN) {
             _KeyEventHandler(event.key);
         } else {
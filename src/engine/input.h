@@ -251,6 +251,9 @@ private:
     bool _hat_right_state;
     //@}
 
+    //! \brief Whether the operating system just reported that it is running low on memory.
+    bool _low_memory;
+
     /** \brief Most recent SDL event
      **/
     SDL_Event _event;
@@ -729,6 +732,12 @@ public:
     }
     //@}
 
+    //! \brief Tells whether the operating system just reported that it is running low on memory,
+    //! in which case the caches should be freed.
+    bool LowMemory() const {
+        return _low_memory;
+    }
+
     //! \brief Returns the most recent event retrieved from SDL
     const SDL_Event &GetMostRecentEvent() const {
         return _event;
@@ -22,6 +22,7 @@
 
 #include "utils/utils_strings.h"
 #include "utils/utils_files.h"
+#include "utils/exception.h"
 
 #include "common/app_name.h"
 #include "common/app_settings.h"
@@ -29,6 +30,10 @@
 
 #include "mode_manager.h"
 
+#include <SDL2/SDL_cpuinfo.h>
+
+#include <algorithm>
+
 // Gettext
 #ifndef DISABLE_TRANSLATIONS
 #include <libintl.h>
@@ -332,6 +337,181 @@ void SystemTimer::_UpdateTimer(uint32_t time)
     }
 }
 
+// -----------------------------------------------------------------------------
+// WorkerPool Class
+// -----------------------------------------------------------------------------
+
+WorkerPool::WorkerPool() :
+    _mutex(SDL_CreateMutex()),
+    _job_queued_condition(SDL_CreateCond()),
+    _job_done_condition(SDL_CreateCond()),
+    _quit(false)
+{
+    if(!_mutex || !_job_queued_condition || !_job_done_condition) {
+        PRINT_WARNING << "Couldn't create the worker threads lock: " << SDL_GetError() << std::endl;
+        return;
+    }
+
+    // Keep a core for the main thread.
+    int32_t num_threads = std::min(SDL_GetCPUCount() - 1, static_cast<int32_t>(SYSTEM_MAX_WORKER_THREADS));
+    num_threads = std::max(num_threads, 1);
+
+    for(int32_t i = 0; i < num_threads; ++i) {
+        SDL_Thread* thread = SDL_CreateThread(_RunWorker, "worker", this);
+        if(!thread) {
+            PRINT_WARNING << "Couldn't start a worker thread: " << SDL_GetError() << std::endl;
+            break;
+        }
+        _threads.push_back(thread);
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    if(!_threads.empty()) {
+        SDL_LockMutex(_mutex);
+        _quit = true;
+        SDL_CondBroadcast(_job_queued_condition);
+        SDL_UnlockMutex(_mutex);
+
+        for(uint32_t i = 0; i < _threads.size(); ++i)
+            SDL_WaitThread(_threads[i], nullptr);
+    }
+
+    for(uint32_t i = 0; i < _pending_jobs.size(); ++i)
+        delete _pending_jobs[i];
+    for(uint32_t i = 0; i < _done_jobs.size(); ++i)
+        delete _done_jobs[i];
+
+    if(_job_done_condition)
+        SDL_DestroyCond(_job_done_condition);
+    if(_job_queued_condition)
+        SDL_DestroyCond(_job_queued_condition);
+    if(_mutex)
+        SDL_DestroyMutex(_mutex);
+}
+
+void WorkerPool::QueueJob(const void* owner, WorkerJob* job, bool urgent)
+{
+    job->_owner = owner;
+
+    // Without worker threads, the job is run right away.
+    if(_threads.empty()) {
+        job->Run();
+        _done_jobs.push_back(job);
+        return;
+    }
+
+    SDL_LockMutex(_mutex);
+    if(urgent)
+        _pending_jobs.push_front(job);
+    else
+        _pending_jobs.push_back(job);
+    SDL_CondSignal(_job_queued_condition);
+    SDL_UnlockMutex(_mutex);
+}
+
+void WorkerPool::TakeDoneJobs(const void* owner, std::vector<WorkerJob*>& jobs)
+{
+    if(!_threads.empty())
+        SDL_LockMutex(_mutex);
+
+    std::vector<WorkerJob*>::iterator it = _done_jobs.begin();
+    while(it != _done_jobs.end()) {
+        if((*it)->_owner == owner) {
+            jobs.push_back(*it);
+            it = _done_jobs.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    if(!_threads.empty())
+        SDL_UnlockMutex(_mutex);
+}
+
+void WorkerPool::CancelJobs(const void* owner)
+{
+    if(_threads.empty())
+        return;
+
+    SDL_LockMutex(_mutex);
+    std::deque<WorkerJob*>::iterator it = _pending_jobs.begin();
+    while(it != _pending_jobs.end()) {
+        if((*it)->_owner == owner) {
+            delete *it;
+            it = _pending_jobs.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    SDL_UnlockMutex(_mutex);
+}
+
+void WorkerPool::RemoveJobs(const void* owner)
+{
+    CancelJobs(owner);
+
+    if(!_threads.empty()) {
+        SDL_LockMutex(_mutex);
+        bool running = true;
+        while(running) {
+            running = false;
+            for(uint32_t i = 0; i < _running_jobs.size(); ++i) {
+                if(_running_jobs[i]->_owner == owner)
+                    running = true;
+            }
+            if(running)
+                SDL_CondWait(_job_done_condition, _mutex);
+        }
+        SDL_UnlockMutex(_mutex);
+    }
+
+    std::vector<WorkerJob*> jobs;
+    TakeDoneJobs(owner, jobs);
+    for(uint32_t i = 0; i < jobs.size(); ++i)
+        delete jobs[i];
+}
+
+int WorkerPool::_RunWorker(void* pool)
+{
+    WorkerPool* self = static_cast<WorkerPool*>(pool);
+
+    SDL_LockMutex(self->_mutex);
+    while(!self->_quit) {
+        if(self->_pending_jobs.empty()) {
+            SDL_CondWait(self->_job_queued_condition, self->_mutex);
+            continue;
+        }
+
+        WorkerJob* job = self->_pending_jobs.front();
+        self->_pending_jobs.pop_front();
+        self->_running_jobs.push_back(job);
+
+        // Run the job without holding the lock, so that the other threads are never blocked by it.
+        SDL_UnlockMutex(self->_mutex);
+        job->Run();
+        SDL_LockMutex(self->_mutex);
+
+        self->_running_jobs.erase(std::find(self->_running_jobs.begin(), self->_running_jobs.end(), job));
+        self->_done_jobs.push_back(job);
+        SDL_CondBroadcast(self->_job_done_condition);
+    }
+    SDL_UnlockMutex(self->_mutex);
+    return 0;
+}
+
+WorkerPool::WorkerPool(const WorkerPool&)
+{
+    throw Exception("Not Implemented!", __FILE__, __LINE__, __FUNCTION__);
+}
+
+WorkerPool& WorkerPool::operator=(const WorkerPool&)
+{
+    throw Exception("Not Implemented!", __FILE__, __LINE__, __FUNCTION__);
+    return *this;
+}
+
 // -----------------------------------------------------------------------------
 // SystemEngine Class
 // -----------------------------------------------------------------------------
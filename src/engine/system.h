@@ -28,8 +28,13 @@
 #include "utils/ustring.h"
 #include "utils/singleton.h"
 
+#include <SDL2/SDL_thread.h>
+#include <SDL2/SDL_mutex.h>
+
+#include <deque>
 #include <set>
 #include <map>
+#include <vector>
 
 namespace vt_mode_manager {
 class GameMode;
@@ -69,6 +74,9 @@ const int32_t SYSTEM_TIMER_NO_LOOPS = 0;
 **/
 const int32_t SYSTEM_TIMER_INFINITE_LOOP = -1;
 
+//! \brief The maximum number of worker threads shared by the engine components.
+const uint32_t SYSTEM_MAX_WORKER_THREADS = 4;
+
 //! \brief All of the possible states which a SystemTimer classs object may be in
 enum SYSTEM_TIMER_STATE {
     SYSTEM_TIMER_INVALID  = -1,
@@ -419,6 +427,91 @@ protected:
 }; // class SystemTimer
 
 
+/** ****************************************************************************
+*** \brief A unit of work run by the worker pool.
+***
+*** The derived classes hold the job input and its result, as the job is
+*** given back to its owner once run.
+*** ***************************************************************************/
+class WorkerJob
+{
+    friend class WorkerPool;
+
+public:
+    WorkerJob() :
+        _owner(nullptr)
+    {}
+
+    virtual ~WorkerJob()
+    {}
+
+    //! \brief Does the work, on a worker thread. It must not use Lua nor OpenGL.
+    virtual void Run() = 0;
+
+private:
+    //! \brief The object the job is given back to.
+    const void* _owner;
+};
+
+/** ****************************************************************************
+*** \brief Runs jobs on a pool of worker threads shared by the engine components.
+***
+*** Each job is given back to the object which queued it, so that several
+*** components can share the threads. Every method must be called from the main
+*** thread. When no worker thread could be started, the jobs are run when queued.
+*** ***************************************************************************/
+class WorkerPool
+{
+public:
+    WorkerPool();
+
+    ~WorkerPool();
+
+    /** \brief Queues a job, which is owned by the pool until taken back.
+    *** \param owner The object to give the job back to.
+    *** \param urgent Whether the job should be run before the other pending ones.
+    **/
+    void QueueJob(const void* owner, WorkerJob* job, bool urgent = false);
+
+    //! \brief Takes the jobs of the owner which are done. The caller must delete them.
+    void TakeDoneJobs(const void* owner, std::vector<WorkerJob*>& jobs);
+
+    //! \brief Deletes the pending jobs of the owner. The running ones will still be given back.
+    void CancelJobs(const void* owner);
+
+    //! \brief Deletes every job of the owner, waiting for the running ones. Used before deleting the owner.
+    void RemoveJobs(const void* owner);
+
+    uint32_t GetNumThreads() const {
+        return _threads.size();
+    }
+
+private:
+    //! \brief The copy constructor and assignment operator are hidden by design
+    //! to cause compilation errors when attempting to copy or assign this class.
+    WorkerPool(const WorkerPool& pool);
+    WorkerPool& operator=(const WorkerPool& pool);
+
+    //! \brief The worker threads, and the lock guarding the job queues.
+    std::vector<SDL_Thread*> _threads;
+    SDL_mutex* _mutex;
+
+    //! \brief Signaled when a job is queued, and when one is done.
+    SDL_cond* _job_queued_condition;
+    SDL_cond* _job_done_condition;
+
+    //! \brief Tells the worker threads to stop. Guarded by _mutex.
+    bool _quit;
+
+    //! \brief The jobs waiting for a worker thread, being run, and done. Guarded by _mutex.
+    std::deque<WorkerJob*> _pending_jobs;
+    std::vector<WorkerJob*> _running_jobs;
+    std::vector<WorkerJob*> _done_jobs;
+
+    //! \brief The worker threads main function.
+    static int _RunWorker(void* pool);
+};
+
 /** ****************************************************************************
 *** \brief Engine class that manages system information and functions
 ***
@@ -613,6 +706,11 @@ public:
             _game_save_slots = 10;
     }
 
+    //! \brief Gives the worker threads the engine components can run their jobs on.
+    WorkerPool* GetWorkerPool() {
+        return &_worker_pool;
+    }
+
 private:
     SystemEngine();
 
@@ -664,6 +762,9 @@ private:
     *** The timers in this container are updated on each call to UpdateTimers().
     **/
     std::set<SystemTimer *> _auto_system_timers;
+
+    //! \brief The worker threads shared by the engine components.
+    WorkerPool _worker_pool;
 }; // class SystemEngine : public vt_utils::Singleton<SystemEngine>
 
 } // namepsace vt_system
@@ -315,6 +315,7 @@ void ParticleSystem::Draw(float* vertex_positions,
                      vertex_positions,
                      GL_DYNAMIC_DRAW);
 
+#ifdef DEBUG_GL_ERRORS
         GLenum error = glGetError();
         if (error != GL_NO_ERROR) {
             errors = true;
@@ -324,6 +325,7 @@ void ParticleSystem::Draw(float* vertex_positions,
                            std::endl;
             assert(error == GL_NO_ERROR);
         }
+#endif
     }
 
     // Bind the vertex texture coordinate buffer.
@@ -338,6 +340,7 @@ void ParticleSystem::Draw(float* vertex_positions,
                      vertex_texture_coordinates,
                      GL_DYNAMIC_DRAW);
 
+#ifdef DEBUG_GL_ERRORS
         GLenum error = glGetError();
         if (error != GL_NO_ERROR) {
             errors = true;
@@ -347,6 +350,7 @@ void ParticleSystem::Draw(float* vertex_positions,
                            std::endl;
             assert(error == GL_NO_ERROR);
         }
+#endif
     }
 
     // Bind the vertex color buffer.
@@ -361,6 +365,7 @@ void ParticleSystem::Draw(float* vertex_positions,
                      vertex_colors,
                      GL_DYNAMIC_DRAW);
 
+#ifdef DEBUG_GL_ERRORS
         GLenum error = glGetError();
         if (error != GL_NO_ERROR) {
             errors = true;
@@ -370,6 +375,7 @@ void ParticleSystem::Draw(float* vertex_positions,
                            std::endl;
             assert(error == GL_NO_ERROR);
         }
+#endif
     }
 
     // Create the index buffer's data.
@@ -412,6 +418,7 @@ void ParticleSystem::Draw(float* vertex_positions,
                      GL_DYNAMIC_DRAW);
         _number_of_indices = indices.size();
 
+#ifdef DEBUG_GL_ERRORS
         GLenum error = glGetError();
         if (error != GL_NO_ERROR) {
             errors = true;
@@ -421,6 +428,7 @@ void ParticleSystem::Draw(float* vertex_positions,
                            std::endl;
             assert(error == GL_NO_ERROR);
         }
+#endif
     }
 
     // Unbind the buffers from the pipeline.
@@ -122,7 +122,6 @@ namespace shader_definitions
         "}\n";
 
     const char SPRITE_GRAYSCALE_FRAGMENT[] =
-        "\n"
         "#version 110\n"
         "\n"
         "//\n"
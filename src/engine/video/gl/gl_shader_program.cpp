@@ -127,9 +127,11 @@ ShaderProgram::ShaderProgram(const Shader* vertex_shader,
     GLint is_linked = -1;
     glGetProgramiv(_program, GL_LINK_STATUS, &is_linked);
 
-    // Return if linkage went well
-    if (is_linked != 0)
+    // Retrieve the uniform locations once and return if linkage went well.
+    if (is_linked != 0) {
+        _ResolveUniformLocations();
         return;
+    }
 
     // Retrieve the linker output.
     GLint length = 0;
@@ -168,6 +170,7 @@ bool ShaderProgram::Load()
 
     glUseProgram(_program);
 
+#ifdef DEBUG_GL_ERRORS
     GLenum error = glGetError();
     if (error != GL_NO_ERROR) {
         result = false;
@@ -176,6 +179,7 @@ bool ShaderProgram::Load()
                        std::endl;
         assert(error == GL_NO_ERROR);
     }
+#endif
 
     return result;
 }
@@ -184,9 +188,13 @@ bool ShaderProgram::UpdateUniform(const std::string& uniform, float value)
 {
     bool result = true;
 
-    GLint location = glGetUniformLocation(_program, uniform.c_str());
+    GLint location = -1;
+    if (!_StoreUniformValue(uniform, &value, 1, location))
+        return result;
+
     glUniform1f(location, value);
 
+#ifdef DEBUG_GL_ERRORS
     GLenum error = glGetError();
     if (error != GL_NO_ERROR) {
         result = false;
@@ -195,6 +203,7 @@ bool ShaderProgram::UpdateUniform(const std::string& uniform, float value)
                        std::endl;
         assert(error == GL_NO_ERROR);
     }
+#endif
 
     return result;
 }
@@ -203,9 +212,17 @@ bool ShaderProgram::UpdateUniform(const std::string& uniform, int32_t value)
 {
     bool result = true;
 
-    GLint location = glGetUniformLocation(_program, uniform.c_str());
+    // The integer is stored bitwise in the float value copy.
+    float stored_value = 0.0f;
+    memcpy(&stored_value, &value, sizeof(stored_value));
+
+    GLint location = -1;
+    if (!_StoreUniformValue(uniform, &stored_value, 1, location))
+        return result;
+
     glUniform1i(location, value);
 
+#ifdef DEBUG_GL_ERRORS
     GLenum error = glGetError();
     if (error != GL_NO_ERROR) {
         result = false;
@@ -214,6 +231,7 @@ bool ShaderProgram::UpdateUniform(const std::string& uniform, int32_t value)
                        std::endl;
         assert(error == GL_NO_ERROR);
     }
+#endif
 
     return result;
 }
@@ -222,25 +240,27 @@ bool ShaderProgram::UpdateUniform(const std::string& uniform, const float* data,
 {
     bool result = false;
 
-    GLint location = glGetUniformLocation(_program, uniform.c_str());
-
     // This function currently only supports matrices and vectors.
     assert(data != nullptr && (length == 4 || length == 16));
-    if (data != nullptr) {
-        if (length == 4) {
-            result = true;
+    if (data == nullptr || (length != 4 && length != 16))
+        return result;
 
-            // The vector case.
-            glUniform4f(location, data[0], data[1], data[2], data[3]);
-        }
-        else if (length == 16) {
-            result = true;
+    result = true;
 
-            // The matrix case.
-            glUniformMatrix4fv(location, 1, true, data);
-        }
+    GLint location = -1;
+    if (!_StoreUniformValue(uniform, data, length, location))
+        return result;
+
+    if (length == 4) {
+        // The vector case.
+        glUniform4f(location, data[0], data[1], data[2], data[3]);
+    }
+    else {
+        // The matrix case.
+        glUniformMatrix4fv(location, 1, true, data);
     }
 
+#ifdef DEBUG_GL_ERRORS
     GLenum error = glGetError();
     if (error != GL_NO_ERROR) {
         result = false;
@@ -249,10 +269,61 @@ bool ShaderProgram::UpdateUniform(const std::string& uniform, const float* data,
                        std::endl;
         assert(error == GL_NO_ERROR);
     }
+#endif
 
     return result;
 }
 
+void ShaderProgram::_ResolveUniformLocations()
+{
+    _uniforms.clear();
+
+    GLint number_of_uniforms = 0;
+    glGetProgramiv(_program, GL_ACTIVE_UNIFORMS, &number_of_uniforms);
+
+    GLint max_length = 0;
+    glGetProgramiv(_program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+    if (number_of_uniforms <= 0 || max_length <= 0)
+        return;
+
+    std::vector<GLchar> name(max_length, 0);
+    for (GLint i = 0; i < number_of_uniforms; ++i) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(_program, static_cast<GLuint>(i), max_length, &length, &size, &type, &name[0]);
+
+        std::string uniform_name(&name[0], length);
+
+        // Array uniforms are reported with a trailing "[0]".
+        size_t bracket = uniform_name.find('[');
+        if (bracket != std::string::npos)
+            uniform_name.resize(bracket);
+
+        Uniform& uniform = _uniforms[uniform_name];
+        uniform.location = glGetUniformLocation(_program, uniform_name.c_str());
+    }
+}
+
+bool ShaderProgram::_StoreUniformValue(const std::string& uniform, const float* data, uint32_t length, GLint& location)
+{
+    std::map<std::string, Uniform>::iterator it = _uniforms.find(uniform);
+
+    // Inactive uniforms are silently ignored, as OpenGL does for the -1 location.
+    if (it == _uniforms.end() || it->second.location < 0)
+        return false;
+
+    Uniform& stored_uniform = it->second;
+    location = stored_uniform.location;
+
+    if (stored_uniform.value.size() == length &&
+            memcmp(&stored_uniform.value[0], data, length * sizeof(float)) == 0)
+        return false;
+
+    stored_uniform.value.assign(data, data + length);
+    return true;
+}
+
 ShaderProgram::ShaderProgram(const ShaderProgram&)
 {
     throw vt_utils::Exception("Not Implemented!",
@@ -18,6 +18,7 @@
 
 #include "utils/gl_include.h"
 
+#include <map>
 #include <vector>
 #include <string>
 
@@ -40,16 +41,45 @@ public:
 
     bool Load();
 
+    /** \brief Updates a uniform of the program, which must be the currently loaded one.
+    *** The value is only sent to OpenGL when it differs from the last uploaded one.
+    *** Updating a uniform that isn't active in the program does nothing.
+    **/
     bool UpdateUniform(const std::string& uniform, float value);
     bool UpdateUniform(const std::string& uniform, int32_t value);
     bool UpdateUniform(const std::string& uniform, const float* data, uint32_t length);
 
 private:
+    //! \brief An active uniform of the program.
+    struct Uniform {
+        Uniform():
+            location(-1)
+        {}
+
+        //! \brief The uniform location, resolved once after linking.
+        GLint location;
+
+        //! \brief A copy of the last uploaded value. Empty until the first upload.
+        std::vector<float> value;
+    };
+
     GLuint _program;
 
     const Shader* _vertex_shader;
     const Shader* _fragment_shader;
 
+    //! \brief The active uniforms, indexed by name.
+    std::map<std::string, Uniform> _uniforms;
+
+    //! \brief Retrieves the locations of every active uniforms of the linked program.
+    void _ResolveUniformLocations();
+
+    /** \brief Tells whether the given value differs from the last uploaded one,
+    *** and stores it in that case.
+    *** \return false if the uniform isn't active or if the value is unchanged.
+    **/
+    bool _StoreUniformValue(const std::string& uniform, const float* data, uint32_t length, GLint& location);
+
     //! \brief The copy constructor and assignment operator are hidden by design
     //! to cause compilation errors when attempting to copy or assign this class.
     ShaderProgram(const ShaderProgram& shader_program);
@@ -349,6 +349,7 @@ void Sprite::Draw(float* vertex_positions,
     // Update the vertex position data.
     glBufferSubData(GL_ARRAY_BUFFER, 0, VERTICES_PER_SPRITE * POSITIONS_PER_VERTEX * sizeof(float), vertex_positions);
 
+#ifdef DEBUG_GL_ERRORS
     GLenum error = glGetError();
     if (error != GL_NO_ERROR) {
         errors = true;
@@ -358,6 +359,7 @@ void Sprite::Draw(float* vertex_positions,
                         std::endl;
         assert(error == GL_NO_ERROR);
     }
+#endif
 
     // Bind the vertex texture coordinate buffer.
     if (!errors) {
@@ -368,6 +370,7 @@ void Sprite::Draw(float* vertex_positions,
     if (!errors) {
         glBufferSubData(GL_ARRAY_BUFFER, 0, VERTICES_PER_SPRITE * TEXTURE_COORDINATES_PER_VERTEX * sizeof(float), vertex_texture_coordinates);
 
+#ifdef DEBUG_GL_ERRORS
         GLenum error = glGetError();
         if (error != GL_NO_ERROR) {
             errors = true;
@@ -377,6 +380,7 @@ void Sprite::Draw(float* vertex_positions,
                            std::endl;
             assert(error == GL_NO_ERROR);
         }
+#endif
     }
 
     // Bind the vertex color buffer.
@@ -388,6 +392,7 @@ void Sprite::Draw(float* vertex_positions,
     if (!errors) {
         glBufferSubData(GL_ARRAY_BUFFER, 0, VERTICES_PER_SPRITE * COLORS_PER_VERTEX * sizeof(float), vertex_colors);
 
+#ifdef DEBUG_GL_ERRORS
         GLenum error = glGetError();
         if (error != GL_NO_ERROR) {
             errors = true;
@@ -397,6 +402,7 @@ void Sprite::Draw(float* vertex_positions,
                            std::endl;
             assert(error == GL_NO_ERROR);
         }
+#endif
     }
 
     // Unbind the buffers from the pipeline.
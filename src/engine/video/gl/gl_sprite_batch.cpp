@@ -0,0 +1,286 @@
+////////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2016 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+////////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    gl_sprite_batch.cpp
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Source file for the sprite batch buffers.
+*** ***************************************************************************/
+
+#include "gl_sprite_batch.h"
+
+#include "utils/utils_common.h"
+#include "utils/exception.h"
+#include "utils/utils_strings.h"
+
+#include <cassert>
+#include <cstring>
+
+#ifdef __APPLE__
+#   define glBindVertexArray    glBindVertexArrayAPPLE
+#   define glGenVertexArrays    glGenVertexArraysAPPLE
+#   define glDeleteVertexArrays glDeleteVertexArraysAPPLE
+#endif
+
+namespace vt_video
+{
+namespace gl
+{
+
+//! \brief constants.
+const unsigned BATCH_VERTICES_PER_QUAD = 4;
+const unsigned BATCH_INDICES_PER_QUAD = 6;
+const unsigned BATCH_POSITIONS_PER_VERTEX = 3;
+const unsigned BATCH_TEXTURE_COORDINATES_PER_VERTEX = 2;
+const unsigned BATCH_COLORS_PER_VERTEX = 4;
+
+SpriteBatch::SpriteBatch(unsigned capacity) :
+    _capacity(capacity),
+    _number_of_quads(0),
+    _vao(0),
+    _vertex_position_buffer(0),
+    _vertex_texture_coordinate_buffer(0),
+    _vertex_color_buffer(0),
+    _index_buffer(0)
+{
+    bool errors = false;
+
+    assert(_capacity > 0);
+
+    _vertex_positions.resize(_capacity * BATCH_VERTICES_PER_QUAD * BATCH_POSITIONS_PER_VERTEX);
+    _vertex_texture_coordinates.resize(_capacity * BATCH_VERTICES_PER_QUAD * BATCH_TEXTURE_COORDINATES_PER_VERTEX);
+    _vertex_colors.resize(_capacity * BATCH_VERTICES_PER_QUAD * BATCH_COLORS_PER_VERTEX);
+
+    // The index data never changes, so it is computed once for the whole capacity.
+    std::vector<unsigned> indices;
+    indices.reserve(_capacity * BATCH_INDICES_PER_QUAD);
+    for (unsigned i = 0; i < _capacity; ++i) {
+        unsigned index = i * BATCH_VERTICES_PER_QUAD;
+
+        // Triangle one.
+        indices.push_back(index + 0);
+        indices.push_back(index + 1);
+        indices.push_back(index + 2);
+
+        // Triangle two.
+        indices.push_back(index + 0);
+        indices.push_back(index + 2);
+        indices.push_back(index + 3);
+    }
+
+    // Create the vertex array object.
+    if (!errors) {
+        GLuint arrays[1] = { 0 };
+        glGenVertexArrays(1, arrays);
+
+        GLenum error = glGetError();
+        if (error != GL_NO_ERROR) {
+            errors = true;
+            PRINT_ERROR << "Failed to create the vertex array object." << std::endl;
+            assert(error == GL_NO_ERROR);
+        } else {
+            // Store the result.
+            _vao = arrays[0];
+        }
+    }
+
+    // Bind the vertex array object.
+    if (!errors) {
+        glBindVertexArray(_vao);
+    }
+
+    // Create the vertex buffer objects.
+    if (!errors) {
+        GLuint buffers[4] = { 0 };
+        glGenBuffers(4, buffers);
+
+        GLenum error = glGetError();
+        if (error != GL_NO_ERROR) {
+            errors = true;
+            PRINT_ERROR << "Failed to create the vertex array object's position, texture coordinate, color, and index buffers. VAO ID: " <<
+                           vt_utils::NumberToString(_vao) <<
+                           std::endl;
+            assert(error == GL_NO_ERROR);
+        } else {
+            // Store the results.
+            _vertex_position_buffer = buffers[0];
+            _vertex_texture_coordinate_buffer = buffers[1];
+            _vertex_color_buffer = buffers[2];
+            _index_buffer = buffers[3];
+        }
+    }
+
+    // Set up the vertex position data in slot 0.
+    if (!errors) {
+        glBindBuffer(GL_ARRAY_BUFFER, _vertex_position_buffer);
+        glBufferData(GL_ARRAY_BUFFER, _vertex_positions.size() * sizeof(float), nullptr, GL_STREAM_DRAW);
+        glVertexAttribPointer(0, BATCH_POSITIONS_PER_VERTEX, GL_FLOAT, false, 0, nullptr);
+        glEnableVertexAttribArray(0);
+
+        GLenum error = glGetError();
+        if (error != GL_NO_ERROR) {
+            errors = true;
+            PRINT_ERROR << "Failed to set up the vertex position buffer. VAO ID: " <<
+                           vt_utils::NumberToString(_vao) << " Buffer ID: " <<
+                           vt_utils::NumberToString(_vertex_position_buffer) <<
+                           std::endl;
+            assert(error == GL_NO_ERROR);
+        }
+    }
+
+    // Set up the vertex texture coordinate data in slot 1.
+    if (!errors) {
+        glBindBuffer(GL_ARRAY_BUFFER, _vertex_texture_coordinate_buffer);
+        glBufferData(GL_ARRAY_BUFFER, _vertex_texture_coordinates.size() * sizeof(float), nullptr, GL_STREAM_DRAW);
+        glVertexAttribPointer(1, BATCH_TEXTURE_COORDINATES_PER_VERTEX, GL_FLOAT, false, 0, nullptr);
+        glEnableVertexAttribArray(1);
+
+        GLenum error = glGetError();
+        if (error != GL_NO_ERROR) {
+            errors = true;
+            PRINT_ERROR << "Failed to set up the vertex texture coordinate buffer. VAO ID: " <<
+                           vt_utils::NumberToString(_vao) << " Buffer ID: " <<
+                           vt_utils::NumberToString(_vertex_texture_coordinate_buffer) <<
+                           std::endl;
+            assert(error == GL_NO_ERROR);
+        }
+    }
+
+    // Set up the vertex color data in slot 2.
+    if (!errors) {
+        glBindBuffer(GL_ARRAY_BUFFER, _vertex_color_buffer);
+        glBufferData(GL_ARRAY_BUFFER, _vertex_colors.size() * sizeof(float), nullptr, GL_STREAM_DRAW);
+        glVertexAttribPointer(2, BATCH_COLORS_PER_VERTEX, GL_FLOAT, false, 0, nullptr);
+        glEnableVertexAttribArray(2);
+
+        GLenum error = glGetError();
+        if (error != GL_NO_ERROR) {
+            errors = true;
+            PRINT_ERROR << "Failed to set up the vertex color buffer. VAO ID: " <<
+                           vt_utils::NumberToString(_vao) << " Buffer ID: " <<
+                           vt_utils::NumberToString(_vertex_color_buffer) <<
+                           std::endl;
+            assert(error == GL_NO_ERROR);
+        }
+    }
+
+    // Set up the static index data.
+    if (!errors) {
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _index_buffer);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned), &indices.front(), GL_STATIC_DRAW);
+
+        GLenum error = glGetError();
+        if (error != GL_NO_ERROR) {
+            PRINT_ERROR << "Failed to store the index data. VAO ID: " <<
+                           vt_utils::NumberToString(_vao) << " Buffer ID: " <<
+                           vt_utils::NumberToString(_index_buffer) <<
+                           std::endl;
+            assert(error == GL_NO_ERROR);
+        }
+    }
+
+    // Unbind the vertex array object from the pipeline.
+    glBindVertexArray(0);
+
+    // Unbind the active buffers from the pipeline.
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+SpriteBatch::~SpriteBatch()
+{
+    if (_vao != 0) {
+        const GLuint arrays[] = { _vao };
+        glDeleteVertexArrays(1, arrays);
+        _vao = 0;
+    }
+
+    const GLuint buffers[] = { _vertex_position_buffer,
+                               _vertex_texture_coordinate_buffer,
+                               _vertex_color_buffer,
+                               _index_buffer };
+    glDeleteBuffers(4, buffers);
+
+    _vertex_position_buffer = 0;
+    _vertex_texture_coordinate_buffer = 0;
+    _vertex_color_buffer = 0;
+    _index_buffer = 0;
+}
+
+void SpriteBatch::AddQuad(const float* vertex_positions,
+                          const float* vertex_texture_coordinates,
+                          const float* vertex_colors)
+{
+    assert(vertex_positions != nullptr);
+    assert(vertex_texture_coordinates != nullptr);
+    assert(vertex_colors != nullptr);
+    assert(!IsFull());
+
+    const unsigned positions = BATCH_VERTICES_PER_QUAD * BATCH_POSITIONS_PER_VERTEX;
+    const unsigned texture_coordinates = BATCH_VERTICES_PER_QUAD * BATCH_TEXTURE_COORDINATES_PER_VERTEX;
+    const unsigned colors = BATCH_VERTICES_PER_QUAD * BATCH_COLORS_PER_VERTEX;
+
+    memcpy(&_vertex_positions[_number_of_quads * positions], vertex_positions, positions * sizeof(float));
+    memcpy(&_vertex_texture_coordinates[_number_of_quads * texture_coordinates], vertex_texture_coordinates, texture_coordinates * sizeof(float));
+    memcpy(&_vertex_colors[_number_of_quads * colors], vertex_colors, colors * sizeof(float));
+
+    ++_number_of_quads;
+}
+
+bool SpriteBatch::Flush()
+{
+    if (_number_of_quads == 0 || _vao == 0)
+        return false;
+
+    const unsigned number_of_vertices = _number_of_quads * BATCH_VERTICES_PER_QUAD;
+
+    // Orphan the previous storage before streaming the new data,
+    // so the driver doesn't have to wait for the previous draw call to finish.
+    glBindBuffer(GL_ARRAY_BUFFER, _vertex_position_buffer);
+    glBufferData(GL_ARRAY_BUFFER, _vertex_positions.size() * sizeof(float), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, number_of_vertices * BATCH_POSITIONS_PER_VERTEX * sizeof(float), &_vertex_positions.front());
+
+    glBindBuffer(GL_ARRAY_BUFFER, _vertex_texture_coordinate_buffer);
+    glBufferData(GL_ARRAY_BUFFER, _vertex_texture_coordinates.size() * sizeof(float), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, number_of_vertices * BATCH_TEXTURE_COORDINATES_PER_VERTEX * sizeof(float), &_vertex_texture_coordinates.front());
+
+    glBindBuffer(GL_ARRAY_BUFFER, _vertex_color_buffer);
+    glBufferData(GL_ARRAY_BUFFER, _vertex_colors.size() * sizeof(float), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, number_of_vertices * BATCH_COLORS_PER_VERTEX * sizeof(float), &_vertex_colors.front());
+
+    // Draw the quads.
+    glBindVertexArray(_vao);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _index_buffer);
+    glDrawElements(GL_TRIANGLES, _number_of_quads * BATCH_INDICES_PER_QUAD, GL_UNSIGNED_INT, nullptr);
+
+    // Unbind the vertex array object from the pipeline.
+    glBindVertexArray(0);
+
+    // Unbind the active buffers from the pipeline.
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    _number_of_quads = 0;
+    return true;
+}
+
+SpriteBatch::SpriteBatch(const SpriteBatch&)
+{
+    throw vt_utils::Exception("Not Implemented!", __FILE__, __LINE__, __FUNCTION__);
+}
+
+SpriteBatch& SpriteBatch::operator=(const SpriteBatch&)
+{
+    throw vt_utils::Exception("Not Implemented!", __FILE__, __LINE__, __FUNCTION__);
+    return *this;
+}
+
+} // namespace gl
+
+} // namespace vt_video
@@ -0,0 +1,97 @@
+////////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2016 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+////////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    gl_sprite_batch.h
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Header file for the sprite batch buffers.
+***
+*** The sprite batch accumulates already transformed quads into client-side
+*** arrays and sends them to the GPU using a single streaming vertex buffer
+*** upload and a single draw call.
+*** ***************************************************************************/
+
+#ifndef __GL_SPRITE_BATCH_HEADER__
+#define __GL_SPRITE_BATCH_HEADER__
+
+#include "utils/gl_include.h"
+
+#include <vector>
+
+namespace vt_video
+{
+namespace gl
+{
+
+//! \brief A class accumulating sprite quads and drawing them in one go.
+class SpriteBatch
+{
+public:
+    //! \param capacity The maximum number of quads stored before a flush is required.
+    explicit SpriteBatch(unsigned capacity);
+    ~SpriteBatch();
+
+    /** \brief Adds a quad to the batch.
+    *** \param vertex_positions 4 vertices of 3 floats, already transformed in view space.
+    *** \param vertex_texture_coordinates 4 vertices of 2 floats.
+    *** \param vertex_colors 4 vertices of 4 floats, already modulated.
+    *** \note The caller must flush the batch when IsFull() returns true.
+    **/
+    void AddQuad(const float* vertex_positions,
+                 const float* vertex_texture_coordinates,
+                 const float* vertex_colors);
+
+    /** \brief Uploads the pending quads and draws them using the currently loaded
+    *** shader program, texture and blending states.
+    *** \return true if a draw call was issued.
+    **/
+    bool Flush();
+
+    //! \brief Returns the number of quads waiting to be drawn.
+    unsigned GetNumberOfQuads() const {
+        return _number_of_quads;
+    }
+
+    bool IsEmpty() const {
+        return _number_of_quads == 0;
+    }
+
+    bool IsFull() const {
+        return _number_of_quads >= _capacity;
+    }
+
+private:
+    //! \brief The copy constructor and assignment operator are hidden by design
+    //! to cause compilation errors when attempting to copy or assign this class.
+    SpriteBatch(const SpriteBatch& sprite_batch);
+    SpriteBatch& operator=(const SpriteBatch& sprite_batch);
+
+    //! \brief The maximum number of quads the batch can store.
+    unsigned _capacity;
+
+    //! \brief The number of quads currently stored.
+    unsigned _number_of_quads;
+
+    //! \brief The client-side vertex data, streamed at flush time.
+    std::vector<float> _vertex_positions;
+    std::vector<float> _vertex_texture_coordinates;
+    std::vector<float> _vertex_colors;
+
+    GLuint _vao;
+    GLuint _vertex_position_buffer;
+    GLuint _vertex_texture_coordinate_buffer;
+    GLuint _vertex_color_buffer;
+    GLuint _index_buffer;
+};
+
+} // namespace gl
+
+} // namespace vt_video
+
+#endif // __GL_SPRITE_BATCH_HEADER__
@@ -0,0 +1,291 @@
+////////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2016 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+////////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    gl_sprite_buffer.cpp
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Source file for the static sprite buffers.
+*** ***************************************************************************/
+
+#include "gl_sprite_buffer.h"
+
+#include "utils/utils_common.h"
+#include "utils/exception.h"
+#include "utils/utils_strings.h"
+
+#include <cassert>
+#include <vector>
+
+#ifdef __APPLE__
+#   define glBindVertexArray    glBindVertexArrayAPPLE
+#   define glGenVertexArrays    glGenVertexArraysAPPLE
+#   define glDeleteVertexArrays glDeleteVertexArraysAPPLE
+#endif
+
+namespace vt_video
+{
+namespace gl
+{
+
+//! \brief constants.
+const unsigned BUFFER_VERTICES_PER_QUAD = 4;
+const unsigned BUFFER_INDICES_PER_QUAD = 6;
+const unsigned BUFFER_POSITIONS_PER_VERTEX = 3;
+const unsigned BUFFER_TEXTURE_COORDINATES_PER_VERTEX = 2;
+const unsigned BUFFER_COLORS_PER_VERTEX = 4;
+
+SpriteBuffer::SpriteBuffer(const float* vertex_positions,
+                           const float* vertex_texture_coordinates,
+                           const float* vertex_colors,
+                           unsigned number_of_quads,
+                           bool dynamic_texture_coordinates) :
+    _number_of_quads(number_of_quads),
+    _vao(0),
+    _vertex_position_buffer(0),
+    _vertex_texture_coordinate_buffer(0),
+    _vertex_color_buffer(0),
+    _index_buffer(0)
+{
+    bool errors = false;
+
+    assert(vertex_positions != nullptr);
+    assert(vertex_texture_coordinates != nullptr);
+    assert(vertex_colors != nullptr);
+    assert(_number_of_quads > 0);
+
+    const unsigned number_of_vertices = _number_of_quads * BUFFER_VERTICES_PER_QUAD;
+
+    std::vector<unsigned> indices;
+    indices.reserve(_number_of_quads * BUFFER_INDICES_PER_QUAD);
+    for (unsigned i = 0; i < _number_of_quads; ++i) {
+        unsigned index = i * BUFFER_VERTICES_PER_QUAD;
+
+        // Triangle one.
+        indices.push_back(index + 0);
+        indices.push_back(index + 1);
+        indices.push_back(index + 2);
+
+        // Triangle two.
+        indices.push_back(index + 0);
+        indices.push_back(index + 2);
+        indices.push_back(index + 3);
+    }
+
+    // Create the vertex array object.
+    if (!errors) {
+        GLuint arrays[1] = { 0 };
+        glGenVertexArrays(1, arrays);
+
+        GLenum error = glGetError();
+        if (error != GL_NO_ERROR) {
+            errors = true;
+            PRINT_ERROR << "Failed to create the vertex array object." << std::endl;
+            assert(error == GL_NO_ERROR);
+        } else {
+            // Store the result.
+            _vao = arrays[0];
+        }
+    }
+
+    // Bind the vertex array object.
+    if (!errors) {
+        glBindVertexArray(_vao);
+    }
+
+    // Create the vertex buffer objects.
+    if (!errors) {
+        GLuint buffers[4] = { 0 };
+        glGenBuffers(4, buffers);
+
+        GLenum error = glGetError();
+        if (error != GL_NO_ERROR) {
+            errors = true;
+            PRINT_ERROR << "Failed to create the vertex array object's position, texture coordinate, color, and index buffers. VAO ID: " <<
+                           vt_utils::NumberToString(_vao) <<
+                           std::endl;
+            assert(error == GL_NO_ERROR);
+        } else {
+            // Store the results.
+            _vertex_position_buffer = buffers[0];
+            _vertex_texture_coordinate_buffer = buffers[1];
+            _vertex_color_buffer = buffers[2];
+            _index_buffer = buffers[3];
+        }
+    }
+
+    // Store the vertex position data in slot 0.
+    if (!errors) {
+        glBindBuffer(GL_ARRAY_BUFFER, _vertex_position_buffer);
+        glBufferData(GL_ARRAY_BUFFER, number_of_vertices * BUFFER_POSITIONS_PER_VERTEX * sizeof(float), vertex_positions, GL_STATIC_DRAW);
+        glVertexAttribPointer(0, BUFFER_POSITIONS_PER_VERTEX, GL_FLOAT, false, 0, nullptr);
+        glEnableVertexAttribArray(0);
+
+        GLenum error = glGetError();
+        if (error != GL_NO_ERROR) {
+            errors = true;
+            PRINT_ERROR << "Failed to store the vertex position data. VAO ID: " <<
+                           vt_utils::NumberToString(_vao) << " Buffer ID: " <<
+                           vt_utils::NumberToString(_vertex_position_buffer) <<
+                           std::endl;
+            assert(error == GL_NO_ERROR);
+        }
+    }
+
+    // Store the vertex texture coordinate data in slot 1.
+    if (!errors) {
+        glBindBuffer(GL_ARRAY_BUFFER, _vertex_texture_coordinate_buffer);
+        glBufferData(GL_ARRAY_BUFFER, number_of_vertices * BUFFER_TEXTURE_COORDINATES_PER_VERTEX * sizeof(float), vertex_texture_coordinates,
+                     dynamic_texture_coordinates ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+        glVertexAttribPointer(1, BUFFER_TEXTURE_COORDINATES_PER_VERTEX, GL_FLOAT, false, 0, nullptr);
+        glEnableVertexAttribArray(1);
+
+        GLenum error = glGetError();
+        if (error != GL_NO_ERROR) {
+            errors = true;
+            PRINT_ERROR << "Failed to store the vertex texture coordinate data. VAO ID: " <<
+                           vt_utils::NumberToString(_vao) << " Buffer ID: " <<
+                           vt_utils::NumberToString(_vertex_texture_coordinate_buffer) <<
+                           std::endl;
+            assert(error == GL_NO_ERROR);
+        }
+    }
+
+    // Store the vertex color data in slot 2.
+    if (!errors) {
+        glBindBuffer(GL_ARRAY_BUFFER, _vertex_color_buffer);
+        glBufferData(GL_ARRAY_BUFFER, number_of_vertices * BUFFER_COLORS_PER_VERTEX * sizeof(float), vertex_colors, GL_STATIC_DRAW);
+        glVertexAttribPointer(2, BUFFER_COLORS_PER_VERTEX, GL_FLOAT, false, 0, nullptr);
+        glEnableVertexAttribArray(2);
+
+        GLenum error = glGetError();
+        if (error != GL_NO_ERROR) {
+            errors = true;
+            PRINT_ERROR << "Failed to store the vertex color data. VAO ID: " <<
+                           vt_utils::NumberToString(_vao) << " Buffer ID: " <<
+                           vt_utils::NumberToString(_vertex_color_buffer) <<
+                           std::endl;
+            assert(error == GL_NO_ERROR);
+        }
+    }
+
+    // Store the index data.
+    if (!errors) {
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _index_buffer);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned), &indices.front(), GL_STATIC_DRAW);
+
+        GLenum error = glGetError();
+        if (error != GL_NO_ERROR) {
+            errors = true;
+            PRINT_ERROR << "Failed to store the index data. VAO ID: " <<
+                           vt_utils::NumberToString(_vao) << " Buffer ID: " <<
+                           vt_utils::NumberToString(_index_buffer) <<
+                           std::endl;
+            assert(error == GL_NO_ERROR);
+        }
+    }
+
+    // Nothing will be drawn if the buffers couldn't be set up.
+    if (errors)
+        _number_of_quads = 0;
+
+    // Unbind the vertex array object from the pipeline.
+    glBindVertexArray(0);
+
+    // Unbind the active buffers from the pipeline.
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+SpriteBuffer::~SpriteBuffer()
+{
+    if (_vao != 0) {
+        const GLuint arrays[] = { _vao };
+        glDeleteVertexArrays(1, arrays);
+        _vao = 0;
+    }
+
+    const GLuint buffers[] = { _vertex_position_buffer,
+                               _vertex_texture_coordinate_buffer,
+                               _vertex_color_buffer,
+                               _index_buffer };
+    glDeleteBuffers(4, buffers);
+
+    _vertex_position_buffer = 0;
+    _vertex_texture_coordinate_buffer = 0;
+    _vertex_color_buffer = 0;
+    _index_buffer = 0;
+}
+
+void SpriteBuffer::Draw()
+{
+    if (_number_of_quads == 0)
+        return;
+
+    // Bind the vertex array object.
+    glBindVertexArray(_vao);
+
+    // Bind the index buffer.
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _index_buffer);
+
+    // Draw the quads.
+    glDrawElements(GL_TRIANGLES, _number_of_quads * BUFFER_INDICES_PER_QUAD, GL_UNSIGNED_INT, nullptr);
+
+    // Unbind the vertex array object from the pipeline.
+    glBindVertexArray(0);
+
+    // Unbind the active buffers from the pipeline.
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+void SpriteBuffer::UpdateTextureCoordinates(unsigned first_quad,
+                                            const float* vertex_texture_coordinates,
+                                            unsigned number_of_quads)
+{
+    assert(vertex_texture_coordinates != nullptr);
+    assert(first_quad + number_of_quads <= _number_of_quads);
+    if (number_of_quads == 0 || first_quad + number_of_quads > _number_of_quads)
+        return;
+
+    const unsigned floats_per_quad = BUFFER_VERTICES_PER_QUAD * BUFFER_TEXTURE_COORDINATES_PER_VERTEX;
+
+    glBindBuffer(GL_ARRAY_BUFFER, _vertex_texture_coordinate_buffer);
+    glBufferSubData(GL_ARRAY_BUFFER,
+                    first_quad * floats_per_quad * sizeof(float),
+                    number_of_quads * floats_per_quad * sizeof(float),
+                    vertex_texture_coordinates);
+
+#ifdef DEBUG_GL_ERRORS
+    GLenum error = glGetError();
+    if (error != GL_NO_ERROR) {
+        PRINT_ERROR << "Failed to update the vertex texture coordinate data. VAO ID: " <<
+                       vt_utils::NumberToString(_vao) << " Buffer ID: " <<
+                       vt_utils::NumberToString(_vertex_texture_coordinate_buffer) <<
+                       std::endl;
+        assert(error == GL_NO_ERROR);
+    }
+#endif
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+SpriteBuffer::SpriteBuffer(const SpriteBuffer&)
+{
+    throw vt_utils::Exception("Not Implemented!", __FILE__, __LINE__, __FUNCTION__);
+}
+
+SpriteBuffer& SpriteBuffer::operator=(const SpriteBuffer&)
+{
+    throw vt_utils::Exception("Not Implemented!", __FILE__, __LINE__, __FUNCTION__);
+    return *this;
+}
+
+} // namespace gl
+
+} // namespace vt_video
@@ -0,0 +1,83 @@
+////////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2016 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+////////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    gl_sprite_buffer.h
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Header file for the static sprite buffers.
+***
+*** A sprite buffer stores a fixed set of quads in GPU memory, so that they
+*** can be drawn again and again without sending any vertex data.
+*** ***************************************************************************/
+
+#ifndef __GL_SPRITE_BUFFER_HEADER__
+#define __GL_SPRITE_BUFFER_HEADER__
+
+#include "utils/gl_include.h"
+
+namespace vt_video
+{
+namespace gl
+{
+
+//! \brief A class storing quads in GPU memory and drawing them using one draw call.
+class SpriteBuffer
+{
+public:
+    /** \param vertex_positions 4 vertices of 3 floats per quad.
+    *** \param vertex_texture_coordinates 4 vertices of 2 floats per quad.
+    *** \param vertex_colors 4 vertices of 4 floats per quad.
+    *** \param number_of_quads The number of quads stored in the arrays.
+    *** \param dynamic_texture_coordinates Whether the texture coordinates will be updated
+    *** after creation, so that the driver can store them accordingly.
+    **/
+    SpriteBuffer(const float* vertex_positions,
+                 const float* vertex_texture_coordinates,
+                 const float* vertex_colors,
+                 unsigned number_of_quads,
+                 bool dynamic_texture_coordinates);
+    ~SpriteBuffer();
+
+    //! \brief Draws every quad of the buffer.
+    void Draw();
+
+    /** \brief Updates the texture coordinates of some quads.
+    *** \param first_quad The index of the first quad to update.
+    *** \param vertex_texture_coordinates 4 vertices of 2 floats per quad.
+    *** \param number_of_quads The number of quads to update.
+    **/
+    void UpdateTextureCoordinates(unsigned first_quad,
+                                  const float* vertex_texture_coordinates,
+                                  unsigned number_of_quads);
+
+    unsigned GetNumberOfQuads() const {
+        return _number_of_quads;
+    }
+
+private:
+    //! \brief The copy constructor and assignment operator are hidden by design
+    //! to cause compilation errors when attempting to copy or assign this class.
+    SpriteBuffer(const SpriteBuffer& sprite_buffer);
+    SpriteBuffer& operator=(const SpriteBuffer& sprite_buffer);
+
+    //! \brief The number of quads stored.
+    unsigned _number_of_quads;
+
+    GLuint _vao;
+    GLuint _vertex_position_buffer;
+    GLuint _vertex_texture_coordinate_buffer;
+    GLuint _vertex_color_buffer;
+    GLuint _index_buffer;
+};
+
+} // namespace gl
+
+} // namespace vt_video
+
+#endif // __GL_SPRITE_BUFFER_HEADER__
@@ -0,0 +1,280 @@
+////////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2016 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+////////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    glyph_atlas.cpp
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Source file for the font glyph atlas.
+***
+*** \note Normally the int data type should not be used in the game code,
+*** however it is used periodically throughout this file as the SDL_ttf library
+*** requests integer arguments.
+*** ***************************************************************************/
+
+#include "glyph_atlas.h"
+
+#include "texture_controller.h"
+#include "video.h"
+
+#include "utils/exception.h"
+
+#ifdef __APPLE__
+#   include <SDL_ttf.h>
+#else
+#   include <SDL2/SDL_ttf.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace vt_video
+{
+
+namespace private_video
+{
+
+//! \brief The atlas texture width, in pixels.
+const uint32_t GLYPH_ATLAS_WIDTH = 512;
+
+//! \brief The atlas texture height when created, and the maximum height it can grow to, in pixels.
+const uint32_t GLYPH_ATLAS_INITIAL_HEIGHT = 256;
+const uint32_t GLYPH_ATLAS_MAX_HEIGHT = 2048;
+
+//! \brief The space left between two cells, so that linear filtering doesn't bleed into the next glyph.
+const uint32_t GLYPH_ATLAS_PADDING = 1;
+
+GlyphAtlas::GlyphAtlas(TTF_Font* ttf_font) :
+    _ttf_font(ttf_font),
+    _texture_id(0),
+    _width(GLYPH_ATLAS_WIDTH),
+    _height(GLYPH_ATLAS_INITIAL_HEIGHT),
+    _pen_x(0),
+    _pen_y(0),
+    _row_height(0)
+{
+}
+
+GlyphAtlas::~GlyphAtlas()
+{
+    if (_texture_id != 0) {
+        TextureManager->_DeleteTexture(_texture_id);
+        _texture_id = 0;
+    }
+}
+
+const Glyph* GlyphAtlas::GetGlyph(uint16_t character)
+{
+    auto it = _glyphs.find(character);
+    if (it != _glyphs.end())
+        return &it->second;
+
+    if (_ttf_font == nullptr)
+        return nullptr;
+
+    int minx = 0, maxx = 0, miny = 0, maxy = 0, advance = 0;
+    if (TTF_GlyphMetrics(_ttf_font, character, &minx, &maxx, &miny, &maxy, &advance) != 0) {
+        IF_PRINT_WARNING(VIDEO_DEBUG) << "call to TTF_GlyphMetrics() failed for character: " << character << std::endl;
+        return nullptr;
+    }
+
+    // The cell has the size of the character rendered alone.
+    const uint16_t text[] = { character, 0 };
+    int32_t width = 0, height = 0;
+    if (TTF_SizeUNICODE(_ttf_font, text, &width, &height) != 0 || width <= 0 || height <= 0) {
+        IF_PRINT_WARNING(VIDEO_DEBUG) << "call to TTF_SizeUNICODE() failed for character: " << character << std::endl;
+        return nullptr;
+    }
+
+    Glyph glyph;
+    glyph.width = static_cast<uint32_t>(width);
+    glyph.height = static_cast<uint32_t>(height);
+    // When rendered alone, a glyph going left of the pen is shifted back into the cell.
+    glyph.x_offset = minx < 0 ? minx : 0;
+    glyph.advance = advance;
+
+    if (!_AllocateCell(glyph.width, glyph.height, glyph.x, glyph.y)) {
+        IF_PRINT_WARNING(VIDEO_DEBUG) << "no room left in the glyph atlas for character: " << character << std::endl;
+        return nullptr;
+    }
+
+    if (!_UploadGlyph(character, glyph.x, glyph.y))
+        return nullptr;
+
+    Glyph& stored_glyph = _glyphs[character];
+    stored_glyph = glyph;
+    return &stored_glyph;
+}
+
+int32_t GlyphAtlas::GetKerning(uint16_t previous_character, uint16_t character) const
+{
+#if SDL_TTF_MAJOR_VERSION > 2 || (SDL_TTF_MAJOR_VERSION == 2 && (SDL_TTF_MINOR_VERSION > 0 || SDL_TTF_PATCHLEVEL >= 14))
+    if (_ttf_font == nullptr || previous_character == 0 || TTF_GetFontKerning(_ttf_font) == 0)
+        return 0;
+
+    return TTF_GetFontKerningSizeGlyphs(_ttf_font, previous_character, character);
+#else
+    // Older SDL_ttf versions only expose the kerning using FreeType glyph indices.
+    (void)previous_character;
+    (void)character;
+    return 0;
+#endif
+}
+
+void GlyphAtlas::Clear()
+{
+    // The pending sprites might still use the evicted glyphs.
+    if (_texture_id != 0)
+        VideoManager->FlushSpriteBatch();
+
+    _glyphs.clear();
+    _pen_x = 0;
+    _pen_y = 0;
+    _row_height = 0;
+}
+
+bool GlyphAtlas::_UploadGlyph(uint16_t character, uint32_t x, uint32_t y)
+{
+    const SDL_Color white = { 255, 255, 255, 255 };
+    SDL_Surface* surface = TTF_RenderGlyph_Blended(_ttf_font, character, white);
+    if (surface == nullptr) {
+        IF_PRINT_WARNING(VIDEO_DEBUG) << "call to TTF_RenderGlyph_Blended() failed for character: " << character << std::endl;
+        return false;
+    }
+
+    // Don't write past the allocated cell.
+    uint32_t width = std::min(static_cast<uint32_t>(surface->w), _width - x);
+    uint32_t height = std::min(static_cast<uint32_t>(surface->h), _height - y);
+
+    TextureManager->_BindTexture(_texture_id);
+
+    SDL_LockSurface(surface);
+
+    if (static_cast<uint32_t>(surface->pitch) == width * 4) {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, surface->pixels);
+    } else {
+        // Pack the rows, as the surface pitch can't be given to OpenGL ES.
+        std::vector<uint8_t> pixels(width * height * 4);
+        for (uint32_t row = 0; row < height; ++row) {
+            memcpy(&pixels[row * width * 4],
+                   static_cast<uint8_t*>(surface->pixels) + row * surface->pitch,
+                   width * 4);
+        }
+        glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, &pixels.front());
+    }
+
+    SDL_UnlockSurface(surface);
+    SDL_FreeSurface(surface);
+
+    return true;
+}
+
+bool GlyphAtlas::_AllocateCell(uint32_t width, uint32_t height, uint32_t& x, uint32_t& y)
+{
+    if (width > GLYPH_ATLAS_WIDTH || height > GLYPH_ATLAS_MAX_HEIGHT)
+        return false;
+
+    // The texture is only created once the first glyph is needed.
+    if (_texture_id == 0) {
+        _width = GLYPH_ATLAS_WIDTH;
+        _height = GLYPH_ATLAS_INITIAL_HEIGHT;
+        if (!_ResizeTexture())
+            return false;
+    }
+
+    // Start a new row when the current one is full.
+    if (_pen_x + width > _width) {
+        _pen_x = 0;
+        _pen_y += _row_height + GLYPH_ATLAS_PADDING;
+        _row_height = 0;
+    }
+
+    // Grow the atlas, or start over once it can't grow anymore.
+    while (_pen_y + height > _height) {
+        if (!_Grow()) {
+            Clear();
+            break;
+        }
+    }
+
+    if (_pen_y + height > _height)
+        return false;
+
+    x = _pen_x;
+    y = _pen_y;
+
+    _pen_x += width + GLYPH_ATLAS_PADDING;
+    if (height > _row_height)
+        _row_height = height;
+
+    return true;
+}
+
+bool GlyphAtlas::_ResizeTexture()
+{
+    if (_texture_id == 0) {
+        _texture_id = TextureManager->_CreateBlankGLTexture(_width, _height);
+        if (_texture_id == INVALID_TEXTURE_ID) {
+            _texture_id = 0;
+            PRINT_ERROR << "Couldn't create the glyph atlas texture." << std::endl;
+            return false;
+        }
+    }
+
+    // The cell paddings must be transparent for the glyph borders to be filtered properly.
+    std::vector<uint8_t> pixels(_width * _height * 4, 0);
+
+    TextureManager->_BindTexture(_texture_id);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, _width, _height, 0, GL_RGBA, GL_UNSIGNED_BYTE, &pixels.front());
+
+    if (VideoManager->CheckGLError()) {
+        PRINT_ERROR << "Couldn't allocate the glyph atlas texture. OpenGL reported the following error: "
+                    << VideoManager->CreateGLErrorString() << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool GlyphAtlas::_Grow()
+{
+    if (_texture_id == 0 || _height * 2 > GLYPH_ATLAS_MAX_HEIGHT)
+        return false;
+
+    // The pending sprites texture coordinates are relative to the previous size.
+    VideoManager->FlushSpriteBatch();
+
+    _height *= 2;
+    if (!_ResizeTexture()) {
+        _height /= 2;
+        _ResizeTexture();
+        return false;
+    }
+
+    // The texture content is lost when resizing it, so render the glyphs again at the same places.
+    for (auto it = _glyphs.begin(); it != _glyphs.end(); ++it)
+        _UploadGlyph(it->first, it->second.x, it->second.y);
+
+    return true;
+}
+
+GlyphAtlas::GlyphAtlas(const GlyphAtlas&)
+{
+    throw vt_utils::Exception("Not Implemented!", __FILE__, __LINE__, __FUNCTION__);
+}
+
+GlyphAtlas& GlyphAtlas::operator=(const GlyphAtlas&)
+{
+    throw vt_utils::Exception("Not Implemented!", __FILE__, __LINE__, __FUNCTION__);
+    return *this;
+}
+
+} // namespace private_video
+
+} // namespace vt_video
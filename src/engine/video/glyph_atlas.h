@@ -0,0 +1,141 @@
+////////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2016 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+////////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    glyph_atlas.h
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Header file for the font glyph atlas.
+***
+*** A glyph atlas keeps every glyph of a font already rendered with SDL_ttf
+*** in a single texture, so that text drawn each frame can be laid out as
+*** textured quads instead of being rendered and uploaded again.
+*** ***************************************************************************/
+
+#ifndef __GLYPH_ATLAS_HEADER__
+#define __GLYPH_ATLAS_HEADER__
+
+#include "utils/gl_include.h"
+
+#include <map>
+#include <cstdint>
+
+typedef struct _TTF_Font TTF_Font;
+
+namespace vt_video
+{
+
+namespace private_video
+{
+
+//! \brief The location and metrics of a glyph rendered in a glyph atlas.
+class Glyph
+{
+public:
+    //! \brief The glyph cell position in the atlas texture, in pixels.
+    uint32_t x, y;
+
+    //! \brief The glyph cell size, in pixels. The height is the font height.
+    uint32_t width, height;
+
+    //! \brief The horizontal offset of the cell from the pen position.
+    int32_t x_offset;
+
+    //! \brief The horizontal distance to the next pen position.
+    int32_t advance;
+};
+
+/** ****************************************************************************
+*** \brief Stores the glyphs of a font in a texture, rendering them on demand.
+***
+*** Each glyph is rendered by SDL_ttf the first time it is requested, in a cell
+*** as high as the font and placed relatively to the baseline, so that the cells
+*** can be put side by side using the glyph advance and the font kerning.
+*** The atlas texture height grows when it gets full. Once at its maximum size,
+*** every glyph is evicted and the atlas starts over.
+*** ***************************************************************************/
+class GlyphAtlas
+{
+public:
+    explicit GlyphAtlas(TTF_Font* ttf_font);
+    ~GlyphAtlas();
+
+    /** \brief Returns the given character glyph, rendering it in the atlas if needed.
+    *** \return nullptr if the glyph couldn't be rendered.
+    *** \note The returned pointer may become invalid once another glyph is requested.
+    **/
+    const Glyph* GetGlyph(uint16_t character);
+
+    //! \brief Returns the kerning to apply between two characters, in pixels.
+    int32_t GetKerning(uint16_t previous_character, uint16_t character) const;
+
+    //! \brief Forgets every rendered glyph, e.g. when the characters in use change with the locale.
+    void Clear();
+
+    //! \brief Returns the atlas texture, or 0 when no glyph has been rendered yet.
+    GLuint GetTextureId() const {
+        return _texture_id;
+    }
+
+    uint32_t GetWidth() const {
+        return _width;
+    }
+
+    uint32_t GetHeight() const {
+        return _height;
+    }
+
+private:
+    //! \brief The copy constructor and assignment operator are hidden by design
+    //! to cause compilation errors when attempting to copy or assign this class.
+    GlyphAtlas(const GlyphAtlas& glyph_atlas);
+    GlyphAtlas& operator=(const GlyphAtlas& glyph_atlas);
+
+    //! \brief The font the glyphs are rendered with.
+    TTF_Font* _ttf_font;
+
+    //! \brief The atlas texture.
+    GLuint _texture_id;
+
+    //! \brief The atlas texture size, in pixels.
+    uint32_t _width;
+    uint32_t _height;
+
+    //! \brief Where the next glyph cell will be placed.
+    uint32_t _pen_x;
+    uint32_t _pen_y;
+
+    //! \brief The height of the current row of cells.
+    uint32_t _row_height;
+
+    //! \brief The rendered glyphs, by character.
+    std::map<uint16_t, Glyph> _glyphs;
+
+    /** \brief Renders a glyph and uploads it at the given place in the atlas texture.
+    *** \return false if the glyph couldn't be rendered.
+    **/
+    bool _UploadGlyph(uint16_t character, uint32_t x, uint32_t y);
+
+    /** \brief Finds room for a cell of the given size in the atlas texture,
+    *** growing or clearing the atlas when needed.
+    *** \return false if the cell can't fit even in an empty atlas.
+    **/
+    bool _AllocateCell(uint32_t width, uint32_t height, uint32_t& x, uint32_t& y);
+
+    //! \brief (Re)creates the atlas texture storage at the current size, cleared to transparent.
+    bool _ResizeTexture();
+
+    //! \brief Doubles the atlas texture height and renders the existing glyphs again.
+    bool _Grow();
+};
+
+} // namespace private_video
+
+} // namespace vt_video
+
+#endif // __GLYPH_ATLAS_HEADER__
@@ -26,6 +26,7 @@
 #include "utils/utils_strings.h"
 
 #include "video.h"
+#include "image_decoder.h"
 
 #include <SDL_image.h>
 
@@ -59,14 +60,6 @@ ImageDescriptor::ImageDescriptor() :
 
 ImageDescriptor::~ImageDescriptor()
 {
-    // The destructor for the inherited class should have disabled grayscale mode
-    // If it didn't, the grayscale image might not have been properly dereferenced
-    // and/or removed from texture memory
-    if(_grayscale) {
-        IF_PRINT_WARNING(VIDEO_DEBUG) << "grayscale mode was still enabled when destructor was invoked "
-                                      << "-- possible memory leak" << std::endl;
-    }
-
     // Remove the reference to the original, colored texture
     if(_texture != nullptr)
         _RemoveTextureReference();
@@ -142,12 +135,6 @@ ImageDescriptor &ImageDescriptor::operator=(const ImageDescriptor &copy)
 
 void ImageDescriptor::Clear()
 {
-    // This will also remove a reference to the grayscale version of the image
-    // FIXME: This is triggering a crash when several images using the same file
-    // are in different states.
-    //if (_grayscale)
-    //    _DisableGrayscale();
-
     if(_texture != nullptr)
         _RemoveTextureReference();
 
@@ -344,6 +331,11 @@ bool ImageDescriptor::SaveMultiImage(const std::vector<StillImage *>& images,
                                           << filename << std::endl;
             return false;
         }
+        if(images[i]->IsLoading()) {
+            IF_PRINT_WARNING(VIDEO_DEBUG) << "an image still being loaded was present in images vector argument when saving file: "
+                                          << filename << std::endl;
+            return false;
+        }
         if(!IsFloatEqual(images[i]->_width,  img_width) ||
            !IsFloatEqual(images[i]->_height, img_height)) {
             IF_PRINT_WARNING(VIDEO_DEBUG) << "images contained in vector argument did not share the same dimensions" << std::endl;
@@ -371,7 +363,7 @@ bool ImageDescriptor::SaveMultiImage(const std::vector<StillImage *>& images,
     // and malloc enough memory for the entire sheet so that we can copy over the texture sheet from video memory to
     // system memory.
     ImageTexture *img = images[0]->_image_texture;
-    GLuint tex_id = img->texture_sheet->tex_id;
+    TexSheet *sheet = img->texture_sheet;
 
     ImageMemory texture;
     ImageMemory save;
@@ -388,7 +380,7 @@ bool ImageDescriptor::SaveMultiImage(const std::vector<StillImage *>& images,
         return false;
     }
 
-    TextureManager->_BindTexture(tex_id);
+    TextureManager->_BindTexSheet(sheet);
     texture.GlGetTexImage();
 
     uint32_t i = 0; // i is used to count through the images vector to get the image to save
@@ -396,13 +388,13 @@ bool ImageDescriptor::SaveMultiImage(const std::vector<StillImage *>& images,
         for(uint32_t y = 0; y < grid_columns; y++) {
             img = images[i]->_image_texture;
 
-            // Check if this image has a different texture ID than the last. If it does, we need to re-grab the texture
+            // Check if this image has a different texture sheet than the last. If it does, we need to re-grab the texture
             // memory for the texture sheet that the new image is contained within and store it in the texture.pixels
             // buffer, which is CPU system memory.
-            if(tex_id != img->texture_sheet->tex_id) {
-                // Get new texture ID
-                TextureManager->_BindTexture(img->texture_sheet->tex_id);
-                tex_id = img->texture_sheet->tex_id;
+            if(sheet != img->texture_sheet) {
+                // Get new texture sheet
+                sheet = img->texture_sheet;
+                TextureManager->_BindTexSheet(sheet);
 
                 // If the new texture is bigger, reallocate memory
                 if(texture.GetSize2D() < img->texture_sheet->height * img->texture_sheet->width) {
@@ -428,6 +420,10 @@ bool ImageDescriptor::SaveMultiImage(const std::vector<StillImage *>& images,
         }
     }
 
+    // The textures are kept in colors, so the grayscale conversion is done on the CPU here.
+    if(images[0]->_grayscale)
+        save.ConvertToGrayscale();
+
     // save.pixels now contains all the image data we wish to save,
     // so write it out to the new image file
     bool success = save.SaveImage(filename);
@@ -458,13 +454,16 @@ void ImageDescriptor::_RemoveTextureReference()
         return;
     }
 
+    // Textures still being loaded asynchronously aren't in any texture sheet yet
     if(_texture->RemoveReference()) {
-        _texture->texture_sheet->RemoveTexture(_texture);
+        if(_texture->texture_sheet != nullptr) {
+            _texture->texture_sheet->RemoveTexture(_texture);
 
-        // If the image exceeds 512 in either width or height, it has an un-shared texture sheet, which we
-        // should now delete that the image is being removed
-        if(_texture->width > 512 || _texture->height > 512) {
-            TextureManager->_RemoveSheet(_texture->texture_sheet);
+            // If the image exceeds 512 in either width or height, it has an un-shared texture sheet, which we
+            // should now delete that the image is being removed
+            if(_texture->width > 512 || _texture->height > 512) {
+                TextureManager->_RemoveSheet(_texture->texture_sheet);
+            }
         }
 //      else {
 //          // TODO: Otherise simply mark the image as free in the texture sheet
@@ -563,13 +562,13 @@ void ImageDescriptor::_DrawTexture(const Color* draw_color) const
     if (VideoManager->_current_context.blend) {
         VideoManager->EnableBlending();
         if (VideoManager->_current_context.blend == 1) {
-            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); // Normal blending
+            VideoManager->SetBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); // Normal blending
         } else {
-            glBlendFunc(GL_SRC_ALPHA, GL_ONE); // Additive blending
+            VideoManager->SetBlendFunc(GL_SRC_ALPHA, GL_ONE); // Additive blending
         }
     } else if (_blend) {
         VideoManager->EnableBlending();
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); // Normal blending
+        VideoManager->SetBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); // Normal blending
     } else {
         VideoManager->DisableBlending();
     }
@@ -619,11 +618,13 @@ void ImageDescriptor::_DrawTexture(const Color* draw_color) const
 
         // Enable texturing and bind the texture.
         VideoManager->EnableTexture2D();
-        TextureManager->_BindTexture(_texture->texture_sheet->tex_id);
+        TextureManager->_BindTexSheet(_texture->texture_sheet);
         _texture->texture_sheet->Smooth(_smooth);
 
-        // Load the sprite shader program.
-        shader_program = VideoManager->LoadShaderProgram(gl::shader_programs::Sprite);
+        // Load the sprite shader program, which converts the texture colors when the image is grayscale.
+        shader_program = VideoManager->LoadShaderProgram(_grayscale ?
+                                                         gl::shader_programs::SpriteGrayscale :
+                                                         gl::shader_programs::Sprite);
         assert(shader_program != nullptr);
     } else {
         //
@@ -634,7 +635,9 @@ void ImageDescriptor::_DrawTexture(const Color* draw_color) const
         VideoManager->DisableTexture2D();
 
         // Load the solid shader program.
-        shader_program = VideoManager->LoadShaderProgram(gl::shader_programs::Solid);
+        shader_program = VideoManager->LoadShaderProgram(_grayscale ?
+                                                         gl::shader_programs::SolidGrayscale :
+                                                         gl::shader_programs::Solid);
         assert(shader_program != nullptr);
     }
 
@@ -659,7 +662,9 @@ void ImageDescriptor::_DrawTexture(const Color* draw_color) const
         VideoManager->UnloadShaderProgram();
 
         // Load the solid shader program.
-        shader_program = VideoManager->LoadShaderProgram(gl::shader_programs::Solid);
+        shader_program = VideoManager->LoadShaderProgram(_grayscale ?
+                                                         gl::shader_programs::SolidGrayscale :
+                                                         gl::shader_programs::Solid);
         assert(shader_program != nullptr);
 
         // Draw the image.
@@ -706,7 +711,7 @@ bool ImageDescriptor::_LoadMultiImage(std::vector<StillImage>& images, const std
     ImageMemory multi_image;
     ImageMemory sub_image;
     if(need_load) {
-        if(multi_image.LoadImage(filename) == false) {
+        if(!TextureManager->_TakePreloadedImage(filename, multi_image) && !multi_image.LoadImage(filename)) {
             IF_PRINT_WARNING(VIDEO_DEBUG) << "Failed to load multi image file: " << filename << std::endl;
             return false;
         }
@@ -771,14 +776,6 @@ bool ImageDescriptor::_LoadMultiImage(std::vector<StillImage>& images, const std
 
             img->AddReference();
 
-            // Finally, do a grayscale conversion for the image if grayscale mode is enabled
-            if(images.at(current_image)._grayscale) {
-                // Set _grayscale to false so that the call doesn't think that the grayscale image is already loaded
-                // It will be set back to true by the _EnableGrayscale call
-                images.at(current_image)._grayscale = false;
-                images.at(current_image)._EnableGrayscale();
-            }
-
             current_image++;
         } // for (y = 0; y < grid_cols; y++)
     } // for (x = 0; x < grid_rows; x++)
@@ -804,8 +801,35 @@ StillImage::~StillImage()
     Clear();
 }
 
+StillImage::StillImage(const StillImage &copy) :
+    ImageDescriptor(copy),
+    _filename(copy._filename),
+    _image_texture(copy._image_texture),
+    _offset(copy._offset)
+{
+    if(IsLoading())
+        TextureManager->_pending_images.insert(this);
+}
+
+StillImage &StillImage::operator=(const StillImage &copy)
+{
+    if(this == &copy)
+        return *this;
+
+    _StopLoading();
+    ImageDescriptor::operator=(copy);
+    _filename = copy._filename;
+    _image_texture = copy._image_texture;
+    _offset = copy._offset;
+
+    if(IsLoading())
+        TextureManager->_pending_images.insert(this);
+    return *this;
+}
+
 void StillImage::Clear()
 {
+    _StopLoading();
     ImageDescriptor::Clear(); // This call will remove the texture reference for us
     _filename.clear();
     _image_texture = nullptr;
@@ -817,6 +841,7 @@ bool StillImage::Load(const std::string &filename)
 {
     // Delete everything previously stored in here
     if(_image_texture != nullptr) {
+        _StopLoading();
         _RemoveTextureReference();
         _image_texture = nullptr;
         _width = 0.0f;
@@ -844,13 +869,23 @@ bool StillImage::Load(const std::string &filename)
             return false;
         }
 
+        _texture->AddReference();
+
+        // The image file is being decoded for an asynchronous load: load it right away instead
+        if(_image_texture->texture_sheet == nullptr) {
+            TextureManager->_pending_images.insert(this);
+
+            ImageMemory img_data;
+            img_data.LoadImage(_filename);
+            return TextureManager->_UploadImageTexture(_image_texture, img_data);
+        }
+
         // If the width or height of this object is 0.0, use the pixel width/height of the image texture
         if(IsFloatEqual(_width, 0.0f))
             _width = static_cast<float>(_image_texture->width);
         if(IsFloatEqual(_height, 0.0f))
             _height = static_cast<float>(_image_texture->height);
 
-        _texture->AddReference();
         return true;
     }
 
@@ -861,9 +896,8 @@ bool StillImage::Load(const std::string &filename)
         return false;
     }
 
-    // Create a new texture image and store it in a texture sheet. If the _grayscale member of this class is true,
-    // we first load the color copy of the image to a texture sheet. Then we'll convert the image data to grayscale
-    // and save that image data to texture memory as well
+    // Create a new texture image and store it in a texture sheet.
+    // Grayscale images use the same texture, as the conversion is done when drawing.
     _image_texture = new ImageTexture(_filename, "", img_data.GetWidth(), img_data.GetHeight());
     _texture = _image_texture;
 
@@ -884,35 +918,56 @@ bool StillImage::Load(const std::string &filename)
     if(IsFloatEqual(_height, 0.0f))
         _height = static_cast<float>(img_data.GetHeight());
 
-    // If we don't need to create a grayscale version, we finished successfully
-    if(_grayscale == false) {
-        return true;
-    }
+    return true;
+}
 
-    // 3. If we reached this point, we must now create a grayscale version of this image
-    img_data.ConvertToGrayscale();
-    ImageTexture *gray_image = new ImageTexture(_filename, "<G>", img_data.GetWidth(), img_data.GetHeight());
-    if(TextureManager->_InsertImageInTexSheet(gray_image, img_data, _is_static) == nullptr) {
-        IF_PRINT_WARNING(VIDEO_DEBUG) << "call to TextureController::_InsertImageInTexSheet() failed for file: " << _filename << std::endl;
+bool StillImage::LoadAsync(const std::string &filename)
+{
+    // Procedural images, and images already loaded, don't need any decoding.
+    // Without the decoding threads, the image is loaded right away as well.
+    ImageTexture *image = TextureManager->_GetImageTexture(filename);
+    if(filename.empty() || TextureManager->_image_decoder == nullptr ||
+            (image != nullptr && image->texture_sheet != nullptr)) {
+        return Load(filename);
+    }
 
-        TextureManager->_UnregisterImageTexture(gray_image);
-        delete gray_image;
-        _RemoveTextureReference(); // sets _texture to nullptr
+    // Delete everything previously stored in here
+    if(_image_texture != nullptr) {
+        _StopLoading();
+        _RemoveTextureReference();
         _image_texture = nullptr;
-        return false;
+        _width = 0.0f;
+        _height = 0.0f;
+        _offset.x = 0.0f;
+        _offset.y = 0.0f;
     }
 
-    _image_texture = gray_image;
+    _filename = filename;
+
+    // Share the texture of the image file if it is already being decoded.
+    // Otherwise, register an empty texture waiting for the decoded image.
+    _image_texture = TextureManager->_GetImageTexture(_filename);
+    if(_image_texture == nullptr) {
+        _image_texture = new ImageTexture(_filename, "", 0, 0);
+        TextureManager->_image_decoder->RequestImage(_filename);
+    }
     _texture = _image_texture;
-    _image_texture->AddReference();
+    _texture->AddReference();
 
+    TextureManager->_pending_images.insert(this);
     return true;
 }
 
+bool StillImage::IsLoading() const
+{
+    return _image_texture != nullptr && _image_texture->texture_sheet == nullptr;
+}
+
 void StillImage::Draw(const Color &draw_color) const
 {
-    // Don't draw anything if this image is completely transparent (invisible).
-    if (IsFloatEqual(draw_color[3], 0.0f))
+    // Don't draw anything if this image is completely transparent (invisible),
+    // or while it is being loaded.
+    if (IsFloatEqual(draw_color[3], 0.0f) || IsLoading())
         return;
 
     VideoManager->PushMatrix();
@@ -947,6 +1002,11 @@ bool StillImage::Save(const std::string &filename) const
         return false;
     }
 
+    if(IsLoading()) {
+        IF_PRINT_WARNING(VIDEO_DEBUG) << "attempted to save an image still being loaded: " << _filename << std::endl;
+        return false;
+    }
+
     // Isolate the file extension
     size_t ext_position = filename.rfind('.');
 
@@ -964,75 +1024,28 @@ bool StillImage::Save(const std::string &filename) const
 
     ImageMemory buffer;
     buffer.CopyFromImage(_image_texture);
+
+    // The texture is kept in colors, so the grayscale conversion is done on the CPU here.
+    if(_grayscale)
+        buffer.ConvertToGrayscale();
     return buffer.SaveImage(filename);
 }
 
 void StillImage::_EnableGrayscale()
 {
-    if(_grayscale)
-        return;
-
+    // The grayscale shader programs are used when drawing, so the texture doesn't change.
     _grayscale = true;
-
-    // If no image texture is available we are done here (when Load() is next called, grayscale will automatically be enabled)
-    if(_image_texture == nullptr)
-        return;
-
-    // Check if a grayscale version of this image already exists in texture memory and if so, update the ImageTexture pointer and reference
-    std::string search_key = _filename + _image_texture->tags + "<G>";
-    std::string tags = _image_texture->tags;
-    ImageTexture *temp_texture = _image_texture;
-    if((_image_texture = TextureManager->_GetImageTexture(search_key)) != nullptr) {
-        // NOTE: We do not decrement the reference to the colored image, because we want to guarantee that
-        // it remains referenced in texture memory while its grayscale counterpart is being used
-        _texture = _image_texture;
-        _image_texture->AddReference();
-        return;
-    }
-
-    // If no grayscale version exists, create a copy of the image, convert it to grayscale, and add the gray copy to texture memory
-    ImageMemory gray_img;
-    gray_img.CopyFromImage(temp_texture);
-    gray_img.ConvertToGrayscale();
-
-    ImageTexture* new_img = new ImageTexture(_filename, tags + "<G>", gray_img.GetWidth(), gray_img.GetHeight());
-
-    if(TextureManager->_InsertImageInTexSheet(new_img, gray_img, _is_static) == nullptr) {
-        IF_PRINT_WARNING(VIDEO_DEBUG) << "failed to insert new grayscale image into texture sheet" << std::endl;
-        delete new_img;
-
-        return;
-    }
-
-    _image_texture = new_img;
-    _texture = _image_texture;
-    _image_texture->AddReference();
 }
 
 void StillImage::_DisableGrayscale()
 {
-    if(_grayscale == false)
-        return;
-
     _grayscale = false;
+}
 
-    // If no image data is loaded, we're finished
-    if(_image_texture == nullptr)
-        return;
-
-    std::string search_key = _image_texture->filename + _image_texture->tags.substr(0, _image_texture->tags.length() - 3);
-    if((_image_texture = TextureManager->_GetImageTexture(search_key)) == nullptr) {
-        PRINT_WARNING << "non-grayscale version of image was not found in texture memory: "
-                      << GetFilename() << std::endl;
-        return;
-    }
-
-    // Remove the reference to the grayscale version and grab the reference to the original color image
-    _RemoveTextureReference();
-
-    // No reference change is needed for the color image, since the color texture did not have a reference
-    // decrement when the grayscale version was enabled
-    _texture = _image_texture;
+void StillImage::_StopLoading()
+{
+    if(IsLoading())
+        TextureManager->_pending_images.erase(this);
 }
 
 void StillImage::SetWidthKeepRatio(float width)
@@ -1195,7 +1208,6 @@ bool AnimatedImage::LoadFromFrameSize(const std::string &filename, const std::ve
                                       const uint32_t frame_width, const uint32_t frame_height, const uint32_t trim)
 {
     // Make the multi image call
-    // TODO: Handle the case where the _grayscale member is true so all frames are loaded in grayscale format
     std::vector<StillImage> image_frames;
     if(ImageDescriptor::LoadMultiImageFromElementSize(image_frames, filename, frame_width, frame_height) == false) {
         return false;
@@ -1243,7 +1255,6 @@ bool AnimatedImage::LoadFromFrameGrid(const std::string &filename, const std::ve
     ResetAnimation();
 
     // Make the multi image call
-    // TODO: Handle the case where the _grayscale member is true so all frames are loaded in grayscale format
     std::vector<StillImage> image_frames;
     if(ImageDescriptor::LoadMultiImageFromElementGrid(image_frames, filename, frame_rows, frame_cols) == false) {
         return false;
@@ -1378,7 +1389,7 @@ void AnimatedImage::Update(uint32_t elapsed_time)
 
 bool AnimatedImage::AddFrame(const std::string &frame, uint32_t frame_time)
 {
-    StillImage img;
+    StillImage img(_grayscale);
     img.SetStatic(_is_static);
     img.SetVertexColors(_color[0], _color[1], _color[2], _color[3]);
     if(!img.Load(frame, _width, _height)) {
@@ -1402,6 +1413,7 @@ bool AnimatedImage::AddFrame(const StillImage &frame, uint32_t frame_time)
 
     AnimationFrame new_frame;
     new_frame.image = frame;
+    new_frame.image._grayscale = _grayscale;
     new_frame.frame_time = frame_time;
 
     _frames.push_back(new_frame);
@@ -94,6 +94,7 @@ class StillImage;
 class ImageDescriptor
 {
     friend class VideoEngine;
+    friend class ImageBatch;
 
 public:
     ImageDescriptor();
@@ -350,6 +351,7 @@ class StillImage : public ImageDescriptor
     friend class AnimatedImage;
     friend class CompositeImage;
     friend class TextureController;
+    friend class ImageBatch;
     friend class vt_mode_manager::ParticleSystem;
 
 public:
@@ -358,6 +360,11 @@ public:
 
     virtual ~StillImage() override;
 
+    //! \brief The copies of an image being loaded asynchronously are updated when it is loaded as well
+    StillImage(const StillImage &copy);
+
+    StillImage &operator=(const StillImage &copy);
+
     //! \brief Resets the image's properties and removes any references to image data that it maintains
     void Clear() override;
 
@@ -377,6 +384,28 @@ public:
         return Load(filename);
     }
 
+    /** \brief Loads a single image file without waiting for it to be decoded
+    *** \param filename The filename of the image to load (should have a SDL_image compatible extension)
+    *** \return True if the image was already loaded, or its loading was started
+    ***
+    *** The image file is decoded by a worker thread, and its texture uploaded by the texture
+    *** controller within a time budget per frame. Until then, IsLoading() returns true and the
+    *** image draws nothing. The width and height, when left to 0, are set once the image is loaded,
+    *** and the image is cleared if the file couldn't be loaded.
+    ***
+    *** \note The tilesets and animations are cut from their image file according to its
+    *** dimensions, so they keep using the synchronous loading.
+    **/
+    bool LoadAsync(const std::string &filename);
+
+    bool LoadAsync(const std::string &filename, float width, float height) {
+        SetDimensions(width, height);
+        return LoadAsync(filename);
+    }
+
+    //! \brief Tells whether the image is being loaded asynchronously, and can't be drawn yet
+    bool IsLoading() const;
+
     /** \brief Draws a color-modulated version of the image
     *** \param draw_color The color to modulate the image by
     **/
@@ -490,11 +519,14 @@ protected:
     //! \brief X and y draw position offsets of this element
     vt_common::Position2D _offset;
 
-    //! \brief Enables grayscaling for the image then reloads it
+    //! \brief Makes the image drawn in grayscale
     void _EnableGrayscale() override;
 
-    //! \brief Disables grayscaling for the image then reloads it
+    //! \brief Makes the image drawn in colors again
     void _DisableGrayscale() override;
+
+    //! \brief Stops waiting for the asynchronously loaded texture, before releasing or replacing it
+    void _StopLoading();
 };
 
 namespace private_video
@@ -16,11 +16,13 @@
 *** ***************************************************************************/
 
 #include "image_base.h"
+#include "image_kernels.h"
 
 #include "video.h"
 
 #include "utils/utils_common.h"
 
+#include <algorithm>
 #include <cassert>
 
 #include <SDL2/SDL_image.h>
@@ -94,44 +96,34 @@ bool ImageMemory::LoadImage(const std::string& filename)
     Resize(alpha_surf->w, alpha_surf->h, 3 == alpha_surf->format->BytesPerPixel);
 
     // convert the data so that it works in our format
-    uint8_t* img_pixel = nullptr;
-    uint8_t* dst_pixel = nullptr;
-
+    const size_t dst_pitch = _width * GetBytesPerPixel();
     for (uint32_t y = 0; y < _height; ++y) {
-        for (uint32_t x = 0; x < _width; ++x) {
-            img_pixel = static_cast<uint8_t *>(alpha_surf->pixels) + y * alpha_surf->pitch + x * alpha_surf->format->BytesPerPixel;
-            dst_pixel = &_pixels[(y * _width + x) * GetBytesPerPixel()];
+        const uint8_t* src_row = static_cast<const uint8_t *>(alpha_surf->pixels) + y * alpha_surf->pitch;
+        uint8_t* dst_row = &_pixels[y * dst_pitch];
+
+        if (alpha_format) { // ARGB8888
+            // The red and blue bytes are in reverse order in memory on little endian systems.
 #if SDL_BYTEORDER == SDL_BIG_ENDIAN
-            if (alpha_format) {
-                dst_pixel[0] = img_pixel[0];
-                dst_pixel[1] = img_pixel[1];
-                dst_pixel[2] = img_pixel[2];
-                dst_pixel[3] = img_pixel[3];
-            } else {
-                dst_pixel[2] = img_pixel[0];
-                dst_pixel[1] = img_pixel[1];
-                dst_pixel[0] = img_pixel[2];
-                dst_pixel[3] = img_pixel[3];
-            }
-#else
-            if (alpha_format) { // ARGB8888
-#ifdef __APPLE__
-                dst_pixel[3] = img_pixel[3];
-                dst_pixel[0] = img_pixel[2];
-                dst_pixel[1] = img_pixel[1];
-                dst_pixel[2] = img_pixel[0];
+            ConvertARGBRow(src_row, dst_row, _width, false);
 #else
-                dst_pixel[2] = img_pixel[0];
-                dst_pixel[1] = img_pixel[1];
-                dst_pixel[0] = img_pixel[2];
-                dst_pixel[3] = img_pixel[3];
+            ConvertARGBRow(src_row, dst_row, _width, true);
 #endif
-            } else {
-                dst_pixel[0] = img_pixel[0];
-                dst_pixel[1] = img_pixel[1];
-                dst_pixel[2] = img_pixel[2];
-                dst_pixel[3] = img_pixel[3];
-            }
+            continue;
+        }
+
+        for (uint32_t x = 0; x < _width; ++x) {
+            const uint8_t* img_pixel = src_row + x * alpha_surf->format->BytesPerPixel;
+            uint8_t* dst_pixel = dst_row + x * GetBytesPerPixel();
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+            dst_pixel[2] = img_pixel[0];
+            dst_pixel[1] = img_pixel[1];
+            dst_pixel[0] = img_pixel[2];
+            dst_pixel[3] = img_pixel[3];
+#else
+            dst_pixel[0] = img_pixel[0];
+            dst_pixel[1] = img_pixel[1];
+            dst_pixel[2] = img_pixel[2];
+            dst_pixel[3] = img_pixel[3];
 #endif
             // GL_LINEAR white artifact removal
             // Make the r,g,b values black to prevent OpenGL to make linear average with
@@ -297,40 +289,10 @@ void ImageMemory::ConvertToGrayscale()
 
     assert(_pixels.size() > bytes_per_pixel);
 
-    // We are going to increment through the loop by 'bytes_per_pixel'.
-    // So, the size of the array must be divisible by 'bytes_per_pixel'.
+    // The size of the array must be divisible by 'bytes_per_pixel'.
     assert(_pixels.size() % bytes_per_pixel == 0);
-    if (_pixels.size() % bytes_per_pixel == 0) {
-
-        auto current_pixel = _pixels.begin();
-        auto end_pixel = _pixels.end();
-
-        while (current_pixel != end_pixel) {
-
-            //
-            // Calculate the grayscale value for this pixel based on RGB values: 0.30R + 0.59G + 0.11B.
-            //
-
-            uint8_t red   = *(current_pixel + 0);
-            uint8_t green = *(current_pixel + 1);
-            uint8_t blue  = *(current_pixel + 2);
-
-            // Compute the sum.
-            uint32_t sum = (30 * red) + (59 * green) + (11 * blue);
-
-            // Scale the sum.
-            uint8_t value = static_cast<uint8_t>(sum * 0.01f);
-
-            // Store the result.
-            *(current_pixel + 0) = value;
-            *(current_pixel + 1) = value;
-            *(current_pixel + 2) = value;
-            // *(current_pixel + 3) for RGBA is the alpha value and is left unmodified.
-
-            // Increment to the next pixel.
-            current_pixel = current_pixel + bytes_per_pixel;
-        }
-    }
+    if (_pixels.size() % bytes_per_pixel == 0)
+        ConvertPixelsToGrayscale(&_pixels[0], _pixels.size() / bytes_per_pixel, bytes_per_pixel);
 }
 
 void ImageMemory::RGBAToRGB()
@@ -376,7 +338,7 @@ void ImageMemory::CopyFromTexture(TexSheet *texture)
                     << std::endl;
     }
 
-    TextureManager->_BindTexture(texture->tex_id);
+    TextureManager->_BindTexSheet(texture);
     glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, &_pixels[0]);
 }
 
@@ -471,17 +433,16 @@ void ImageMemory::GlReadPixels(int32_t x, int32_t y)
 
 void ImageMemory::VerticalFlip()
 {
-    std::vector<uint8_t> flipped;
-    flipped.reserve(_pixels.size());
+    if (_pixels.empty())
+        return;
 
-    for (uint32_t i = 1; i <= _height; ++i) {
-        std::vector<uint8_t>::const_iterator start =
-            _pixels.end() - (i * _width * GetBytesPerPixel());
-        std::vector<uint8_t>::const_iterator end =
-            start + _width * GetBytesPerPixel();
-        flipped.insert(flipped.end(), start, end);
+    // Swap the rows in place, from both ends
+    const size_t bytes_per_row = _width * GetBytesPerPixel();
+    for (uint32_t i = 0; i < _height / 2; ++i) {
+        std::vector<uint8_t>::iterator top = _pixels.begin() + i * bytes_per_row;
+        std::vector<uint8_t>::iterator bottom = _pixels.begin() + (_height - 1 - i) * bytes_per_row;
+        std::swap_ranges(top, top + bytes_per_row, bottom);
     }
-    std::swap(flipped, _pixels);
 }
 
 // -----------------------------------------------------------------------------
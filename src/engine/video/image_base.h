@@ -45,6 +45,7 @@
 
 #include <string>
 #include <vector>
+#include <utility>
 
 namespace vt_video
 {
@@ -91,6 +92,15 @@ public:
         return _rgb_format ? 3 : 4;
     }
 
+    //! \brief Returns the pixels, row after row, or nullptr when the image is empty.
+    uint8_t* GetPixels() {
+        return _pixels.empty() ? nullptr : &_pixels[0];
+    }
+
+    const uint8_t* GetPixels() const {
+        return _pixels.empty() ? nullptr : &_pixels[0];
+    }
+
     /** \brief Loads raw image data from a file and stores the data in the class members
     *** \param filename The name of the image file to load.
     *** \return True if the image was loaded successfully, false if it was not
@@ -157,6 +167,14 @@ public:
     //! \brief Flip the image pixels vertically.
     void VerticalFlip();
 
+    //! \brief Exchanges the image data with another image, without copying the pixels.
+    void Swap(ImageMemory& other) {
+        std::swap(_width, other._width);
+        std::swap(_height, other._height);
+        _pixels.swap(other._pixels);
+        std::swap(_rgb_format, other._rgb_format);
+    }
+
 private:
     //! \brief The width of the image data (in pixels)
     size_t _width;
@@ -297,7 +315,6 @@ public:
     ***    while "ROWS" is the total number of rows of elements in the multi image
     *** -# \<Ycol_COLS>: used for multi image elements. "col" is the column number of this particular element
     ***    while "COLS" is the total number of columns of elements in the multi image
-    *** -# \<G>: used to indicate that this image texture has been converted to grayscale mode
     ***
     *** \note Please remember to document new tags here when they are added
     **/
@@ -0,0 +1,293 @@
+////////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2016 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+////////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    image_batch.cpp
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Source file for the image batch class.
+*** ***************************************************************************/
+
+#include "image_batch.h"
+
+#include "image.h"
+#include "texture.h"
+#include "video.h"
+
+#include "engine/video/gl/gl_sprite_buffer.h"
+
+#include "utils/exception.h"
+
+#include <cassert>
+
+namespace vt_video
+{
+
+//! \brief The number of floats per image for each kind of vertex data.
+const uint32_t IMAGE_BATCH_POSITIONS = 4 * 3;
+const uint32_t IMAGE_BATCH_TEXTURE_COORDINATES = 4 * 2;
+const uint32_t IMAGE_BATCH_COLORS = 4 * 4;
+
+ImageBatch::ImageBatch() :
+    _texture_sheet(nullptr),
+    _smooth(false),
+    _blend(false),
+    _grayscale(false),
+    _dynamic(false),
+    _number_of_images(0),
+    _sprite_buffer(nullptr)
+{
+}
+
+ImageBatch::~ImageBatch()
+{
+    Clear();
+}
+
+bool ImageBatch::AddImage(const StillImage& image, float x, float y)
+{
+    // The batch can't grow once on the GPU.
+    if (_sprite_buffer)
+        return false;
+
+    if (!IsCompatible(image))
+        return false;
+
+    if (_number_of_images == 0) {
+        // The textures of the sheet must stay in place while the batch uses it.
+        _texture_sheet = image._texture->texture_sheet;
+        ++_texture_sheet->num_batches;
+        _smooth = image._smooth;
+        _blend = image._blend;
+        _grayscale = image._grayscale;
+    }
+
+    const Context& context = VideoManager->_current_context;
+    const float h_direction = context.coordinate_system.GetHorizontalDirection();
+    const float v_direction = context.coordinate_system.GetVerticalDirection();
+
+    // Place the image as ImageDescriptor::_DrawOrientation() would, minus the screen shaking
+    // which is applied when drawing the whole batch.
+    float origin_x = x + image._offset.x
+                     + ((context.x_align + 1) * image._width) * 0.5f * -h_direction;
+    float origin_y = y + image._offset.y
+                     + ((context.y_align + 1) * image._height) * 0.5f * -v_direction;
+    if (context.x_flip)
+        origin_x += image._width * h_direction;
+    if (context.y_flip)
+        origin_y += image._height * v_direction;
+
+    const float scale_x = h_direction < 0.0f ? -image._width : image._width;
+    const float scale_y = v_direction < 0.0f ? -image._height : image._height;
+
+    const float vertex_positions[] =
+    {
+        origin_x + image._u1 * scale_x, origin_y + image._v1 * scale_y, 0.0f, // Vertex One.
+        origin_x + image._u2 * scale_x, origin_y + image._v1 * scale_y, 0.0f, // Vertex Two.
+        origin_x + image._u2 * scale_x, origin_y + image._v2 * scale_y, 0.0f, // Vertex Three.
+        origin_x + image._u1 * scale_x, origin_y + image._v2 * scale_y, 0.0f  // Vertex Four.
+    };
+    _vertex_positions.insert(_vertex_positions.end(), vertex_positions, vertex_positions + IMAGE_BATCH_POSITIONS);
+
+    float vertex_texture_coordinates[IMAGE_BATCH_TEXTURE_COORDINATES];
+    _ComputeTextureCoordinates(image, vertex_texture_coordinates);
+    _vertex_texture_coordinates.insert(_vertex_texture_coordinates.end(), vertex_texture_coordinates,
+                                       vertex_texture_coordinates + IMAGE_BATCH_TEXTURE_COORDINATES);
+
+    const Color& color = image._color[0];
+    for (uint32_t i = 0; i < 4; ++i) {
+        _vertex_colors.push_back(color[0]);
+        _vertex_colors.push_back(color[1]);
+        _vertex_colors.push_back(color[2]);
+        _vertex_colors.push_back(color[3]);
+    }
+
+    ++_number_of_images;
+    return true;
+}
+
+bool ImageBatch::IsCompatible(const StillImage& image) const
+{
+    // Images being loaded have no texture sheet nor dimensions yet.
+    if (image.IsLoading() || !image._texture || !image._texture->texture_sheet || !image._unichrome_vertices)
+        return false;
+
+    // Any valid image can start a batch.
+    if (_number_of_images == 0)
+        return true;
+
+    return _texture_sheet == image._texture->texture_sheet
+           && _smooth == image._smooth && _blend == image._blend && _grayscale == image._grayscale;
+}
+
+bool ImageBatch::UpdateImage(uint32_t index, const StillImage& image)
+{
+    assert(index < _number_of_images);
+    if (index >= _number_of_images)
+        return false;
+
+    if (!IsCompatible(image))
+        return false;
+
+    // Static buffers can't be updated anymore.
+    if (_sprite_buffer && !_dynamic)
+        return false;
+
+    float* vertex_texture_coordinates = &_vertex_texture_coordinates[index * IMAGE_BATCH_TEXTURE_COORDINATES];
+    _ComputeTextureCoordinates(image, vertex_texture_coordinates);
+
+    if (_sprite_buffer)
+        _sprite_buffer->UpdateTextureCoordinates(index, vertex_texture_coordinates, 1);
+
+    return true;
+}
+
+void ImageBatch::Finalize(bool dynamic)
+{
+    if (_sprite_buffer || _number_of_images == 0)
+        return;
+
+    _dynamic = dynamic;
+    _sprite_buffer = new gl::SpriteBuffer(&_vertex_positions.front(),
+                                          &_vertex_texture_coordinates.front(),
+                                          &_vertex_colors.front(),
+                                          _number_of_images,
+                                          _dynamic);
+
+    // Only the texture coordinates are needed to update dynamic batches.
+    std::vector<float>().swap(_vertex_positions);
+    std::vector<float>().swap(_vertex_colors);
+    if (!_dynamic)
+        std::vector<float>().swap(_vertex_texture_coordinates);
+}
+
+void ImageBatch::Draw() const
+{
+    if (!_sprite_buffer || !_texture_sheet)
+        return;
+
+    const Context& context = VideoManager->_current_context;
+
+    // Set the blending parameters, as ImageDescriptor::_DrawTexture() does.
+    if (context.blend) {
+        VideoManager->EnableBlending();
+        if (context.blend == 1) {
+            VideoManager->SetBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); // Normal blending
+        } else {
+            VideoManager->SetBlendFunc(GL_SRC_ALPHA, GL_ONE); // Additive blending
+        }
+    } else if (_blend) {
+        VideoManager->EnableBlending();
+        VideoManager->SetBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); // Normal blending
+    } else {
+        VideoManager->DisableBlending();
+    }
+
+    // Enable texturing and bind the texture.
+    VideoManager->EnableTexture2D();
+    TextureManager->_BindTexSheet(_texture_sheet);
+    _texture_sheet->Smooth(_smooth);
+
+    VideoManager->PushMatrix();
+
+    if (VideoManager->IsScreenShaking()) {
+        // Calculate x and y draw offsets due to any screen shaking effects
+        float shake_x = VideoManager->_shake_offset.x
+                        * (context.coordinate_system.GetRight() - context.coordinate_system.GetLeft())
+                        / VIDEO_STANDARD_RES_WIDTH;
+        float shake_y = VideoManager->_shake_offset.y
+                        * (context.coordinate_system.GetTop() - context.coordinate_system.GetBottom())
+                        / VIDEO_STANDARD_RES_HEIGHT;
+        VideoManager->MoveRelative(shake_x * context.coordinate_system.GetHorizontalDirection(),
+                                   shake_y * context.coordinate_system.GetVerticalDirection());
+    }
+
+    gl::ShaderProgram* shader_program = VideoManager->LoadShaderProgram(_grayscale ?
+                                                                        gl::shader_programs::SpriteGrayscale :
+                                                                        gl::shader_programs::Sprite);
+    assert(shader_program != nullptr);
+
+    VideoManager->DrawSpriteBuffer(shader_program, _sprite_buffer);
+
+    VideoManager->UnloadShaderProgram();
+
+    VideoManager->PopMatrix();
+}
+
+void ImageBatch::Clear()
+{
+    if (_sprite_buffer) {
+        delete _sprite_buffer;
+        _sprite_buffer = nullptr;
+    }
+
+    _vertex_positions.clear();
+    _vertex_texture_coordinates.clear();
+    _vertex_colors.clear();
+
+    if (_texture_sheet)
+        --_texture_sheet->num_batches;
+    _texture_sheet = nullptr;
+    _smooth = false;
+    _blend = false;
+    _grayscale = false;
+    _dynamic = false;
+    _number_of_images = 0;
+}
+
+void ImageBatch::_ComputeTextureCoordinates(const StillImage& image, float* vertex_texture_coordinates)
+{
+    assert(image._texture != nullptr);
+    const private_video::BaseTexture* texture = image._texture;
+
+    float s0 = texture->u1 + (image._u1 * (texture->u2 - texture->u1));
+    float s1 = texture->u1 + (image._u2 * (texture->u2 - texture->u1));
+    float t0 = texture->v1 + (image._v1 * (texture->v2 - texture->v1));
+    float t1 = texture->v1 + (image._v2 * (texture->v2 - texture->v1));
+
+    // Swap the texture coordinates when flipping is enabled.
+    if (VideoManager->_current_context.x_flip) {
+        float temp = s0;
+        s0 = s1;
+        s1 = temp;
+    }
+    if (VideoManager->_current_context.y_flip) {
+        float temp = t0;
+        t0 = t1;
+        t1 = temp;
+    }
+
+    // Vertex One.
+    vertex_texture_coordinates[0] = s0;
+    vertex_texture_coordinates[1] = t1;
+
+    // Vertex Two.
+    vertex_texture_coordinates[2] = s1;
+    vertex_texture_coordinates[3] = t1;
+
+    // Vertex Three.
+    vertex_texture_coordinates[4] = s1;
+    vertex_texture_coordinates[5] = t0;
+
+    // Vertex Four.
+    vertex_texture_coordinates[6] = s0;
+    vertex_texture_coordinates[7] = t0;
+}
+
+ImageBatch::ImageBatch(const ImageBatch&)
+{
+    throw vt_utils::Exception("Not Implemented!", __FILE__, __LINE__, __FUNCTION__);
+}
+
+ImageBatch& ImageBatch::operator=(const ImageBatch&)
+{
+    throw vt_utils::Exception("Not Implemented!", __FILE__, __LINE__, __FUNCTION__);
+    return *this;
+}
+
+} // namespace vt_video
@@ -0,0 +1,127 @@
+////////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2016 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+////////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    image_batch.h
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Header file for the image batch class.
+***
+*** An image batch stores the quads of many still images sharing the same
+*** texture sheet at fixed positions in GPU memory, so that they can all be
+*** drawn using a single draw call. It is meant for content that doesn't move,
+*** such as the map tiles.
+*** ***************************************************************************/
+
+#ifndef __IMAGE_BATCH_HEADER__
+#define __IMAGE_BATCH_HEADER__
+
+#include <vector>
+#include <cstdint>
+
+namespace vt_video
+{
+
+class StillImage;
+
+namespace gl
+{
+class SpriteBuffer;
+}
+
+namespace private_video
+{
+class TexSheet;
+}
+
+class ImageBatch
+{
+public:
+    ImageBatch();
+    ~ImageBatch();
+
+    /** \brief Adds a still image to the batch.
+    *** \param image The image to add.
+    *** \param x The x position of the draw cursor the image would be drawn at, relative to the batch origin.
+    *** \param y The y position of the draw cursor the image would be drawn at, relative to the batch origin.
+    *** The image is placed as StillImage::Draw() would do, using the current draw flags
+    *** and coordinate system.
+    *** \return false if the image can't be part of the batch: the batch is already finalized,
+    *** or the image is still loading, has no texture, has non-unichrome vertices or uses another texture sheet,
+    *** smoothing or blending mode than the previous images.
+    **/
+    bool AddImage(const StillImage& image, float x, float y);
+
+    /** \brief Tells whether the image could be added to the batch,
+    *** or used to update one of the batch images.
+    **/
+    bool IsCompatible(const StillImage& image) const;
+
+    /** \brief Replaces the texture part used by an already added image.
+    *** Used to display the current frame of an animation.
+    *** \param index The index of the image in the batch, in insertion order.
+    *** \param image The image to take the texture part from.
+    *** \return false if the image isn't compatible with the batch.
+    *** \note Once finalized, only dynamic batches can be updated.
+    **/
+    bool UpdateImage(uint32_t index, const StillImage& image);
+
+    /** \brief Sends the images to the GPU. Must be called once all the images have been added.
+    *** \param dynamic Whether UpdateImage() will be called after finalizing the batch.
+    **/
+    void Finalize(bool dynamic = false);
+
+    //! \brief Draws the batch images using the current draw cursor as the batch origin.
+    void Draw() const;
+
+    //! \brief Removes every image and frees the GPU memory.
+    void Clear();
+
+    uint32_t GetNumberOfImages() const {
+        return _number_of_images;
+    }
+
+    bool IsEmpty() const {
+        return _number_of_images == 0;
+    }
+
+private:
+    //! \brief The copy constructor and assignment operator are hidden by design
+    //! to cause compilation errors when attempting to copy or assign this class.
+    ImageBatch(const ImageBatch& image_batch);
+    ImageBatch& operator=(const ImageBatch& image_batch);
+
+    //! \brief The texture sheet shared by every image of the batch.
+    private_video::TexSheet* _texture_sheet;
+
+    //! \brief The smoothing, blending and grayscale modes shared by every image of the batch.
+    bool _smooth;
+    bool _blend;
+    bool _grayscale;
+
+    //! \brief Whether the texture coordinates can be updated once finalized.
+    bool _dynamic;
+
+    //! \brief The number of images in the batch.
+    uint32_t _number_of_images;
+
+    //! \brief The vertex data, kept in memory until the batch is finalized.
+    std::vector<float> _vertex_positions;
+    std::vector<float> _vertex_texture_coordinates;
+    std::vector<float> _vertex_colors;
+
+    //! \brief The GPU buffers, once finalized.
+    gl::SpriteBuffer* _sprite_buffer;
+
+    //! \brief Computes the texture coordinates of the image 4 vertices, as ImageDescriptor::_DrawTexture() does.
+    static void _ComputeTextureCoordinates(const StillImage& image, float* vertex_texture_coordinates);
+};
+
+} // namespace vt_video
+
+#endif // __IMAGE_BATCH_HEADER__
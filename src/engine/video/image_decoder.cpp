@@ -0,0 +1,86 @@
+////////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2016 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+////////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    image_decoder.cpp
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Source file for the image decoding worker threads.
+*** ***************************************************************************/
+
+#include "image_decoder.h"
+
+#include "video.h"
+
+#include "utils/exception.h"
+
+namespace vt_video
+{
+
+namespace private_video
+{
+
+ImageDecoder::ImageDecoder() :
+    _worker_pool(vt_system::SystemManager->GetWorkerPool())
+{
+}
+
+ImageDecoder::~ImageDecoder()
+{
+    _worker_pool->RemoveJobs(this);
+
+    for(uint32_t i = 0; i < _done_jobs.size(); ++i)
+        delete _done_jobs[i];
+}
+
+void ImageDecoder::RequestImage(const std::string& filename)
+{
+    if(!_requested_filenames.insert(filename).second)
+        return;
+
+    DecodeJob* job = new DecodeJob();
+    job->filename = filename;
+    _worker_pool->QueueJob(this, job);
+}
+
+bool ImageDecoder::TakeDecodedImage(std::string& filename, ImageMemory& image)
+{
+    if(_done_jobs.empty()) {
+        std::vector<vt_system::WorkerJob*> jobs;
+        _worker_pool->TakeDoneJobs(this, jobs);
+        for(uint32_t i = 0; i < jobs.size(); ++i)
+            _done_jobs.push_back(static_cast<DecodeJob*>(jobs[i]));
+    }
+
+    if(_done_jobs.empty())
+        return false;
+
+    DecodeJob* job = _done_jobs.front();
+    _done_jobs.pop_front();
+
+    filename = job->filename;
+    image.Swap(job->image);
+    _requested_filenames.erase(job->filename);
+    delete job;
+    return true;
+}
+
+ImageDecoder::ImageDecoder(const ImageDecoder&)
+{
+    throw vt_utils::Exception("Not Implemented!", __FILE__, __LINE__, __FUNCTION__);
+}
+
+ImageDecoder& ImageDecoder::operator=(const ImageDecoder&)
+{
+    throw vt_utils::Exception("Not Implemented!", __FILE__, __LINE__, __FUNCTION__);
+    return *this;
+}
+
+} // namespace private_video
+
+} // namespace vt_video
@@ -0,0 +1,97 @@
+////////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2016 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+////////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    image_decoder.h
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Header file for the image decoding worker threads.
+***
+*** The image files requested by StillImage::LoadAsync() are read, decoded and
+*** converted by the worker threads of the system engine. The decoded images are then uploaded
+*** to the texture sheets by the texture controller on the main thread, as the
+*** OpenGL context can only be used from there.
+*** ***************************************************************************/
+
+#ifndef __IMAGE_DECODER_HEADER__
+#define __IMAGE_DECODER_HEADER__
+
+#include "image_base.h"
+
+#include "engine/system.h"
+
+#include <deque>
+#include <set>
+
+namespace vt_video
+{
+
+namespace private_video
+{
+
+/** ****************************************************************************
+*** \brief Decodes image files on the worker threads.
+***
+*** Every method must be called from the main thread. When no worker thread
+*** could be started, the images are decoded when requested instead.
+*** ***************************************************************************/
+class ImageDecoder
+{
+public:
+    ImageDecoder();
+
+    ~ImageDecoder();
+
+    //! \brief Queues the decoding of the given image file, unless it is already queued.
+    void RequestImage(const std::string& filename);
+
+    /** \brief Takes an image decoded by the worker threads.
+    *** \param filename Set to the filename of the image.
+    *** \param image Receives the decoded image, left empty if the decoding failed.
+    *** \return false if no image is decoded yet.
+    **/
+    bool TakeDecodedImage(std::string& filename, ImageMemory& image);
+
+    //! \brief Returns the number of image files requested and not taken yet.
+    uint32_t GetNumRequestedImages() const {
+        return _requested_filenames.size();
+    }
+
+private:
+    //! \brief The copy constructor and assignment operator are hidden by design
+    //! to cause compilation errors when attempting to copy or assign this class.
+    ImageDecoder(const ImageDecoder& decoder);
+    ImageDecoder& operator=(const ImageDecoder& decoder);
+
+    //! \brief An image file to decode, and its result.
+    class DecodeJob : public vt_system::WorkerJob
+    {
+    public:
+        void Run() {
+            image.LoadImage(filename);
+        }
+
+        std::string filename;
+        ImageMemory image;
+    };
+
+    //! \brief The worker threads the images are decoded on.
+    vt_system::WorkerPool* _worker_pool;
+
+    //! \brief The jobs given back by the worker threads, and not taken yet.
+    std::deque<DecodeJob*> _done_jobs;
+
+    //! \brief The image files requested and not taken yet.
+    std::set<std::string> _requested_filenames;
+};
+
+} // namespace private_video
+
+} // namespace vt_video
+
+#endif // __IMAGE_DECODER_HEADER__
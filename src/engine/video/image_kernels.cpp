@@ -0,0 +1,118 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2016 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See https://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    image_kernels.cpp
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Source file for the image pixel conversion kernels
+*** ***************************************************************************/
+
+#include "image_kernels.h"
+
+// SSE2 is always there on x86-64. The instruction set is chosen at compile time only,
+// as newer ones would need a runtime check of the CPU.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define IMAGE_KERNELS_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace vt_video
+{
+
+namespace private_video
+{
+
+void ConvertARGBRow(const uint8_t *src, uint8_t *dst, size_t num_pixels, bool swap_red_blue)
+{
+    size_t i = 0;
+
+#if defined(IMAGE_KERNELS_SSE2)
+    const __m128i red_blue_mask = _mm_set1_epi32(0x00FF00FF);
+    const __m128i zero = _mm_setzero_si128();
+    for(; i + 4 <= num_pixels; i += 4) {
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 4));
+        if(swap_red_blue) {
+            __m128i red_blue = _mm_and_si128(pixels, red_blue_mask);
+            red_blue = _mm_or_si128(_mm_slli_epi32(red_blue, 16), _mm_srli_epi32(red_blue, 16));
+            pixels = _mm_or_si128(_mm_andnot_si128(red_blue_mask, pixels), red_blue);
+        }
+
+        // The alpha is the highest byte of each pixel
+        __m128i transparent = _mm_cmpeq_epi32(_mm_srli_epi32(pixels, 24), zero);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 4), _mm_andnot_si128(transparent, pixels));
+    }
+#endif
+
+    for(; i < num_pixels; ++i) {
+        const uint8_t *src_pixel = src + i * 4;
+        uint8_t *dst_pixel = dst + i * 4;
+        if(src_pixel[3] == 0) {
+            dst_pixel[0] = dst_pixel[1] = dst_pixel[2] = dst_pixel[3] = 0;
+            continue;
+        }
+
+        dst_pixel[0] = src_pixel[swap_red_blue ? 2 : 0];
+        dst_pixel[1] = src_pixel[1];
+        dst_pixel[2] = src_pixel[swap_red_blue ? 0 : 2];
+        dst_pixel[3] = src_pixel[3];
+    }
+}
+
+void ConvertPixelsToGrayscale(uint8_t *pixels, size_t num_pixels, uint32_t bytes_per_pixel)
+{
+    size_t i = 0;
+
+#if defined(IMAGE_KERNELS_SSE2)
+    if(bytes_per_pixel == 4) {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i weights = _mm_setr_epi16(30, 59, 11, 0, 30, 59, 11, 0);
+        // x / 100 is (x * 5243) >> 19 for every x up to 100 * 255
+        const __m128i divisor = _mm_set1_epi32(5243);
+        const __m128i alpha_mask = _mm_set1_epi32(static_cast<int32_t>(0xFF000000));
+        for(; i + 4 <= num_pixels; i += 4) {
+            __m128i rgba = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pixels + i * 4));
+
+            // Gives the weighted red plus green, and the weighted blue, of each pixel
+            __m128 low = _mm_castsi128_ps(_mm_madd_epi16(_mm_unpacklo_epi8(rgba, zero), weights));
+            __m128 high = _mm_castsi128_ps(_mm_madd_epi16(_mm_unpackhi_epi8(rgba, zero), weights));
+            __m128i sum = _mm_add_epi32(_mm_castps_si128(_mm_shuffle_ps(low, high, _MM_SHUFFLE(2, 0, 2, 0))),
+                                        _mm_castps_si128(_mm_shuffle_ps(low, high, _MM_SHUFFLE(3, 1, 3, 1))));
+
+            __m128i gray = _mm_srli_epi32(_mm_mulhi_epu16(sum, divisor), 3);
+            gray = _mm_or_si128(gray, _mm_or_si128(_mm_slli_epi32(gray, 8), _mm_slli_epi32(gray, 16)));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(pixels + i * 4),
+                             _mm_or_si128(gray, _mm_and_si128(rgba, alpha_mask)));
+        }
+    }
+#endif
+
+    for(; i < num_pixels; ++i) {
+        uint8_t *pixel = pixels + i * bytes_per_pixel;
+        uint32_t sum = (30 * pixel[0]) + (59 * pixel[1]) + (11 * pixel[2]);
+        uint8_t value = static_cast<uint8_t>(sum / 100);
+
+        pixel[0] = value;
+        pixel[1] = value;
+        pixel[2] = value;
+        // pixel[3] for RGBA is the alpha value and is left unmodified.
+    }
+}
+
+const char *GetImageKernelsName()
+{
+#if defined(IMAGE_KERNELS_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+} // namespace private_video
+
+} // namespace vt_video
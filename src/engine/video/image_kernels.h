@@ -0,0 +1,59 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2016 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See https://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    image_kernels.h
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Header file for the image pixel conversion kernels
+***
+*** The pixel loops run when loading images. They use SSE2 when the compiler
+*** targets it, as on every x86-64 CPU, and plain loops otherwise. They don't
+*** depend on the rest of the engine, so that they can be tested on their own.
+*** ***************************************************************************/
+
+#ifndef __IMAGE_KERNELS_HEADER__
+#define __IMAGE_KERNELS_HEADER__
+
+#include <cstddef>
+#include <cstdint>
+
+namespace vt_video
+{
+
+namespace private_video
+{
+
+/** \brief Converts a row of ARGB8888 pixels to RGBA, and makes the fully transparent pixels black
+*** \param src The source pixels, 4 bytes each
+*** \param dst The converted pixels, which may not overlap the source ones
+*** \param num_pixels The number of pixels in the row
+*** \param swap_red_blue Whether the red and blue bytes are in reverse order in memory, depending on the byte order
+***
+*** The transparent pixels are made black to prevent OpenGL from averaging their color
+*** with the other pixels when smoothing, which gives white edges around sprites.
+**/
+void ConvertARGBRow(const uint8_t *src, uint8_t *dst, size_t num_pixels, bool swap_red_blue);
+
+/** \brief Converts pixels to grayscale, keeping their alpha
+*** \param pixels The RGB or RGBA pixels to convert
+*** \param num_pixels The number of pixels
+*** \param bytes_per_pixel 3 for RGB pixels, 4 for RGBA ones
+***
+*** The gray level is (30 * red + 59 * green + 11 * blue) / 100.
+**/
+void ConvertPixelsToGrayscale(uint8_t *pixels, size_t num_pixels, uint32_t bytes_per_pixel);
+
+//! \brief Returns the instruction set the kernels were compiled for, "SSE2" or "scalar".
+const char *GetImageKernelsName();
+
+} // namespace private_video
+
+} // namespace vt_video
+
+#endif // __IMAGE_KERNELS_HEADER__
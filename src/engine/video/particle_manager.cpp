@@ -63,6 +63,9 @@ void ParticleManager::Draw() const
 
     std::vector<ParticleEffect *>::const_iterator it = _active_effects.begin();
 
+    // The pending sprites must be drawn before clearing the stencil buffer.
+    VideoManager->FlushSpriteBatch();
+
     glClearStencil(0);
     glClear(GL_STENCIL_BUFFER_BIT);
 
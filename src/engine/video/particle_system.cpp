@@ -81,40 +81,41 @@ void ParticleSystem::Draw()
         VideoManager->EnableBlending();
 
         if (_system_def->blend_mode == VIDEO_BLEND)
-            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            VideoManager->SetBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
         else
-            glBlendFunc(GL_SRC_ALPHA, GL_ONE); // Additive.
+            VideoManager->SetBlendFunc(GL_SRC_ALPHA, GL_ONE); // Additive.
     }
 
     if (_system_def->use_stencil) {
         VideoManager->EnableStencilTest();
-        glStencilFunc(GL_EQUAL, 1, 0xFFFFFFFF);
-        glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+        VideoManager->SetStencilFunc(GL_EQUAL, 1, 0xFFFFFFFF);
+        VideoManager->SetStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
     } else if (_system_def->modify_stencil) {
         VideoManager->EnableStencilTest();
 
         if (_system_def->stencil_op == VIDEO_STENCIL_OP_INCREASE)
-            glStencilOp(GL_INCR, GL_KEEP, GL_KEEP);
+            VideoManager->SetStencilOp(GL_INCR, GL_KEEP, GL_KEEP);
         else if (_system_def->stencil_op == VIDEO_STENCIL_OP_DECREASE)
-            glStencilOp(GL_DECR, GL_KEEP, GL_KEEP);
+            VideoManager->SetStencilOp(GL_DECR, GL_KEEP, GL_KEEP);
         else if (_system_def->stencil_op == VIDEO_STENCIL_OP_ZERO)
-            glStencilOp(GL_ZERO, GL_KEEP, GL_KEEP);
+            VideoManager->SetStencilOp(GL_ZERO, GL_KEEP, GL_KEEP);
         else
-            glStencilOp(GL_REPLACE, GL_KEEP, GL_KEEP);
+            VideoManager->SetStencilOp(GL_REPLACE, GL_KEEP, GL_KEEP);
 
-        glStencilFunc(GL_NEVER, 1, 0xFFFFFFFF);
+        VideoManager->SetStencilFunc(GL_NEVER, 1, 0xFFFFFFFF);
     } else {
         VideoManager->DisableStencilTest();
     }
 
     VideoManager->EnableTexture2D();
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
     StillImage* id = _animation.GetFrame(_animation.GetCurrentFrameIndex());
     private_video::ImageTexture* img = id->_image_texture;
-    TextureManager->_BindTexture(img->texture_sheet->tex_id);
+    TextureManager->_BindTexSheet(img->texture_sheet);
+
+    // Particles are always drawn smoothed. Going through the texture sheet
+    // keeps its cached filtering state up to date.
+    img->texture_sheet->Smooth(true);
 
     float frame_progress = _animation.GetPercentProgress();
 
@@ -282,7 +283,7 @@ void ParticleSystem::Draw()
 
         StillImage *id2 = _animation.GetFrame(findex);
         private_video::ImageTexture *img2 = id2->_image_texture;
-        TextureManager->_BindTexture(img2->texture_sheet->tex_id);
+        TextureManager->_BindTexSheet(img2->texture_sheet);
 
         u1 = img2->u1;
         u2 = img2->u2;
@@ -49,6 +49,12 @@ public:
     void Set(int32_t l, int32_t t, int32_t w, int32_t h)
     { left = l; top = t; width = w; height = h; }
 
+    bool operator==(const ScreenRect& rect) const
+    { return left == rect.left && top == rect.top && width == rect.width && height == rect.height; }
+
+    bool operator!=(const ScreenRect& rect) const
+    { return !(*this == rect); }
+
 
     /** \brief Modifies the rectangle coordinates to be an intersection of itself with another rectangle
     *** \param rect The rectangle to intersect this rectangle with
@@ -24,6 +24,7 @@
 
 #include "text.h"
 #include "video.h"
+#include "glyph_atlas.h"
 
 #include "script/script_read.h"
 #include "engine/system.h"
@@ -59,7 +60,8 @@ FontProperties::FontProperties() :
     ascent(0),
     descent(0),
     ttf_font(nullptr),
-    font_size(0)
+    font_size(0),
+    glyph_atlas(nullptr)
 {
 }
 
@@ -70,6 +72,12 @@ FontProperties::~FontProperties()
 
 void FontProperties::ClearFont()
 {
+    // Free the glyphs rendered using the font.
+    if (glyph_atlas)
+        delete glyph_atlas;
+
+    glyph_atlas = nullptr;
+
     // Free the font.
     if (ttf_font)
         TTF_CloseFont(ttf_font);
@@ -546,27 +554,12 @@ void TextImage::_Regenerate()
 // TextSupervisor class
 // -----------------------------------------------------------------------------
 
-TextSupervisor::TextSupervisor() :
-    _text_texture(0),
-    _text_texture_width(0),
-    _text_texture_height(0)
+TextSupervisor::TextSupervisor()
 {
-    glGenTextures(1, &_text_texture);
-    if (_text_texture == 0) {
-        IF_PRINT_WARNING(VIDEO_DEBUG) << "call to glGenTextures() failed" << std::endl;
-        assert(_text_texture != 0);
-    }
 }
 
 TextSupervisor::~TextSupervisor()
 {
-    // Clean up the text texture.
-    if (_text_texture != 0) {
-        GLuint textures[] = { _text_texture };
-        glDeleteTextures(1, textures);
-        _text_texture = 0;
-    }
-
     // Remove all loaded fonts.  Then, shutdown the SDL_ttf library.
     for (auto it = _font_map.begin(); it != _font_map.end(); ++it)
         delete it->second;
@@ -716,6 +709,13 @@ bool TextSupervisor::LoadFonts(const std::string& locale_name)
 
     font_script.CloseFile();
 
+    // The characters in use may have changed along with the locale,
+    // so the glyph atlases are started over.
+    for (auto it = _font_map.begin(); it != _font_map.end(); ++it) {
+        if (it->second->glyph_atlas)
+            it->second->glyph_atlas->Clear();
+    }
+
     // Setup the default font
     SetDefaultStyle(TextStyle(style_default, Color::white, VIDEO_TEXT_SHADOW_BLACK, 1, -2));
     return true;
@@ -773,6 +773,7 @@ bool TextSupervisor::_LoadFont(const std::string& textstyle_name,
     fp->line_skip = TTF_FontLineSkip(font);
     fp->ascent = TTF_FontAscent(font);
     fp->descent = TTF_FontDescent(font);
+    fp->glyph_atlas = new GlyphAtlas(font);
 
     // If the text style is new, we add it to the font cache map
     if (!reload)
@@ -1027,123 +1028,49 @@ void TextSupervisor::_RenderText(const uint16_t* text, FontProperties* font_prop
         return;
     }
 
-    if (font_properties == nullptr || font_properties->ttf_font == nullptr) {
+    if (font_properties == nullptr || font_properties->ttf_font == nullptr || font_properties->glyph_atlas == nullptr) {
         IF_PRINT_WARNING(VIDEO_DEBUG) << "invalid argument, nullptr font properties or nullptr ttf font" << std::endl;
         assert(font_properties != nullptr && font_properties->ttf_font != nullptr);
         return;
     }
 
-    // Render the text.
-    const SDL_Color white = { 255, 255, 255, 255 };
-    SDL_Surface* surface = TTF_RenderUNICODE_Blended(font_properties->ttf_font, text, white);
-    if (surface == nullptr) {
-        IF_PRINT_WARNING(VIDEO_DEBUG) << "call to TTF_RenderUNICODE_Blended() failed" << std::endl;
-        assert(surface != nullptr);
-        return;
-    }
-
     // Retrieve the size of the text.
     int32_t font_width = 0, font_height = 0;
     if (TTF_SizeUNICODE(font_properties->ttf_font, text, &font_width, &font_height) != 0) {
         IF_PRINT_WARNING(VIDEO_DEBUG) << "call to TTF_SizeUNICODE() failed" << std::endl;
-        SDL_FreeSurface(surface);
         assert(false);
         return;
     }
 
-    // Enable texturing.
-    VideoManager->EnableTexture2D();
-
-    // Bind the OpenGL texture.
-    TextureManager->_BindTexture(_text_texture);
-
-    // Lock the SDL surface.
-    SDL_LockSurface(surface);
-
-    //
-    // Send the surface pixel data to OpenGL.
-    //
-
-    if (_text_texture_width == static_cast<GLuint>(surface->w) &&
-        _text_texture_height == static_cast<GLuint>(surface->h)) {
-        // The size of the old texture is the same.  Just update the pixel data.
-        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, _text_texture_width, _text_texture_height, GL_RGBA, GL_UNSIGNED_BYTE, surface->pixels);
-    } else {
-        // The size of the old texture is different.  Update the storage definition as well as the pixel data.
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, surface->w, surface->h, 0, GL_RGBA, GL_UNSIGNED_BYTE, surface->pixels);
-    }
+    // Render the glyphs not used yet before drawing anything.
+    GlyphAtlas* glyph_atlas = font_properties->glyph_atlas;
+    for (const uint16_t* character = text; *character != 0; ++character)
+        glyph_atlas->GetGlyph(*character);
 
-    // Update the texture's width and height.
-    _text_texture_width = surface->w;
-    _text_texture_height = surface->h;
+    if (glyph_atlas->GetTextureId() == 0)
+        return;
 
-    // Unlock the SDL surface.
-    SDL_UnlockSurface(surface);
+    // Enable texturing.
+    VideoManager->EnableTexture2D();
 
-    // Update some of the OpenGL texture parameters.
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    // Bind the glyph atlas texture.
+    TextureManager->_BindTexture(glyph_atlas->GetTextureId());
 
     // Enable blending.
     VideoManager->EnableBlending();
 
     // Update the blending function.
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-    // Push the matrix stack.
-    VideoManager->PushMatrix();
-
-    // Update the transmation matrix.
-    CoordSys& coordinate_system = VideoManager->_current_context.coordinate_system;
-    float x_offset = ((VideoManager->_current_context.x_align + 1) * font_width) * 0.5f * -coordinate_system.GetHorizontalDirection();
-    float y_offset = ((VideoManager->_current_context.y_align + 1) * font_height) * 0.5f * -coordinate_system.GetVerticalDirection();
-    VideoManager->MoveRelative(x_offset, y_offset);
+    VideoManager->SetBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     // Load the shader program.
     gl::ShaderProgram* shader_program = VideoManager->LoadShaderProgram(gl::shader_programs::Sprite);
     assert(shader_program != nullptr);
 
-    // The vertex positions.
-    float vertex_positions[] =
-    {
-        0.0f,                           0.0f,                            0.0f, // Vertex One.
-        static_cast<float>(font_width), 0.0f,                            0.0f, // Vertex Two.
-        static_cast<float>(font_width), static_cast<float>(font_height), 0.0f, // Vertex Three.
-        0.0f,                           static_cast<float>(font_height), 0.0f  // Vertex Four.
-    };
-
-    // The vertex texture coordinates.
-    float vertex_texture_coordinates[] =
-    {
-        0.0f, 0.0f, // Vertex One.
-        1.0f, 0.0f, // Vertex Two.
-        1.0f, 1.0f, // Vertex Three.
-        0.0f, 1.0f  // Vertex Four.
-    };
-
-    // The vertex colors.
-    float vertex_colors[] =
-    {
-        1.0f, 1.0f, 1.0f, 1.0f, // Vertex One.
-        1.0f, 1.0f, 1.0f, 1.0f, // Vertex Two.
-        1.0f, 1.0f, 1.0f, 1.0f, // Vertex Three.
-        1.0f, 1.0f, 1.0f, 1.0f  // Vertex Four.
-    };
-
     // Draw the text.
-    VideoManager->DrawSprite(shader_program, vertex_positions, vertex_texture_coordinates, vertex_colors, color);
+    _DrawGlyphs(text, font_properties, font_width, font_height, shader_program, color);
 
     // Unload the shader program.
     VideoManager->UnloadShaderProgram();
-
-    // Restore the transformation stack.
-    VideoManager->PopMatrix();
-
-    // Clean up.
-    if (surface != nullptr) {
-        SDL_FreeSurface(surface);
-        surface = nullptr;
-    }
 }
 
 void TextSupervisor::_RenderText(const uint16_t* text, FontProperties* font_properties,
@@ -1157,68 +1084,43 @@ void TextSupervisor::_RenderText(const uint16_t* text, FontProperties* font_prop
         return;
     }
 
-    if (font_properties == nullptr || font_properties->ttf_font == nullptr) {
+    if (font_properties == nullptr || font_properties->ttf_font == nullptr || font_properties->glyph_atlas == nullptr) {
         IF_PRINT_WARNING(VIDEO_DEBUG) << "invalid argument, nullptr font properties or nullptr ttf font" << std::endl;
         assert(font_properties != nullptr && font_properties->ttf_font != nullptr);
         return;
     }
 
-    // Render the text.
-    const SDL_Color white = { 255, 255, 255, 255 };
-    SDL_Surface* surface = TTF_RenderUNICODE_Blended(font_properties->ttf_font, text, white);
-    if (surface == nullptr) {
-        IF_PRINT_WARNING(VIDEO_DEBUG) << "call to TTF_RenderUNICODE_Blended() failed" << std::endl;
-        assert(surface != nullptr);
-        return;
-    }
-
     // Retrieve the size of the text.
     int32_t font_width = 0, font_height = 0;
     if (TTF_SizeUNICODE(font_properties->ttf_font, text, &font_width, &font_height) != 0) {
         IF_PRINT_WARNING(VIDEO_DEBUG) << "call to TTF_SizeUNICODE() failed" << std::endl;
-        SDL_FreeSurface(surface);
         assert(false);
         return;
     }
 
-    // Enable texturing.
-    VideoManager->EnableTexture2D();
-
-    // Bind the OpenGL texture.
-    TextureManager->_BindTexture(_text_texture);
-
-    // Lock the SDL surface.
-    SDL_LockSurface(surface);
-
-    //
-    // Send the surface pixel data to OpenGL.
-    //
-
-    if (_text_texture_width == static_cast<GLuint>(surface->w) &&
-        _text_texture_height == static_cast<GLuint>(surface->h)) {
-        // The size of the old texture is the same.  Just update the pixel data.
-        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, _text_texture_width, _text_texture_height, GL_RGBA, GL_UNSIGNED_BYTE, surface->pixels);
-    } else {
-        // The size of the old texture is different.  Update the storage definition as well as the pixel data.
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, surface->w, surface->h, 0, GL_RGBA, GL_UNSIGNED_BYTE, surface->pixels);
-    }
+    // Render the glyphs not used yet before drawing anything.
+    GlyphAtlas* glyph_atlas = font_properties->glyph_atlas;
+    for (const uint16_t* character = text; *character != 0; ++character)
+        glyph_atlas->GetGlyph(*character);
 
-    // Update the texture's width and height.
-    _text_texture_width = surface->w;
-    _text_texture_height = surface->h;
+    if (glyph_atlas->GetTextureId() == 0)
+        return;
 
-    // Unlock the SDL surface.
-    SDL_UnlockSurface(surface);
+    // Enable texturing.
+    VideoManager->EnableTexture2D();
 
-    // Update some of the OpenGL texture parameters.
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    // Bind the glyph atlas texture.
+    TextureManager->_BindTexture(glyph_atlas->GetTextureId());
 
     // Enable blending.
     VideoManager->EnableBlending();
 
     // Update the blending function.
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    VideoManager->SetBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    // Load the shader program.
+    gl::ShaderProgram* shader_program = VideoManager->LoadShaderProgram(gl::shader_programs::Sprite);
+    assert(shader_program != nullptr);
 
     //
     // Draw the shadow first.
@@ -1232,45 +1134,8 @@ void TextSupervisor::_RenderText(const uint16_t* text, FontProperties* font_prop
     const float delta_y = VideoManager->_current_context.coordinate_system.GetVerticalDirection() * shadow_offset_y;
     VideoManager->MoveRelative(delta_x, delta_y);
 
-    // Update the transmation matrix.
-    CoordSys& coordinate_system = VideoManager->_current_context.coordinate_system;
-    float x_offset = ((VideoManager->_current_context.x_align + 1) * font_width) * 0.5f * -coordinate_system.GetHorizontalDirection();
-    float y_offset = ((VideoManager->_current_context.y_align + 1) * font_height) * 0.5f * -coordinate_system.GetVerticalDirection();
-    VideoManager->MoveRelative(x_offset, y_offset);
-
-    // Load the shader program.
-    gl::ShaderProgram* shader_program = VideoManager->LoadShaderProgram(gl::shader_programs::Sprite);
-    assert(shader_program != nullptr);
-
-    // The vertex positions.
-    float vertex_positions[] =
-    {
-        0.0f,                           0.0f,                            0.0f, // Vertex One.
-        static_cast<float>(font_width), 0.0f,                            0.0f, // Vertex Two.
-        static_cast<float>(font_width), static_cast<float>(font_height), 0.0f, // Vertex Three.
-        0.0f,                           static_cast<float>(font_height), 0.0f  // Vertex Four.
-    };
-
-    // The vertex texture coordinates.
-    float vertex_texture_coordinates[] =
-    {
-        0.0f, 0.0f, // Vertex One.
-        1.0f, 0.0f, // Vertex Two.
-        1.0f, 1.0f, // Vertex Three.
-        0.0f, 1.0f  // Vertex Four.
-    };
-
-    // The vertex colors.
-    float vertex_colors[] =
-    {
-        1.0f, 1.0f, 1.0f, 1.0f, // Vertex One.
-        1.0f, 1.0f, 1.0f, 1.0f, // Vertex Two.
-        1.0f, 1.0f, 1.0f, 1.0f, // Vertex Three.
-        1.0f, 1.0f, 1.0f, 1.0f  // Vertex Four.
-    };
-
     // Draw the shadow.
-    VideoManager->DrawSprite(shader_program, vertex_positions, vertex_texture_coordinates, vertex_colors, color_shadow);
+    _DrawGlyphs(text, font_properties, font_width, font_height, shader_program, color_shadow);
 
     // Restore the transformation stack.
     VideoManager->PopMatrix();
@@ -1279,26 +1144,89 @@ void TextSupervisor::_RenderText(const uint16_t* text, FontProperties* font_prop
     // Draw the text second.
     //
 
-    // Push the transformation stack.
+    _DrawGlyphs(text, font_properties, font_width, font_height, shader_program, color);
+
+    // Unload the shader program.
+    VideoManager->UnloadShaderProgram();
+}
+
+void TextSupervisor::_DrawGlyphs(const uint16_t* text, FontProperties* font_properties,
+                                 int32_t text_width, int32_t text_height,
+                                 gl::ShaderProgram* shader_program,
+                                 const Color& color)
+{
+    GlyphAtlas* glyph_atlas = font_properties->glyph_atlas;
+
+    // Push the matrix stack.
     VideoManager->PushMatrix();
 
     // Update the transmation matrix.
+    CoordSys& coordinate_system = VideoManager->_current_context.coordinate_system;
+    float x_offset = ((VideoManager->_current_context.x_align + 1) * text_width) * 0.5f * -coordinate_system.GetHorizontalDirection();
+    float y_offset = ((VideoManager->_current_context.y_align + 1) * text_height) * 0.5f * -coordinate_system.GetVerticalDirection();
     VideoManager->MoveRelative(x_offset, y_offset);
 
-    // Draw the text.
-    VideoManager->DrawSprite(shader_program, vertex_positions, vertex_texture_coordinates, vertex_colors, color);
+    // The vertex colors.
+    float vertex_colors[] =
+    {
+        1.0f, 1.0f, 1.0f, 1.0f, // Vertex One.
+        1.0f, 1.0f, 1.0f, 1.0f, // Vertex Two.
+        1.0f, 1.0f, 1.0f, 1.0f, // Vertex Three.
+        1.0f, 1.0f, 1.0f, 1.0f  // Vertex Four.
+    };
 
-    // Unload the shader program.
-    VideoManager->UnloadShaderProgram();
+    // Lay the glyph cells out the way SDL_ttf renders a whole line:
+    // the line is shifted right when the first glyph goes left of the pen.
+    int32_t pen_x = 0;
+    uint16_t previous_character = 0;
+    for (const uint16_t* character = text; *character != 0; ++character) {
+        const Glyph* glyph = glyph_atlas->GetGlyph(*character);
+        if (glyph == nullptr)
+            continue;
+
+        if (previous_character == 0)
+            pen_x = -glyph->x_offset;
+        else
+            pen_x += glyph_atlas->GetKerning(previous_character, *character);
+        previous_character = *character;
+
+        const float left = static_cast<float>(pen_x + glyph->x_offset);
+        const float right = left + static_cast<float>(glyph->width);
+        const float bottom = static_cast<float>(glyph->height);
+
+        // The vertex positions.
+        float vertex_positions[] =
+        {
+            left,  0.0f,   0.0f, // Vertex One.
+            right, 0.0f,   0.0f, // Vertex Two.
+            right, bottom, 0.0f, // Vertex Three.
+            left,  bottom, 0.0f  // Vertex Four.
+        };
+
+        // The vertex texture coordinates.
+        // The atlas size is read for each glyph, as it may grow while drawing.
+        const float atlas_width = static_cast<float>(glyph_atlas->GetWidth());
+        const float atlas_height = static_cast<float>(glyph_atlas->GetHeight());
+        const float s0 = glyph->x / atlas_width;
+        const float s1 = (glyph->x + glyph->width) / atlas_width;
+        const float t0 = glyph->y / atlas_height;
+        const float t1 = (glyph->y + glyph->height) / atlas_height;
+        float vertex_texture_coordinates[] =
+        {
+            s0, t0, // Vertex One.
+            s1, t0, // Vertex Two.
+            s1, t1, // Vertex Three.
+            s0, t1  // Vertex Four.
+        };
+
+        // Draw the glyph.
+        VideoManager->DrawSprite(shader_program, vertex_positions, vertex_texture_coordinates, vertex_colors, color);
+
+        pen_x += glyph->advance;
+    }
 
     // Restore the transformation stack.
     VideoManager->PopMatrix();
-
-    // Clean up.
-    if (surface != nullptr) {
-        SDL_FreeSurface(surface);
-        surface = nullptr;
-    }
 }
 
 bool TextSupervisor::_RenderText(const vt_utils::ustring& text, TextStyle& style, ImageMemory& buffer)
@@ -35,6 +35,16 @@ namespace vt_video
 
 class TextSupervisor;
 
+namespace gl
+{
+class ShaderProgram;
+}
+
+namespace private_video
+{
+class GlyphAtlas;
+}
+
 //! \brief The singleton pointer for the instance of the text supervisor
 extern TextSupervisor *TextManager;
 
@@ -91,6 +101,9 @@ public:
     //! \brief Used to know the font size currently used.
     uint32_t font_size;
 
+    //! \brief The font glyphs already rendered, used to draw text every frame.
+    private_video::GlyphAtlas* glyph_atlas;
+
 private:
     //! \brief The copy constructor and assignment operator are hidden by design
     //! to cause compilation errors when attempting to copy or assign this class.
@@ -589,15 +602,6 @@ private:
 
     // ---------- Private members
 
-    //! \brief A texture used to draw text to the screen.
-    GLuint _text_texture;
-
-    //! \brief The text texture's width.
-    GLuint _text_texture_width;
-
-    //! \brief The text texture's height.
-    GLuint _text_texture_height;
-
     //! \brief The default text style
     TextStyle _default_style;
 
@@ -631,6 +635,7 @@ private:
     *** \param color The color to render the text in.
     ***
     *** This method is intended for drawing only a single line of text.
+    *** The string is drawn glyph by glyph using the font glyph atlas.
     **/
     void _RenderText(const uint16_t* text, FontProperties* font_properties, const Color& color);
 
@@ -649,6 +654,21 @@ private:
                      float shadow_offset_x, float shadow_offset_y,
                      const Color& color_shadow);
 
+    /** \brief Draws a line of text as one quad per glyph, using the font glyph atlas.
+    *** \param text A pointer to a unicode string to draw.
+    *** \param font_properties A pointer to the properties of the font to use in drawing the text.
+    *** \param text_width The width of the whole rendered line, used for alignment.
+    *** \param text_height The height of the whole rendered line, used for alignment.
+    *** \param shader_program The shader program already loaded.
+    *** \param color The color to draw the text in.
+    ***
+    *** The glyphs must already be in the atlas, and its texture bound.
+    **/
+    void _DrawGlyphs(const uint16_t* text, FontProperties* font_properties,
+                     int32_t text_width, int32_t text_height,
+                     gl::ShaderProgram* shader_program,
+                     const Color& color);
+
     /** \brief Renders a unicode string to a pixel array.
     *** \param text The unicdoe string to render.
     *** \param style The text style to render the string in.
@@ -21,7 +21,9 @@
 
 #include "utils/utils_common.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 
 using namespace vt_utils;
 
@@ -31,6 +33,82 @@ namespace vt_video
 namespace private_video
 {
 
+/** \brief Encodes RGBA pixels as runs of identical pixels and sequences of literal ones
+*** \param pixels The pixels to encode
+*** \param num_pixels The number of pixels to encode
+*** \param buffer The buffer receiving the encoded pixels
+***
+*** Each sequence starts with a byte: below 128, it is followed by that number plus one
+*** literal pixels; otherwise, by one pixel repeated that number minus 126 times.
+**/
+static void _CompressPixels(const uint8_t *pixels, size_t num_pixels, std::vector<uint8_t> &buffer)
+{
+    buffer.clear();
+
+    size_t i = 0;
+    while(i < num_pixels) {
+        // Count the identical pixels following the current one
+        size_t run = 1;
+        while(i + run < num_pixels && run < 129 && memcmp(pixels + i * 4, pixels + (i + run) * 4, 4) == 0)
+            ++run;
+
+        if(run >= 2) {
+            buffer.push_back(static_cast<uint8_t>(run + 126));
+            buffer.insert(buffer.end(), pixels + i * 4, pixels + i * 4 + 4);
+            i += run;
+            continue;
+        }
+
+        // Gather the pixels until the next run
+        size_t literals = 1;
+        while(i + literals < num_pixels && literals < 128
+                && (i + literals + 1 >= num_pixels
+                    || memcmp(pixels + (i + literals) * 4, pixels + (i + literals + 1) * 4, 4) != 0))
+            ++literals;
+
+        buffer.push_back(static_cast<uint8_t>(literals - 1));
+        buffer.insert(buffer.end(), pixels + i * 4, pixels + (i + literals) * 4);
+        i += literals;
+    }
+}
+
+/** \brief Decodes RGBA pixels encoded by _CompressPixels()
+*** \param buffer The encoded pixels
+*** \param pixels The pixels to fill
+*** \param num_pixels The number of pixels to fill
+*** \return false if the buffer doesn't hold the given number of pixels
+**/
+static bool _UncompressPixels(const std::vector<uint8_t> &buffer, uint8_t *pixels, size_t num_pixels)
+{
+    size_t i = 0;
+    size_t position = 0;
+    while(position < buffer.size() && i < num_pixels) {
+        uint8_t header = buffer[position++];
+
+        if(header < 128) {
+            size_t literals = header + 1;
+            if(i + literals > num_pixels || position + literals * 4 > buffer.size())
+                return false;
+
+            memcpy(pixels + i * 4, &buffer[position], literals * 4);
+            position += literals * 4;
+            i += literals;
+        }
+        else {
+            size_t run = header - 126;
+            if(i + run > num_pixels || position + 4 > buffer.size())
+                return false;
+
+            for(size_t j = 0; j < run; ++j)
+                memcpy(pixels + (i + j) * 4, &buffer[position], 4);
+            position += 4;
+            i += run;
+        }
+    }
+
+    return i == num_pixels && position == buffer.size();
+}
+
 // -----------------------------------------------------------------------------
 // TexSheet class
 // -----------------------------------------------------------------------------
@@ -42,7 +120,12 @@ TexSheet::TexSheet(uint32_t sheet_width, uint32_t sheet_height, GLuint sheet_id,
     type(sheet_type),
     is_static(sheet_static),
     smoothed(false),
-    loaded(true)
+    loaded(true),
+    repackable(false),
+    num_batches(0),
+    reload_from_files(false),
+    reload_failed(false),
+    last_used_frame(0)
 {
     Smooth();
 }
@@ -50,7 +133,8 @@ TexSheet::TexSheet(uint32_t sheet_width, uint32_t sheet_height, GLuint sheet_id,
 TexSheet::~TexSheet()
 {
     // Unload the OpenGL texture from memory.
-    TextureManager->_DeleteTexture(tex_id);
+    if(loaded)
+        TextureManager->_DeleteTexture(tex_id);
 }
 
 bool TexSheet::Unload()
@@ -89,20 +173,70 @@ bool TexSheet::Reload()
     smoothed = false;
     Smooth(was_smoothed);
 
+    // Restore the copy of an evicted sheet
+    if(!_evicted_pixels.empty()) {
+        ImageMemory pixels;
+        pixels.Resize(width, height, false);
+        bool restored = _UncompressPixels(_evicted_pixels, pixels.GetPixels(), pixels.GetSize2D());
+        std::vector<uint8_t>().swap(_evicted_pixels);
+
+        if(!restored || !CopyRect(0, 0, pixels)) {
+            PRINT_ERROR << "could not restore the pixels of an evicted texture sheet" << std::endl;
+            _AbortReload();
+            return false;
+        }
+
+        loaded = true;
+        reload_failed = false;
+        return true;
+    }
+
     // Reload all of the images that belong to this texture
     if(TextureManager->_ReloadImagesToSheet(this) == false) {
         PRINT_ERROR << "call to TextureController::_ReloadImagesToSheet() failed" << std::endl;
+        _AbortReload();
         return false;
     }
 
     loaded = true;
+    reload_failed = false;
     return true;
 }
 
+void TexSheet::_AbortReload()
+{
+    TextureManager->_DeleteTexture(tex_id);
+    tex_id = INVALID_TEXTURE_ID;
+    reload_failed = true;
+}
+
+bool TexSheet::Evict()
+{
+    if(!loaded) {
+        IF_PRINT_WARNING(VIDEO_DEBUG) << "attempted to evict an unloaded texture sheet" << std::endl;
+        return false;
+    }
+
+    if(!reload_from_files) {
+        ImageMemory pixels;
+        pixels.CopyFromTexture(this);
+        if(pixels.GetPixels() == nullptr)
+            return false;
+
+        _CompressPixels(pixels.GetPixels(), pixels.GetSize2D(), _evicted_pixels);
+        std::vector<uint8_t>(_evicted_pixels).swap(_evicted_pixels);
+    }
+
+    return Unload();
+}
+
 bool TexSheet::CopyRect(int32_t x, int32_t y, ImageMemory& data)
 {
     TextureManager->_BindTexture(tex_id);
 
+    // The pending sprites might use the sheet area being overwritten.
+    VideoManager->FlushSpriteBatch();
+
     data.GlTexSubImage(x, y);
 
     if(VideoManager->CheckGLError()) {
@@ -117,6 +251,9 @@ bool TexSheet::CopyScreenRect(int32_t x, int32_t y, const ScreenRect &screen_rec
 {
     TextureManager->_BindTexture(tex_id);
 
+    // Every sprite must be on screen before copying it.
+    VideoManager->FlushSpriteBatch();
+
     glCopyTexSubImage2D(
         GL_TEXTURE_2D, // target
         0, // level
@@ -143,6 +280,9 @@ void TexSheet::Smooth(bool flag)
         smoothed = flag;
         GLenum filtering_type = smoothed ? GL_LINEAR : GL_NEAREST;
 
+        // The pending sprites must keep the previous filtering.
+        VideoManager->FlushSpriteBatch();
+
         TextureManager->_BindTexture(tex_id);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filtering_type);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filtering_type);
@@ -434,166 +574,369 @@ FixedTexNode *FixedTexSheet::_RemoveOpenNode()
 }
 
 // -----------------------------------------------------------------------------
-// VariableTexSheet class
+// MaxRectsPacker class
 // -----------------------------------------------------------------------------
 
-VariableTexSheet::VariableTexSheet(int32_t sheet_width, int32_t sheet_height, GLuint sheet_id, TexSheetType sheet_type, bool sheet_static) :
-    TexSheet(sheet_width, sheet_height, sheet_id, sheet_type, sheet_static)
+MaxRectsPacker::MaxRectsPacker(int32_t sheet_width, int32_t sheet_height) :
+    _width(sheet_width),
+    _height(sheet_height)
 {
-    _block_width = width / 16;
-    _block_height = height / 16;
-    _blocks = new VariableTexNode[_block_width * _block_height];
+    _free_rects.push_back(Rect(0, 0, _width, _height));
 }
 
-VariableTexSheet::~VariableTexSheet()
+bool MaxRectsPacker::Insert(int32_t rect_width, int32_t rect_height, int32_t &x, int32_t &y)
 {
-    if (GetNumberTextures() != 0)
-        IF_PRINT_WARNING(VIDEO_DEBUG) << "texture sheet being deleted when it has a non-zero allocated texture count: " << GetNumberTextures() << std::endl;
+    if(rect_width <= 0 || rect_height <= 0 || rect_width > _width || rect_height > _height)
+        return false;
 
-    if (_blocks != nullptr) {
-        delete [] _blocks;
-        _blocks = nullptr;
+    // Find the free rectangle leaving the shortest side left over (Best Short Side Fit),
+    // using the longest side left over to break the ties.
+    int32_t best_index = -1;
+    int32_t best_short_side = 0;
+    int32_t best_long_side = 0;
+    for(uint32_t i = 0; i < _free_rects.size(); ++i) {
+        const Rect &free_rect = _free_rects[i];
+        if(free_rect.width < rect_width || free_rect.height < rect_height)
+            continue;
+
+        int32_t left_over_x = free_rect.width - rect_width;
+        int32_t left_over_y = free_rect.height - rect_height;
+        int32_t short_side = std::min(left_over_x, left_over_y);
+        int32_t long_side = std::max(left_over_x, left_over_y);
+
+        if(best_index == -1 || short_side < best_short_side
+                || (short_side == best_short_side && long_side < best_long_side)) {
+            best_index = i;
+            best_short_side = short_side;
+            best_long_side = long_side;
+        }
     }
+
+    if(best_index == -1)
+        return false;
+
+    x = _free_rects[best_index].x;
+    y = _free_rects[best_index].y;
+    _PlaceRect(Rect(x, y, rect_width, rect_height));
+    return true;
 }
 
-bool VariableTexSheet::AddTexture(BaseTexture *img, ImageMemory &data)
+bool MaxRectsPacker::Reserve(int32_t x, int32_t y, int32_t rect_width, int32_t rect_height)
 {
-    if(InsertTexture(img) == false)
+    if(x < 0 || y < 0 || x + rect_width > _width || y + rect_height > _height)
         return false;
 
-    // Copy the pixel data for the texture over
-    if(CopyRect(img->x, img->y, data) == false) {
-        IF_PRINT_WARNING(VIDEO_DEBUG) << "VIDEO ERROR: CopyRect() failed in TexSheet::AddImage()!" << std::endl;
-        return false;
+    Rect rect(x, y, rect_width, rect_height);
+    for(uint32_t i = 0; i < _used_rects.size(); ++i) {
+        if(_used_rects[i].Intersects(rect))
+            return false;
     }
 
+    _PlaceRect(rect);
     return true;
 }
 
+void MaxRectsPacker::Remove(int32_t x, int32_t y)
+{
+    for(uint32_t i = 0; i < _used_rects.size(); ++i) {
+        if(_used_rects[i].x == x && _used_rects[i].y == y) {
+            Rect freed_rect = _used_rects[i];
+            _used_rects[i] = _used_rects.back();
+            _used_rects.pop_back();
+            _FreeRect(freed_rect);
+            return;
+        }
+    }
 
+    IF_PRINT_WARNING(VIDEO_DEBUG) << "no rectangle was reserved at the given position: " << x << ", " << y << std::endl;
+}
 
-bool VariableTexSheet::InsertTexture(BaseTexture *img)
+uint32_t MaxRectsPacker::GetUsedArea() const
 {
-    if(img == nullptr) {
-        IF_PRINT_WARNING(VIDEO_DEBUG) << "nullptr pointer was given as function argument" << std::endl;
-        return false;
-    }
+    uint32_t area = 0;
+    for(uint32_t i = 0; i < _used_rects.size(); ++i)
+        area += _used_rects[i].width * _used_rects[i].height;
+    return area;
+}
 
-    // Don't allow insertions into a texture sheet containing a texture larger than 512x512.
-    // Texture sheets with this property may only be used by one texture at a time
-    if(_block_width > 32 || _block_height > 32) {  // 32 blocks == 512 pixels
-        if(_blocks[0].free_image == false)
-            return false;
+float MaxRectsPacker::GetFragmentation()
+{
+    uint32_t free_area = _width * _height - GetUsedArea();
+    if(free_area == 0)
+        return 0.0f;
+
+    uint32_t largest_area = 0;
+    for(uint32_t i = 0; i < _free_rects.size(); ++i)
+        largest_area = std::max(largest_area, static_cast<uint32_t>(_free_rects[i].width * _free_rects[i].height));
+
+    return 1.0f - static_cast<float>(largest_area) / static_cast<float>(free_area);
+}
+
+void MaxRectsPacker::_PlaceRect(const Rect &rect)
+{
+    _used_rects.push_back(rect);
+    _SplitFreeRects(rect);
+    _PruneFreeRects();
+}
+
+void MaxRectsPacker::_FreeRect(const Rect &freed_rect)
+{
+    // The freed rectangle, and the free rectangles touching it, are grown as much as possible.
+    // Only the free rectangles around the freed space change, the other ones are still maximal.
+    std::vector<Rect> grown_rects;
+    grown_rects.push_back(_GrowRect(freed_rect, true));
+    grown_rects.push_back(_GrowRect(freed_rect, false));
+    for(uint32_t i = 0; i < _free_rects.size(); ++i) {
+        if(!_free_rects[i].Touches(freed_rect))
+            continue;
+
+        grown_rects.push_back(_GrowRect(_free_rects[i], true));
+        grown_rects.push_back(_GrowRect(_free_rects[i], false));
     }
 
-    // Attempt to find an open region in the texture sheet to fit this texture
-    int32_t block_x = -1, block_y = -1;
-    int32_t w = (img->width + 15) / 16;
-    int32_t h = (img->height + 15) / 16;
-
-    // This is a brute force algorithm to try and find space to allocate the texture.
-    // If this becomes a bottleneck, we may wish to use a more intellegent algorithm here.
-    bool continue_search = true;
-    for(int32_t y = 0; y < _block_height - h + 1 && continue_search; y++) {
-        for(int32_t x = 0; x < _block_width - w + 1; x++) {
-            int32_t furthest_blocker = -1;
-
-            bool continue_neighbor_search = true;
-            for(int32_t dy = 0; dy < h && continue_neighbor_search; dy++) {
-                for(int32_t dx = 0; dx < w; dx++) {
-                    if(_blocks[(x + dx) + ((y + dy) * _block_width)].free_image == false) {
-                        furthest_blocker = x + dx;
-                        continue_neighbor_search = false;
-                        break;
-                    }
-                }
-            }
+    for(uint32_t i = 0; i < grown_rects.size(); ++i)
+        _AddFreeRect(grown_rects[i]);
+}
 
-            if(furthest_blocker == -1) {
-                block_x = x;
-                block_y = y;
-                continue_search = false;
-                break;
+MaxRectsPacker::Rect MaxRectsPacker::_GrowRect(const Rect &free_rect, bool horizontally_first) const
+{
+    Rect rect = free_rect;
+    for(uint32_t pass = 0; pass < 2; ++pass) {
+        bool horizontally = (pass == 0) == horizontally_first;
+
+        // Find the closest used rectangles on both sides, within the span of the free rectangle.
+        int32_t low = 0;
+        int32_t high = horizontally ? _width : _height;
+        for(uint32_t i = 0; i < _used_rects.size(); ++i) {
+            const Rect &used_rect = _used_rects[i];
+            if(horizontally) {
+                if(used_rect.y >= rect.y + rect.height || rect.y >= used_rect.y + used_rect.height)
+                    continue;
+                if(used_rect.x + used_rect.width <= rect.x)
+                    low = std::max(low, used_rect.x + used_rect.width);
+                else
+                    high = std::min(high, used_rect.x);
+            }
+            else {
+                if(used_rect.x >= rect.x + rect.width || rect.x >= used_rect.x + used_rect.width)
+                    continue;
+                if(used_rect.y + used_rect.height <= rect.y)
+                    low = std::max(low, used_rect.y + used_rect.height);
+                else
+                    high = std::min(high, used_rect.y);
             }
         }
+
+        if(horizontally) {
+            rect.x = low;
+            rect.width = high - low;
+        }
+        else {
+            rect.y = low;
+            rect.height = high - low;
+        }
     }
+    return rect;
+}
 
-    // If either of these conditions is true, it means we were unable to allocate enough space to insert this texture
-    if(block_x == -1 || block_y == -1)
-        return false;
+void MaxRectsPacker::_AddFreeRect(const Rect &rect)
+{
+    for(uint32_t i = 0; i < _free_rects.size(); ++i) {
+        if(_free_rects[i].Contains(rect))
+            return;
+    }
 
-    // Go through each block that is to be occupied by the new texture and set its properties
-    for(int32_t y = block_y; y < block_y + h; y++) {
-        for(int32_t x = block_x; x < block_x + w; x++) {
-            int32_t index = x + (y * _block_width);
+    for(uint32_t i = 0; i < _free_rects.size();) {
+        if(rect.Contains(_free_rects[i])) {
+            _free_rects[i] = _free_rects.back();
+            _free_rects.pop_back();
+        }
+        else {
+            ++i;
+        }
+    }
+    _free_rects.push_back(rect);
+}
 
-            // If the texture pointer for the block is not nullptr, this means it contains a freed texture.
-            // Now we must remove that texture entirely since we are overwriting at least one of its blocks.
-            if(_blocks[index].image) {
-                RemoveTexture(_blocks[index].image);
-            }
+void MaxRectsPacker::_SplitFreeRects(const Rect &used_rect)
+{
+    // The new rectangles are appended, and thus not split again.
+    uint32_t num_free_rects = _free_rects.size();
+    for(uint32_t i = 0; i < num_free_rects;) {
+        Rect free_rect = _free_rects[i];
+        if(!free_rect.Intersects(used_rect)) {
+            ++i;
+            continue;
+        }
+
+        // Keep the parts of the free rectangle on each side of the used one.
+        if(used_rect.x > free_rect.x)
+            _free_rects.push_back(Rect(free_rect.x, free_rect.y, used_rect.x - free_rect.x, free_rect.height));
+        if(used_rect.x + used_rect.width < free_rect.x + free_rect.width)
+            _free_rects.push_back(Rect(used_rect.x + used_rect.width, free_rect.y,
+                                       free_rect.x + free_rect.width - used_rect.x - used_rect.width, free_rect.height));
+        if(used_rect.y > free_rect.y)
+            _free_rects.push_back(Rect(free_rect.x, free_rect.y, free_rect.width, used_rect.y - free_rect.y));
+        if(used_rect.y + used_rect.height < free_rect.y + free_rect.height)
+            _free_rects.push_back(Rect(free_rect.x, used_rect.y + used_rect.height,
+                                       free_rect.width, free_rect.y + free_rect.height - used_rect.y - used_rect.height));
+
+        // Replace the split rectangle by the last one not yet checked.
+        --num_free_rects;
+        _free_rects[i] = _free_rects[num_free_rects];
+        _free_rects[num_free_rects] = _free_rects.back();
+        _free_rects.pop_back();
+    }
+}
 
-            _blocks[index].free_image = false;
-            _blocks[index].image = img;
+void MaxRectsPacker::_PruneFreeRects()
+{
+    for(uint32_t i = 0; i < _free_rects.size(); ++i) {
+        for(uint32_t j = i + 1; j < _free_rects.size();) {
+            if(_free_rects[i].Contains(_free_rects[j])) {
+                _free_rects[j] = _free_rects.back();
+                _free_rects.pop_back();
+            }
+            else if(_free_rects[j].Contains(_free_rects[i])) {
+                _free_rects[i] = _free_rects[j];
+                _free_rects[j] = _free_rects.back();
+                _free_rects.pop_back();
+                j = i + 1;
+            }
+            else {
+                ++j;
+            }
         }
     }
+}
 
-    // Calculate the pixel and uv coordinates for the newly inserted texture
-    img->x = block_x * 16;
-    img->y = block_y * 16;
+// -----------------------------------------------------------------------------
+// PackedTexSheet class
+// -----------------------------------------------------------------------------
 
-    float sheet_width = static_cast<float>(width);
-    float sheet_height = static_cast<float>(height);
+PackedTexSheet::PackedTexSheet(int32_t sheet_width, int32_t sheet_height, GLuint sheet_id, TexSheetType sheet_type, bool sheet_static) :
+    TexSheet(sheet_width, sheet_height, sheet_id, sheet_type, sheet_static),
+    _packer(sheet_width, sheet_height)
+{
+    _block_width = 0;
+    _block_height = 0;
+}
 
-    img->u1 = static_cast<float>(img->x + 0.5f) / sheet_width;
-    img->u2 = static_cast<float>(img->x + img->width - 0.5f) / sheet_width;
-    img->v1 = static_cast<float>(img->y + 0.5f) / sheet_height;
-    img->v2 = static_cast<float>(img->y + img->height - 0.5f) / sheet_height;
+PackedTexSheet::~PackedTexSheet()
+{
+    if (GetNumberTextures() != 0)
+        IF_PRINT_WARNING(VIDEO_DEBUG) << "texture sheet being deleted when it has a non-zero allocated texture count: " << GetNumberTextures() << std::endl;
+}
 
-    img->texture_sheet = this;
-    _textures.insert(img);
+bool PackedTexSheet::AddTexture(BaseTexture *img, ImageMemory &data)
+{
+    if(InsertTexture(img) == false)
+        return false;
+
+    // Copy the pixel data for the texture over
+    if(CopyRect(img->x, img->y, data) == false) {
+        IF_PRINT_WARNING(VIDEO_DEBUG) << "VIDEO ERROR: CopyRect() failed in TexSheet::AddImage()!" << std::endl;
+        return false;
+    }
 
     return true;
-} // bool VariableTexSheet::InsertTexture(BaseTexture* img)
+}
 
+bool PackedTexSheet::InsertTexture(BaseTexture *img)
+{
+    if(img == nullptr) {
+        IF_PRINT_WARNING(VIDEO_DEBUG) << "nullptr pointer was given as function argument" << std::endl;
+        return false;
+    }
 
+    // Don't allow insertions into a texture sheet larger than 512x512.
+    // Texture sheets with this property may only be used by one texture at a time
+    if((width > 512 || height > 512) && _textures.size() > _freed_textures.size())
+        return false;
 
-void VariableTexSheet::RemoveTexture(BaseTexture *img)
-{
-    _SetBlockProperties(img, nullptr, true);
-    _textures.erase(img);
-}
+    int32_t x = 0, y = 0;
+    if(!_packer.Insert(img->width, img->height, x, y))
+        return false;
 
+    img->x = x;
+    img->y = y;
+
+    // The freed textures overwritten, even partly, by the new texture can't be restored anymore.
+    std::set<BaseTexture *>::iterator it = _freed_textures.begin();
+    while(it != _freed_textures.end()) {
+        BaseTexture *freed = *it;
+        ++it;
+        if(freed->x < x + static_cast<int32_t>(img->width) && x < freed->x + static_cast<int32_t>(freed->width)
+                && freed->y < y + static_cast<int32_t>(img->height) && y < freed->y + static_cast<int32_t>(freed->height))
+            RemoveTexture(freed);
+    }
 
+    _SetTextureCoordinates(img);
+    _textures.insert(img);
+    return true;
+}
 
-void VariableTexSheet::_SetBlockProperties(BaseTexture *tex, BaseTexture *new_tex, bool free)
+void PackedTexSheet::RemoveTexture(BaseTexture *img)
 {
-    if(tex == nullptr) {
+    if(img == nullptr) {
         IF_PRINT_WARNING(VIDEO_DEBUG) << "nullptr pointer was given as function argument" << std::endl;
         return;
     }
 
-    if(_textures.find(tex) == _textures.end()) {
+    if(_textures.erase(img) == 0) {
         IF_PRINT_WARNING(VIDEO_DEBUG) << "texture pointer argument was not contained within this texture sheet" << std::endl;
+        return;
     }
 
-    // Calculate upper-left corner in blocks
-    int32_t block_x = tex->x / 16;
-    int32_t block_y = tex->y / 16;
+    // The space of freed textures is already released.
+    if(_freed_textures.erase(img) == 0)
+        _packer.Remove(img->x, img->y);
+}
 
-    // Calculate width and height in blocks
-    int32_t w = (tex->width  + 15) / 16;
-    int32_t h = (tex->height + 15) / 16;
+void PackedTexSheet::FreeTexture(BaseTexture *img)
+{
+    if(_textures.find(img) == _textures.end() || _freed_textures.find(img) != _freed_textures.end()) {
+        IF_PRINT_WARNING(VIDEO_DEBUG) << "texture pointer argument was not a used texture of this texture sheet" << std::endl;
+        return;
+    }
 
-    for(int32_t y = block_y; y < block_y + h; y++) {
-        for(int32_t x = block_x; x < block_x + w; x++) {
-            int32_t index = x + y * _block_width;
-            if(_blocks[index].image == tex) {
-                _blocks[index].free_image = free;
-                _blocks[index].image = new_tex;
-            }
-        }
+    _packer.Remove(img->x, img->y);
+    _freed_textures.insert(img);
+}
+
+void PackedTexSheet::RestoreTexture(BaseTexture *img)
+{
+    if(_freed_textures.find(img) == _freed_textures.end()) {
+        IF_PRINT_WARNING(VIDEO_DEBUG) << "texture pointer argument was not a freed texture of this texture sheet" << std::endl;
+        return;
     }
+
+    // The space of a freed texture is never reused while it is kept.
+    _packer.Reserve(img->x, img->y, img->width, img->height);
+    _freed_textures.erase(img);
+}
+
+uint32_t PackedTexSheet::GetUsedArea()
+{
+    uint32_t area = 0;
+    for(std::set<BaseTexture *>::const_iterator it = _textures.begin(); it != _textures.end(); ++it) {
+        if(_freed_textures.find(*it) == _freed_textures.end())
+            area += (*it)->width * (*it)->height;
+    }
+    return area;
+}
+
+void PackedTexSheet::_SetTextureCoordinates(BaseTexture *img)
+{
+    float sheet_width = static_cast<float>(width);
+    float sheet_height = static_cast<float>(height);
+
+    img->u1 = static_cast<float>(img->x + 0.5f) / sheet_width;
+    img->u2 = static_cast<float>(img->x + img->width - 0.5f) / sheet_width;
+    img->v1 = static_cast<float>(img->y + 0.5f) / sheet_height;
+    img->v2 = static_cast<float>(img->y + img->height - 0.5f) / sheet_height;
+
+    img->texture_sheet = this;
 }
 
 } // namespace private_video
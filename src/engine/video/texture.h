@@ -32,12 +32,12 @@
 *** - <b>FixedTexNode</b>: represents a texture node entry for the
 *** FixedTexSheet class.
 ***
-*** - <b>VariableTexSheet</b>: a texture sheet for variable-size textures.
+*** - <b>PackedTexSheet</b>: a texture sheet for variable-size textures.
 *** This sheet allows textures of any size to be inserted, but has slower
 *** performance than the FixedTexSheet.
 ***
-*** - <b>VariableTexNode</b>: represents a texture node entry for the
-*** VariableTexSheet class.
+*** - <b>MaxRectsPacker</b>: finds the space for the textures of the
+*** PackedTexSheet class.
 *** ***************************************************************************/
 
 #ifndef __TEXTURE_HEADER__
@@ -46,6 +46,7 @@
 #include "utils/gl_include.h"
 
 #include <set>
+#include <vector>
 
 namespace vt_video
 {
@@ -150,6 +151,21 @@ public:
     //! \brief Returns the number of textures that are contained on this texture sheet
     virtual uint32_t GetNumberTextures() = 0;
 
+    //! \brief Returns the area used by the textures contained on this texture sheet, in pixels
+    virtual uint32_t GetUsedArea() = 0;
+
+    /** \brief Returns how much the free space of the sheet is scattered, between 0.0f and 1.0f
+    *** 0.0f means that the free space can hold a texture of any size up to the free area.
+    **/
+    virtual float GetFragmentation() {
+        return 0.0f;
+    }
+
+    //! \brief Returns the part of the sheet used by textures, between 0.0f and 1.0f
+    float GetOccupancy() {
+        return static_cast<float>(GetUsedArea()) / static_cast<float>(width * height);
+    }
+
     /** \brief Unloads all texture memory used by OpenGL for this sheet
     *** \return Success/failure
     **/
@@ -157,9 +173,24 @@ public:
 
     /** \brief Reloads all the images into the sheet and reallocates OpenGL memory
     *** \return Success/failure
+    ***
+    *** An evicted sheet is restored from its compressed copy when it has one.
     **/
     bool Reload();
 
+    /** \brief Unloads the sheet to free video memory, until one of its images is drawn again
+    *** \return Success/failure
+    ***
+    *** Unless its textures can be reloaded from their image files, a compressed copy
+    *** of the sheet is kept in system memory.
+    **/
+    bool Evict();
+
+    //! \brief Returns the video memory used by the sheet when loaded, in bytes
+    size_t GetMemorySize() const {
+        return static_cast<size_t>(width) * static_cast<size_t>(height) * 4;
+    }
+
     /** \brief Copies pixel data of an image over to a sub-rectangle in the texture sheet
     *** \param x X coordinate of the texture sheet where to copy the pixel data to
     *** \param y Y coordinate of the texture sheet where to copy the pixel data to
@@ -219,9 +250,31 @@ public:
     //! \brief Flag indicating if texture sheet is loaded or not
     bool loaded;
 
+    //! \brief If true, the texture controller may move the textures of this sheet to other sheets
+    bool repackable;
+
+    //! \brief The number of image batches drawing from this sheet, whose textures can't be moved meanwhile
+    uint32_t num_batches;
+
+    //! \brief If true, the textures of this sheet can be reloaded from their image files after an eviction
+    bool reload_from_files;
+
+    //! \brief Set when the last reload failed, so that drawing doesn't retry it every frame
+    bool reload_failed;
+
+    //! \brief The frame at which the sheet was last bound, used to evict the least recently used sheets first
+    uint32_t last_used_frame;
+
 protected:
     //! \brief The width and height of the sheet in number of texture blocks
     int32_t _block_width, _block_height;
+
+private:
+    //! \brief The run-length encoded pixels of the sheet, kept while it is evicted
+    std::vector<uint8_t> _evicted_pixels;
+
+    //! \brief Deletes the texture created by a failed Reload() call and flags the failure
+    void _AbortReload();
 }; // class TexSheet
 
 
@@ -315,6 +368,10 @@ public:
     void RestoreTexture(BaseTexture *img);
 
     uint32_t GetNumberTextures();
+
+    uint32_t GetUsedArea() {
+        return GetNumberTextures() * _texture_width * _texture_height;
+    }
     //@}
 
 private:
@@ -351,34 +408,114 @@ private:
 };
 
 /** ****************************************************************************
-*** \brief Keeps track of which images are used/freed in the variable texture mem manager
+*** \brief Finds space for rectangles in a texture sheet, using the MaxRects algorithm
+***
+*** The packer keeps the list of the maximal free rectangles of the sheet, and
+*** places each new rectangle in the free rectangle leaving the shortest side
+*** left over. Removing a rectangle grows the freed space and the free rectangles
+*** touching it as much as possible, leaving the other free rectangles untouched.
+***
+*** This class doesn't touch OpenGL, so that it can be copied to test several
+*** insertions before doing them.
 *** ***************************************************************************/
-class VariableTexNode
+class MaxRectsPacker
 {
 public:
-    VariableTexNode() :
-        image(nullptr),
-        free_image(true)
+    MaxRectsPacker(int32_t sheet_width, int32_t sheet_height);
+
+    /** \brief Finds space for a rectangle of the given size and reserves it
+    *** \param x, y Set to the position of the rectangle in the sheet
+    *** \return false if there wasn't enough space left
+    **/
+    bool Insert(int32_t rect_width, int32_t rect_height, int32_t &x, int32_t &y);
+
+    /** \brief Reserves the given rectangle in the sheet
+    *** \return false if a part of the rectangle is already used
+    **/
+    bool Reserve(int32_t x, int32_t y, int32_t rect_width, int32_t rect_height);
+
+    //! \brief Frees the rectangle reserved at the given position
+    void Remove(int32_t x, int32_t y);
+
+    //! \brief Returns the area of the reserved rectangles, in pixels
+    uint32_t GetUsedArea() const;
+
+    /** \brief Returns how much the free space is scattered, between 0.0f and 1.0f
+    *** 0.0f means that the free space is a single rectangle.
+    **/
+    float GetFragmentation();
+
+private:
+    //! \brief A rectangle in the sheet, in pixels
+    class Rect
     {
-    }
+    public:
+        Rect(int32_t x_, int32_t y_, int32_t width_, int32_t height_) :
+            x(x_),
+            y(y_),
+            width(width_),
+            height(height_)
+        {}
+
+        bool Contains(const Rect &rect) const {
+            return rect.x >= x && rect.y >= y
+                   && rect.x + rect.width <= x + width && rect.y + rect.height <= y + height;
+        }
+
+        bool Intersects(const Rect &rect) const {
+            return rect.x < x + width && x < rect.x + rect.width
+                   && rect.y < y + height && y < rect.y + rect.height;
+        }
+
+        //! \brief Tells whether the rectangles intersect or share a part of an edge
+        bool Touches(const Rect &rect) const {
+            return rect.x <= x + width && x <= rect.x + rect.width
+                   && rect.y <= y + height && y <= rect.y + rect.height;
+        }
+
+        int32_t x, y, width, height;
+    };
+
+    //! \brief The size of the sheet, in pixels
+    int32_t _width, _height;
+
+    //! \brief The reserved rectangles
+    std::vector<Rect> _used_rects;
+
+    //! \brief The maximal free rectangles, which may overlap each other
+    std::vector<Rect> _free_rects;
+
+    //! \brief Reserves the rectangle, which must lie in free space
+    void _PlaceRect(const Rect &rect);
+
+    //! \brief Updates the free rectangles around a rectangle which isn't used anymore
+    void _FreeRect(const Rect &freed_rect);
+
+    /** \brief Returns the free rectangle grown as much as possible, first along one axis then the other
+    *** \param free_rect A rectangle in free space
+    *** \param horizontally_first Whether the rectangle is first grown horizontally
+    **/
+    Rect _GrowRect(const Rect &free_rect, bool horizontally_first) const;
 
-    //! \brief A pointer to the image.
-    BaseTexture *image;
+    //! \brief Adds a free rectangle, unless contained in another one, and removes the ones it contains
+    void _AddFreeRect(const Rect &rect);
+
+    //! \brief Splits the free rectangles overlapping the given used rectangle
+    void _SplitFreeRects(const Rect &used_rect);
 
-    //! \brief Set to true if the image is freed.
-    bool free_image;
+    //! \brief Removes the free rectangles contained in another one
+    void _PruneFreeRects();
 };
 
 /** ****************************************************************************
 *** \brief Used to manage texture sheets of variable image sizes
 ***
-*** This class divides a texture sheet up into 16x16 pixel blocks, and keeps
-*** track of which images have allocated which blocks. This is done to reduce
-*** the time complexity for doing texture insertion and removal operations, but
-*** the downside is that it may leave some space in the texture sheet occupied
-*** but unused for images that are not divisible by 16 in width or height.
+*** This class packs the textures in the sheet using the MaxRectsPacker, so that
+*** textures of any size are placed without wasting space around them. The textures
+*** of a repackable sheet can be moved to other sheets by the texture controller,
+*** which then updates their coordinates.
 *** ***************************************************************************/
-class VariableTexSheet : public TexSheet
+class PackedTexSheet : public TexSheet
 {
 public:
     /** \brief Constructs a new texture sheet
@@ -388,13 +525,13 @@ public:
     *** \param sheet_type The type of texture data that the texture sheet should hold
     *** \param sheet_static Whether the sheet should be labeled static or not
     **/
-    VariableTexSheet(int32_t sheet_width,
-                     int32_t sheet_height,
-                     GLuint sheet_id,
-                     TexSheetType sheet_type,
-                     bool sheet_static);
+    PackedTexSheet(int32_t sheet_width,
+                   int32_t sheet_height,
+                   GLuint sheet_id,
+                   TexSheetType sheet_type,
+                   bool sheet_static);
 
-    virtual ~VariableTexSheet();
+    virtual ~PackedTexSheet();
 
     //! \name Methods inherited from TexSheet
     //@{
@@ -404,36 +541,47 @@ public:
 
     void RemoveTexture(BaseTexture *img);
 
-    void FreeTexture(BaseTexture *img) {
-        _SetBlockProperties(img, img, true);
-    }
+    void FreeTexture(BaseTexture *img);
 
-    void RestoreTexture(BaseTexture *img) {
-        _SetBlockProperties(img, img, false);
-    }
+    void RestoreTexture(BaseTexture *img);
 
     uint32_t GetNumberTextures() {
         return _textures.size();
     }
+
+    uint32_t GetUsedArea();
+
+    float GetFragmentation() {
+        return _packer.GetFragmentation();
+    }
     //@}
 
+    //! \brief Returns the textures contained in the sheet
+    const std::set<BaseTexture *>& GetTextures() const {
+        return _textures;
+    }
+
+    //! \brief Returns the packer of the sheet, which can be copied to test insertions
+    const MaxRectsPacker& GetPacker() const {
+        return _packer;
+    }
+
 private:
-    /** \brief The list of 16x16 pixel blocks in the sheet.
-    *** The size of this structure is: (width / 16) * (height / 16)
-    **/
-    VariableTexNode *_blocks;
+    //! \brief Places the textures in the sheet
+    MaxRectsPacker _packer;
 
     /** \brief A set containing each texture that has been inserted into this class
     *** This container is used to be able to quickly determine if a texture is loaded by an object of this class
     **/
     std::set<BaseTexture *> _textures;
 
-    /** \brief Updates the properties of all of the blocks associated with a given texture
-    *** \param tex The texture to update
-    *** \param new_tex The texture pointer to set the block to
-    *** \param new_image The boolean value to set the free status flag to
+    /** \brief The textures freed but not removed, whose space can still be restored
+    *** They are forgotten as soon as another texture uses a part of their space.
     **/
-    void _SetBlockProperties(BaseTexture *tex, BaseTexture *new_tex, bool free);
+    std::set<BaseTexture *> _freed_textures;
+
+    //! \brief Sets the texture coordinates from its position in the sheet
+    void _SetTextureCoordinates(BaseTexture *img);
 };
 
 } // namespace private_video
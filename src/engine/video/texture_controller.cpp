@@ -20,6 +20,11 @@
 
 #include "engine/mode_manager.h"
 #include "engine/video/video.h"
+#include "engine/video/image_decoder.h"
+
+#include <SDL2/SDL_timer.h>
+
+#include <algorithm>
 
 using namespace vt_video::private_video;
 
@@ -30,19 +35,32 @@ namespace vt_video
 TextureController* TextureManager = nullptr;
 
 TextureController::TextureController() :
-    _debug_current_sheet(-1)
+    _image_decoder(nullptr),
+    _debug_current_sheet(-1),
+    _repack_timer(0),
+    _num_repacked_sheets(0),
+    _current_frame(0),
+    _num_evicted_sheets(0),
+    _last_tex_id(0)
 {
 }
 
 TextureController::~TextureController()
 {
+    // Stop the decoding threads first, as they don't know about the textures
+    delete _image_decoder;
+    _image_decoder = nullptr;
+    _pending_images.clear();
+
     IF_PRINT_DEBUG(VIDEO_DEBUG) << "Deleting all remaining ImageTextures, a total of: " << _images.size() << std::endl;
 
     // Invoking the ImageTexture destructor will erase the entry in the _images map that corresponds to that object
     // Thus the map will decrement in size by one on every iteration through this loop
     while(_images.empty() == false) {
         ImageTexture *img = (*_images.begin()).second;
-        img->texture_sheet->RemoveTexture(img);
+        // The textures still being loaded aren't in any texture sheet
+        if(img->texture_sheet != nullptr)
+            img->texture_sheet->RemoveTexture(img);
         delete img;
     }
 
@@ -52,6 +70,22 @@ TextureController::~TextureController()
     }
 }
 
+void TextureController::AddPreloadedImage(const std::string& filename, ImageMemory& image)
+{
+    _preloaded_images[filename].Swap(image);
+}
+
+bool TextureController::_TakePreloadedImage(const std::string& filename, ImageMemory& image)
+{
+    std::map<std::string, ImageMemory>::iterator it = _preloaded_images.find(filename);
+    if(it == _preloaded_images.end())
+        return false;
+
+    image.Swap(it->second);
+    _preloaded_images.erase(it);
+    return true;
+}
+
 bool TextureController::SingletonInitialize()
 {
     // Create a default set of texture sheets
@@ -76,6 +110,14 @@ bool TextureController::SingletonInitialize()
         return false;
     }
 
+    // The textures of the shared sheets may be moved to other sheets, and come from image files
+    for(uint32_t i = 0; i < _tex_sheets.size(); ++i) {
+        _tex_sheets[i]->repackable = true;
+        _tex_sheets[i]->reload_from_files = true;
+    }
+
+    _image_decoder = new ImageDecoder();
+
     return true;
 }
 
@@ -169,6 +211,38 @@ void TextureController::DEBUG_ShowTexSheet()
     VideoManager->MoveRelative(0, 20);
     TextManager->Draw(buf);
 
+    sprintf(buf, "  Textures: %d", sheet->GetNumberTextures());
+    VideoManager->MoveRelative(0, 20);
+    TextManager->Draw(buf);
+
+    sprintf(buf, "  Occupancy: %.1f%%", sheet->GetOccupancy() * 100.0f);
+    VideoManager->MoveRelative(0, 20);
+    TextManager->Draw(buf);
+
+    sprintf(buf, "  Fragmentation: %.1f%%", sheet->GetFragmentation() * 100.0f);
+    VideoManager->MoveRelative(0, 20);
+    TextManager->Draw(buf);
+
+    sprintf(buf, "  Repackable: %d", sheet->repackable);
+    VideoManager->MoveRelative(0, 20);
+    TextManager->Draw(buf);
+
+    sprintf(buf, "  Loaded:  %d", sheet->loaded);
+    VideoManager->MoveRelative(0, 20);
+    TextManager->Draw(buf);
+
+    sprintf(buf, "Texture sheets: %d (%d repacked, %d evicted)", num_sheets, _num_repacked_sheets, _num_evicted_sheets);
+    VideoManager->MoveRelative(0, 40);
+    TextManager->Draw(buf);
+
+    sprintf(buf, "Video memory: %.1f MiB", _GetLoadedMemorySize() / (1024.0f * 1024.0f));
+    VideoManager->MoveRelative(0, 20);
+    TextManager->Draw(buf);
+
+    sprintf(buf, "Loading images: %d", static_cast<int32_t>(_pending_images.size()));
+    VideoManager->MoveRelative(0, 20);
+    TextManager->Draw(buf);
+
     VideoManager->PopState();
 }
 
@@ -206,12 +280,35 @@ GLuint TextureController::_CreateBlankGLTexture(int32_t width, int32_t height)
 
 void TextureController::_BindTexture(GLuint tex_id)
 {
+    if (tex_id == _last_tex_id)
+        return;
+
+    // The pending sprites are using the previous texture.
+    VideoManager->FlushSpriteBatch();
+
     glBindTexture(GL_TEXTURE_2D, tex_id);
+    _last_tex_id = tex_id;
+}
+
+void TextureController::_BindTexSheet(TexSheet *sheet)
+{
+    // A sheet which couldn't be reloaded is left unloaded, rather than retried on every draw
+    if(!sheet->loaded && !sheet->reload_failed && !sheet->Reload())
+        PRINT_WARNING << "could not reload an evicted texture sheet" << std::endl;
+
+    sheet->last_used_frame = _current_frame;
+    _BindTexture(sheet->loaded ? sheet->tex_id : 0);
 }
 
 void TextureController::_DeleteTexture(GLuint tex_id)
 {
     if (tex_id != 0) {
+        // The pending sprites might still be using the texture.
+        VideoManager->FlushSpriteBatch();
+
+        if (tex_id == _last_tex_id)
+            _last_tex_id = 0;
+
         GLuint textures[] = { tex_id };
         glDeleteTextures(1, textures);
     }
@@ -245,8 +342,9 @@ TexSheet *TextureController::_CreateTexSheet(int32_t width, int32_t height, TexS
     else if(type == VIDEO_TEXSHEET_64x64)
         sheet = new FixedTexSheet(width, height, tex_id, type, is_static, 64, 64);
     else
-        sheet = new VariableTexSheet(width, height, tex_id, type, is_static);
+        sheet = new PackedTexSheet(width, height, tex_id, type, is_static);
 
+    sheet->last_used_frame = _current_frame;
     _tex_sheets.push_back(sheet);
     return sheet;
 }
@@ -290,6 +388,7 @@ TexSheet *TextureController::_InsertImageInTexSheet(BaseTexture *image, ImageMem
             IF_PRINT_WARNING(VIDEO_DEBUG) << "could not create new texture sheet for image" << std::endl;
             return nullptr;
         }
+        sheet->reload_from_files = true;
 
         if(sheet->AddTexture(image, load_info))
             return sheet;
@@ -320,7 +419,8 @@ TexSheet *TextureController::_InsertImageInTexSheet(BaseTexture *image, ImageMem
             continue;
         }
 
-        if(sheet->type == type && sheet->is_static == is_static) {
+        // Evicted sheets are left as they are, rather than reloaded to receive the image
+        if(sheet->type == type && sheet->is_static == is_static && sheet->loaded) {
             if(sheet->AddTexture(image, load_info)) {
                 return sheet;
             }
@@ -333,6 +433,8 @@ TexSheet *TextureController::_InsertImageInTexSheet(BaseTexture *image, ImageMem
         IF_PRINT_WARNING(VIDEO_DEBUG) << "failed to create a new texture sheet for image" << std::endl;
         return nullptr;
     }
+    sheet->repackable = true;
+    sheet->reload_from_files = true;
 
     // AddTexture should always work here. If not, there is a serious problem
     if(sheet->AddTexture(image, load_info)) {
@@ -343,6 +445,207 @@ TexSheet *TextureController::_InsertImageInTexSheet(BaseTexture *image, ImageMem
     }
 }
 
+void TextureController::_UpdateRepacking(uint32_t frame_time)
+{
+    _repack_timer += frame_time;
+    if(_repack_timer < TEXSHEET_REPACK_INTERVAL)
+        return;
+    _repack_timer = 0;
+
+    // Find the least used sheet whose textures can be moved
+    PackedTexSheet *source = nullptr;
+    float source_occupancy = TEXSHEET_REPACK_OCCUPANCY;
+    for(uint32_t i = 0; i < _tex_sheets.size(); ++i) {
+        TexSheet *sheet = _tex_sheets[i];
+        if(!sheet->repackable || !sheet->loaded || sheet->num_batches > 0)
+            continue;
+
+        PackedTexSheet *packed_sheet = dynamic_cast<PackedTexSheet *>(sheet);
+        if(packed_sheet == nullptr)
+            continue;
+
+        float occupancy = packed_sheet->GetOccupancy();
+        if(occupancy < source_occupancy) {
+            source = packed_sheet;
+            source_occupancy = occupancy;
+        }
+    }
+
+    if(source == nullptr)
+        return;
+
+    // Find the sheets which can receive its textures
+    std::vector<PackedTexSheet *> destinations;
+    std::vector<MaxRectsPacker> packers;
+    for(uint32_t i = 0; i < _tex_sheets.size(); ++i) {
+        TexSheet *sheet = _tex_sheets[i];
+        if(sheet == source || !sheet->repackable || !sheet->loaded || sheet->is_static != source->is_static)
+            continue;
+
+        PackedTexSheet *packed_sheet = dynamic_cast<PackedTexSheet *>(sheet);
+        if(packed_sheet == nullptr)
+            continue;
+
+        destinations.push_back(packed_sheet);
+        packers.push_back(packed_sheet->GetPacker());
+    }
+
+    // Keep one sheet of each static status
+    if(destinations.empty())
+        return;
+
+    // Check that every texture fits in the other sheets, the largest first
+    std::vector<std::pair<uint32_t, BaseTexture *> > textures;
+    const std::set<BaseTexture *>& source_textures = source->GetTextures();
+    for(std::set<BaseTexture *>::const_iterator it = source_textures.begin(); it != source_textures.end(); ++it)
+        textures.push_back(std::make_pair((*it)->width * (*it)->height, *it));
+    std::sort(textures.rbegin(), textures.rend());
+
+    std::vector<PackedTexSheet *> texture_destinations;
+    for(uint32_t i = 0; i < textures.size(); ++i) {
+        BaseTexture *texture = textures[i].second;
+        int32_t x = 0, y = 0;
+        uint32_t j = 0;
+        while(j < packers.size() && !packers[j].Insert(texture->width, texture->height, x, y))
+            ++j;
+
+        if(j == packers.size())
+            return;
+        texture_destinations.push_back(destinations[j]);
+    }
+
+    // Move the textures, using a copy of the sheet pixels
+    ImageMemory sheet_pixels;
+    if(!textures.empty())
+        sheet_pixels.CopyFromTexture(source);
+
+    for(uint32_t i = 0; i < textures.size(); ++i) {
+        BaseTexture *texture = textures[i].second;
+
+        ImageMemory texture_pixels;
+        texture_pixels.Resize(texture->width, texture->height, false);
+        texture_pixels.CopyFrom(sheet_pixels, texture->y * source->width + texture->x);
+
+        source->RemoveTexture(texture);
+        if(!texture_destinations[i]->AddTexture(texture, texture_pixels)) {
+            // Put the texture back, and keep the sheet
+            IF_PRINT_WARNING(VIDEO_DEBUG) << "could not move a texture to the planned texture sheet" << std::endl;
+            if(!source->AddTexture(texture, texture_pixels))
+                PRINT_WARNING << "a texture was lost while repacking the texture sheets" << std::endl;
+            return;
+        }
+    }
+
+    IF_PRINT_DEBUG(VIDEO_DEBUG) << "moved " << textures.size() << " textures out of a texture sheet "
+                                << "used at " << source_occupancy * 100.0f << "%" << std::endl;
+
+    _RemoveSheet(source);
+    ++_num_repacked_sheets;
+}
+
+void TextureController::_UpdateResidency(size_t memory_budget)
+{
+    ++_current_frame;
+
+    if(memory_budget == 0 || _GetLoadedMemorySize() <= memory_budget)
+        return;
+
+    // Find the least recently used sheet
+    TexSheet *lru_sheet = nullptr;
+    for(uint32_t i = 0; i < _tex_sheets.size(); ++i) {
+        TexSheet *sheet = _tex_sheets[i];
+        if(!sheet->loaded || sheet->is_static || _current_frame - sheet->last_used_frame < TEXSHEET_EVICTION_DELAY)
+            continue;
+
+        if(lru_sheet == nullptr || sheet->last_used_frame < lru_sheet->last_used_frame)
+            lru_sheet = sheet;
+    }
+
+    if(lru_sheet == nullptr)
+        return;
+
+    IF_PRINT_DEBUG(VIDEO_DEBUG) << "evicting a texture sheet unused for " << _current_frame - lru_sheet->last_used_frame
+                                << " frames" << std::endl;
+
+    if(lru_sheet->Evict())
+        ++_num_evicted_sheets;
+}
+
+size_t TextureController::_GetLoadedMemorySize() const
+{
+    size_t memory_size = 0;
+    for(uint32_t i = 0; i < _tex_sheets.size(); ++i) {
+        if(_tex_sheets[i]->loaded)
+            memory_size += _tex_sheets[i]->GetMemorySize();
+    }
+    return memory_size;
+}
+
+void TextureController::_UpdateImageLoading()
+{
+    if(_image_decoder == nullptr || _image_decoder->GetNumRequestedImages() == 0)
+        return;
+
+    const uint64_t start_time = SDL_GetPerformanceCounter();
+    const uint64_t budget = static_cast<uint64_t>(SDL_GetPerformanceFrequency() * IMAGE_UPLOAD_TIME_BUDGET / 1000.0f);
+
+    std::string filename;
+    ImageMemory load_info;
+    while(_image_decoder->TakeDecodedImage(filename, load_info)) {
+        // The images waiting for it may have been cleared, or loaded synchronously in the meantime
+        ImageTexture *image = _GetImageTexture(filename);
+        if(image != nullptr && image->texture_sheet == nullptr)
+            _UploadImageTexture(image, load_info);
+
+        if(SDL_GetPerformanceCounter() - start_time >= budget)
+            break;
+    }
+}
+
+bool TextureController::_UploadImageTexture(ImageTexture *image, ImageMemory &load_info)
+{
+    std::vector<StillImage *> waiting_images;
+    bool is_static = false;
+    for(std::set<StillImage *>::iterator i = _pending_images.begin(); i != _pending_images.end(); ++i) {
+        if((*i)->_image_texture != image)
+            continue;
+
+        waiting_images.push_back(*i);
+        is_static = is_static || (*i)->_is_static;
+    }
+
+    bool uploaded = false;
+    if(load_info.GetPixels() != nullptr) {
+        image->width = load_info.GetWidth();
+        image->height = load_info.GetHeight();
+        uploaded = (_InsertImageInTexSheet(image, load_info, is_static) != nullptr);
+    }
+
+    if(!uploaded) {
+        IF_PRINT_WARNING(VIDEO_DEBUG) << "failed to load the image file: " << image->filename << std::endl;
+    }
+
+    for(uint32_t i = 0; i < waiting_images.size(); ++i) {
+        StillImage *img = waiting_images[i];
+        _pending_images.erase(img);
+
+        // The texture is deleted along with its last reference
+        if(!uploaded) {
+            img->_RemoveTextureReference();
+            img->_image_texture = nullptr;
+            continue;
+        }
+
+        // As with StillImage::Load(), the dimensions default to the pixel ones
+        if(vt_utils::IsFloatEqual(img->_width, 0.0f))
+            img->_width = static_cast<float>(image->width);
+        if(vt_utils::IsFloatEqual(img->_height, 0.0f))
+            img->_height = static_cast<float>(image->height);
+    }
+
+    return uploaded;
+}
+
 bool TextureController::_ReloadImagesToSheet(TexSheet *sheet)
 {
     // Delete images
@@ -406,10 +709,6 @@ bool TextureController::_ReloadImagesToSheet(TexSheet *sheet)
                            load_info.GetWidth() * (x * load_info.GetHeight() / rows)
                                + load_info.GetWidth() * y / cols);
 
-            // Convert to grayscale if needed
-            if(img->tags.find("<G>", 0) != img->filename.npos)
-                image.ConvertToGrayscale();
-
             // Copy the image into the texture sheet
             if(sheet->CopyRect(img->x, img->y, image) == false) {
                 IF_PRINT_WARNING(VIDEO_DEBUG) << "call to TexSheet::CopyRect() failed" << std::endl;
@@ -428,10 +727,6 @@ bool TextureController::_ReloadImagesToSheet(TexSheet *sheet)
                 success = false;
             }
 
-            // Convert to grayscale if needed
-            if(img->tags.find("<G>", 0) != img->filename.npos)
-                load_info.ConvertToGrayscale();
-
             if(sheet->CopyRect(img->x, img->y, load_info) == false) {
                 IF_PRINT_WARNING(VIDEO_DEBUG) << "call to TexSheet::CopyRect() failed" << std::endl;
                 success = false;
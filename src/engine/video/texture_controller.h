@@ -36,8 +36,24 @@ class ParticleSystem;
 namespace vt_video
 {
 
+class StillImage;
+
 namespace private_video {
 class TextTexture;
+class GlyphAtlas;
+class ImageDecoder;
+
+//! \brief The time between two attempts to repack a texture sheet, in milliseconds
+const uint32_t TEXSHEET_REPACK_INTERVAL = 2000;
+
+//! \brief The part of a texture sheet used by textures under which its textures are moved to other sheets
+const float TEXSHEET_REPACK_OCCUPANCY = 0.5f;
+
+//! \brief The number of frames a texture sheet must stay unused before it can be evicted
+const uint32_t TEXSHEET_EVICTION_DELAY = 120;
+
+//! \brief The time spent uploading the asynchronously decoded images each frame, in milliseconds
+const float IMAGE_UPLOAD_TIME_BUDGET = 4.0f;
 }
 
 class TextureController : public vt_utils::Singleton<TextureController>
@@ -47,13 +63,15 @@ class TextureController : public vt_utils::Singleton<TextureController>
     friend class private_video::ImageMemory;
     friend class ImageDescriptor;
     friend class StillImage;
+    friend class ImageBatch;
     friend class private_video::ImageTexture;
     friend class private_video::TextTexture;
+    friend class private_video::GlyphAtlas;
     friend class TextSupervisor;
     friend class TextImage;
     friend class private_video::TexSheet;
     friend class private_video::FixedTexSheet;
-    friend class private_video::VariableTexSheet;
+    friend class private_video::PackedTexSheet;
     friend class vt_mode_manager::ParticleSystem;
 
 public:
@@ -73,6 +91,22 @@ public:
     **/
     void DEBUG_ShowTexSheet();
 
+    /** \brief Gives an image file content decoded ahead of time, for example by a worker thread.
+    *** The next load of that image file will use it instead of reading the file again.
+    *** \param image The decoded image, whose data is taken and left empty.
+    **/
+    void AddPreloadedImage(const std::string& filename, private_video::ImageMemory& image);
+
+    //! \brief Frees the preloaded images which haven't been used.
+    void ClearPreloadedImages() {
+        _preloaded_images.clear();
+    }
+
+    //! \brief Returns the number of images loaded asynchronously and not drawable yet.
+    uint32_t GetNumLoadingImages() const {
+        return _pending_images.size();
+    }
+
 private:
     virtual ~TextureController() override;
 
@@ -85,9 +119,33 @@ private:
     //! \brief A STL set containing all of the text images currently being managed by this class
     std::set<private_video::TextTexture *> _text_images;
 
+    //! \brief The image files decoded ahead of time, and not used yet, by filename.
+    std::map<std::string, private_video::ImageMemory> _preloaded_images;
+
+    //! \brief Decodes the image files of the images loaded asynchronously
+    private_video::ImageDecoder *_image_decoder;
+
+    //! \brief The images waiting for their texture to be decoded and uploaded
+    std::set<StillImage *> _pending_images;
+
     //! \brief An index to _tex_sheets of the current texture sheet being shown in debug mode. -1 indicates no sheet
     int32_t _debug_current_sheet;
 
+    //! \brief The time since the last attempt to repack a texture sheet, in milliseconds
+    uint32_t _repack_timer;
+
+    //! \brief The number of texture sheets emptied by repacking, for debugging purpose
+    uint32_t _num_repacked_sheets;
+
+    //! \brief The number of frames updated so far, used to know which texture sheets were used recently
+    uint32_t _current_frame;
+
+    //! \brief The number of texture sheets evicted so far, for debugging purpose
+    uint32_t _num_evicted_sheets;
+
+    //! \brief The OpenGL ID of the texture currently bound, used to eliminate redundant bindings.
+    GLuint _last_tex_id;
+
     // ---------- Private methods
 
     //! \name Texture Operations
@@ -105,6 +163,11 @@ private:
     **/
     void _BindTexture(GLuint tex_id);
 
+    /** \brief Binds the texture of a sheet, reloading it first if it was evicted
+    *** \param sheet The texture sheet to bind, marked as used during this frame
+    **/
+    void _BindTexSheet(private_video::TexSheet *sheet);
+
     /** \brief A wrapper to glDeleteTextures() that also adds checking to eliminate redundant texture binding
     *** \param tex_id The integer handle to the OpenGL texture to delete
      */
@@ -144,6 +207,38 @@ private:
     *** \return True only if every single image owned by the TexSheet was successfully reloaded back into it
     **/
     bool _ReloadImagesToSheet(private_video::TexSheet *sheet);
+
+    /** \brief Moves the textures of a sparsely used texture sheet into the other sheets, and removes it
+    *** \param frame_time The time elapsed since the last call, in milliseconds
+    ***
+    *** At most one repackable sheet is handled every TEXSHEET_REPACK_INTERVAL, and only when all of its
+    *** textures fit in the other sheets of the same type and static status. Sheets used by image batches are skipped.
+    **/
+    void _UpdateRepacking(uint32_t frame_time);
+
+    /** \brief Evicts the least recently used texture sheet when over the video memory budget
+    *** \param memory_budget The video memory the texture sheets may use, in bytes. 0 means no limit
+    ***
+    *** Only non-static sheets unused for TEXSHEET_EVICTION_DELAY frames are evicted, at most one per call.
+    *** They are reloaded the next time one of their images is drawn.
+    **/
+    void _UpdateResidency(size_t memory_budget);
+
+    //! \brief Returns the video memory used by the loaded texture sheets, in bytes
+    size_t _GetLoadedMemorySize() const;
+
+    /** \brief Uploads the decoded images to the texture sheets until the frame time budget is spent
+    ***
+    *** At least one image is uploaded each frame, even when it takes longer than IMAGE_UPLOAD_TIME_BUDGET.
+    **/
+    void _UpdateImageLoading();
+
+    /** \brief Inserts a texture loaded asynchronously in a texture sheet, and updates the images waiting for it
+    *** \param image The texture, registered without any texture sheet
+    *** \param load_info The decoded image data, empty if the image file couldn't be decoded
+    *** \return True if the texture is now in a texture sheet. Otherwise, the waiting images lose their texture
+    **/
+    bool _UploadImageTexture(private_video::ImageTexture *image, private_video::ImageMemory &load_info);
     //@}
 
     //! \name Image Texture Operations
@@ -195,6 +290,12 @@ private:
         return (_text_images.find(tex) != _text_images.end());
     }
     //@}
+
+    /** \brief Takes the preloaded image data of the given image file, if any.
+    *** \param image An empty image, receiving the preloaded data.
+    *** \return false if the image file wasn't preloaded.
+    **/
+    bool _TakePreloadedImage(const std::string& filename, private_video::ImageMemory& image);
 }; // class TextureController : public vt_utils::Singleton<TextureController>
 
 //! \brief The singleton pointer for the instance of the texture controller
@@ -28,10 +28,14 @@
 #include "engine/video/gl/gl_shader_programs.h"
 #include "engine/video/gl/gl_shaders.h"
 #include "engine/video/gl/gl_sprite.h"
+#include "engine/video/gl/gl_sprite_batch.h"
+#include "engine/video/gl/gl_sprite_buffer.h"
 #include "engine/video/gl/gl_transform.h"
 
 #include "utils/utils_strings.h"
 
+#include <cstring>
+
 using namespace vt_utils;
 using namespace vt_video::private_video;
 
@@ -41,6 +45,9 @@ namespace vt_video
 VideoEngine *VideoManager = nullptr;
 bool VIDEO_DEBUG = false;
 
+//! \brief The maximum number of sprites drawn using one draw call.
+const unsigned SPRITE_BATCH_CAPACITY = 2048;
+
 //-----------------------------------------------------------------------------
 // Static variable for the Color class
 //-----------------------------------------------------------------------------
@@ -84,11 +91,21 @@ VideoEngine::VideoEngine():
     _current_sample(0),
     _number_samples(0),
     _FPS_textimage(nullptr),
+    _batch_count_textimage(nullptr),
     _gl_error_code(GL_NO_ERROR),
     _gl_blend_is_active(false),
     _gl_texture_2d_is_active(false),
     _gl_stencil_test_is_active(false),
     _gl_scissor_test_is_active(false),
+    _gl_blend_source_factor(GL_ONE),
+    _gl_blend_destination_factor(GL_ZERO),
+    _gl_stencil_function(GL_ALWAYS),
+    _gl_stencil_reference(0),
+    _gl_stencil_mask(0xFFFFFFFF),
+    _gl_stencil_fail(GL_KEEP),
+    _gl_stencil_depth_fail(GL_KEEP),
+    _gl_stencil_depth_pass(GL_KEEP),
+    _gl_scissor_rectangle(0, 0, 0, 0),
     _viewport_x_offset(0),
     _viewport_y_offset(0),
     _viewport_width(0),
@@ -104,8 +121,13 @@ VideoEngine::VideoEngine():
     _temp_width(0),
     _temp_height(0),
     _vsync_mode(0),
+    _texture_memory_budget(0),
     _game_update_mode(false),
     _sprite(nullptr),
+    _sprite_batch(nullptr),
+    _current_shader_program(nullptr),
+    _batch_count(0),
+    _last_frame_batch_count(0),
     _particle_system(nullptr),
     _initialized(false)
 {
@@ -138,6 +160,12 @@ VideoEngine::~VideoEngine()
         _sprite = nullptr;
     }
 
+    // Clean up the sprite batch.
+    if (_sprite_batch != nullptr) {
+        delete _sprite_batch;
+        _sprite_batch = nullptr;
+    }
+
     // Clean up the particle system.
     if (_particle_system != nullptr) {
         delete _particle_system;
@@ -146,6 +174,7 @@ VideoEngine::~VideoEngine()
 
     // Clean up the shaders and shader programs.
     glUseProgram(0);
+    _current_shader_program = nullptr;
 
     for (std::map<gl::shader_programs::ShaderPrograms, gl::ShaderProgram*>::iterator i = _programs.begin(); i != _programs.end(); ++i) {
         if (i->second != nullptr) {
@@ -178,6 +207,11 @@ VideoEngine::~VideoEngine()
         _FPS_textimage = nullptr;
     }
 
+    if (_batch_count_textimage != nullptr) {
+        delete _batch_count_textimage;
+        _batch_count_textimage = nullptr;
+    }
+
     TextureManager->SingletonDestroy();
 }
 
@@ -195,6 +229,9 @@ bool VideoEngine::FinalizeInitialization()
     // Create the sprite.
     _sprite = new gl::Sprite();
 
+    // Create the sprite batch.
+    _sprite_batch = new gl::SpriteBatch(SPRITE_BATCH_CAPACITY);
+
     // Create the secondary render target.
     _secondary_render_target = new gl::RenderTarget(VIDEO_STANDARD_RES_WIDTH,
                                                     VIDEO_STANDARD_RES_HEIGHT);
@@ -368,6 +405,9 @@ void VideoEngine::SetDrawFlags(int32_t first_flag, ...)
 
 void VideoEngine::Clear()
 {
+    // The pending sprites must be drawn before clearing.
+    FlushSpriteBatch();
+
     glClear(GL_COLOR_BUFFER_BIT |
             GL_DEPTH_BUFFER_BIT |
             GL_STENCIL_BUFFER_BIT);
@@ -379,6 +419,14 @@ void VideoEngine::Update()
 
     _screen_fader.Update(frame_time);
 
+    TextureManager->_UpdateImageLoading();
+    TextureManager->_UpdateRepacking(frame_time);
+    TextureManager->_UpdateResidency(static_cast<size_t>(_texture_memory_budget) * 1024 * 1024);
+
+    // Keep the last frame draw calls count for debugging purpose.
+    _last_frame_batch_count = _batch_count;
+    _batch_count = 0;
+
     if (_fps_display)
         _UpdateFPS();
 }
@@ -480,12 +528,19 @@ bool VideoEngine::ApplySettings()
     _screen_height = _temp_height;
     _fullscreen = _temp_fullscreen;
 
+    // Draw the pending sprites using the previous settings.
+    FlushSpriteBatch();
+
     _UpdateViewportMetrics();
 
     // Resize the secondary render target.
     assert(_secondary_render_target != nullptr);
     _secondary_render_target->Resize(_screen_width, _screen_height);
 
+    // The render target resizing unbinds any bound texture.
+    if (TextureManager)
+        TextureManager->_last_tex_id = 0;
+
     // Try to apply the VSync mode
     if (_vsync_mode > 2) {
         _vsync_mode = 0;
@@ -535,11 +590,21 @@ void VideoEngine::SetCoordSys(const CoordSys &coordinate_system)
     float m13 = -(top + bottom) / (top - bottom);
     float m23 = -(far_z + near_z) / (far_z - near_z);
 
+    gl::Transform projection(m00, 0.0f, 0.0f, m03,
+                             0.0f, m11, 0.0f, m13,
+                             0.0f, 0.0f, m22, m23,
+                             0.0f, 0.0f, 0.0f, 1.0f);
+
+    // The pending sprites must be drawn using the previous projection.
+    float previous[16] = { 0 };
+    float next[16] = { 0 };
+    _projection.Apply(previous);
+    projection.Apply(next);
+    if (memcmp(previous, next, sizeof(previous)) != 0)
+        FlushSpriteBatch();
+
     // Store the orthographic projection.
-    _projection = gl::Transform(m00, 0.0f, 0.0f, m03,
-                                0.0f, m11, 0.0f, m13,
-                                0.0f, 0.0f, m22, m23,
-                                0.0f, 0.0f, 0.0f, 1.0f);
+    _projection = projection;
 }
 
 void VideoEngine::GetCurrentViewport(float &x, float &y,
@@ -564,6 +629,13 @@ void VideoEngine::SetViewport(float x, float y, float width, float height)
         return;
     }
 
+    // The pending sprites must be drawn within the previous viewport.
+    if (static_cast<int32_t>(x) != _viewport_x_offset ||
+            static_cast<int32_t>(y) != _viewport_y_offset ||
+            static_cast<int32_t>(width) != _viewport_width ||
+            static_cast<int32_t>(height) != _viewport_height)
+        FlushSpriteBatch();
+
     _viewport_x_offset = x;
     _viewport_y_offset = y;
     _viewport_width = width;
@@ -576,6 +648,7 @@ void VideoEngine::SetViewport(float x, float y, float width, float height)
 void VideoEngine::EnableBlending()
 {
     if(!_gl_blend_is_active) {
+        FlushSpriteBatch();
         glEnable(GL_BLEND);
         _gl_blend_is_active = true;
     }
@@ -584,6 +657,7 @@ void VideoEngine::EnableBlending()
 void VideoEngine::DisableBlending()
 {
     if(_gl_blend_is_active) {
+        FlushSpriteBatch();
         glDisable(GL_BLEND);
         _gl_blend_is_active = false;
     }
@@ -592,6 +666,7 @@ void VideoEngine::DisableBlending()
 void VideoEngine::EnableStencilTest()
 {
     if(!_gl_stencil_test_is_active) {
+        FlushSpriteBatch();
         glEnable(GL_STENCIL_TEST);
         _gl_stencil_test_is_active = true;
     }
@@ -600,6 +675,7 @@ void VideoEngine::EnableStencilTest()
 void VideoEngine::DisableStencilTest()
 {
     if(_gl_stencil_test_is_active) {
+        FlushSpriteBatch();
         glDisable(GL_STENCIL_TEST);
         _gl_stencil_test_is_active = false;
     }
@@ -608,6 +684,7 @@ void VideoEngine::DisableStencilTest()
 void VideoEngine::EnableTexture2D()
 {
     if(!_gl_texture_2d_is_active) {
+        FlushSpriteBatch();
         glEnable(GL_TEXTURE_2D);
         _gl_texture_2d_is_active = true;
     }
@@ -616,19 +693,62 @@ void VideoEngine::EnableTexture2D()
 void VideoEngine::DisableTexture2D()
 {
     if(_gl_texture_2d_is_active) {
+        FlushSpriteBatch();
         glDisable(GL_TEXTURE_2D);
         _gl_texture_2d_is_active = false;
     }
 }
 
+void VideoEngine::SetBlendFunc(GLenum source_factor, GLenum destination_factor)
+{
+    if (source_factor == _gl_blend_source_factor &&
+            destination_factor == _gl_blend_destination_factor)
+        return;
+
+    FlushSpriteBatch();
+    glBlendFunc(source_factor, destination_factor);
+    _gl_blend_source_factor = source_factor;
+    _gl_blend_destination_factor = destination_factor;
+}
+
+void VideoEngine::SetStencilFunc(GLenum function, GLint reference, GLuint mask)
+{
+    if (function == _gl_stencil_function &&
+            reference == _gl_stencil_reference &&
+            mask == _gl_stencil_mask)
+        return;
+
+    FlushSpriteBatch();
+    glStencilFunc(function, reference, mask);
+    _gl_stencil_function = function;
+    _gl_stencil_reference = reference;
+    _gl_stencil_mask = mask;
+}
+
+void VideoEngine::SetStencilOp(GLenum stencil_fail, GLenum depth_fail, GLenum depth_pass)
+{
+    if (stencil_fail == _gl_stencil_fail &&
+            depth_fail == _gl_stencil_depth_fail &&
+            depth_pass == _gl_stencil_depth_pass)
+        return;
+
+    FlushSpriteBatch();
+    glStencilOp(stencil_fail, depth_fail, depth_pass);
+    _gl_stencil_fail = stencil_fail;
+    _gl_stencil_depth_fail = depth_fail;
+    _gl_stencil_depth_pass = depth_pass;
+}
+
 void VideoEngine::EnableSecondaryRenderTarget()
 {
     assert(_secondary_render_target != nullptr);
+    FlushSpriteBatch();
     _secondary_render_target->Bind();
 }
 
 void VideoEngine::DisableSecondaryRenderTarget()
 {
+    FlushSpriteBatch();
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
@@ -637,6 +757,9 @@ void VideoEngine::DrawSecondaryRenderTarget()
     assert(_sprite != nullptr);
     assert(_secondary_render_target != nullptr);
 
+    // Draw the pending sprites into the secondary render target.
+    FlushSpriteBatch();
+
     float width_render_target = static_cast<float>(_secondary_render_target->GetWidth());
     float height_render_target = static_cast<float>(_secondary_render_target->GetHeight());
 
@@ -648,7 +771,7 @@ void VideoEngine::DrawSecondaryRenderTarget()
     vt_video::VideoManager->SetDrawFlags(vt_video::VIDEO_X_LEFT, vt_video::VIDEO_Y_TOP, vt_video::VIDEO_BLEND, 0);
 
     VideoManager->EnableBlending();
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    VideoManager->SetBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     // Load the shader program.
     gl::ShaderProgram* shader_program = VideoManager->LoadShaderProgram(gl::shader_programs::Sprite);
@@ -706,9 +829,11 @@ void VideoEngine::DrawSecondaryRenderTarget()
     };
 
     _sprite->Draw(vertex_positions, vertex_texture_coordinates, vertex_colors);
+    ++_batch_count;
 
     // Unbind the secondary render target's texture.
     glBindTexture(GL_TEXTURE_2D, 0);
+    TextureManager->_last_tex_id = 0;
 
     // Unload the shader program.
     VideoManager->UnloadShaderProgram();
@@ -724,7 +849,13 @@ gl::ShaderProgram* VideoEngine::LoadShaderProgram(const gl::shader_programs::Sha
     assert(_programs.find(shader_program) != _programs.end());
     if (_programs.find(shader_program) != _programs.end()) {
         result = _programs.at(shader_program);
-        result->Load();
+
+        // Only switch programs when needed, drawing the pending sprites beforehand.
+        if (result != _current_shader_program) {
+            FlushSpriteBatch();
+            result->Load();
+            _current_shader_program = result;
+        }
     }
 
     return result;
@@ -732,7 +863,8 @@ gl::ShaderProgram* VideoEngine::LoadShaderProgram(const gl::shader_programs::Sha
 
 void VideoEngine::UnloadShaderProgram()
 {
-    glUseProgram(0);
+    // The program is kept bound so that the following sprites using it
+    // can be added to the current batch.
 }
 
 void VideoEngine::DrawParticleSystem(gl::ShaderProgram* shader_program,
@@ -748,6 +880,9 @@ void VideoEngine::DrawParticleSystem(gl::ShaderProgram* shader_program,
     assert(vertex_colors != nullptr);
     assert(number_of_vertices % 4 == 0);
 
+    // The particle system has its own buffers, so the pending sprites are drawn first.
+    FlushSpriteBatch();
+
     // Load the shader uniforms common to all programs.
     float buffer[16] = { 0 };
     _transform_stack.top().Apply(buffer);
@@ -764,6 +899,35 @@ void VideoEngine::DrawParticleSystem(gl::ShaderProgram* shader_program,
 
     // Draw the particle system.
     _particle_system->Draw(vertex_positions, vertex_texture_coordinates, vertex_colors, number_of_vertices);
+    ++_batch_count;
+}
+
+void VideoEngine::DrawSpriteBuffer(gl::ShaderProgram* shader_program,
+                                   gl::SpriteBuffer* sprite_buffer)
+{
+    assert(shader_program != nullptr);
+    assert(shader_program == _current_shader_program);
+    assert(sprite_buffer != nullptr);
+
+    // The sprite buffer has its own vertex data, so the pending sprites are drawn first.
+    FlushSpriteBatch();
+
+    // Load the shader uniforms common to all programs.
+    float buffer[16] = { 0 };
+    _transform_stack.top().Apply(buffer);
+    shader_program->UpdateUniform("u_Model", buffer, 16);
+
+    gl::Transform identity;
+    identity.Apply(buffer);
+    shader_program->UpdateUniform("u_View", buffer, 16);
+
+    _projection.Apply(buffer);
+    shader_program->UpdateUniform("u_Projection", buffer, 16);
+
+    shader_program->UpdateUniform("u_Color", ::vt_video::Color::white.GetColors(), 4);
+
+    sprite_buffer->Draw();
+    ++_batch_count;
 }
 
 void VideoEngine::DrawSprite(gl::ShaderProgram* shader_program,
@@ -772,34 +936,69 @@ void VideoEngine::DrawSprite(gl::ShaderProgram* shader_program,
                              float* vertex_colors,
                              const Color& color)
 {
-    assert(_sprite != nullptr);
+    assert(_sprite_batch != nullptr);
     assert(shader_program != nullptr);
+    assert(shader_program == _current_shader_program);
     assert(vertex_positions != nullptr);
     assert(vertex_texture_coordinates != nullptr);
     assert(vertex_colors != nullptr);
 
-    // Load the shader uniforms common to all programs.
-    float buffer[16] = { 0 };
-    _transform_stack.top().Apply(buffer);
-    shader_program->UpdateUniform("u_Model", buffer, 16);
+    if (_sprite_batch->IsFull())
+        FlushSpriteBatch();
+
+    // Transform the vertices on the CPU, so that sprites using different
+    // model matrices can still be drawn using the same draw call.
+    float model[16] = { 0 };
+    _transform_stack.top().Apply(model);
 
+    float transformed_positions[12] = { 0 };
+    for (unsigned i = 0; i < 4; ++i) {
+        const float x = vertex_positions[i * 3];
+        const float y = vertex_positions[i * 3 + 1];
+        const float z = vertex_positions[i * 3 + 2];
+
+        transformed_positions[i * 3]     = model[0] * x + model[1] * y + model[2]  * z + model[3];
+        transformed_positions[i * 3 + 1] = model[4] * x + model[5] * y + model[6]  * z + model[7];
+        transformed_positions[i * 3 + 2] = model[8] * x + model[9] * y + model[10] * z + model[11];
+    }
+
+    // Apply the modulation color to the vertex colors for the same reason.
+    const float* modulation = color.GetColors();
+    float modulated_colors[16] = { 0 };
+    for (unsigned i = 0; i < 16; ++i)
+        modulated_colors[i] = vertex_colors[i] * modulation[i % 4];
+
+    _sprite_batch->AddQuad(transformed_positions, vertex_texture_coordinates, modulated_colors);
+}
+
+void VideoEngine::FlushSpriteBatch()
+{
+    if (_sprite_batch == nullptr || _sprite_batch->IsEmpty())
+        return;
+
+    assert(_current_shader_program != nullptr);
+
+    // The vertices are already transformed and colored.
+    float buffer[16] = { 0 };
     gl::Transform identity;
     identity.Apply(buffer);
-    shader_program->UpdateUniform("u_View", buffer, 16);
+    _current_shader_program->UpdateUniform("u_Model", buffer, 16);
+    _current_shader_program->UpdateUniform("u_View", buffer, 16);
 
     _projection.Apply(buffer);
-    shader_program->UpdateUniform("u_Projection", buffer, 16);
+    _current_shader_program->UpdateUniform("u_Projection", buffer, 16);
 
-    shader_program->UpdateUniform("u_Color", color.GetColors(), 4);
+    _current_shader_program->UpdateUniform("u_Color", ::vt_video::Color::white.GetColors(), 4);
 
-    // Draw the sprite.
-    _sprite->Draw(vertex_positions, vertex_texture_coordinates, vertex_colors);
+    if (_sprite_batch->Flush())
+        ++_batch_count;
 }
 
 void VideoEngine::EnableScissoring()
 {
     _current_context.scissoring_enabled = true;
     if (!_gl_scissor_test_is_active) {
+        FlushSpriteBatch();
         glEnable(GL_SCISSOR_TEST);
         _gl_scissor_test_is_active = true;
     }
@@ -809,6 +1008,7 @@ void VideoEngine::DisableScissoring()
 {
     _current_context.scissoring_enabled = false;
     if (_gl_scissor_test_is_active) {
+        FlushSpriteBatch();
         glDisable(GL_SCISSOR_TEST);
         _gl_scissor_test_is_active = false;
     }
@@ -824,6 +1024,15 @@ void VideoEngine::SetScissorRect(const ScreenRect& screen_rectangle)
 {
     _current_context.scissor_rectangle = screen_rectangle;
 
+    if (_gl_scissor_rectangle == screen_rectangle)
+        return;
+
+    // The pending sprites must be clipped using the previous rectangle.
+    if (_gl_scissor_test_is_active)
+        FlushSpriteBatch();
+
+    _gl_scissor_rectangle = screen_rectangle;
+
     glScissor(static_cast<GLint>(_current_context.scissor_rectangle.left),
               static_cast<GLint>(_current_context.scissor_rectangle.top),
               static_cast<GLsizei>(_current_context.scissor_rectangle.width),
@@ -1006,7 +1215,7 @@ StillImage VideoEngine::CaptureScreen()
                                                            RoundUpPow2(static_cast<uint32_t>(viewport_height)),
                                                            VIDEO_TEXSHEET_ANY,
                                                            false);
-    VariableTexSheet *sheet = dynamic_cast<VariableTexSheet *>(temp_sheet);
+    PackedTexSheet *sheet = dynamic_cast<PackedTexSheet *>(temp_sheet);
 
     // Ensure that texture sheet creation succeeded, insert the texture image into the sheet, and copy the screen into the sheet
     if (sheet == nullptr) {
@@ -1088,7 +1297,7 @@ StillImage VideoEngine::CreateImage(ImageMemory *raw_image,
     // Create a texture sheet of an appropriate size that can retain the capture.
     TexSheet* temp_sheet = TextureManager->_CreateTexSheet(RoundUpPow2(raw_image->GetWidth()),
                                                            RoundUpPow2(raw_image->GetHeight()), VIDEO_TEXSHEET_ANY, false);
-    VariableTexSheet *sheet = dynamic_cast<VariableTexSheet *>(temp_sheet);
+    PackedTexSheet *sheet = dynamic_cast<PackedTexSheet *>(temp_sheet);
 
     // Ensure that texture sheet creation succeeded, insert the texture image into the sheet, and copy the screen into the sheet
     if(sheet == nullptr) {
@@ -1153,6 +1362,9 @@ void VideoEngine::MakeScreenshot(const std::string &filename)
 {
     private_video::ImageMemory buffer;
 
+    // Make sure every sprite is drawn before reading the pixels.
+    FlushSpriteBatch();
+
     // Retrieve the width and height of the viewport.
     GLint viewport_dimensions[4]; // viewport_dimensions[2] is the width, [3] is the height
     glGetIntegerv(GL_VIEWPORT, viewport_dimensions);
@@ -1220,7 +1432,7 @@ void VideoEngine::DrawLine(float x1, float y1, unsigned width1,
     DisableTexture2D();
 
     // Normal blending.
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    SetBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     // Load the solid shader program.
     gl::ShaderProgram* shader_program = VideoManager->LoadShaderProgram(gl::shader_programs::Solid);
@@ -1369,6 +1581,8 @@ void VideoEngine::_UpdateFPS()
     // We only create the text image when needed, to permit getting the text style correctly.
     if (!_FPS_textimage)
         _FPS_textimage = new TextImage("FPS: ", TextStyle("text20", Color::white));
+    if (!_batch_count_textimage)
+        _batch_count_textimage = new TextImage("Batches: ", TextStyle("text20", Color::white));
 
     //! \brief Maximum milliseconds that the current frame time and our averaged frame time must vary
     //! before we begin trying to catch up
@@ -1423,6 +1637,7 @@ void VideoEngine::_UpdateFPS()
 
     // The text to display to the screen
     _FPS_textimage->SetText("FPS: " + NumberToString(avg_fps));
+    _batch_count_textimage->SetText("Batches: " + NumberToString(_last_frame_batch_count));
 }
 
 void VideoEngine::_DrawFPS()
@@ -1436,6 +1651,10 @@ void VideoEngine::_DrawFPS()
                  VIDEO_BLEND, 0);
     Move(930.0f, 40.0f); // Upper right hand corner of the screen
     _FPS_textimage->Draw();
+    if (_batch_count_textimage) {
+        Move(880.0f, 65.0f);
+        _batch_count_textimage->Draw();
+    }
     PopState();
 }
 
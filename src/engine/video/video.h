@@ -75,6 +75,8 @@ class RenderTarget;
 class Shader;
 class ShaderProgram;
 class Sprite;
+class SpriteBatch;
+class SpriteBuffer;
 }
 
 class VideoEngine;
@@ -114,10 +116,11 @@ class VideoEngine : public vt_utils::Singleton<VideoEngine>
     friend class vt_gui::private_gui::GUIElement;
     friend class private_video::TexSheet;
     friend class private_video::FixedTexSheet;
-    friend class private_video::VariableTexSheet;
+    friend class private_video::PackedTexSheet;
 
     friend class ImageDescriptor;
     friend class CompositeImage;
+    friend class ImageBatch;
     friend class private_video::TextElement;
     friend class TextImage;
 
@@ -245,6 +248,17 @@ public:
         return _vsync_mode;
     }
 
+    //! \brief Sets the video memory the texture sheets may use before the least recently used ones are evicted.
+    //! \param megabytes The budget in MiB, 0 meaning no limit.
+    void SetTextureMemoryBudget(uint32_t megabytes) {
+        _texture_memory_budget = megabytes;
+    }
+
+    //! \brief Gets the video memory budget of the texture sheets, in MiB. 0 means no limit.
+    uint32_t GetTextureMemoryBudget() const {
+        return _texture_memory_budget;
+    }
+
     //! \brief Returns a reference to the current coordinate system
     const CoordSys& GetCoordSys() const {
         return _current_context.coordinate_system;
@@ -310,6 +324,17 @@ public:
     void EnableTexture2D();
     void DisableTexture2D();
 
+    /** \brief Sets the blending function, but only if it differs from the current one.
+    *** \note The pending sprites are drawn beforehand, since they rely on the previous function.
+    **/
+    void SetBlendFunc(GLenum source_factor, GLenum destination_factor);
+
+    //! \brief Sets the stencil test function, but only if it differs from the current one.
+    void SetStencilFunc(GLenum function, GLint reference, GLuint mask);
+
+    //! \brief Sets the stencil test operations, but only if they differ from the current ones.
+    void SetStencilOp(GLenum stencil_fail, GLenum depth_fail, GLenum depth_pass);
+
     //! Enables the secondary render target.
     void EnableSecondaryRenderTarget();
 
@@ -326,7 +351,10 @@ public:
     //! \brief Loads a shader program.
     gl::ShaderProgram* LoadShaderProgram(const gl::shader_programs::ShaderPrograms& shader_program);
 
-    //! \brief Unloads the currently loaded shader program.
+    /** \brief Unloads the currently loaded shader program.
+    *** \note The program is actually kept bound until another one is loaded,
+    *** so that consecutive sprites using it can be drawn in one go.
+    **/
     void UnloadShaderProgram();
 
     //! \brief Draws a particle system.
@@ -336,13 +364,30 @@ public:
                             float* vertex_colors,
                             unsigned number_of_vertices);
 
-    //! \brief Draws a sprite.
+    //! \brief Draws a sprite buffer using the current transformation.
+    void DrawSpriteBuffer(gl::ShaderProgram* shader_program,
+                          gl::SpriteBuffer* sprite_buffer);
+
+    /** \brief Draws a sprite.
+    *** The sprite vertices are transformed on the CPU and added to the sprite batch.
+    *** The batch is actually drawn only when a texture, shader program, blending, scissoring
+    *** or stencil change requires it, or when FlushSpriteBatch() is called.
+    *** \note The given shader program must be the currently loaded one.
+    **/
     void DrawSprite(gl::ShaderProgram* shader_program,
                     float* vertex_positions,
                     float* vertex_texture_coordinates,
                     float* vertex_colors,
                     const Color& color = ::vt_video::Color::white);
 
+    //! \brief Draws the pending sprites, if any. Must be called before swapping the buffers.
+    void FlushSpriteBatch();
+
+    //! \brief Returns the number of sprite batch draw calls issued during the last frame.
+    uint32_t GetLastFrameBatchCount() const {
+        return _last_frame_batch_count;
+    }
+
     /** \brief Enables the scissoring effect in the video engine
     *** Scissoring is where you can specify a rectangle of the screen which is affected
     *** by rendering operations (and hence, specify what area is not affected). Make sure
@@ -667,6 +712,9 @@ private:
     //! The FPS text
     TextImage* _FPS_textimage;
 
+    //! The sprite batches count text
+    TextImage* _batch_count_textimage;
+
     //! \brief Holds the most recently fetched OpenGL error code
     GLenum _gl_error_code;
 
@@ -684,6 +732,23 @@ private:
     //! \brief Holds whether the GL_SCISSOR_TEST state is activated. Used to optimize the drawing logic
     bool _gl_scissor_test_is_active;
 
+    //! \brief The current blending function factors.
+    GLenum _gl_blend_source_factor;
+    GLenum _gl_blend_destination_factor;
+
+    //! \brief The current stencil test function parameters.
+    GLenum _gl_stencil_function;
+    GLint _gl_stencil_reference;
+    GLuint _gl_stencil_mask;
+
+    //! \brief The current stencil test operations.
+    GLenum _gl_stencil_fail;
+    GLenum _gl_stencil_depth_fail;
+    GLenum _gl_stencil_depth_pass;
+
+    //! \brief The scissor rectangle currently applied to the GL state.
+    ScreenRect _gl_scissor_rectangle;
+
     //! \brief The x/y offsets, width and height of the current viewport (the drawn part), in pixels
     //! \note the viewport is different from the screen size when in non-4:3 modes.
     int32_t _viewport_x_offset;
@@ -734,6 +799,9 @@ private:
     //! \brief Stores the current vsync mode.
     uint32_t _vsync_mode;
 
+    //! \brief The video memory budget of the texture sheets, in MiB. 0 means no limit.
+    uint32_t _texture_memory_budget;
+
     //! \brief The game main loop update mode.
     //! \note update_mode true for performance, false for the CPU-gentle loop.
     //! It is always on performance when VSync is enabled.
@@ -754,6 +822,16 @@ private:
     //! The OpenGL buffers and objects to draw a sprite.
     gl::Sprite* _sprite;
 
+    //! The OpenGL buffers and objects used to draw several sprites at once.
+    gl::SpriteBatch* _sprite_batch;
+
+    //! The shader program currently bound to the pipeline, if any.
+    gl::ShaderProgram* _current_shader_program;
+
+    //! \brief The number of sprite batch draw calls issued during the current and the last frame.
+    uint32_t _batch_count;
+    uint32_t _last_frame_batch_count;
+
     //! The OpenGL buffers and objects to draw a particle system.
     gl::ParticleSystem* _particle_system;
 
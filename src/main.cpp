@@ -39,6 +39,7 @@
 #include "common/app_name.h"
 
 #include "modes/boot/boot.h"
+#include "modes/map/map_mode.h"
 #include "main_options.h"
 
 #include <SDL2/SDL_image.h>
@@ -178,6 +179,8 @@ static bool LoadSettings()
     VideoManager->SetFullscreen(settings.ReadBool("full_screen"));
     if (settings.DoesUIntExist("vsync_mode"))
         VideoManager->SetVSyncMode(settings.ReadUInt("vsync_mode"));
+    if (settings.DoesUIntExist("texture_memory_budget"))
+        VideoManager->SetTextureMemoryBudget(settings.ReadUInt("texture_memory_budget"));
     GUIManager->SetUserMenuSkin(settings.ReadString("ui_theme"));
     settings.CloseTable(); // video_settings
 
@@ -583,6 +586,9 @@ int main(int argc, char* argv[])
                 VideoManager->DrawFadeEffect();
                 VideoManager->DrawDebugInfo();
 
+                // Draw the remaining batched sprites.
+                VideoManager->FlushSpriteBatch();
+
                 // Swap the buffers once the draw operations are done.
                 SDL_GL_SwapWindow(sdl_window);
 
@@ -594,6 +600,10 @@ int main(int argc, char* argv[])
                 // Process all new events
                 InputManager->EventHandler();
 
+                // Free the map caches when the system runs low on memory.
+                if(InputManager->LowMemory())
+                    MapMode::FreeCachedMaps();
+
                 // Update video
                 VideoManager->Update();
 
@@ -631,8 +641,9 @@ int main(int argc, char* argv[])
     GUISystem::SingletonDestroy();
     AudioEngine::SingletonDestroy();
     InputEngine::SingletonDestroy();
-    SystemEngine::SingletonDestroy();
     VideoEngine::SingletonDestroy();
+    // After the video engine, as its texture controller decodes images on the system worker threads.
+    SystemEngine::SingletonDestroy();
     // Do it last since all luabind objects must be freed
     // before closing the lua state.
     ScriptEngine::SingletonDestroy();
@@ -20,6 +20,7 @@
 #include "engine/audio/audio.h"
 #include "engine/video/video.h"
 #include "script/script_write.h"
+#include "modes/map/map_data.h"
 #include "engine/input.h"
 #include "engine/system.h"
 #include "engine/mode_manager.h"
@@ -89,6 +90,16 @@ bool ParseProgramOptions(int32_t &return_code, int32_t argc, char* argv[])
                 return_code = 1;
             }
             return false;
+        } else if(options[i] == "--compile-maps") {
+            std::vector<std::string> map_files(options.begin() + i + 1, options.end());
+            if(map_files.empty()) {
+                std::cerr << "Option " << options[i] << " requires at least one map data file." << std::endl;
+                PrintUsage();
+                return_code = 1;
+                return false;
+            }
+            return_code = CompileMaps(map_files) ? 0 : 1;
+            return false;
         } else if(options[i] == "-r" || options[i] == "--reset") {
             if(ResetSettings()) {
                 return_code = 0;
@@ -150,6 +161,8 @@ void PrintUsage()
             << "                       all, audio, battle, boot, data, global, input," << std::endl
             << "                       map, mode_manager, pause, quit, scene, system" << std::endl
             << "                       utils, video" << std::endl
+            << "  --compile-maps <files> :: compiles the given map data files, so that maps" << std::endl
+            << "                       load faster, then exits" << std::endl
             << "  --disable-audio   :: disables loading and playing audio" << std::endl
             << "  --help/-h         :: prints this help menu" << std::endl
             << "  --info/-i         :: prints information about the user's system" << std::endl
@@ -299,6 +312,29 @@ bool ResetSettings()
     return false;
 } // bool ResetSettings()
 
+bool CompileMaps(const std::vector<std::string>& map_files)
+{
+    vt_script::ScriptManager = vt_script::ScriptEngine::SingletonCreate();
+    if(!vt_script::ScriptManager->SingletonInitialize()) {
+        std::cerr << "ERROR: unable to initialize ScriptManager" << std::endl;
+        vt_script::ScriptEngine::SingletonDestroy();
+        return false;
+    }
+
+    uint32_t num_failures = 0;
+    for(uint32_t i = 0; i < map_files.size(); ++i) {
+        if(vt_map::private_map::CompileMapData(map_files[i])) {
+            std::cout << "Compiled: " << map_files[i] << std::endl;
+        } else {
+            std::cerr << "Failed to compile: " << map_files[i] << std::endl;
+            ++num_failures;
+        }
+    }
+
+    vt_script::ScriptEngine::SingletonDestroy();
+    return num_failures == 0;
+} // bool CompileMaps(const std::vector<std::string>& map_files)
+
 bool EnableDebugging(const std::string &vars)
 {
     // A vector of all the debug arguments
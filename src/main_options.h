@@ -56,6 +56,12 @@ bool PrintSystemInformation();
 **/
 bool ResetSettings();
 
+/** \brief Compiles the given map data files, so that the maps don't need to parse them when loading.
+*** \param map_files The map data Lua files, each one being compiled next to it.
+*** \return False if any map data file couldn't be compiled.
+**/
+bool CompileMaps(const std::vector<std::string>& map_files);
+
 /** \brief Enables debugging print statements in various parts of the game engine.
 *** \param vars The name(s) of the debugging variable(s) to enable.
 *** \return False if a bad function argument was given, or true on success.
@@ -0,0 +1,152 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2016 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See https://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    map_ambient_sounds.cpp
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Source file for the map ambient sounds mixing.
+*** ***************************************************************************/
+
+#include "modes/map/map_ambient_sounds.h"
+
+#include "modes/map/map_objects/map_sound.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace vt_common;
+
+namespace vt_map
+{
+
+namespace private_map
+{
+
+void AmbientSoundMixer::AddSound(SoundObject* sound_object)
+{
+    vt_audio::SoundDescriptor* sound = sound_object->GetSoundDescriptor();
+
+    std::map<vt_audio::SoundDescriptor*, uint32_t>::iterator it = _groups.find(sound);
+    uint32_t group = 0;
+    if(it != _groups.end()) {
+        group = it->second;
+    }
+    else {
+        group = _elected_sounds.size();
+        _groups[sound] = group;
+        _elected_sounds.push_back(sound_object);
+        _elected_volumes.push_back(0.0f);
+    }
+
+    _sounds.push_back(sound_object);
+    _sound_groups.push_back(group);
+    _sound_updates.push_back(0);
+    _grid_built = false;
+}
+
+void AmbientSoundMixer::Update(const Position2D& listener, uint16_t grid_width, uint16_t grid_height)
+{
+    if(_sounds.empty())
+        return;
+
+    if(!_grid_built || grid_width != _grid_width || grid_height != _grid_height)
+        _BuildGrid(grid_width, grid_height);
+
+    ++_update_count;
+    if(_update_count == 0) {
+        std::fill(_sound_updates.begin(), _sound_updates.end(), 0);
+        _update_count = 1;
+    }
+
+    // The sounds not updated are silent, so the previously elected objects can still
+    // apply the volume of the groups where no sound is heard anymore.
+    std::fill(_elected_volumes.begin(), _elected_volumes.end(), 0.0f);
+
+    // The sounds heard at the last update, which may have to fade out.
+    std::vector<uint32_t> previous_audible_sounds;
+    previous_audible_sounds.swap(_audible_sounds);
+    for(uint32_t i = 0; i < previous_audible_sounds.size(); ++i)
+        _UpdateSound(previous_audible_sounds[i]);
+
+    // The sounds which may be heard from the listener cell.
+    if(_num_cells_x > 0 && _num_cells_y > 0) {
+        int32_t cell_x = static_cast<int32_t>(listener.x) / AMBIENT_SOUND_CELL_LENGTH;
+        int32_t cell_y = static_cast<int32_t>(listener.y) / AMBIENT_SOUND_CELL_LENGTH;
+        cell_x = std::max(0, std::min<int32_t>(cell_x, _num_cells_x - 1));
+        cell_y = std::max(0, std::min<int32_t>(cell_y, _num_cells_y - 1));
+
+        const std::vector<uint32_t>& cell = _cells[cell_y * _num_cells_x + cell_x];
+        for(uint32_t i = 0; i < cell.size(); ++i)
+            _UpdateSound(cell[i]);
+    }
+}
+
+void AmbientSoundMixer::_BuildGrid(uint16_t grid_width, uint16_t grid_height)
+{
+    _grid_width = grid_width;
+    _grid_height = grid_height;
+    _num_cells_x = (grid_width + AMBIENT_SOUND_CELL_LENGTH - 1) / AMBIENT_SOUND_CELL_LENGTH;
+    _num_cells_y = (grid_height + AMBIENT_SOUND_CELL_LENGTH - 1) / AMBIENT_SOUND_CELL_LENGTH;
+    _cells.assign(_num_cells_x * _num_cells_y, std::vector<uint32_t>());
+    _grid_built = true;
+
+    if(_num_cells_x == 0 || _num_cells_y == 0)
+        return;
+
+    for(uint32_t i = 0; i < _sounds.size(); ++i) {
+        // Sounds too weak to be heard are never updated.
+        const float strength = _sounds[i]->GetStrength();
+        if(strength < 1.0f)
+            continue;
+
+        // Reference the sound in every cell its audible square overlaps.
+        const Position2D position = _sounds[i]->GetPosition();
+        int32_t left = static_cast<int32_t>(std::floor((position.x - strength) / AMBIENT_SOUND_CELL_LENGTH));
+        int32_t right = static_cast<int32_t>(std::floor((position.x + strength) / AMBIENT_SOUND_CELL_LENGTH));
+        int32_t top = static_cast<int32_t>(std::floor((position.y - strength) / AMBIENT_SOUND_CELL_LENGTH));
+        int32_t bottom = static_cast<int32_t>(std::floor((position.y + strength) / AMBIENT_SOUND_CELL_LENGTH));
+        left = std::max(0, left);
+        top = std::max(0, top);
+        right = std::min<int32_t>(right, _num_cells_x - 1);
+        bottom = std::min<int32_t>(bottom, _num_cells_y - 1);
+
+        for(int32_t y = top; y <= bottom; ++y) {
+            for(int32_t x = left; x <= right; ++x)
+                _cells[y * _num_cells_x + x].push_back(i);
+        }
+    }
+}
+
+void AmbientSoundMixer::_UpdateSound(uint32_t sound_index)
+{
+    // A sound may be both in the listener cell and heard at the last update.
+    if(_sound_updates[sound_index] == _update_count)
+        return;
+    _sound_updates[sound_index] = _update_count;
+
+    SoundObject* sound_object = _sounds[sound_index];
+    sound_object->UpdateVolume();
+
+    const float volume = sound_object->GetSoundVolume();
+    if(volume <= 0.0f)
+        return;
+
+    _audible_sounds.push_back(sound_index);
+
+    // Elect the loudest sound of the group.
+    const uint32_t group = _sound_groups[sound_index];
+    if(volume > _elected_volumes[group]) {
+        _elected_sounds[group] = sound_object;
+        _elected_volumes[group] = volume;
+    }
+}
+
+} // namespace private_map
+
+} // namespace vt_map
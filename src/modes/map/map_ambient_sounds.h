@@ -0,0 +1,128 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2016 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See https://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    map_ambient_sounds.h
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Header file for the map ambient sounds mixing.
+***
+*** The ambient sound objects sharing a sound descriptor are grouped when added,
+*** and the loudest object of each group sets the sound volume. The sounds are
+*** also referenced by the cells of a coarse grid covering their audible area,
+*** so that only the sounds which may be heard from the camera are updated.
+*** ***************************************************************************/
+
+#ifndef __MAP_AMBIENT_SOUNDS_HEADER__
+#define __MAP_AMBIENT_SOUNDS_HEADER__
+
+#include "common/position_2d.h"
+
+#include <map>
+#include <vector>
+#include <cstdint>
+
+namespace vt_audio
+{
+class SoundDescriptor;
+}
+
+namespace vt_map
+{
+
+namespace private_map
+{
+
+class SoundObject;
+
+//! \brief The side length of an ambient sound grid cell, in collision grid elements.
+const uint16_t AMBIENT_SOUND_CELL_LENGTH = 16;
+
+/** ****************************************************************************
+*** \brief Elects the loudest ambient sound object of each sound descriptor.
+***
+*** \note The sound objects are expected to stay at the position they were added at.
+*** ***************************************************************************/
+class AmbientSoundMixer
+{
+public:
+    AmbientSoundMixer() :
+        _grid_width(0),
+        _grid_height(0),
+        _num_cells_x(0),
+        _num_cells_y(0),
+        _grid_built(false),
+        _update_count(0)
+    {}
+
+    //! \brief Adds a sound object to the group of its sound descriptor.
+    void AddSound(SoundObject* sound_object);
+
+    /** \brief Updates the volume of the sounds which may be heard, and elects the loudest object of each group.
+    *** \param listener The position the sounds are heard from, in collision grid elements.
+    *** \param grid_width, grid_height The map size, in collision grid elements.
+    **/
+    void Update(const vt_common::Position2D& listener, uint16_t grid_width, uint16_t grid_height);
+
+    //! \brief Returns the loudest object of each group, whose volume is applied to the sound descriptor.
+    const std::vector<SoundObject*>& GetElectedSounds() const {
+        return _elected_sounds;
+    }
+
+private:
+    //! \brief The ambient sound objects.
+    std::vector<SoundObject*> _sounds;
+
+    //! \brief The group index of each sound object.
+    std::vector<uint32_t> _sound_groups;
+
+    //! \brief The update count at which each sound object was last updated.
+    std::vector<uint32_t> _sound_updates;
+
+    //! \brief The group index of each sound descriptor.
+    std::map<vt_audio::SoundDescriptor*, uint32_t> _groups;
+
+    //! \brief The elected sound object of each group.
+    std::vector<SoundObject*> _elected_sounds;
+
+    //! \brief The volume of the elected sound object of each group, at the current update.
+    std::vector<float> _elected_volumes;
+
+    //! \brief The sound objects heard at the last update, updated even when leaving their cell
+    //! so that they get silent.
+    std::vector<uint32_t> _audible_sounds;
+
+    //! \brief The sound objects which may be heard from each cell, stored at [cell_y * _num_cells_x + cell_x].
+    std::vector<std::vector<uint32_t> > _cells;
+
+    //! \brief The map size the grid was built for, in collision grid elements.
+    uint16_t _grid_width;
+    uint16_t _grid_height;
+
+    //! \brief The number of cells on each axis.
+    uint16_t _num_cells_x;
+    uint16_t _num_cells_y;
+
+    //! \brief Whether the grid is up to date with the added sounds.
+    bool _grid_built;
+
+    //! \brief The number of updates done, used to update each sound object once per update.
+    uint32_t _update_count;
+
+    //! \brief Builds the cells from the sound objects audible areas.
+    void _BuildGrid(uint16_t grid_width, uint16_t grid_height);
+
+    //! \brief Updates the given sound object volume, and elects it if it is the loudest of its group.
+    void _UpdateSound(uint32_t sound_index);
+};
+
+} // namespace private_map
+
+} // namespace vt_map
+
+#endif // __MAP_AMBIENT_SOUNDS_HEADER__
@@ -0,0 +1,131 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2016 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See https://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    map_cache.cpp
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Source file for the cache of the recently left maps.
+*** ***************************************************************************/
+
+#include "modes/map/map_cache.h"
+
+#include "modes/map/map_tiles.h"
+
+#include "utils/exception.h"
+
+#include <SDL2/SDL_cpuinfo.h>
+
+namespace vt_map
+{
+
+namespace private_map
+{
+
+MapCache::MapCache() :
+    _memory_used(0),
+    _memory_budget(MAP_CACHE_MEMORY_BUDGET)
+{
+    // Keep a smaller cache on systems having little memory.
+    int32_t system_memory = SDL_GetSystemRAM();
+    if(system_memory > 0) {
+        size_t system_budget = static_cast<size_t>(system_memory) * 1024 * 1024 / MAP_CACHE_SYSTEM_MEMORY_DIVISOR;
+        if(system_budget < _memory_budget)
+            _memory_budget = system_budget;
+    }
+}
+
+void MapCache::Store(const std::string& map_data_filename, MapData& map_data, TileSupervisor* tile_supervisor,
+                     const GeneratedMinimap& minimap)
+{
+    if(!tile_supervisor)
+        return;
+
+    // Replace any older version of the map.
+    MapData old_map_data;
+    TileSupervisor* old_tile_supervisor = nullptr;
+    GeneratedMinimap old_minimap;
+    if(Take(map_data_filename, old_map_data, old_tile_supervisor, old_minimap))
+        delete old_tile_supervisor;
+
+    _maps.push_front(CachedMap());
+    CachedMap& cached_map = _maps.front();
+    cached_map.map_data_filename = map_data_filename;
+    cached_map.map_data = std::move(map_data);
+    cached_map.tile_supervisor = tile_supervisor;
+    cached_map.minimap = minimap;
+
+    cached_map.memory_size = tile_supervisor->GetMemorySize() + cached_map.map_data.collision_grid.size();
+    cached_map.memory_size += static_cast<size_t>(minimap.image.GetWidth()) * static_cast<size_t>(minimap.image.GetHeight()) * 4;
+    for(uint32_t i = 0; i < cached_map.map_data.layers.size(); ++i)
+        cached_map.memory_size += cached_map.map_data.layers[i].tiles.size() * sizeof(int16_t);
+    _memory_used += cached_map.memory_size;
+
+    _Evict();
+}
+
+bool MapCache::Take(const std::string& map_data_filename, MapData& map_data, TileSupervisor*& tile_supervisor,
+                    GeneratedMinimap& minimap)
+{
+    for(std::list<CachedMap>::iterator it = _maps.begin(); it != _maps.end(); ++it) {
+        if(it->map_data_filename != map_data_filename)
+            continue;
+
+        map_data = std::move(it->map_data);
+        tile_supervisor = it->tile_supervisor;
+        minimap = it->minimap;
+        _memory_used -= it->memory_size;
+        _maps.erase(it);
+        return true;
+    }
+    return false;
+}
+
+bool MapCache::IsCached(const std::string& map_data_filename) const
+{
+    for(std::list<CachedMap>::const_iterator it = _maps.begin(); it != _maps.end(); ++it) {
+        if(it->map_data_filename == map_data_filename)
+            return true;
+    }
+    return false;
+}
+
+void MapCache::Clear()
+{
+    for(std::list<CachedMap>::iterator it = _maps.begin(); it != _maps.end(); ++it)
+        delete it->tile_supervisor;
+    _maps.clear();
+    _memory_used = 0;
+}
+
+void MapCache::_Evict()
+{
+    while(!_maps.empty() && (_maps.size() > MAP_CACHE_MAX_ENTRIES || _memory_used > _memory_budget)) {
+        CachedMap& cached_map = _maps.back();
+        IF_PRINT_DEBUG(MAP_DEBUG) << "Evicting map from the cache: " << cached_map.map_data_filename << std::endl;
+
+        delete cached_map.tile_supervisor;
+        _memory_used -= cached_map.memory_size;
+        _maps.pop_back();
+    }
+}
+
+MapCache::MapCache(const MapCache&)
+{
+    throw vt_utils::Exception("Not Implemented!", __FILE__, __LINE__, __FUNCTION__);
+}
+
+MapCache& MapCache::operator=(const MapCache&)
+{
+    throw vt_utils::Exception("Not Implemented!", __FILE__, __LINE__, __FUNCTION__);
+    return *this;
+}
+
+} // namespace private_map
+
+} // namespace vt_map
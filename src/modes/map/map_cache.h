@@ -0,0 +1,137 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2016 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See https://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    map_cache.h
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Header file for the cache of the recently left maps.
+***
+*** When a map mode is deleted, the parts of the map which don't depend on the
+*** visit (the map data, the tile supervisor with its tileset textures and the
+*** generated minimap) are kept, so that going back to that map doesn't need to load them again.
+***
+*** The objects, events and script state are still created at each visit: the map script
+*** creates them depending on the global events reached so far, and they keep the state
+*** of the visit (sprite positions, running events), which MapMode::Reset() doesn't restore.
+*** The map script files are thus still read at each visit.
+***
+*** The cached maps are freed when the operating system reports it is running low on memory.
+*** ***************************************************************************/
+
+#ifndef __MAP_CACHE_HEADER__
+#define __MAP_CACHE_HEADER__
+
+#include "modes/map/map_data.h"
+#include "modes/map/map_minimap.h"
+
+#include <list>
+
+namespace vt_map
+{
+
+namespace private_map
+{
+
+class TileSupervisor;
+
+//! \brief The maximum number of maps kept in the cache.
+const uint32_t MAP_CACHE_MAX_ENTRIES = 4;
+
+//! \brief The memory the cached maps may use at most, in bytes.
+const size_t MAP_CACHE_MEMORY_BUDGET = 96 * 1024 * 1024;
+
+//! \brief The fraction of the system memory the cached maps may use, when lower than the budget above.
+const size_t MAP_CACHE_SYSTEM_MEMORY_DIVISOR = 32;
+
+/** ****************************************************************************
+*** \brief A least recently used cache of the recently left maps.
+*** ***************************************************************************/
+class MapCache
+{
+public:
+    MapCache();
+
+    ~MapCache() {
+        Clear();
+    }
+
+    /** \brief Keeps the given map, evicting the least recently left maps when needed.
+    *** \param map_data The map data, whose content is taken.
+    *** \param tile_supervisor The loaded tile supervisor, now owned by the cache.
+    *** \param minimap The generated minimap image, if any.
+    **/
+    void Store(const std::string& map_data_filename, MapData& map_data, TileSupervisor* tile_supervisor,
+               const GeneratedMinimap& minimap);
+
+    /** \brief Takes the given map out of the cache.
+    *** \param tile_supervisor Receives the tile supervisor, now owned by the caller.
+    *** \param minimap Receives the generated minimap image, if any.
+    *** \return false if the map isn't cached.
+    **/
+    bool Take(const std::string& map_data_filename, MapData& map_data, TileSupervisor*& tile_supervisor,
+              GeneratedMinimap& minimap);
+
+    //! \brief Tells whether the given map is cached.
+    bool IsCached(const std::string& map_data_filename) const;
+
+    //! \brief Frees every cached map.
+    void Clear();
+
+    //! \brief Returns the memory used by the cached maps, in bytes.
+    size_t GetMemoryUsed() const {
+        return _memory_used;
+    }
+
+    //! \brief Returns the memory the cached maps may use, in bytes.
+    size_t GetMemoryBudget() const {
+        return _memory_budget;
+    }
+
+private:
+    //! \brief The copy constructor and assignment operator are hidden by design
+    //! to cause compilation errors when attempting to copy or assign this class.
+    MapCache(const MapCache& map_cache);
+    MapCache& operator=(const MapCache& map_cache);
+
+    //! \brief A map kept in the cache.
+    class CachedMap
+    {
+    public:
+        CachedMap() :
+            tile_supervisor(nullptr),
+            memory_size(0)
+        {}
+
+        std::string map_data_filename;
+        MapData map_data;
+        TileSupervisor* tile_supervisor;
+        GeneratedMinimap minimap;
+
+        //! \brief An estimate of the memory used, in bytes.
+        size_t memory_size;
+    };
+
+    //! \brief The cached maps, the most recently stored first.
+    std::list<CachedMap> _maps;
+
+    //! \brief The memory used by the cached maps, in bytes.
+    size_t _memory_used;
+
+    //! \brief The memory the cached maps may use, in bytes.
+    size_t _memory_budget;
+
+    //! \brief Frees the least recently stored maps until within the entry and memory limits.
+    void _Evict();
+};
+
+} // namespace private_map
+
+} // namespace vt_map
+
+#endif // __MAP_CACHE_HEADER__
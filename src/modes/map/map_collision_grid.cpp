@@ -0,0 +1,144 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2016 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See https://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    map_collision_grid.cpp
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Source file for the map collision grid.
+*** ***************************************************************************/
+
+#include "modes/map/map_collision_grid.h"
+
+#include <algorithm>
+
+namespace vt_map
+{
+
+namespace private_map
+{
+
+void CollisionGrid::Resize(uint16_t width, uint16_t height)
+{
+    _width = width;
+    _height = height;
+    _words_per_row = (static_cast<uint32_t>(width) + 63) / 64;
+    _words.assign(_words_per_row * height, 0);
+    ComputeClearance();
+}
+
+void CollisionGrid::Clear()
+{
+    _width = 0;
+    _height = 0;
+    _words_per_row = 0;
+    std::vector<uint64_t>().swap(_words);
+    std::vector<uint8_t>().swap(_clearance);
+}
+
+void CollisionGrid::ComputeClearance()
+{
+    _clearance.assign(_width * _height, 0);
+
+    // Each element depends on its right and bottom neighbours.
+    for(int32_t y = _height - 1; y >= 0; --y) {
+        for(int32_t x = _width - 1; x >= 0; --x)
+            _clearance[y * _width + x] = _ComputeClearance(x, y);
+    }
+}
+
+void CollisionGrid::ChangeCollision(uint16_t x, uint16_t y, bool collision)
+{
+    if(x >= _width || y >= _height || IsCollision(x, y) == collision)
+        return;
+
+    SetCollision(x, y, collision);
+
+    // Only the elements above and on the left, within the largest clearance, can change.
+    // Once a whole row is left unchanged, the rows above it are too.
+    int32_t left = std::max(0, x - MAX_COLLISION_CLEARANCE + 1);
+    int32_t top = std::max(0, y - MAX_COLLISION_CLEARANCE + 1);
+    for(int32_t row = y; row >= top; --row) {
+        bool row_changed = false;
+        for(int32_t col = x; col >= left; --col) {
+            uint8_t clearance = _ComputeClearance(col, row);
+            uint8_t& current = _clearance[row * _width + col];
+            if(clearance != current) {
+                current = clearance;
+                row_changed = true;
+            }
+        }
+        if(!row_changed)
+            break;
+    }
+}
+
+uint8_t CollisionGrid::_ComputeClearance(uint16_t x, uint16_t y) const
+{
+    if(IsCollision(x, y))
+        return 0;
+
+    // The elements out of the grid are considered walls.
+    uint8_t right = (x + 1 < _width) ? _clearance[y * _width + x + 1] : 0;
+    uint8_t bottom = (y + 1 < _height) ? _clearance[(y + 1) * _width + x] : 0;
+    uint8_t bottom_right = (x + 1 < _width && y + 1 < _height) ? _clearance[(y + 1) * _width + x + 1] : 0;
+
+    uint8_t clearance = std::min(right, std::min(bottom, bottom_right));
+    return (clearance < MAX_COLLISION_CLEARANCE) ? clearance + 1 : MAX_COLLISION_CLEARANCE;
+}
+
+bool CollisionGrid::IsAnyCollision(uint16_t left, uint16_t top, uint16_t right, uint16_t bottom) const
+{
+    // The largest free square from the top-left corner either covers the rectangle,
+    // or already fails to cover its smallest side. A capped clearance may be larger.
+    const uint32_t clearance = GetClearance(left, top);
+    const uint32_t width = right - left + 1;
+    const uint32_t height = bottom - top + 1;
+    if(clearance >= std::max(width, height))
+        return false;
+    if(clearance < std::min(width, height) && clearance < MAX_COLLISION_CLEARANCE)
+        return true;
+
+    return _IsAnyCollisionInWords(left, top, right, bottom);
+}
+
+bool CollisionGrid::_IsAnyCollisionInWords(uint16_t left, uint16_t top, uint16_t right, uint16_t bottom) const
+{
+    const uint32_t first_word = left >> 6;
+    const uint32_t last_word = right >> 6;
+
+    // The bits of the rectangle within its first and last words.
+    const uint64_t all_bits = ~static_cast<uint64_t>(0);
+    const uint64_t first_mask = all_bits << (left & 63);
+    const uint64_t last_mask = all_bits >> (63 - (right & 63));
+
+    for(uint32_t y = top; y <= bottom; ++y) {
+        const uint64_t* row = &_words[y * _words_per_row];
+
+        if(first_word == last_word) {
+            if(row[first_word] & first_mask & last_mask)
+                return true;
+            continue;
+        }
+
+        if(row[first_word] & first_mask)
+            return true;
+        for(uint32_t word = first_word + 1; word < last_word; ++word) {
+            if(row[word])
+                return true;
+        }
+        if(row[last_word] & last_mask)
+            return true;
+    }
+
+    return false;
+}
+
+} // namespace private_map
+
+} // namespace vt_map
@@ -0,0 +1,127 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2016 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See https://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    map_collision_grid.h
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Header file for the map collision grid.
+***
+*** The collision grid stores one bit per grid element, row after row in a single
+*** array, so that testing whether a rectangle contains a wall only requires
+*** a few masked 64-bit operations per row.
+***
+*** It also keeps a clearance map, giving the side of the largest wall-free square
+*** starting at each grid element, so that most rectangle tests only need one lookup.
+*** ***************************************************************************/
+
+#ifndef __MAP_COLLISION_GRID_HEADER__
+#define __MAP_COLLISION_GRID_HEADER__
+
+#include <vector>
+#include <cstdint>
+
+namespace vt_map
+{
+
+namespace private_map
+{
+
+//! \brief The largest clearance stored, in grid elements.
+const uint8_t MAX_COLLISION_CLEARANCE = 255;
+
+class CollisionGrid
+{
+public:
+    CollisionGrid() :
+        _width(0),
+        _height(0),
+        _words_per_row(0)
+    {}
+
+    //! \brief Sets the grid size, every grid element being walkable.
+    void Resize(uint16_t width, uint16_t height);
+
+    //! \brief Frees the grid.
+    void Clear();
+
+    uint16_t GetWidth() const {
+        return _width;
+    }
+
+    uint16_t GetHeight() const {
+        return _height;
+    }
+
+    bool IsEmpty() const {
+        return _words.empty();
+    }
+
+    /** \brief Sets whether the given grid element is a wall.
+    *** \note This doesn't update the clearance map, see ChangeCollision().
+    *** ComputeClearance() must be called once every element is set.
+    **/
+    void SetCollision(uint16_t x, uint16_t y, bool collision) {
+        uint64_t& word = _words[y * _words_per_row + (x >> 6)];
+        const uint64_t bit = static_cast<uint64_t>(1) << (x & 63);
+        if(collision)
+            word |= bit;
+        else
+            word &= ~bit;
+    }
+
+    //! \brief Computes the whole clearance map from the grid elements.
+    void ComputeClearance();
+
+    //! \brief Sets whether the given grid element is a wall, and updates the clearance map around it.
+    void ChangeCollision(uint16_t x, uint16_t y, bool collision);
+
+    /** \brief Returns the side of the largest wall-free square having the given grid element
+    *** as top-left corner, capped to MAX_COLLISION_CLEARANCE.
+    **/
+    uint8_t GetClearance(uint16_t x, uint16_t y) const {
+        return _clearance[y * _width + x];
+    }
+
+    //! \brief Tells whether the given grid element is a wall. The position must be within the grid.
+    bool IsCollision(uint16_t x, uint16_t y) const {
+        return (_words[y * _words_per_row + (x >> 6)] >> (x & 63)) & 1;
+    }
+
+    /** \brief Tells whether any grid element of the given rectangle is a wall.
+    *** The clearance map answers directly unless the rectangle is close to a wall.
+    *** \note The bounds are inclusive, and must be within the grid.
+    **/
+    bool IsAnyCollision(uint16_t left, uint16_t top, uint16_t right, uint16_t bottom) const;
+
+private:
+    //! \brief The grid size, in grid elements.
+    uint16_t _width;
+    uint16_t _height;
+
+    //! \brief The number of 64-bit words used by each row.
+    uint32_t _words_per_row;
+
+    //! \brief The grid bits, row after row. Each row starts on a new word.
+    std::vector<uint64_t> _words;
+
+    //! \brief The clearance of each grid element, stored at [y * _width + x].
+    std::vector<uint8_t> _clearance;
+
+    //! \brief Computes the clearance of one element from its right and bottom neighbours.
+    uint8_t _ComputeClearance(uint16_t x, uint16_t y) const;
+
+    //! \brief Tells whether any grid element of the given rectangle is a wall, only using the grid bits.
+    bool _IsAnyCollisionInWords(uint16_t left, uint16_t top, uint16_t right, uint16_t bottom) const;
+};
+
+} // namespace private_map
+
+} // namespace vt_map
+
+#endif // __MAP_COLLISION_GRID_HEADER__
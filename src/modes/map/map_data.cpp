@@ -0,0 +1,436 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2016 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See https://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    map_data.cpp
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Source file for the map data loading and compilation.
+*** ***************************************************************************/
+
+#include "modes/map/map_data.h"
+
+#include "common/app_settings.h"
+
+#include "script/script_read.h"
+
+#include "utils/utils_files.h"
+
+#include <algorithm>
+#include <fstream>
+
+using namespace vt_script;
+
+namespace vt_map
+{
+
+namespace private_map
+{
+
+//! \brief The compiled map data file magic number.
+const char MAP_DATA_COMPILED_MAGIC[4] = { 'V', 'T', 'M', 'D' };
+
+//! \brief Reads little-endian values from a file content, and remembers whether it went past its end.
+class CompiledMapReader
+{
+public:
+    explicit CompiledMapReader(const std::vector<uint8_t>& buffer) :
+        _buffer(buffer),
+        _position(0),
+        _valid(true)
+    {}
+
+    bool IsValid() const {
+        return _valid;
+    }
+
+    bool IsAtEnd() const {
+        return _position == _buffer.size();
+    }
+
+    //! \brief Returns the next bytes, or nullptr when there aren't enough left.
+    const uint8_t* ReadBytes(size_t size) {
+        if(!_valid || _buffer.size() - _position < size) {
+            _valid = false;
+            return nullptr;
+        }
+        const uint8_t* bytes = &_buffer[0] + _position;
+        _position += size;
+        return bytes;
+    }
+
+    uint64_t ReadUInt(size_t size) {
+        const uint8_t* bytes = ReadBytes(size);
+        uint64_t value = 0;
+        for(size_t i = 0; bytes && i < size; ++i)
+            value |= static_cast<uint64_t>(bytes[i]) << (8 * i);
+        return value;
+    }
+
+    uint32_t ReadUInt32() {
+        return static_cast<uint32_t>(ReadUInt(4));
+    }
+
+    std::string ReadString() {
+        uint32_t size = ReadUInt32();
+        const uint8_t* bytes = ReadBytes(size);
+        return bytes ? std::string(reinterpret_cast<const char*>(bytes), size) : std::string();
+    }
+
+private:
+    const std::vector<uint8_t>& _buffer;
+    size_t _position;
+    bool _valid;
+};
+
+//! \brief Appends little-endian values to a file content.
+class CompiledMapWriter
+{
+public:
+    explicit CompiledMapWriter(std::vector<uint8_t>& buffer) :
+        _buffer(buffer)
+    {}
+
+    void WriteUInt(uint64_t value, size_t size) {
+        for(size_t i = 0; i < size; ++i)
+            _buffer.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+
+    void WriteUInt32(uint32_t value) {
+        WriteUInt(value, 4);
+    }
+
+    void WriteString(const std::string& value) {
+        WriteUInt32(value.size());
+        _buffer.insert(_buffer.end(), value.begin(), value.end());
+    }
+
+private:
+    std::vector<uint8_t>& _buffer;
+};
+
+//! \brief Reads the whole file content at once.
+static bool ReadFileContent(const std::string& filename, std::vector<uint8_t>& content)
+{
+    std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+    if(!file.good())
+        return false;
+
+    file.seekg(0, std::ios::end);
+    std::streamoff size = file.tellg();
+    if(size < 0)
+        return false;
+    file.seekg(0, std::ios::beg);
+
+    content.resize(static_cast<size_t>(size));
+    if(size > 0)
+        file.read(reinterpret_cast<char*>(&content[0]), size);
+    return !file.fail();
+}
+
+void MapData::Clear()
+{
+    num_tile_cols = 0;
+    num_tile_rows = 0;
+    tileset_filenames.clear();
+    grid_width = 0;
+    grid_height = 0;
+    collision_grid.clear();
+    layers.clear();
+}
+
+bool MapData::LoadFromScript(ReadScriptDescriptor& map_file)
+{
+    Clear();
+
+    // Load the map dimensions
+    num_tile_rows = map_file.ReadInt("num_tile_rows");
+    num_tile_cols = map_file.ReadInt("num_tile_cols");
+
+    map_file.ReadStringVector("tileset_filenames", tileset_filenames);
+
+    if(!map_file.DoesTableExist("map_grid")) {
+        PRINT_ERROR << "No map grid found in map file: " << map_file.GetFilename() << std::endl;
+        return false;
+    }
+
+    // Read the collision grid
+    map_file.OpenTable("map_grid");
+    grid_height = map_file.GetTableSize();
+    std::vector<uint32_t> grid_row;
+    for(uint32_t y = 0; y < grid_height; ++y) {
+        grid_row.clear();
+        map_file.ReadUIntVector(y, grid_row);
+
+        // The first row gives the grid width.
+        if(y == 0) {
+            grid_width = grid_row.size();
+            collision_grid.assign(grid_width * grid_height, 0);
+        }
+        else if(grid_row.size() != grid_width) {
+            PRINT_WARNING << "Invalid map grid row size: " << grid_row.size()
+                          << " at row: " << y << ", expected: " << grid_width
+                          << " in map file: " << map_file.GetFilename() << std::endl;
+        }
+
+        uint32_t row_size = std::min<uint32_t>(grid_row.size(), grid_width);
+        for(uint32_t x = 0; x < row_size; ++x)
+            collision_grid[y * grid_width + x] = (grid_row[x] > 0) ? 1 : 0;
+    }
+    map_file.CloseTable();
+
+    if(!map_file.DoesTableExist("layers")) {
+        PRINT_ERROR << "No 'layers' table in the map file." << std::endl;
+        return false;
+    }
+
+    // Read in the map tile indeces from all tile layers.
+    std::vector<int32_t> table_x_indeces; // Used to temporarily store a row of table indeces
+
+    map_file.OpenTable("layers");
+    layers.resize(map_file.GetTableSize());
+
+    // layers[0]-[n]
+    for(uint32_t layer_id = 0; layer_id < layers.size(); ++layer_id) {
+        // Opens the sub-table: layers[layer_id]
+        if(!map_file.DoesTableExist(layer_id))
+            continue;
+
+        map_file.OpenTable(layer_id);
+
+        MapLayerData& layer = layers[layer_id];
+        layer.type = map_file.ReadString("type");
+        layer.tiles.resize(num_tile_cols * num_tile_rows);
+
+        // Read the tile data
+        for(uint32_t y = 0; y < num_tile_rows; ++y) {
+            table_x_indeces.clear();
+
+            // Check to make sure tables are of the proper size
+            if(!map_file.DoesTableExist(y)) {
+                PRINT_ERROR << "the layers[" << layer_id << "] table size was not equal to the number of tile rows specified by the map, "
+                            " first missing row: " << y << std::endl;
+                return false;
+            }
+
+            map_file.ReadIntVector(y, table_x_indeces);
+
+            // Check the number of columns
+            if(table_x_indeces.size() != num_tile_cols) {
+                PRINT_ERROR << "the layers[" << layer_id << "][" << y << "] table size was not equal to the number of tile columns specified by the map, "
+                            "should have " << num_tile_cols << " values." << std::endl;
+                return false;
+            }
+
+            int16_t *row = &layer.tiles[y * num_tile_cols];
+            for(uint32_t x = 0; x < num_tile_cols; ++x) {
+                row[x] = table_x_indeces[x];
+            }
+        }
+        map_file.CloseTable(); // layers[layer_id]
+    }
+
+    map_file.CloseTable(); // layers
+    return true;
+}
+
+bool MapData::LoadCompiled(const std::string& filename, uint64_t source_hash)
+{
+    Clear();
+
+    std::vector<uint8_t> content;
+    if(!ReadFileContent(filename, content))
+        return false;
+
+    CompiledMapReader reader(content);
+    const uint8_t* magic = reader.ReadBytes(sizeof(MAP_DATA_COMPILED_MAGIC));
+    if(!magic || !std::equal(magic, magic + sizeof(MAP_DATA_COMPILED_MAGIC), MAP_DATA_COMPILED_MAGIC)) {
+        PRINT_WARNING << "Invalid compiled map data file: " << filename << std::endl;
+        return false;
+    }
+
+    // Outdated files are silently ignored, the map data Lua file being used instead.
+    if(reader.ReadUInt32() != MAP_DATA_COMPILED_VERSION || reader.ReadUInt(8) != source_hash)
+        return false;
+
+    num_tile_cols = reader.ReadUInt32();
+    num_tile_rows = reader.ReadUInt32();
+
+    uint32_t num_tilesets = reader.ReadUInt32();
+    for(uint32_t i = 0; i < num_tilesets && reader.IsValid(); ++i)
+        tileset_filenames.push_back(reader.ReadString());
+
+    grid_width = reader.ReadUInt32();
+    grid_height = reader.ReadUInt32();
+    const uint64_t grid_size = static_cast<uint64_t>(grid_width) * grid_height;
+    const uint8_t* grid = reader.ReadBytes(grid_size);
+    if(grid)
+        collision_grid.assign(grid, grid + grid_size);
+
+    uint32_t num_layers = reader.ReadUInt32();
+    for(uint32_t layer_id = 0; layer_id < num_layers && reader.IsValid(); ++layer_id) {
+        layers.push_back(MapLayerData());
+        MapLayerData& layer = layers.back();
+        layer.type = reader.ReadString();
+
+        uint32_t num_tiles = reader.ReadUInt32();
+        const uint8_t* tiles = reader.ReadBytes(static_cast<uint64_t>(num_tiles) * 2);
+        if(!tiles)
+            break;
+
+        layer.tiles.resize(num_tiles);
+        for(uint32_t i = 0; i < num_tiles; ++i)
+            layer.tiles[i] = static_cast<int16_t>(tiles[2 * i] | (tiles[2 * i + 1] << 8));
+    }
+
+    if(!reader.IsValid() || !reader.IsAtEnd()) {
+        PRINT_WARNING << "Invalid compiled map data file: " << filename << std::endl;
+        Clear();
+        return false;
+    }
+    return true;
+}
+
+bool MapData::SaveCompiled(const std::string& filename, uint64_t source_hash) const
+{
+    std::vector<uint8_t> content;
+    CompiledMapWriter writer(content);
+
+    content.insert(content.end(), MAP_DATA_COMPILED_MAGIC, MAP_DATA_COMPILED_MAGIC + sizeof(MAP_DATA_COMPILED_MAGIC));
+    writer.WriteUInt32(MAP_DATA_COMPILED_VERSION);
+    writer.WriteUInt(source_hash, 8);
+
+    writer.WriteUInt32(num_tile_cols);
+    writer.WriteUInt32(num_tile_rows);
+
+    writer.WriteUInt32(tileset_filenames.size());
+    for(uint32_t i = 0; i < tileset_filenames.size(); ++i)
+        writer.WriteString(tileset_filenames[i]);
+
+    writer.WriteUInt32(grid_width);
+    writer.WriteUInt32(grid_height);
+    content.insert(content.end(), collision_grid.begin(), collision_grid.end());
+
+    writer.WriteUInt32(layers.size());
+    for(uint32_t layer_id = 0; layer_id < layers.size(); ++layer_id) {
+        const MapLayerData& layer = layers[layer_id];
+        writer.WriteString(layer.type);
+        writer.WriteUInt32(layer.tiles.size());
+        for(uint32_t i = 0; i < layer.tiles.size(); ++i)
+            writer.WriteUInt(static_cast<uint16_t>(layer.tiles[i]), 2);
+    }
+
+    std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if(!file.good()) {
+        PRINT_ERROR << "Couldn't open the compiled map data file for writing: " << filename << std::endl;
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(&content[0]), content.size());
+    return !file.fail();
+}
+
+bool ComputeFileHash(const std::string& filename, uint64_t& hash)
+{
+    std::vector<uint8_t> content;
+    if(!ReadFileContent(filename, content))
+        return false;
+
+    hash = ComputeDataHash(content);
+    return true;
+}
+
+uint64_t ComputeDataHash(const std::vector<uint8_t>& data)
+{
+    // 64-bit FNV-1a
+    uint64_t hash = 14695981039346656037ULL;
+    for(size_t i = 0; i < data.size(); ++i) {
+        hash ^= data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+std::string GetCompiledMapDataFilename(const std::string& map_data_filename)
+{
+    const std::string lua_extension = ".lua";
+    if(map_data_filename.size() > lua_extension.size() &&
+            map_data_filename.compare(map_data_filename.size() - lua_extension.size(),
+                                      lua_extension.size(), lua_extension) == 0) {
+        return map_data_filename.substr(0, map_data_filename.size() - lua_extension.size())
+               + MAP_DATA_COMPILED_EXTENSION;
+    }
+    return map_data_filename + MAP_DATA_COMPILED_EXTENSION;
+}
+
+bool CompileMapData(const std::string& map_data_filename)
+{
+    uint64_t source_hash = 0;
+    if(!ComputeFileHash(map_data_filename, source_hash)) {
+        PRINT_ERROR << "Couldn't read the map data file: " << map_data_filename << std::endl;
+        return false;
+    }
+
+    ReadScriptDescriptor map_file;
+    if(!map_file.OpenFile(map_data_filename))
+        return false;
+
+    if(!map_file.OpenTable("map_data")) {
+        PRINT_ERROR << "Couldn't open the 'map_data' table in: " << map_data_filename << std::endl;
+        map_file.CloseFile();
+        return false;
+    }
+
+    MapData map_data;
+    bool loaded = map_data.LoadFromScript(map_file);
+    map_file.CloseAllTables();
+    map_file.CloseFile();
+    if(!loaded)
+        return false;
+
+    return map_data.SaveCompiled(GetCompiledMapDataFilename(map_data_filename), source_hash);
+}
+
+//! \brief Returns the user data directory where the game writes the map data files it compiled itself.
+static std::string _GetUserCompiledMapDataPath()
+{
+    return vt_common::GetUserDataPath() + "maps/";
+}
+
+std::string GetUserCompiledMapDataFilename(const std::string& map_data_filename)
+{
+    // Flatten the map data file path, so that every compiled file is written in the same directory.
+    std::string compiled_filename = GetCompiledMapDataFilename(map_data_filename);
+    std::replace(compiled_filename.begin(), compiled_filename.end(), '/', '_');
+    std::replace(compiled_filename.begin(), compiled_filename.end(), '\\', '_');
+    return _GetUserCompiledMapDataPath() + compiled_filename;
+}
+
+bool LoadCompiledMapData(const std::string& map_data_filename, const std::string& user_compiled_filename,
+                         uint64_t source_hash, MapData& map_data)
+{
+    // The files compiled along with the game data are used first.
+    if(map_data.LoadCompiled(GetCompiledMapDataFilename(map_data_filename), source_hash))
+        return true;
+
+    return !user_compiled_filename.empty() && map_data.LoadCompiled(user_compiled_filename, source_hash);
+}
+
+bool SaveUserCompiledMapData(const std::string& user_compiled_filename, uint64_t source_hash, const MapData& map_data)
+{
+    const std::string path = _GetUserCompiledMapDataPath();
+    if(!vt_utils::DoesFileExist(path) && !vt_utils::MakeDirectory(path)) {
+        PRINT_WARNING << "Couldn't create the compiled map data directory: " << path << std::endl;
+        return false;
+    }
+
+    return map_data.SaveCompiled(user_compiled_filename, source_hash);
+}
+
+} // namespace private_map
+
+} // namespace vt_map
@@ -0,0 +1,155 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2016 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See https://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    map_data.h
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Header file for the map data loading and compilation.
+***
+*** The map data (grid size, tilesets, collision grid and tile layers) is
+*** either read from the map data Lua file, or from its compiled binary
+*** counterpart when it exists and was compiled from the very same Lua file.
+*** The compiled files are either shipped next to the Lua files (see tools/compile-maps.sh),
+*** or written in the user data directory the first time a map is read from Lua.
+***
+*** Compiled map data file format, all values being little-endian:
+*** - "VTMD" magic, uint32 version, uint64 hash of the source Lua file.
+*** - uint32 number of tile columns, uint32 number of tile rows.
+*** - uint32 number of tilesets, then each tileset filename as a uint32 length and its characters.
+*** - uint32 grid width, uint32 grid height, then one byte per grid element, row after row.
+*** - uint32 number of layers, then for each layer: the type as a uint32 length and its characters,
+***   uint32 number of tiles, then each tile as an int16, row after row.
+*** ***************************************************************************/
+
+#ifndef __MAP_DATA_HEADER__
+#define __MAP_DATA_HEADER__
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace vt_script
+{
+class ReadScriptDescriptor;
+}
+
+namespace vt_map
+{
+
+namespace private_map
+{
+
+//! \brief The compiled map data file format version, to increment whenever the format changes.
+const uint32_t MAP_DATA_COMPILED_VERSION = 1;
+
+//! \brief The extension replacing the '.lua' one of the compiled map data files.
+const std::string MAP_DATA_COMPILED_EXTENSION = ".vtmap";
+
+//! \brief The tiles of one map layer.
+class MapLayerData
+{
+public:
+    //! \brief The layer type name, empty if the layer isn't defined.
+    std::string type;
+
+    //! \brief The tile indeces, row after row, or empty if the layer isn't defined.
+    std::vector<int16_t> tiles;
+};
+
+/** ****************************************************************************
+*** \brief The map data table content, used to load the tile and object supervisors.
+*** ***************************************************************************/
+class MapData
+{
+public:
+    MapData() :
+        num_tile_cols(0),
+        num_tile_rows(0),
+        grid_width(0),
+        grid_height(0)
+    {}
+
+    //! \brief The map size, in tiles.
+    uint32_t num_tile_cols;
+    uint32_t num_tile_rows;
+
+    //! \brief The tileset definition files used.
+    std::vector<std::string> tileset_filenames;
+
+    //! \brief The collision grid size, in grid elements.
+    uint32_t grid_width;
+    uint32_t grid_height;
+
+    //! \brief The collision grid, row after row. Non-zero values are walls.
+    std::vector<uint8_t> collision_grid;
+
+    //! \brief The tile layers, by layer id.
+    std::vector<MapLayerData> layers;
+
+    //! \brief Removes every data.
+    void Clear();
+
+    /** \brief Reads the map data from the map data Lua file.
+    *** \param map_file The map data file, with the 'map_data' table opened.
+    *** \return false if the map data is invalid.
+    **/
+    bool LoadFromScript(vt_script::ReadScriptDescriptor& map_file);
+
+    /** \brief Reads the map data from a compiled map data file, read at once.
+    *** \param source_hash The hash of the current map data Lua file.
+    *** \return false if the file doesn't exist, is invalid, or wasn't compiled from that Lua file.
+    **/
+    bool LoadCompiled(const std::string& filename, uint64_t source_hash);
+
+    /** \brief Writes the map data to a compiled map data file.
+    *** \param source_hash The hash of the map data Lua file the data was read from.
+    **/
+    bool SaveCompiled(const std::string& filename, uint64_t source_hash) const;
+};
+
+/** \brief Computes the 64-bit FNV-1a hash of the given file content.
+*** \return false if the file couldn't be read.
+**/
+bool ComputeFileHash(const std::string& filename, uint64_t& hash);
+
+//! \brief Computes the 64-bit FNV-1a hash of the given data.
+uint64_t ComputeDataHash(const std::vector<uint8_t>& data);
+
+//! \brief Returns the compiled map data filename corresponding to a map data Lua file.
+std::string GetCompiledMapDataFilename(const std::string& map_data_filename);
+
+/** \brief Compiles the given map data Lua file next to it.
+*** \note The script engine must be initialized.
+**/
+bool CompileMapData(const std::string& map_data_filename);
+
+/** \brief Returns the filename of the compiled map data the game writes in the user data directory,
+*** when no up to date compiled file was found next to the map data Lua file.
+*** \note Only call it from the main thread.
+**/
+std::string GetUserCompiledMapDataFilename(const std::string& map_data_filename);
+
+/** \brief Reads the compiled map data file next to the map data Lua file, or else the one in the user data directory.
+*** \param source_hash The hash of the current map data Lua file.
+*** \return false if none of them was compiled from that Lua file.
+**/
+bool LoadCompiledMapData(const std::string& map_data_filename, const std::string& user_compiled_filename,
+                         uint64_t source_hash, MapData& map_data);
+
+/** \brief Writes the map data just read from its Lua file in the user data directory,
+*** so that the next loads of the map don't have to parse it.
+*** \note Only call it from the main thread.
+**/
+bool SaveUserCompiledMapData(const std::string& user_compiled_filename, uint64_t source_hash, const MapData& map_data);
+
+} // namespace private_map
+
+} // namespace vt_map
+
+#endif // __MAP_DATA_HEADER__
@@ -15,6 +15,8 @@
 
 #include "engine/system.h"
 
+#include <algorithm>
+
 namespace vt_map
 {
 
@@ -25,8 +27,9 @@ EventSupervisor::~EventSupervisor()
 {
     _active_events.clear();
     _paused_events.clear();
-    _active_delayed_events.clear();
+    _delayed_events.clear();
     _paused_delayed_events.clear();
+    _events_by_handle.clear();
 
     for(std::map<std::string, MapEvent *>::iterator it = _all_events.begin(); it != _all_events.end(); ++it) {
         delete it->second;
@@ -60,7 +63,7 @@ void EventSupervisor::StartEvent(const std::string &event_id, uint32_t launch_ti
     if(launch_time == 0)
         StartEvent(event);
     else
-        _active_delayed_events.push_back(std::make_pair(static_cast<int32_t>(launch_time), event));
+        _ScheduleDelayedEvent(event, launch_time);
 }
 
 void EventSupervisor::StartEvent(MapEvent *event, uint32_t launch_time)
@@ -74,7 +77,7 @@ void EventSupervisor::StartEvent(MapEvent *event, uint32_t launch_time)
     if(launch_time == 0)
         StartEvent(event);
     else
-        _active_delayed_events.push_back(std::make_pair(static_cast<int32_t>(launch_time), event));
+        _ScheduleDelayedEvent(event, launch_time);
 }
 
 void EventSupervisor::StartEvent(MapEvent *event)
@@ -93,22 +96,46 @@ void EventSupervisor::StartEvent(MapEvent *event)
         return;
     }
 
-    for(std::vector<MapEvent *>::iterator it = _active_events.begin(); it != _active_events.end(); ++it) {
-        if((*it) == event) {
-            PRINT_WARNING << "The event: '" << event->GetEventID()
-                          << "' is already active and can be active only once at a time. "
-                          << "The StartEvent() call will be ignored."
-                          << std::endl << " You should fix the map script: "
-                          << MapMode::CurrentInstance()->GetMapScriptFilename() << std::endl;
-            return;
-        }
+    if(IsEventActive(event)) {
+        PRINT_WARNING << "The event: '" << event->GetEventID()
+                      << "' is already active and can be active only once at a time. "
+                      << "The StartEvent() call will be ignored."
+                      << std::endl << " You should fix the map script: "
+                      << MapMode::CurrentInstance()->GetMapScriptFilename() << std::endl;
+        return;
     }
 
-    _active_events.push_back(event);
+    _AddActiveEvent(event);
     event->_Start();
     _ExamineEventLinks(event, true);
 }
 
+void EventSupervisor::StartEventByHandle(uint32_t handle)
+{
+    MapEvent *event = GetEventByHandle(handle);
+    if(event == nullptr) {
+        PRINT_WARNING << "No event with this handle existed: " << handle
+            << " in map script: "
+            << MapMode::CurrentInstance()->GetMapScriptFilename() << std::endl;
+        return;
+    }
+
+    StartEvent(event);
+}
+
+void EventSupervisor::StartEventByHandle(uint32_t handle, uint32_t launch_time)
+{
+    MapEvent *event = GetEventByHandle(handle);
+    if(event == nullptr) {
+        PRINT_WARNING << "No event with this handle existed: " << handle
+            << " in map script: "
+            << MapMode::CurrentInstance()->GetMapScriptFilename() << std::endl;
+        return;
+    }
+
+    StartEvent(event, launch_time);
+}
+
 void EventSupervisor::PauseEvent(const std::string &event_id)
 {
     // Never ever do that when updating events.
@@ -120,26 +147,18 @@ void EventSupervisor::PauseEvent(const std::string &event_id)
         return;
     }
 
-    // Search for active ones
-    for(std::vector<MapEvent *>::iterator it = _active_events.begin(); it != _active_events.end();) {
-        if((*it)->_event_id == event_id) {
-            _paused_events.push_back(*it);
-            it = _active_events.erase(it);
-        } else {
-            ++it;
-        }
+    MapEvent *event = GetEvent(event_id);
+    if(event == nullptr)
+        return;
+
+    // Search for the active one
+    if(IsEventActive(event)) {
+        _RemoveActiveEvent(event);
+        _paused_events.push_back(event);
     }
 
     // and for the delayed ones
-    for(std::vector<std::pair<int32_t, MapEvent *> >::iterator it = _active_delayed_events.begin();
-            it != _active_delayed_events.end();) {
-        if((*it).second->_event_id == event_id) {
-            _paused_delayed_events.push_back(*it);
-            it = _active_delayed_events.erase(it);
-        } else {
-            ++it;
-        }
-    }
+    _PauseDelayedEvent(event);
 }
 
 void EventSupervisor::PauseAllEvents(VirtualSprite *sprite)
@@ -158,27 +177,19 @@ void EventSupervisor::PauseAllEvents(VirtualSprite *sprite)
     }
 
     // Starting by active ones.
-    for(std::vector<MapEvent *>::iterator it = _active_events.begin(); it != _active_events.end();) {
-        SpriteEvent *event = dynamic_cast<SpriteEvent *>(*it);
+    for(uint32_t i = 0; i < _active_events.size(); ++i) {
+        SpriteEvent *event = dynamic_cast<SpriteEvent *>(_active_events[i]);
         if(event && event->GetSprite() == sprite) {
-            _paused_events.push_back(*it);
-            it = _active_events.erase(it);
-        } else {
-            ++it;
+            _RemoveActiveEvent(event);
+            _paused_events.push_back(event);
         }
     }
 
     // Looking at incoming ones.
-    for(std::vector<std::pair<int32_t, MapEvent *> >::iterator it = _active_delayed_events.begin();
-            it != _active_delayed_events.end();) {
-        SpriteEvent *event = dynamic_cast<SpriteEvent *>((*it).second);
-        if(event && event->GetSprite() == sprite) {
-            _paused_delayed_events.push_back(*it);
-            it = _active_delayed_events.erase(it);
-        } else {
-            ++it;
-        }
-    }
+    std::vector<MapEvent *> delayed_events;
+    _GetDelayedSpriteEvents(sprite, delayed_events);
+    for(uint32_t i = 0; i < delayed_events.size(); ++i)
+        _PauseDelayedEvent(delayed_events[i]);
 }
 
 void EventSupervisor::ResumeEvent(const std::string &event_id)
@@ -192,10 +203,16 @@ void EventSupervisor::ResumeEvent(const std::string &event_id)
         return;
     }
 
+    MapEvent *event = GetEvent(event_id);
+    if(event == nullptr)
+        return;
+
     for(std::vector<MapEvent *>::iterator it = _paused_events.begin();
             it != _paused_events.end();) {
-        if((*it)->_event_id == event_id) {
-            _active_events.push_back(*it);
+        if(*it == event) {
+            // The event may have been started again in the meantime.
+            if(!IsEventActive(event))
+                _AddActiveEvent(event);
             it = _paused_events.erase(it);
         } else {
             ++it;
@@ -205,8 +222,8 @@ void EventSupervisor::ResumeEvent(const std::string &event_id)
     // and the delayed ones
     for(std::vector<std::pair<int32_t, MapEvent *> >::iterator it = _paused_delayed_events.begin();
             it != _paused_delayed_events.end();) {
-        if((*it).second->_event_id == event_id) {
-            _active_delayed_events.push_back(*it);
+        if((*it).second == event) {
+            _ScheduleDelayedEvent(event, (*it).first);
             it = _paused_delayed_events.erase(it);
         } else {
             ++it;
@@ -233,7 +250,9 @@ void EventSupervisor::ResumeAllEvents(VirtualSprite *sprite)
     for(std::vector<MapEvent *>::iterator it = _paused_events.begin(); it != _paused_events.end();) {
         SpriteEvent *event = dynamic_cast<SpriteEvent *>(*it);
         if(event && event->GetSprite() == sprite) {
-            _active_events.push_back(*it);
+            // The event may have been started again in the meantime.
+            if(!IsEventActive(event))
+                _AddActiveEvent(event);
             it = _paused_events.erase(it);
         } else {
             ++it;
@@ -245,7 +264,7 @@ void EventSupervisor::ResumeAllEvents(VirtualSprite *sprite)
             it != _paused_delayed_events.end();) {
         SpriteEvent *event = dynamic_cast<SpriteEvent *>((*it).second);
         if(event && event->GetSprite() == sprite) {
-            _active_delayed_events.push_back(*it);
+            _ScheduleDelayedEvent(event, (*it).first);
             it = _paused_delayed_events.erase(it);
         } else {
             ++it;
@@ -255,8 +274,6 @@ void EventSupervisor::ResumeAllEvents(VirtualSprite *sprite)
 
 void EventSupervisor::EndEvent(const std::string &event_id, bool trigger_event_links)
 {
-    // Examine all potential active (now or later) events
-
     // Never ever do that when updating events.
     if(_is_updating) {
         PRINT_WARNING << "Tried to terminate the event: '" << event_id
@@ -266,70 +283,11 @@ void EventSupervisor::EndEvent(const std::string &event_id, bool trigger_event_l
         return;
     }
 
-    // Starting by active ones.
-    for(std::vector<MapEvent *>::iterator it = _active_events.begin(); it != _active_events.end();) {
-        if((*it)->_event_id == event_id) {
-            SpriteEvent *sprite_event = dynamic_cast<SpriteEvent *>(*it);
-            // Terminated sprite events need to release their owned sprite.
-            if(sprite_event)
-                sprite_event->Terminate();
-
-            MapEvent *terminated_event = *it;
-            it = _active_events.erase(it);
-            // We examine the event links only after the event has been removed from the active list
-            if(trigger_event_links)
-                _ExamineEventLinks(terminated_event, false);
-        } else {
-            ++it;
-        }
-    }
-
-    // Looking at incoming ones.
-    for(std::vector<std::pair<int32_t, MapEvent *> >::iterator it = _active_delayed_events.begin();
-            it != _active_delayed_events.end();) {
-        if((*it).second->_event_id == event_id) {
-            MapEvent *terminated_event = (*it).second;
-            it = _active_delayed_events.erase(it);
-
-            // We examine the event links only after the event has been removed from the active list
-            if(trigger_event_links)
-                _ExamineEventLinks(terminated_event, false);
-        } else {
-            ++it;
-        }
-    }
-
-    // And paused ones
-    for(std::vector<MapEvent *>::iterator it = _paused_events.begin(); it != _paused_events.end();) {
-        if((*it)->_event_id == event_id) {
-            SpriteEvent *sprite_event = dynamic_cast<SpriteEvent *>(*it);
-            // Paused sprite events need to release their owned sprite as they have been previously started.
-            if(sprite_event)
-                sprite_event->Terminate();
-
-            MapEvent *terminated_event = *it;
-            it = _paused_events.erase(it);
-            // We examine the event links only after the event has been removed from the list
-            if(trigger_event_links)
-                _ExamineEventLinks(terminated_event, false);
-        } else {
-            ++it;
-        }
-    }
-
-    for(std::vector<std::pair<int32_t, MapEvent *> >::iterator it = _paused_delayed_events.begin();
-            it != _paused_delayed_events.end();) {
-        if((*it).second->_event_id == event_id) {
-            MapEvent *terminated_event = (*it).second;
-            it = _paused_delayed_events.erase(it);
+    MapEvent *event = GetEvent(event_id);
+    if(event == nullptr)
+        return;
 
-            // We examine the event links only after the event has been removed from the list
-            if(trigger_event_links)
-                _ExamineEventLinks(terminated_event, false);
-        } else {
-            ++it;
-        }
-    }
+    _EndEvent(event, trigger_event_links);
 }
 
 void EventSupervisor::EndEvent(MapEvent *event, bool trigger_event_links)
@@ -348,7 +306,7 @@ void EventSupervisor::EndEvent(MapEvent *event, bool trigger_event_links)
         return;
     }
 
-    EndEvent(event->GetEventID(), trigger_event_links);
+    _EndEvent(event, trigger_event_links);
 }
 
 void EventSupervisor::EndAllEvents(VirtualSprite *sprite)
@@ -367,27 +325,21 @@ void EventSupervisor::EndAllEvents(VirtualSprite *sprite)
     }
 
     // Starting by active ones.
-    for(std::vector<MapEvent *>::iterator it = _active_events.begin(); it != _active_events.end();) {
-        SpriteEvent *event = dynamic_cast<SpriteEvent *>(*it);
+    for(uint32_t i = 0; i < _active_events.size(); ++i) {
+        SpriteEvent *event = dynamic_cast<SpriteEvent *>(_active_events[i]);
         if(event && event->GetSprite() == sprite) {
             // Active events need to release their owned sprite upon termination.
             event->Terminate();
 
-            it = _active_events.erase(it);
-        } else {
-            ++it;
+            _RemoveActiveEvent(event);
         }
     }
 
     // Looking at incoming ones.
-    for(std::vector<std::pair<int32_t, MapEvent *> >::iterator it = _active_delayed_events.begin();
-            it != _active_delayed_events.end();) {
-        SpriteEvent *event = dynamic_cast<SpriteEvent *>((*it).second);
-        if(event && event->GetSprite() == sprite)
-            it = _active_delayed_events.erase(it);
-        else
-            ++it;
-    }
+    std::vector<MapEvent *> delayed_events;
+    _GetDelayedSpriteEvents(sprite, delayed_events);
+    for(uint32_t i = 0; i < delayed_events.size(); ++i)
+        _CancelDelayedEvent(delayed_events[i]);
 
     // And paused ones
     for(std::vector<MapEvent *>::iterator it = _paused_events.begin(); it != _paused_events.end();) {
@@ -414,24 +366,26 @@ void EventSupervisor::EndAllEvents(VirtualSprite *sprite)
 
 void EventSupervisor::Update()
 {
+    _current_time += vt_system::SystemManager->GetUpdateTime();
+
     // Store the events that became active in the delayed event loop.
     std::vector<MapEvent *> events_to_start;
 
-    // Update all launch event timers and start all events whose timers have finished
-    for(std::vector<std::pair<int32_t, MapEvent *> >::iterator it = _active_delayed_events.begin();
-            it != _active_delayed_events.end();) {
-        it->first -= vt_system::SystemManager->GetUpdateTime();
+    // Take every launch whose time has come from the heap front.
+    while(!_delayed_events.empty() && _delayed_events.front().launch_time <= _current_time) {
+        const DelayedEvent delayed_event = _delayed_events.front();
+        std::pop_heap(_delayed_events.begin(), _delayed_events.end());
+        _delayed_events.pop_back();
+
+        if(_IsCancelled(delayed_event))
+            continue;
 
-        if(it->first <= 0) {  // Timer has expired
-            MapEvent *start_event = it->second;
-            it = _active_delayed_events.erase(it);
+        --delayed_event.event->_num_delayed_launches;
+        --_num_delayed_events;
 
-            // We add the event ready to start i a vector, waiting for the loop to end
-            // before starting it.
-            events_to_start.push_back(start_event);
-        } else {
-            ++it;
-        }
+        // We add the event ready to start i a vector, waiting for the loop to end
+        // before starting it.
+        events_to_start.push_back(delayed_event.event);
     }
 
     // Starts the events that became active.
@@ -445,20 +399,21 @@ void EventSupervisor::Update()
     _is_updating = true;
 
     // Check for active events which have finished
-    for(std::vector<MapEvent *>::iterator it = _active_events.begin(); it != _active_events.end();) {
-        if((*it)->_Update()) {
+    for(uint32_t i = 0; i < _active_events.size(); ++i) {
+        MapEvent *event = _active_events[i];
+        if(event && event->_Update()) {
             // Add it ot the finished events list
-            finished_events.push_back(*it);
+            finished_events.push_back(event);
 
             // Remove the finished event from the active queue.
-            it = _active_events.erase(it);
-        } else {
-            ++it;
+            _RemoveActiveEvent(event);
         }
     }
 
     _is_updating = false;
 
+    _CompactActiveEvents();
+
     // We examine the event links only after the events has been removed from the active list
     // and the active list has finished parsing, to avoid a crash when adding a new event within the update loop.
     for(std::vector<MapEvent *>::iterator it = finished_events.begin(); it != finished_events.end(); ++it) {
@@ -468,12 +423,7 @@ void EventSupervisor::Update()
 
 bool EventSupervisor::IsEventActive(const std::string &event_id) const
 {
-    for(std::vector<MapEvent *>::const_iterator it = _active_events.begin(); it != _active_events.end(); ++it) {
-        if((*it)->_event_id == event_id) {
-            return true;
-        }
-    }
-    return false;
+    return IsEventActive(GetEvent(event_id));
 }
 
 MapEvent *EventSupervisor::GetEvent(const std::string &event_id) const
@@ -486,6 +436,21 @@ MapEvent *EventSupervisor::GetEvent(const std::string &event_id) const
         return it->second;
 }
 
+uint32_t EventSupervisor::GetEventHandle(const std::string &event_id) const
+{
+    MapEvent *event = GetEvent(event_id);
+    return event ? event->_handle : 0;
+}
+
+void EventSupervisor::GetEventsByType(EVENT_TYPE event_type, std::vector<MapEvent*>& events) const
+{
+    events.clear();
+    for(std::map<std::string, MapEvent *>::const_iterator it = _all_events.begin(); it != _all_events.end(); ++it) {
+        if(it->second->GetEventType() == event_type)
+            events.push_back(it->second);
+    }
+}
+
 bool EventSupervisor::_RegisterEvent(MapEvent* new_event)
 {
     if(new_event == nullptr) {
@@ -502,6 +467,8 @@ bool EventSupervisor::_RegisterEvent(MapEvent* new_event)
     }
 
     _all_events.insert(std::make_pair(new_event->_event_id, new_event));
+    _events_by_handle.push_back(new_event);
+    new_event->_handle = _events_by_handle.size();
     return true;
 }
 
@@ -514,27 +481,190 @@ void EventSupervisor::_ExamineEventLinks(MapEvent *parent_event, bool event_star
         if(link.launch_at_start != event_start) {
             continue;
         }
+
+        // The child event may be registered after the link is declared, so it is looked up the first time only.
+        if(link.child_event_handle == 0)
+            link.child_event_handle = GetEventHandle(link.child_event_id);
+
+        MapEvent *child = GetEventByHandle(link.child_event_handle);
+        if(child == nullptr) {
+            PRINT_WARNING << "Couldn't launch child event, no event with this ID existed: '"
+                          << link.child_event_id << "' from parent event ID: '"
+                          << parent_event->GetEventID()
+                          << "' in map script: "
+                          << MapMode::CurrentInstance()->GetMapScriptFilename() << std::endl;
+            continue;
+        }
         // Case 2: The child event is to be launched immediately
         else if(link.launch_timer == 0) {
-            StartEvent(link.child_event_id);
+            StartEvent(child);
         }
         // Case 3: The child event has a timer associated with it and needs to be placed in the event launch container
         else {
-            MapEvent *child = GetEvent(link.child_event_id);
-            if(child == nullptr) {
-                PRINT_WARNING << "Couldn't launch child event, no event with this ID existed: '"
-                              << link.child_event_id << "' from parent event ID: '"
-                              << parent_event->GetEventID()
-                              << "' in map script: "
-                              << MapMode::CurrentInstance()->GetMapScriptFilename() << std::endl;
-                continue;
-            } else {
-                _active_delayed_events.push_back(std::make_pair(static_cast<int32_t>(link.launch_timer), child));
-            }
+            _ScheduleDelayedEvent(child, link.launch_timer);
         }
     }
 }
 
+void EventSupervisor::_EndEvent(MapEvent *event, bool trigger_event_links)
+{
+    // Examine all potential active (now or later) events
+
+    // Starting by the active one.
+    if(IsEventActive(event)) {
+        SpriteEvent *sprite_event = dynamic_cast<SpriteEvent *>(event);
+        // Terminated sprite events need to release their owned sprite.
+        if(sprite_event)
+            sprite_event->Terminate();
+
+        _RemoveActiveEvent(event);
+        // We examine the event links only after the event has been removed from the active list
+        if(trigger_event_links)
+            _ExamineEventLinks(event, false);
+    }
+
+    // Looking at incoming ones.
+    uint32_t num_delayed_launches = event->_num_delayed_launches;
+    _CancelDelayedEvent(event);
+    // We examine the event links only after the event has been removed from the delayed events
+    for(uint32_t i = 0; trigger_event_links && i < num_delayed_launches; ++i)
+        _ExamineEventLinks(event, false);
+
+    // And paused ones
+    for(std::vector<MapEvent *>::iterator it = _paused_events.begin(); it != _paused_events.end();) {
+        if(*it == event) {
+            SpriteEvent *sprite_event = dynamic_cast<SpriteEvent *>(event);
+            // Paused sprite events need to release their owned sprite as they have been previously started.
+            if(sprite_event)
+                sprite_event->Terminate();
+
+            it = _paused_events.erase(it);
+            // We examine the event links only after the event has been removed from the list
+            if(trigger_event_links)
+                _ExamineEventLinks(event, false);
+        } else {
+            ++it;
+        }
+    }
+
+    for(std::vector<std::pair<int32_t, MapEvent *> >::iterator it = _paused_delayed_events.begin();
+            it != _paused_delayed_events.end();) {
+        if((*it).second == event) {
+            it = _paused_delayed_events.erase(it);
+
+            // We examine the event links only after the event has been removed from the list
+            if(trigger_event_links)
+                _ExamineEventLinks(event, false);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void EventSupervisor::_AddActiveEvent(MapEvent *event)
+{
+    event->_active_index = static_cast<int32_t>(_active_events.size());
+    _active_events.push_back(event);
+    ++_num_active_events;
+}
+
+void EventSupervisor::_RemoveActiveEvent(MapEvent *event)
+{
+    if(!IsEventActive(event))
+        return;
+
+    // The slot is freed at the next update, to keep the events update order.
+    _active_events[event->_active_index] = nullptr;
+    event->_active_index = -1;
+    --_num_active_events;
+}
+
+void EventSupervisor::_CompactActiveEvents()
+{
+    if(_num_active_events == _active_events.size())
+        return;
+
+    uint32_t num_events = 0;
+    for(uint32_t i = 0; i < _active_events.size(); ++i) {
+        MapEvent *event = _active_events[i];
+        if(event == nullptr)
+            continue;
+
+        event->_active_index = static_cast<int32_t>(num_events);
+        _active_events[num_events++] = event;
+    }
+    _active_events.resize(num_events);
+}
+
+void EventSupervisor::_ScheduleDelayedEvent(MapEvent *event, uint32_t launch_time)
+{
+    _delayed_events.push_back(DelayedEvent(_current_time + launch_time, ++_delayed_sequence,
+                                           event->_delayed_generation, event));
+    std::push_heap(_delayed_events.begin(), _delayed_events.end());
+
+    ++event->_num_delayed_launches;
+    ++_num_delayed_events;
+}
+
+void EventSupervisor::_CancelDelayedEvent(MapEvent *event)
+{
+    if(event->_num_delayed_launches == 0)
+        return;
+
+    // The launches already in the heap are ignored from now on.
+    ++event->_delayed_generation;
+    _num_delayed_events -= event->_num_delayed_launches;
+    event->_num_delayed_launches = 0;
+
+    // Don't let the cancelled launches pile up when they are far in time.
+    const uint32_t num_cancelled = _delayed_events.size() - _num_delayed_events;
+    if(num_cancelled < 64 || num_cancelled < _num_delayed_events)
+        return;
+
+    std::vector<DelayedEvent> delayed_events;
+    delayed_events.reserve(_num_delayed_events);
+    for(uint32_t i = 0; i < _delayed_events.size(); ++i) {
+        if(!_IsCancelled(_delayed_events[i]))
+            delayed_events.push_back(_delayed_events[i]);
+    }
+    _delayed_events.swap(delayed_events);
+    std::make_heap(_delayed_events.begin(), _delayed_events.end());
+}
+
+void EventSupervisor::_PauseDelayedEvent(MapEvent *event)
+{
+    if(event->_num_delayed_launches == 0)
+        return;
+
+    for(uint32_t i = 0; i < _delayed_events.size(); ++i) {
+        const DelayedEvent &delayed_event = _delayed_events[i];
+        if(delayed_event.event != event || _IsCancelled(delayed_event))
+            continue;
+
+        // Keep the time remaining before the launch.
+        int32_t remaining_time = 0;
+        if(delayed_event.launch_time > _current_time)
+            remaining_time = static_cast<int32_t>(delayed_event.launch_time - _current_time);
+        _paused_delayed_events.push_back(std::make_pair(remaining_time, event));
+    }
+
+    _CancelDelayedEvent(event);
+}
+
+void EventSupervisor::_GetDelayedSpriteEvents(VirtualSprite *sprite, std::vector<MapEvent *>& events) const
+{
+    events.clear();
+    for(uint32_t i = 0; i < _delayed_events.size(); ++i) {
+        const DelayedEvent &delayed_event = _delayed_events[i];
+        if(_IsCancelled(delayed_event))
+            continue;
+
+        SpriteEvent *event = dynamic_cast<SpriteEvent *>(delayed_event.event);
+        if(event && event->GetSprite() == sprite && std::find(events.begin(), events.end(), event) == events.end())
+            events.push_back(event);
+    }
+}
+
 } // namespace private_map
 
 } // namespace vt_map
@@ -33,17 +33,24 @@ namespace private_map
 *** Immediately after starting the first event, the supervisor will examine its event
 *** links to determine which, if any, children events begin relative to the start of
 *** the base event. If they are to start a certain time after the start of the parent
-*** event, they are placed in a container and their countdown timers are initialized.
-*** These timers will count down on every update call to the event manager and after
-*** the timers expire, these events will be launched. When an active event ends, again
+*** event, they are placed in a heap ordered by their absolute launch time, and are
+*** launched once the supervisor time reaches it, so that only the due events are
+*** looked at on each update. When an active event ends, again
 *** its event links are examined to determine if any children events exist that start
 *** relative to the end of the parent event.
+***
+*** Each event is given an integer handle at registration, which can be used
+*** instead of its ID to avoid looking it up by string.
 *** ***************************************************************************/
 class EventSupervisor
 {
     friend class MapEvent;
 public:
     EventSupervisor():
+        _num_active_events(0),
+        _num_delayed_events(0),
+        _delayed_sequence(0),
+        _current_time(0),
         _is_updating(false)
     {}
 
@@ -69,6 +76,10 @@ public:
     void StartEvent(MapEvent* event);
     void StartEvent(MapEvent* event, uint32_t launch_time);
 
+    //! \brief Starts the event with the given handle, see StartEvent().
+    void StartEventByHandle(uint32_t handle);
+    void StartEventByHandle(uint32_t handle, uint32_t launch_time);
+
     /** \brief Pauses the active events by preventing them from updating
     *** \param event_id The ID of the active event(s) to pause
     *** If the event corresponding to the ID is not active, a warning will be issued and no change
@@ -119,14 +130,22 @@ public:
     **/
     bool IsEventActive(const std::string& event_id) const;
 
+    bool IsEventActive(const MapEvent* event) const {
+        return event && event->_active_index >= 0;
+    }
+
+    bool IsEventActiveByHandle(uint32_t handle) const {
+        return IsEventActive(GetEventByHandle(handle));
+    }
+
     //! \brief Returns true if any events are active
     bool HasActiveEvent() const {
-        return !_active_events.empty();
+        return _num_active_events > 0;
     }
 
     //! \brief Returns true if any events are being prepared to be launched after their timers expire
     bool HasActiveDelayedEvent() const {
-        return !_active_delayed_events.empty();
+        return _num_delayed_events > 0;
     }
 
     /** \brief Returns a pointer to a specified event stored by this class
@@ -138,23 +157,86 @@ public:
     bool DoesEventExist(const std::string& event_id) const
     { return !(GetEvent(event_id) == nullptr); }
 
+    /** \brief Returns the handle of the given event, which stays valid for the whole map life.
+    *** \return The event handle, or 0 if no event was found
+    **/
+    uint32_t GetEventHandle(const std::string& event_id) const;
+
+    //! \brief Returns the event with the given handle, or nullptr if the handle is invalid.
+    MapEvent* GetEventByHandle(uint32_t handle) const {
+        if(handle == 0 || handle > _events_by_handle.size())
+            return nullptr;
+        return _events_by_handle[handle - 1];
+    }
+
+    //! \brief Gets every registered event of the given type.
+    void GetEventsByType(EVENT_TYPE event_type, std::vector<MapEvent*>& events) const;
+
 private:
+    //! \brief A launch of an event scheduled at a given supervisor time.
+    class DelayedEvent
+    {
+    public:
+        DelayedEvent(uint64_t time, uint32_t sequence_number, uint32_t delayed_generation, MapEvent* delayed_event) :
+            launch_time(time),
+            sequence(sequence_number),
+            generation(delayed_generation),
+            event(delayed_event)
+        {}
+
+        //! \brief The supervisor time at which the event is launched.
+        uint64_t launch_time;
+
+        //! \brief Keeps the launches scheduled at the same time in scheduling order.
+        uint32_t sequence;
+
+        //! \brief The event delayed generation when scheduled. The launch is cancelled when it differs.
+        uint32_t generation;
+
+        MapEvent* event;
+
+        //! \brief Orders the heap so that the next launch is at its front.
+        bool operator<(const DelayedEvent& other) const {
+            if(launch_time != other.launch_time)
+                return launch_time > other.launch_time;
+            return sequence > other.sequence;
+        }
+    };
+
     //! \brief A container for all map events, where the event's ID serves as the key to the std::map
     std::map<std::string, MapEvent*> _all_events;
 
-    //! \brief A list of all events which have started but are not yet finished
+    //! \brief All the map events, where the event handle minus one is the index.
+    std::vector<MapEvent*> _events_by_handle;
+
+    /** \brief A list of all events which have started but are not yet finished
+    *** Events ended outside of the update loop leave a nullptr in their place,
+    *** which is removed at the end of the next update.
+    **/
     std::vector<MapEvent*> _active_events;
 
+    //! \brief The number of events in the active events list.
+    uint32_t _num_active_events;
+
     //! \brief A list of all events which have been paused
     std::vector<MapEvent*> _paused_events;
 
-    /** \brief A list of all events that are waiting on their launch timers to expire before being started
-    *** The interger part of this std::pair is the countdown timer for this event to be launched
+    /** \brief The heap of the events that are waiting for their launch time before being started.
+    *** Cancelled launches are kept until they reach the front of the heap, or until there are too many of them.
     **/
-    std::vector<std::pair<int32_t, MapEvent*> > _active_delayed_events;
+    std::vector<DelayedEvent> _delayed_events;
+
+    //! \brief The number of launches in the delayed events heap which aren't cancelled.
+    uint32_t _num_delayed_events;
+
+    //! \brief The sequence number given to the last scheduled launch.
+    uint32_t _delayed_sequence;
+
+    //! \brief The time elapsed since the supervisor creation, in milliseconds.
+    uint64_t _current_time;
 
     /** \brief A list of all events that are waiting on their launch timers to expire before being started
-    *** The interger part of this std::pair is the countdown timer for this event to be launched
+    *** The interger part of this std::pair is the time remaining before this event is launched
     *** Those ones are put on hold by PauseAllEvents() and PauseEvent();
     **/
     std::vector<std::pair<int32_t, MapEvent*> > _paused_delayed_events;
@@ -170,6 +252,35 @@ private:
     **/
     void _ExamineEventLinks(MapEvent* parent_event, bool event_start);
 
+    //! \brief Terminates the given event, see EndEvent().
+    void _EndEvent(MapEvent* event, bool trigger_event_links);
+
+    //! \brief Adds the event to the active events list.
+    void _AddActiveEvent(MapEvent* event);
+
+    //! \brief Removes the event from the active events list, if it is in it.
+    void _RemoveActiveEvent(MapEvent* event);
+
+    //! \brief Removes the ended events left in the active events list.
+    void _CompactActiveEvents();
+
+    //! \brief Schedules a launch of the event after the given time, in milliseconds.
+    void _ScheduleDelayedEvent(MapEvent* event, uint32_t launch_time);
+
+    //! \brief Tells whether the delayed launch was cancelled since it was scheduled.
+    bool _IsCancelled(const DelayedEvent& delayed_event) const {
+        return delayed_event.generation != delayed_event.event->_delayed_generation;
+    }
+
+    //! \brief Cancels every delayed launch of the event.
+    void _CancelDelayedEvent(MapEvent* event);
+
+    //! \brief Moves every delayed launch of the event to the paused delayed events.
+    void _PauseDelayedEvent(MapEvent* event);
+
+    //! \brief Gets the events having delayed launches and controlling the given sprite.
+    void _GetDelayedSpriteEvents(VirtualSprite* sprite, std::vector<MapEvent*>& events) const;
+
     /** \brief Registers a map event object with the event supervisor
     *** \param new_event A pointer to the new event
     *** \return whether the event was successfully registered.
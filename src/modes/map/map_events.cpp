@@ -48,7 +48,11 @@ namespace private_map
 
 MapEvent::MapEvent(const std::string& id, EVENT_TYPE type):
     _event_id(id),
-    _event_type(type)
+    _event_type(type),
+    _handle(0),
+    _active_index(-1),
+    _delayed_generation(0),
+    _num_delayed_launches(0)
 {
     vt_map::MapMode* map_mode = MapMode::CurrentInstance();
     if (!map_mode) {
@@ -194,6 +198,9 @@ void MapTransitionEvent::_Start()
 {
     MapMode::CurrentInstance()->PushState(STATE_SCENE);
 
+    // Use the fade out time to finish preloading the destination map first.
+    MapMode::GetMapPreloader()->PreloadMap(_transition_map_data_filename, true);
+
     VideoManager->_StartTransitionFadeOut(Color::black, MAP_FADE_OUT_TIME);
     _done = false;
 }
@@ -607,6 +614,7 @@ PathMoveSpriteEvent::PathMoveSpriteEvent(const std::string& event_id,
     _last_position(0.0f, 0.0f),
     _current_node_pos(0.0f, 0.0f),
     _current_node(0),
+    _path_request(0),
     _run(run)
 {}
 
@@ -620,6 +628,7 @@ PathMoveSpriteEvent::PathMoveSpriteEvent(const std::string& event_id,
     _last_position(0.0f, 0.0f),
     _current_node_pos(0.0f, 0.0f),
     _current_node(0),
+    _path_request(0),
     _run(run)
 {}
 
@@ -640,7 +649,7 @@ PathMoveSpriteEvent* PathMoveSpriteEvent::Create(const std::string& event_id,
 
 void PathMoveSpriteEvent::SetDestination(float x_coord, float y_coord, bool run)
 {
-    if(MapMode::CurrentInstance()->GetEventSupervisor()->IsEventActive(GetEventID())) {
+    if(MapMode::CurrentInstance()->GetEventSupervisor()->IsEventActive(this)) {
         IF_PRINT_WARNING(MAP_DEBUG) << "attempted illegal operation while event was active: "
                                     << GetEventID() << std::endl;
         return;
@@ -650,12 +659,13 @@ void PathMoveSpriteEvent::SetDestination(float x_coord, float y_coord, bool run)
     _destination.y = y_coord;
     _target_sprite = nullptr;
     _path.clear();
+    _path_request = 0;
     _run = run;
 }
 
 void PathMoveSpriteEvent::SetDestination(VirtualSprite* target_sprite, bool run)
 {
-    if(MapMode::CurrentInstance()->GetEventSupervisor()->IsEventActive(GetEventID())) {
+    if(MapMode::CurrentInstance()->GetEventSupervisor()->IsEventActive(this)) {
         IF_PRINT_WARNING(MAP_DEBUG) << "attempted illegal operation while event was active: "
                                     << GetEventID() << std::endl;
         return;
@@ -665,6 +675,7 @@ void PathMoveSpriteEvent::SetDestination(VirtualSprite* target_sprite, bool run)
     _destination.y = -1.0f;
     _target_sprite = target_sprite;
     _path.clear();
+    _path_request = 0;
     _run = run;
 }
 
@@ -673,6 +684,8 @@ void PathMoveSpriteEvent::_Start()
     SpriteEvent::_Start();
 
     _current_node = 0;
+    _path.clear();
+    _path_request = 0;
     _last_position = _sprite->GetPosition();
     _sprite->SetRunning(_run);
 
@@ -686,22 +699,31 @@ void PathMoveSpriteEvent::_Start()
     if (_sprite->GetPosition() == _destination)
         return;
 
-    _path = MapMode::CurrentInstance()->GetObjectSupervisor()->FindPath(_sprite,
-                                                                        _destination);
-    if(_path.empty()) {
-        PRINT_ERROR << "No path to destination (" << _destination.x
-                    << ", " << _destination.y << ") for sprite: "
-                    << _sprite->GetObjectID() << std::endl;
-        return;
-    }
-
-    _current_node_pos = _path[_current_node];
-
-    _sprite->SetMoving(true);
+    // The path is computed in a later frame.
+    _path_request = MapMode::CurrentInstance()->GetObjectSupervisor()->RequestPath(_sprite,
+                                                                                   _destination);
 }
 
 bool PathMoveSpriteEvent::_Update()
 {
+    // Wait for the requested path.
+    if(_path_request != 0) {
+        if(!MapMode::CurrentInstance()->GetObjectSupervisor()->TakePath(_path_request, _path))
+            return false;
+        _path_request = 0;
+
+        if(_path.empty()) {
+            PRINT_ERROR << "No path to destination (" << _destination.x
+                        << ", " << _destination.y << ") for sprite: "
+                        << _sprite->GetObjectID() << std::endl;
+            Terminate();
+            return true;
+        }
+
+        _current_node_pos = _path[_current_node];
+        _sprite->SetMoving(true);
+    }
+
     if(_path.empty()) {
         // No path
         Terminate();
@@ -741,6 +763,11 @@ bool PathMoveSpriteEvent::_Update()
 
 void PathMoveSpriteEvent::Terminate()
 {
+    if(_path_request != 0) {
+        MapMode::CurrentInstance()->GetObjectSupervisor()->CancelPathRequest(_path_request);
+        _path_request = 0;
+    }
+
     _sprite->SetMoving(false);
     SpriteEvent::Terminate();
 }
@@ -68,7 +68,7 @@ class EventLink
 {
 public:
     EventLink(const std::string &child_id, bool start, uint32_t time) :
-        child_event_id(child_id), launch_at_start(start), launch_timer(time) {}
+        child_event_id(child_id), launch_at_start(start), launch_timer(time), child_event_handle(0) {}
 
     ~EventLink()
     {}
@@ -81,6 +81,9 @@ public:
 
     //! \brief The amount of milliseconds to wait before launching the event (0 means launch instantly)
     uint32_t launch_timer;
+
+    //! \brief The handle of the child event, resolved the first time the link is examined (0 until then)
+    uint32_t child_event_handle;
 }; // class EventLink
 
 
@@ -120,6 +123,11 @@ public:
         return _event_type;
     }
 
+    //! \brief Returns the handle given by the event supervisor at registration, or 0 if unregistered.
+    uint32_t GetEventHandle() const {
+        return _handle;
+    }
+
     /** \brief Declares a child event to be launched immediately at the start of this event
     *** \param child_event_id The event id of the child event
     **/
@@ -182,6 +190,18 @@ private:
 
     //! \brief All child events of this class, represented by EventLink objects
     std::vector<EventLink> _event_links;
+
+    //! \brief The integer handle of the event in the event supervisor, 0 if unregistered.
+    uint32_t _handle;
+
+    //! \brief The index of the event in the active events list, or -1 when not active.
+    int32_t _active_index;
+
+    //! \brief Incremented to cancel every delayed launch of the event already scheduled.
+    uint32_t _delayed_generation;
+
+    //! \brief The number of delayed launches of the event still scheduled.
+    uint32_t _num_delayed_launches;
 }; // class MapEvent
 
 
@@ -432,6 +452,10 @@ public:
                                       const std::string& script_filename,
                                       const std::string& coming_from);
 
+    const std::string& GetTransitionMapDataFilename() const {
+        return _transition_map_data_filename;
+    }
+
 protected:
     //! \brief Begins the transition process by fading out the screen and music
     void _Start() override;
@@ -919,10 +943,13 @@ protected:
     //! \brief Holds the path needed to traverse from source to destination
     Path _path;
 
+    //! \brief The ticket of the path being computed, or 0 when none is pending.
+    uint32_t _path_request;
+
     //! \brief Tells whether the sprite should use the walk or run animation
     bool _run;
 
-    //! \brief Calculates a path for the sprite to move to the destination
+    //! \brief Requests a path for the sprite to move to the destination
     void _Start();
 
     //! \brief Returns true when the sprite has reached the destination
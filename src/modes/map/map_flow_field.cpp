@@ -0,0 +1,205 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2016 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See https://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    map_flow_field.cpp
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Source file for the flow fields followed by the chasing enemies.
+*** ***************************************************************************/
+
+#include "modes/map/map_flow_field.h"
+
+#include "utils/exception.h"
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+
+namespace vt_map
+{
+
+namespace private_map
+{
+
+//! \brief The cost of lateral and diagonal moves, as used by ObjectSupervisor::FindPath().
+const uint32_t FLOW_FIELD_LATERAL_COST = 10;
+const uint32_t FLOW_FIELD_DIAGONAL_COST = 14;
+
+//! \brief The cost given to unreachable elements.
+const uint32_t FLOW_FIELD_UNREACHABLE = 0xFFFFFFFF;
+
+//! \brief The 8 adjacent elements, lateral ones first, as in ObjectSupervisor::FindPath().
+static const int16_t FLOW_FIELD_ADJACENT_OFFSETS[8][2] = {
+    { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 },
+    { -1, -1 }, { -1, 1 }, { 1, -1 }, { 1, 1 }
+};
+
+FlowField::FlowField(const PathFootprint& footprint) :
+    _footprint(footprint),
+    _computed(false),
+    _root_x(0),
+    _root_y(0),
+    _left(0),
+    _top(0),
+    _right(0),
+    _bottom(0)
+{
+}
+
+void FlowField::Compute(const CollisionGrid* collision_grid, uint16_t root_x, uint16_t root_y)
+{
+    _computed = true;
+    _root_x = root_x;
+    _root_y = root_y;
+
+    _left = root_x > FLOW_FIELD_RADIUS ? root_x - FLOW_FIELD_RADIUS : 0;
+    _top = root_y > FLOW_FIELD_RADIUS ? root_y - FLOW_FIELD_RADIUS : 0;
+    _right = std::min<uint32_t>(root_x + FLOW_FIELD_RADIUS + 1, collision_grid->GetWidth());
+    _bottom = std::min<uint32_t>(root_y + FLOW_FIELD_RADIUS + 1, collision_grid->GetHeight());
+
+    const uint16_t width = _right - _left;
+    _costs.assign(width * (_bottom - _top), FLOW_FIELD_UNREACHABLE);
+    _walkable.assign(_costs.size(), 0);
+
+    typedef std::pair<uint32_t, uint32_t> OpenNode;
+    std::priority_queue<OpenNode, std::vector<OpenNode>, std::greater<OpenNode> > open_list;
+
+    const uint32_t root = (root_y - _top) * width + (root_x - _left);
+    _costs[root] = 0;
+    open_list.push(OpenNode(0, root));
+
+    while(!open_list.empty()) {
+        const uint32_t cost = open_list.top().first;
+        const uint32_t node = open_list.top().second;
+        open_list.pop();
+
+        if(cost > _costs[node])
+            continue;
+
+        const int32_t x = _left + node % width;
+        const int32_t y = _top + node / width;
+
+        for(uint8_t i = 0; i < 8; ++i) {
+            const int32_t next_x = x + FLOW_FIELD_ADJACENT_OFFSETS[i][0];
+            const int32_t next_y = y + FLOW_FIELD_ADJACENT_OFFSETS[i][1];
+            if(next_x < _left || next_y < _top || next_x >= _right || next_y >= _bottom)
+                continue;
+
+            const uint32_t next = (next_y - _top) * width + (next_x - _left);
+            const uint32_t next_cost = cost + (i < 4 ? FLOW_FIELD_LATERAL_COST : FLOW_FIELD_DIAGONAL_COST);
+            if(next_cost >= _costs[next])
+                continue;
+
+            if(!_IsWalkable(collision_grid, next_x, next_y))
+                continue;
+
+            _costs[next] = next_cost;
+            open_list.push(OpenNode(next_cost, next));
+        }
+    }
+}
+
+bool FlowField::GetNextElement(uint16_t x, uint16_t y, uint16_t& next_x, uint16_t& next_y) const
+{
+    if(!_computed || x < _left || y < _top || x >= _right || y >= _bottom)
+        return false;
+
+    const uint16_t width = _right - _left;
+    uint32_t best_cost = _costs[(y - _top) * width + (x - _left)];
+    if(best_cost == 0 || best_cost == FLOW_FIELD_UNREACHABLE)
+        return false;
+
+    bool found = false;
+    for(uint8_t i = 0; i < 8; ++i) {
+        const int32_t adjacent_x = x + FLOW_FIELD_ADJACENT_OFFSETS[i][0];
+        const int32_t adjacent_y = y + FLOW_FIELD_ADJACENT_OFFSETS[i][1];
+        if(adjacent_x < _left || adjacent_y < _top || adjacent_x >= _right || adjacent_y >= _bottom)
+            continue;
+
+        const uint32_t cost = _costs[(adjacent_y - _top) * width + (adjacent_x - _left)];
+        if(cost < best_cost) {
+            best_cost = cost;
+            next_x = adjacent_x;
+            next_y = adjacent_y;
+            found = true;
+        }
+    }
+    return found;
+}
+
+bool FlowField::_IsWalkable(const CollisionGrid* collision_grid, uint16_t x, uint16_t y)
+{
+    uint8_t& walkable = _walkable[(y - _top) * (_right - _left) + (x - _left)];
+    if(walkable == 0) {
+        // Test the footprint as ObjectSupervisor::DetectCollision() would
+        // for the map bounds and the collision grid.
+        bool fits = x >= _footprint.left && y >= _footprint.top
+                    && x + _footprint.right < collision_grid->GetWidth()
+                    && !collision_grid->IsAnyCollision(x - _footprint.left, y - _footprint.top,
+                                                       x + _footprint.right, y);
+        walkable = fits ? 1 : 2;
+    }
+    return walkable == 1;
+}
+
+void FlowFieldSet::Build(const CollisionGrid* collision_grid)
+{
+    Clear();
+    _collision_grid = collision_grid;
+}
+
+void FlowFieldSet::Clear()
+{
+    for(uint32_t i = 0; i < _fields.size(); ++i)
+        delete _fields[i];
+    _fields.clear();
+    _collision_grid = nullptr;
+}
+
+bool FlowFieldSet::GetNextElement(const PathFootprint& footprint,
+                                  uint16_t root_x, uint16_t root_y,
+                                  uint16_t x, uint16_t y,
+                                  uint16_t& next_x, uint16_t& next_y)
+{
+    if(!_collision_grid || root_x >= _collision_grid->GetWidth() || root_y >= _collision_grid->GetHeight())
+        return false;
+
+    FlowField* field = nullptr;
+    for(uint32_t i = 0; i < _fields.size(); ++i) {
+        if(_fields[i]->GetFootprint() == footprint) {
+            field = _fields[i];
+            break;
+        }
+    }
+    if(!field) {
+        field = new FlowField(footprint);
+        _fields.push_back(field);
+    }
+
+    // Only compute the field again when the root has moved to another grid element.
+    if(!field->IsRootedAt(root_x, root_y))
+        field->Compute(_collision_grid, root_x, root_y);
+
+    return field->GetNextElement(x, y, next_x, next_y);
+}
+
+FlowFieldSet::FlowFieldSet(const FlowFieldSet&)
+{
+    throw vt_utils::Exception("Not Implemented!", __FILE__, __LINE__, __FUNCTION__);
+}
+
+FlowFieldSet& FlowFieldSet::operator=(const FlowFieldSet&)
+{
+    throw vt_utils::Exception("Not Implemented!", __FILE__, __LINE__, __FUNCTION__);
+    return *this;
+}
+
+} // namespace private_map
+
+} // namespace vt_map
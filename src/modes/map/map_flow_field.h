@@ -0,0 +1,145 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2016 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See https://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    map_flow_field.h
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Header file for the flow fields followed by the chasing enemies.
+***
+*** A flow field gives the cost to reach its root grid element from every element
+*** around it. Every sprite going to that root then only has to step toward the
+*** cheapest adjacent element, so the enemies chasing the character share a single
+*** search instead of each looking for its own path.
+*** ***************************************************************************/
+
+#ifndef __MAP_FLOW_FIELD_HEADER__
+#define __MAP_FLOW_FIELD_HEADER__
+
+#include "modes/map/map_hierarchical_path.h"
+
+namespace vt_map
+{
+
+namespace private_map
+{
+
+//! \brief The distance from the root covered by the flow fields, in collision grid elements.
+const uint16_t FLOW_FIELD_RADIUS = 24;
+
+/** ****************************************************************************
+*** \brief The costs to reach a root grid element, for one collision footprint.
+***
+*** Only the collision grid is taken into account, within FLOW_FIELD_RADIUS of the root.
+*** ***************************************************************************/
+class FlowField
+{
+public:
+    explicit FlowField(const PathFootprint& footprint);
+
+    const PathFootprint& GetFootprint() const {
+        return _footprint;
+    }
+
+    //! \brief Tells whether the field was computed for the given root.
+    bool IsRootedAt(uint16_t root_x, uint16_t root_y) const {
+        return _computed && _root_x == root_x && _root_y == root_y;
+    }
+
+    //! \brief Computes the costs to reach the given root. The root is considered walkable.
+    void Compute(const CollisionGrid* collision_grid, uint16_t root_x, uint16_t root_y);
+
+    //! \brief Forgets the computed costs, after a collision grid change.
+    void Invalidate() {
+        _computed = false;
+    }
+
+    /** \brief Gives the adjacent grid element to step on to get closer to the root.
+    *** \return false when standing on the root, or when the root can't be reached from there.
+    **/
+    bool GetNextElement(uint16_t x, uint16_t y, uint16_t& next_x, uint16_t& next_y) const;
+
+private:
+    //! \brief The footprint the walkable elements are computed for.
+    PathFootprint _footprint;
+
+    //! \brief Whether the costs are up to date.
+    bool _computed;
+
+    //! \brief The root grid element.
+    uint16_t _root_x;
+    uint16_t _root_y;
+
+    //! \brief The bounds of the covered area, in grid elements. The right and bottom bounds are exclusive.
+    uint16_t _left;
+    uint16_t _top;
+    uint16_t _right;
+    uint16_t _bottom;
+
+    //! \brief The cost to reach the root from each covered element, stored at [(y - _top) * width + (x - _left)].
+    std::vector<uint32_t> _costs;
+
+    //! \brief Whether the footprint fits on each covered element: 0 when not tested yet, 1 when it fits, 2 otherwise.
+    std::vector<uint8_t> _walkable;
+
+    //! \brief Tells whether the footprint fits on the given covered element, testing it when needed.
+    bool _IsWalkable(const CollisionGrid* collision_grid, uint16_t x, uint16_t y);
+};
+
+/** ****************************************************************************
+*** \brief The flow fields toward a common root, one per collision footprint.
+***
+*** A field is only computed when a sprite of its footprint asks for its way,
+*** and once per root grid element.
+*** ***************************************************************************/
+class FlowFieldSet
+{
+public:
+    FlowFieldSet() :
+        _collision_grid(nullptr)
+    {}
+
+    ~FlowFieldSet() {
+        Clear();
+    }
+
+    /** \brief Sets the collision grid used by the fields, forgetting the previous costs.
+    *** \param collision_grid The map collision grid, which must be kept until Clear() is called.
+    **/
+    void Build(const CollisionGrid* collision_grid);
+
+    //! \brief Removes every flow field.
+    void Clear();
+
+    /** \brief Gives the adjacent grid element to step on to get closer to the root.
+    *** The field of the footprint is computed first if it isn't rooted at the given element yet.
+    *** \return false when standing on the root, or when the root can't be reached from there.
+    **/
+    bool GetNextElement(const PathFootprint& footprint,
+                        uint16_t root_x, uint16_t root_y,
+                        uint16_t x, uint16_t y,
+                        uint16_t& next_x, uint16_t& next_y);
+
+private:
+    //! \brief The copy constructor and assignment operator are hidden by design
+    //! to cause compilation errors when attempting to copy or assign this class.
+    FlowFieldSet(const FlowFieldSet& flow_fields);
+    FlowFieldSet& operator=(const FlowFieldSet& flow_fields);
+
+    //! \brief The collision grid the fields are computed from.
+    const CollisionGrid* _collision_grid;
+
+    //! \brief The fields computed so far, one per footprint.
+    std::vector<FlowField*> _fields;
+};
+
+} // namespace private_map
+
+} // namespace vt_map
+
+#endif // __MAP_FLOW_FIELD_HEADER__
@@ -0,0 +1,547 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2016 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See https://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    map_hierarchical_path.cpp
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Source file for the map hierarchical path finding.
+*** ***************************************************************************/
+
+#include "modes/map/map_hierarchical_path.h"
+
+#include "utils/exception.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <queue>
+
+namespace vt_map
+{
+
+namespace private_map
+{
+
+//! \brief The cost of lateral and diagonal moves, as used by ObjectSupervisor::FindPath().
+const uint32_t PATH_LATERAL_COST = 10;
+const uint32_t PATH_DIAGONAL_COST = 14;
+
+//! \brief The cost given to unreachable elements.
+const uint32_t PATH_UNREACHABLE = 0xFFFFFFFF;
+
+//! \brief The border openings longer than this get an entrance at each end, instead of a single one in the middle.
+const uint16_t PATH_MAX_SINGLE_ENTRANCE_LENGTH = 6;
+
+/** \brief The sprite collision sizes, in collision grid elements, whose footprints are precomputed
+*** when the map is loaded. Other footprints are computed the first time they are needed.
+**/
+const float PATH_COMMON_COLLISION_SIZES[][2] = {
+    { 1.0f, 1.2f }, // Most characters and NPCs.
+    { 1.0f, 2.0f }  // Most enemies.
+};
+
+//! \brief Returns the diagonal distance between two grid elements, using the path costs.
+static uint32_t GetDiagonalPathDistance(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2)
+{
+    uint32_t x_delta = x1 > x2 ? x1 - x2 : x2 - x1;
+    uint32_t y_delta = y1 > y2 ? y1 - y2 : y2 - y1;
+    if(x_delta > y_delta)
+        return PATH_DIAGONAL_COST * y_delta + PATH_LATERAL_COST * (x_delta - y_delta);
+    else
+        return PATH_DIAGONAL_COST * x_delta + PATH_LATERAL_COST * (y_delta - x_delta);
+}
+
+PathFootprint::PathFootprint(float coll_half_width, float coll_height)
+{
+    // Match the collision rectangle computed by MapObject::GetGridCollisionRectangle()
+    // for a sprite standing at the center of a grid element.
+    left = static_cast<uint16_t>(-std::floor(0.5f - coll_half_width));
+    right = static_cast<uint16_t>(std::floor(0.5f + coll_half_width));
+    top = static_cast<uint16_t>(-std::floor(0.5f - coll_height));
+}
+
+HierarchicalPathFinder::HierarchicalPathFinder() :
+    _collision_grid(nullptr),
+    _grid_width(0),
+    _grid_height(0),
+    _num_clusters_x(0),
+    _num_clusters_y(0),
+    _dirty(false),
+    _dirty_left(0),
+    _dirty_top(0),
+    _dirty_right(0),
+    _dirty_bottom(0)
+{
+}
+
+void HierarchicalPathFinder::Build(const CollisionGrid* collision_grid)
+{
+    Clear();
+
+    if(!collision_grid || collision_grid->GetWidth() == 0 || collision_grid->GetHeight() == 0)
+        return;
+
+    _collision_grid = collision_grid;
+    _grid_height = _collision_grid->GetHeight();
+    _grid_width = _collision_grid->GetWidth();
+    _num_clusters_x = (_grid_width + PATH_CLUSTER_LENGTH - 1) / PATH_CLUSTER_LENGTH;
+    _num_clusters_y = (_grid_height + PATH_CLUSTER_LENGTH - 1) / PATH_CLUSTER_LENGTH;
+
+    for(uint32_t i = 0; i < sizeof(PATH_COMMON_COLLISION_SIZES) / sizeof(PATH_COMMON_COLLISION_SIZES[0]); ++i)
+        _GetGraph(PathFootprint(PATH_COMMON_COLLISION_SIZES[i][0], PATH_COMMON_COLLISION_SIZES[i][1]));
+}
+
+void HierarchicalPathFinder::Clear()
+{
+    for(uint32_t i = 0; i < _graphs.size(); ++i)
+        delete _graphs[i];
+    _graphs.clear();
+
+    _collision_grid = nullptr;
+    _grid_width = 0;
+    _grid_height = 0;
+    _num_clusters_x = 0;
+    _num_clusters_y = 0;
+    _dirty = false;
+}
+
+void HierarchicalPathFinder::MarkDirty(uint16_t x, uint16_t y)
+{
+    if(!_collision_grid || x >= _grid_width || y >= _grid_height)
+        return;
+
+    if(!_dirty) {
+        _dirty = true;
+        _dirty_left = _dirty_right = x;
+        _dirty_top = _dirty_bottom = y;
+        return;
+    }
+
+    _dirty_left = std::min(_dirty_left, x);
+    _dirty_right = std::max(_dirty_right, x);
+    _dirty_top = std::min(_dirty_top, y);
+    _dirty_bottom = std::max(_dirty_bottom, y);
+}
+
+void HierarchicalPathFinder::Update()
+{
+    if(!_dirty)
+        return;
+    _dirty = false;
+
+    for(uint32_t i = 0; i < _graphs.size(); ++i) {
+        PathClusterGraph* graph = _graphs[i];
+        const PathFootprint& footprint = graph->footprint;
+
+        // A collision element is covered by the footprints standing up to
+        // footprint.right on its left, footprint.left on its right and footprint.top below it.
+        uint16_t left = _dirty_left > footprint.right ? _dirty_left - footprint.right : 0;
+        uint16_t top = _dirty_top;
+        uint32_t right = std::min<uint32_t>(_dirty_right + footprint.left + 1, _grid_width);
+        uint32_t bottom = std::min<uint32_t>(_dirty_bottom + footprint.top + 1, _grid_height);
+
+        std::vector<bool> changed_clusters(_num_clusters_x * _num_clusters_y, false);
+        if(_ComputeWalkableCells(graph, left, top, right, bottom, changed_clusters))
+            _BuildEntrances(graph, changed_clusters);
+    }
+}
+
+bool HierarchicalPathFinder::FindWaypoints(const PathFootprint& footprint,
+                                           uint16_t source_x, uint16_t source_y,
+                                           uint16_t dest_x, uint16_t dest_y,
+                                           std::vector<std::pair<uint16_t, uint16_t> >& waypoints,
+                                           uint32_t& cost)
+{
+    waypoints.clear();
+    cost = 0;
+
+    // The graphs may not match the collision grid until updated.
+    if(!_collision_grid || _dirty)
+        return false;
+
+    if(source_x >= _grid_width || source_y >= _grid_height
+            || dest_x >= _grid_width || dest_y >= _grid_height)
+        return false;
+
+    const uint32_t source_cluster = _GetCluster(source_x, source_y);
+    const uint32_t dest_cluster = _GetCluster(dest_x, dest_y);
+    // Short paths are better handled by a plain search.
+    if(source_cluster == dest_cluster)
+        return false;
+
+    PathClusterGraph* graph = _GetGraph(footprint);
+    if(!graph)
+        return false;
+
+    // Connect the source and destination to the entrances of their clusters.
+    // Moves cost the same both ways, so the destination costs can be computed from it.
+    std::vector<uint32_t> source_costs;
+    std::vector<uint32_t> dest_costs;
+    _ComputeClusterCosts(graph, source_x, source_y, source_costs);
+    _ComputeClusterCosts(graph, dest_x, dest_y, dest_costs);
+
+    // The source and destination are added after the entrances in the search.
+    const uint32_t num_entrances = graph->entrances.size();
+    const uint32_t source_node = num_entrances;
+    const uint32_t dest_node = num_entrances + 1;
+
+    std::vector<uint32_t> g_scores(num_entrances + 2, PATH_UNREACHABLE);
+    std::vector<uint32_t> parents(num_entrances + 2, source_node);
+    std::vector<bool> closed(num_entrances + 2, false);
+
+    // The open list, ordered by f score. Outdated entries are skipped when popped.
+    typedef std::pair<uint32_t, uint32_t> OpenNode;
+    std::priority_queue<OpenNode, std::vector<OpenNode>, std::greater<OpenNode> > open_list;
+
+    g_scores[source_node] = 0;
+    open_list.push(OpenNode(GetDiagonalPathDistance(source_x, source_y, dest_x, dest_y), source_node));
+
+    bool destination_reached = false;
+    while(!open_list.empty()) {
+        const uint32_t node = open_list.top().second;
+        open_list.pop();
+
+        if(closed[node])
+            continue;
+        closed[node] = true;
+
+        if(node == dest_node) {
+            destination_reached = true;
+            break;
+        }
+
+        // Gather the nodes reachable from this one.
+        std::vector<PathClusterGraph::Edge> edges;
+        if(node == source_node) {
+            const std::vector<uint32_t>& cluster_entrances = graph->cluster_entrances[source_cluster];
+            for(uint32_t i = 0; i < cluster_entrances.size(); ++i) {
+                const PathClusterGraph::Entrance& entrance = graph->entrances[cluster_entrances[i]];
+                uint32_t cost = source_costs[(entrance.y % PATH_CLUSTER_LENGTH) * PATH_CLUSTER_LENGTH
+                                             + (entrance.x % PATH_CLUSTER_LENGTH)];
+                if(cost != PATH_UNREACHABLE)
+                    edges.push_back(PathClusterGraph::Edge(cluster_entrances[i], cost));
+            }
+        } else {
+            const PathClusterGraph::Entrance& entrance = graph->entrances[node];
+            edges = entrance.edges;
+            if(entrance.cluster == dest_cluster) {
+                uint32_t cost = dest_costs[(entrance.y % PATH_CLUSTER_LENGTH) * PATH_CLUSTER_LENGTH
+                                           + (entrance.x % PATH_CLUSTER_LENGTH)];
+                if(cost != PATH_UNREACHABLE)
+                    edges.push_back(PathClusterGraph::Edge(dest_node, cost));
+            }
+        }
+
+        for(uint32_t i = 0; i < edges.size(); ++i) {
+            const uint32_t target = edges[i].target;
+            if(closed[target])
+                continue;
+
+            const uint32_t g_score = g_scores[node] + edges[i].cost;
+            if(g_score >= g_scores[target])
+                continue;
+
+            g_scores[target] = g_score;
+            parents[target] = node;
+
+            uint32_t h_score = 0;
+            if(target != dest_node) {
+                const PathClusterGraph::Entrance& entrance = graph->entrances[target];
+                h_score = GetDiagonalPathDistance(entrance.x, entrance.y, dest_x, dest_y);
+            }
+            open_list.push(OpenNode(g_score + h_score, target));
+        }
+    }
+
+    if(!destination_reached)
+        return false;
+
+    cost = g_scores[dest_node];
+
+    // Follow the parent nodes back to the source, which isn't part of the waypoints.
+    waypoints.push_back(std::make_pair(dest_x, dest_y));
+    for(uint32_t node = parents[dest_node]; node != source_node; node = parents[node]) {
+        const PathClusterGraph::Entrance& entrance = graph->entrances[node];
+        waypoints.push_back(std::make_pair(entrance.x, entrance.y));
+    }
+    std::reverse(waypoints.begin(), waypoints.end());
+
+    return true;
+}
+
+PathClusterGraph* HierarchicalPathFinder::_GetGraph(const PathFootprint& footprint)
+{
+    if(!_collision_grid)
+        return nullptr;
+
+    for(uint32_t i = 0; i < _graphs.size(); ++i) {
+        if(_graphs[i]->footprint == footprint)
+            return _graphs[i];
+    }
+
+    PathClusterGraph* graph = new PathClusterGraph();
+    graph->footprint = footprint;
+    _BuildGraph(graph);
+    _graphs.push_back(graph);
+    return graph;
+}
+
+void HierarchicalPathFinder::_BuildGraph(PathClusterGraph* graph)
+{
+    graph->walkable.assign(_grid_width * _grid_height, false);
+    graph->entrances.clear();
+    graph->cluster_entrances.clear();
+
+    std::vector<bool> changed_clusters(_num_clusters_x * _num_clusters_y, true);
+    _ComputeWalkableCells(graph, 0, 0, _grid_width, _grid_height, changed_clusters);
+    _BuildEntrances(graph, changed_clusters);
+}
+
+bool HierarchicalPathFinder::_ComputeWalkableCells(PathClusterGraph* graph, uint16_t left, uint16_t top,
+                                                   uint16_t right, uint16_t bottom,
+                                                   std::vector<bool>& changed_clusters)
+{
+    const PathFootprint& footprint = graph->footprint;
+
+    // Compute where the footprint fits, as ObjectSupervisor::DetectCollision() would
+    // for the map bounds and the collision grid.
+    bool changed = false;
+    for(int32_t y = std::max(top, footprint.top); y < bottom; ++y) {
+        for(int32_t x = std::max(left, footprint.left); x < right && x + footprint.right < _grid_width; ++x) {
+            bool walkable = !_collision_grid->IsAnyCollision(x - footprint.left, y - footprint.top,
+                                                             x + footprint.right, y);
+            if(graph->walkable[y * _grid_width + x] == walkable)
+                continue;
+
+            graph->walkable[y * _grid_width + x] = walkable;
+            changed_clusters[_GetCluster(x, y)] = true;
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+void HierarchicalPathFinder::_BuildEntrances(PathClusterGraph* graph, const std::vector<bool>& changed_clusters)
+{
+    // Keep the previous entrances to reuse the costs of the unchanged clusters.
+    std::vector<PathClusterGraph::Entrance> previous_entrances;
+    std::vector<std::vector<uint32_t> > previous_cluster_entrances;
+    previous_entrances.swap(graph->entrances);
+    previous_cluster_entrances.swap(graph->cluster_entrances);
+
+    graph->cluster_entrances.assign(_num_clusters_x * _num_clusters_y, std::vector<uint32_t>());
+
+    // The entrance index of each grid element already used as an entrance,
+    // as the cluster corners are on two borders.
+    std::map<uint32_t, uint32_t> entrance_cells;
+
+    // Find the entrances along the vertical borders, then the horizontal ones.
+    for(uint16_t cluster_x = 1; cluster_x < _num_clusters_x; ++cluster_x) {
+        for(uint16_t cluster_y = 0; cluster_y < _num_clusters_y; ++cluster_y) {
+            uint16_t start = cluster_y * PATH_CLUSTER_LENGTH;
+            uint16_t end = std::min<uint16_t>(start + PATH_CLUSTER_LENGTH, _grid_height);
+            _AddBorderEntrances(graph, true, cluster_x * PATH_CLUSTER_LENGTH, start, end, entrance_cells);
+        }
+    }
+    for(uint16_t cluster_y = 1; cluster_y < _num_clusters_y; ++cluster_y) {
+        for(uint16_t cluster_x = 0; cluster_x < _num_clusters_x; ++cluster_x) {
+            uint16_t start = cluster_x * PATH_CLUSTER_LENGTH;
+            uint16_t end = std::min<uint16_t>(start + PATH_CLUSTER_LENGTH, _grid_width);
+            _AddBorderEntrances(graph, false, cluster_y * PATH_CLUSTER_LENGTH, start, end, entrance_cells);
+        }
+    }
+
+    // Precompute the costs between the entrances of each cluster.
+    std::vector<uint32_t> costs;
+    for(uint32_t cluster = 0; cluster < graph->cluster_entrances.size(); ++cluster) {
+        const std::vector<uint32_t>& cluster_entrances = graph->cluster_entrances[cluster];
+
+        // The entrances of an unchanged cluster are the same cells as before,
+        // so its previous costs can be copied.
+        if(!_IsClusterOutdated(cluster, changed_clusters)
+                && cluster < previous_cluster_entrances.size()
+                && previous_cluster_entrances[cluster].size() == cluster_entrances.size()) {
+            const std::vector<uint32_t>& previous_indices = previous_cluster_entrances[cluster];
+            for(uint32_t i = 0; i < previous_indices.size(); ++i) {
+                const PathClusterGraph::Entrance& previous = previous_entrances[previous_indices[i]];
+                PathClusterGraph::Entrance& entrance =
+                    graph->entrances[entrance_cells[previous.y * _grid_width + previous.x]];
+
+                for(uint32_t j = 0; j < previous.edges.size(); ++j) {
+                    const PathClusterGraph::Entrance& target = previous_entrances[previous.edges[j].target];
+                    if(target.cluster != cluster)
+                        continue;
+
+                    uint32_t target_index = entrance_cells[target.y * _grid_width + target.x];
+                    entrance.edges.push_back(PathClusterGraph::Edge(target_index, previous.edges[j].cost));
+                }
+            }
+            continue;
+        }
+
+        for(uint32_t i = 0; i < cluster_entrances.size(); ++i) {
+            PathClusterGraph::Entrance& entrance = graph->entrances[cluster_entrances[i]];
+            _ComputeClusterCosts(graph, entrance.x, entrance.y, costs);
+
+            for(uint32_t j = 0; j < cluster_entrances.size(); ++j) {
+                if(i == j)
+                    continue;
+
+                const PathClusterGraph::Entrance& other = graph->entrances[cluster_entrances[j]];
+                uint32_t cost = costs[(other.y % PATH_CLUSTER_LENGTH) * PATH_CLUSTER_LENGTH
+                                      + (other.x % PATH_CLUSTER_LENGTH)];
+                if(cost != PATH_UNREACHABLE)
+                    entrance.edges.push_back(PathClusterGraph::Edge(cluster_entrances[j], cost));
+            }
+        }
+    }
+}
+
+bool HierarchicalPathFinder::_IsClusterOutdated(uint32_t cluster, const std::vector<bool>& changed_clusters) const
+{
+    if(changed_clusters[cluster])
+        return true;
+
+    // The entrances on a border depend on the walkable cells of both clusters.
+    const uint16_t cluster_x = cluster % _num_clusters_x;
+    const uint16_t cluster_y = cluster / _num_clusters_x;
+    return (cluster_x > 0 && changed_clusters[cluster - 1])
+           || (cluster_x + 1 < _num_clusters_x && changed_clusters[cluster + 1])
+           || (cluster_y > 0 && changed_clusters[cluster - _num_clusters_x])
+           || (cluster_y + 1 < _num_clusters_y && changed_clusters[cluster + _num_clusters_x]);
+}
+
+void HierarchicalPathFinder::_AddBorderEntrances(PathClusterGraph* graph, bool vertical_border,
+                                                 uint16_t border, uint16_t start, uint16_t end,
+                                                 std::map<uint32_t, uint32_t>& entrance_cells)
+{
+    uint16_t opening_start = start;
+    for(uint16_t i = start; i <= end; ++i) {
+        // Grid elements on both sides of the border.
+        uint16_t x1 = vertical_border ? border - 1 : i;
+        uint16_t y1 = vertical_border ? i : border - 1;
+        uint16_t x2 = vertical_border ? border : i;
+        uint16_t y2 = vertical_border ? i : border;
+
+        bool open = i < end && graph->walkable[y1 * _grid_width + x1] && graph->walkable[y2 * _grid_width + x2];
+        if(open)
+            continue;
+
+        // The opening ends here.
+        if(i > opening_start) {
+            std::vector<uint16_t> transitions;
+            if(i - opening_start <= PATH_MAX_SINGLE_ENTRANCE_LENGTH) {
+                transitions.push_back(opening_start + (i - opening_start) / 2);
+            } else {
+                transitions.push_back(opening_start);
+                transitions.push_back(i - 1);
+            }
+
+            for(uint32_t j = 0; j < transitions.size(); ++j) {
+                uint16_t cells[2][2] = {
+                    { static_cast<uint16_t>(vertical_border ? border - 1 : transitions[j]),
+                      static_cast<uint16_t>(vertical_border ? transitions[j] : border - 1) },
+                    { static_cast<uint16_t>(vertical_border ? border : transitions[j]),
+                      static_cast<uint16_t>(vertical_border ? transitions[j] : border) }
+                };
+
+                uint32_t indices[2];
+                for(uint32_t k = 0; k < 2; ++k) {
+                    uint32_t cell = cells[k][1] * _grid_width + cells[k][0];
+                    std::map<uint32_t, uint32_t>::const_iterator it = entrance_cells.find(cell);
+                    if(it != entrance_cells.end()) {
+                        indices[k] = it->second;
+                        continue;
+                    }
+
+                    indices[k] = graph->entrances.size();
+                    uint32_t cluster = _GetCluster(cells[k][0], cells[k][1]);
+                    graph->entrances.push_back(PathClusterGraph::Entrance(cells[k][0], cells[k][1], cluster));
+                    graph->cluster_entrances[cluster].push_back(indices[k]);
+                    entrance_cells[cell] = indices[k];
+                }
+
+                // Crossing the border is a lateral move.
+                graph->entrances[indices[0]].edges.push_back(PathClusterGraph::Edge(indices[1], PATH_LATERAL_COST));
+                graph->entrances[indices[1]].edges.push_back(PathClusterGraph::Edge(indices[0], PATH_LATERAL_COST));
+            }
+        }
+
+        opening_start = i + 1;
+    }
+}
+
+void HierarchicalPathFinder::_ComputeClusterCosts(const PathClusterGraph* graph, uint16_t x, uint16_t y,
+                                                  std::vector<uint32_t>& costs) const
+{
+    costs.assign(PATH_CLUSTER_LENGTH * PATH_CLUSTER_LENGTH, PATH_UNREACHABLE);
+
+    // The cluster bounds, the last clusters being possibly smaller.
+    const uint16_t cluster_left = (x / PATH_CLUSTER_LENGTH) * PATH_CLUSTER_LENGTH;
+    const uint16_t cluster_top = (y / PATH_CLUSTER_LENGTH) * PATH_CLUSTER_LENGTH;
+    const uint16_t width = std::min<uint16_t>(PATH_CLUSTER_LENGTH, _grid_width - cluster_left);
+    const uint16_t height = std::min<uint16_t>(PATH_CLUSTER_LENGTH, _grid_height - cluster_top);
+
+    // The 8 adjacent elements, in the same order as ObjectSupervisor::FindPath().
+    static const int16_t adjacent_offsets[8][2] = {
+        { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 },
+        { -1, -1 }, { -1, 1 }, { 1, -1 }, { 1, 1 }
+    };
+
+    typedef std::pair<uint32_t, uint32_t> OpenNode;
+    std::priority_queue<OpenNode, std::vector<OpenNode>, std::greater<OpenNode> > open_list;
+
+    const uint32_t source = (y - cluster_top) * PATH_CLUSTER_LENGTH + (x - cluster_left);
+    costs[source] = 0;
+    open_list.push(OpenNode(0, source));
+
+    while(!open_list.empty()) {
+        const uint32_t cost = open_list.top().first;
+        const uint32_t node = open_list.top().second;
+        open_list.pop();
+
+        if(cost > costs[node])
+            continue;
+
+        const int16_t local_x = node % PATH_CLUSTER_LENGTH;
+        const int16_t local_y = node / PATH_CLUSTER_LENGTH;
+
+        for(uint8_t i = 0; i < 8; ++i) {
+            int16_t next_x = local_x + adjacent_offsets[i][0];
+            int16_t next_y = local_y + adjacent_offsets[i][1];
+            if(next_x < 0 || next_y < 0 || next_x >= width || next_y >= height)
+                continue;
+
+            if(!graph->walkable[(cluster_top + next_y) * _grid_width + cluster_left + next_x])
+                continue;
+
+            const uint32_t next = next_y * PATH_CLUSTER_LENGTH + next_x;
+            const uint32_t next_cost = cost + (i < 4 ? PATH_LATERAL_COST : PATH_DIAGONAL_COST);
+            if(next_cost < costs[next]) {
+                costs[next] = next_cost;
+                open_list.push(OpenNode(next_cost, next));
+            }
+        }
+    }
+}
+
+HierarchicalPathFinder::HierarchicalPathFinder(const HierarchicalPathFinder&)
+{
+    throw vt_utils::Exception("Not Implemented!", __FILE__, __LINE__, __FUNCTION__);
+}
+
+HierarchicalPathFinder& HierarchicalPathFinder::operator=(const HierarchicalPathFinder&)
+{
+    throw vt_utils::Exception("Not Implemented!", __FILE__, __LINE__, __FUNCTION__);
+    return *this;
+}
+
+} // namespace private_map
+
+} // namespace vt_map
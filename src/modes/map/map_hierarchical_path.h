@@ -0,0 +1,235 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2016 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See https://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    map_hierarchical_path.h
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Header file for the map hierarchical path finding.
+***
+*** The collision grid is split into square clusters. The walkable cells on
+*** both sides of each cluster border are grouped into entrances, and the
+*** costs between the entrances of a same cluster are precomputed. Long paths
+*** are then searched on this much smaller graph, and only refined with the
+*** regular A* algorithm between consecutive entrances.
+*** ***************************************************************************/
+
+#ifndef __MAP_HIERARCHICAL_PATH_HEADER__
+#define __MAP_HIERARCHICAL_PATH_HEADER__
+
+#include "modes/map/map_collision_grid.h"
+
+#include <vector>
+#include <map>
+#include <cstdint>
+
+namespace vt_map
+{
+
+namespace private_map
+{
+
+//! \brief The side length of the path finding clusters, in collision grid elements.
+const uint16_t PATH_CLUSTER_LENGTH = 16;
+
+/** \brief The default distance, in collision grid elements, from which the hierarchical
+*** path finding is used instead of a plain A* search. 0 disables it.
+**/
+const uint32_t DEFAULT_HIERARCHICAL_PATH_DISTANCE = 32;
+
+/** ****************************************************************************
+*** \brief The collision footprint of a sprite, in collision grid elements.
+***
+*** It gives how many grid elements the collision rectangle of a sprite covers
+*** around the element it stands on, when placed at the element center.
+*** Sprites with slightly different collision sizes thus share the same footprint.
+*** ***************************************************************************/
+class PathFootprint
+{
+public:
+    PathFootprint() : left(0), right(0), top(0)
+    {}
+
+    //! \brief Computes the footprint of a collision rectangle, in grid elements.
+    PathFootprint(float coll_half_width, float coll_height);
+
+    uint16_t left, right, top;
+
+    bool operator==(const PathFootprint& that) const {
+        return left == that.left && right == that.right && top == that.top;
+    }
+}; // class PathFootprint
+
+/** ****************************************************************************
+*** \brief The abstract graph of the cluster entrances for one collision footprint.
+*** ***************************************************************************/
+class PathClusterGraph
+{
+public:
+    //! \brief An edge to another entrance, with its precomputed cost.
+    class Edge
+    {
+    public:
+        Edge(uint32_t target_, uint32_t cost_) : target(target_), cost(cost_)
+        {}
+
+        uint32_t target;
+        uint32_t cost;
+    };
+
+    //! \brief An entrance cell, on one side of a cluster border.
+    class Entrance
+    {
+    public:
+        Entrance(uint16_t x_, uint16_t y_, uint32_t cluster_) : x(x_), y(y_), cluster(cluster_)
+        {}
+
+        uint16_t x, y;
+
+        //! \brief The cluster the entrance cell belongs to.
+        uint32_t cluster;
+
+        //! \brief The edges to the neighbour cluster and to the other entrances of the same cluster.
+        std::vector<Edge> edges;
+    };
+
+    //! \brief The footprint the walkable cells were computed for.
+    PathFootprint footprint;
+
+    //! \brief Whether a sprite of that footprint can stand on each grid element, stored at [y * width + x].
+    std::vector<bool> walkable;
+
+    //! \brief Every entrance of every cluster.
+    std::vector<Entrance> entrances;
+
+    //! \brief The entrances indices, by cluster.
+    std::vector<std::vector<uint32_t> > cluster_entrances;
+}; // class PathClusterGraph
+
+/** ****************************************************************************
+*** \brief Finds long paths on the map using precomputed cluster entrances.
+***
+*** The walkable cells only take the collision grid into account, so the found
+*** waypoints must be refined by a regular path search, which will also avoid
+*** the other map objects.
+*** ***************************************************************************/
+class HierarchicalPathFinder
+{
+public:
+    HierarchicalPathFinder();
+
+    ~HierarchicalPathFinder() {
+        Clear();
+    }
+
+    /** \brief Splits the collision grid into clusters and precomputes the entrances of the common footprints.
+    *** \param collision_grid The map collision grid, which must be kept unchanged until Clear() is called.
+    **/
+    void Build(const CollisionGrid* collision_grid);
+
+    //! \brief Removes every precomputed graph.
+    void Clear();
+
+    /** \brief Marks a collision grid element as changed.
+    *** The clusters it affects are only recomputed on the next call to Update().
+    **/
+    void MarkDirty(uint16_t x, uint16_t y);
+
+    //! \brief Recomputes the clusters affected by the collision grid elements changed since the last update.
+    void Update();
+
+    /** \brief Searches for the cluster entrances to go through to reach the destination.
+    *** \param footprint The collision footprint of the sprite to find the path for.
+    *** \param waypoints Filled with the entrance cells to go through, and the destination cell.
+    *** \param cost Set to the cost of the path between the entrances, in the same unit as the move costs.
+    *** \return false when the source and destination share the same cluster,
+    *** when the graphs are waiting for an update, or if no path could be found.
+    *** A plain path search should then be used.
+    **/
+    bool FindWaypoints(const PathFootprint& footprint,
+                       uint16_t source_x, uint16_t source_y,
+                       uint16_t dest_x, uint16_t dest_y,
+                       std::vector<std::pair<uint16_t, uint16_t> >& waypoints,
+                       uint32_t& cost);
+
+private:
+    //! \brief The copy constructor and assignment operator are hidden by design
+    //! to cause compilation errors when attempting to copy or assign this class.
+    HierarchicalPathFinder(const HierarchicalPathFinder& path_finder);
+    HierarchicalPathFinder& operator=(const HierarchicalPathFinder& path_finder);
+
+    //! \brief The collision grid the graphs are computed from.
+    const CollisionGrid* _collision_grid;
+
+    //! \brief The collision grid size, in grid elements.
+    uint16_t _grid_width;
+    uint16_t _grid_height;
+
+    //! \brief The number of clusters on each axis.
+    uint16_t _num_clusters_x;
+    uint16_t _num_clusters_y;
+
+    //! \brief The graphs computed so far, one per footprint.
+    std::vector<PathClusterGraph*> _graphs;
+
+    //! \brief Whether collision grid elements changed since the last update.
+    bool _dirty;
+
+    //! \brief The bounds of the changed collision grid elements, inclusive.
+    uint16_t _dirty_left;
+    uint16_t _dirty_top;
+    uint16_t _dirty_right;
+    uint16_t _dirty_bottom;
+
+    //! \brief Returns the graph of the given footprint, computing it when needed.
+    PathClusterGraph* _GetGraph(const PathFootprint& footprint);
+
+    //! \brief Computes the walkable cells, the entrances and their costs for the given footprint.
+    void _BuildGraph(PathClusterGraph* graph);
+
+    /** \brief Recomputes the walkable cells within the given bounds.
+    *** \param changed_clusters Set to true for each cluster where a walkable cell changed.
+    *** \return Whether any walkable cell changed.
+    **/
+    bool _ComputeWalkableCells(PathClusterGraph* graph, uint16_t left, uint16_t top,
+                               uint16_t right, uint16_t bottom, std::vector<bool>& changed_clusters);
+
+    /** \brief Finds the entrances and computes their costs.
+    *** The costs within clusters whose entrances couldn't have changed are kept from the previous entrances.
+    *** \param changed_clusters The clusters where walkable cells changed.
+    **/
+    void _BuildEntrances(PathClusterGraph* graph, const std::vector<bool>& changed_clusters);
+
+    //! \brief Tells whether the entrances or costs of a cluster depend on the changed clusters.
+    bool _IsClusterOutdated(uint32_t cluster, const std::vector<bool>& changed_clusters) const;
+
+    /** \brief Adds the entrances found along the border between two clusters.
+    *** \param entrance_cells The entrances already added, by grid element index.
+    **/
+    void _AddBorderEntrances(PathClusterGraph* graph, bool vertical_border,
+                             uint16_t border, uint16_t start, uint16_t end,
+                             std::map<uint32_t, uint32_t>& entrance_cells);
+
+    //! \brief Returns the cluster containing the given grid element.
+    uint32_t _GetCluster(uint16_t x, uint16_t y) const {
+        return (y / PATH_CLUSTER_LENGTH) * _num_clusters_x + (x / PATH_CLUSTER_LENGTH);
+    }
+
+    /** \brief Computes the costs from a grid element to every element of its cluster.
+    *** \param costs Filled with the cost of each cluster element, stored at [local_y * PATH_CLUSTER_LENGTH + local_x],
+    *** or 0xFFFFFFFF if the element can't be reached.
+    *** The source element is considered walkable.
+    **/
+    void _ComputeClusterCosts(const PathClusterGraph* graph, uint16_t x, uint16_t y, std::vector<uint32_t>& costs) const;
+};
+
+} // namespace private_map
+
+} // namespace vt_map
+
+#endif // __MAP_HIERARCHICAL_PATH_HEADER__
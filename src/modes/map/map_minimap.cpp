@@ -22,8 +22,8 @@
 #include "script/script_write.h"
 #endif
 
-#include <SDL2/SDL_image.h>
-#include <SDL2/SDL_endian.h>
+#include <algorithm>
+#include <cstring>
 
 using namespace vt_common;
 
@@ -45,60 +45,10 @@ const float MINIMAP_POS_X = 775.0f;
 //! \brief The Y value for the minimap's position.
 const float MINIMAP_POS_Y = 545.0f;
 
-//! \brief Allows for scoped-based control of SDL Surfaces.
-struct SDLSurfaceController {
-    SDL_Surface* _surface;
+//! \brief The white noise image shown where the collisions are.
+const std::string MINIMAP_COLLISION_IMAGE = "data/gui/map/minimap_collision.png";
 
-    explicit SDLSurfaceController(const char *str) :
-        _surface(IMG_Load(str))
-    {
-        if (!_surface)
-            PRINT_ERROR << "Couldn't create the white noise image for the collision map: " << SDL_GetError() << std::endl;
-    }
-
-    ~SDLSurfaceController()
-    {
-        if (_surface)
-            SDL_FreeSurface(_surface);
-    }
-
-private:
-    //! \brief The copy constructor and assignment operator are hidden by design
-    //! to cause compilation errors when attempting to copy or assign this class.
-    SDLSurfaceController(const SDLSurfaceController&)
-    {
-        throw vt_utils::Exception("Not Implemented!", __FILE__, __LINE__, __FUNCTION__);
-    }
-    SDLSurfaceController& operator=(const SDLSurfaceController&)
-    {
-        throw vt_utils::Exception("Not Implemented!", __FILE__, __LINE__, __FUNCTION__);
-        return *this;
-    }
-};
-
-//! \brief A helper function to prepare a SDL_Surface.
-static bool _PrepareSurface(SDL_Surface* temp_surface)
-{
-    // A white noise texture.
-    const SDLSurfaceController WHITE_NOISE("data/gui/map/minimap_collision.png");
-    SDL_Rect r = { 0, 0, 0, 0 };
-
-    // Prepare the surface with the image.  Tile the white noise image onto the surface with full alpha.
-    for(int x = 0; x < temp_surface->w; x += WHITE_NOISE._surface->w) {
-        r.x = x;
-        for(int y = 0; y < temp_surface->h; y += WHITE_NOISE._surface->h) {
-            r.y = y;
-            if(SDL_BlitSurface(WHITE_NOISE._surface, nullptr, temp_surface, &r)) {
-                PRINT_ERROR << "Couldn't fill a rect on temp_surface: " << SDL_GetError() << std::endl;
-                return false;
-            }
-        }
-    }
-
-    return true;
-}
-
-Minimap::Minimap(const std::string& minimap_image_filename) :
+Minimap::Minimap(const std::string& minimap_image_filename, GeneratedMinimap* generated_minimap) :
     _current_position(-1.0f, -1.0f),
     _box_x_length(10),
     _box_y_length(_box_x_length * .75f),
@@ -108,7 +58,8 @@ Minimap::Minimap(const std::string& minimap_image_filename) :
     _grid_width(0),
     _grid_height(0),
     _current_opacity(nullptr),
-    _map_alpha_scale(1.0f)
+    _map_alpha_scale(1.0f),
+    _collision_hash(0)
 {
     ObjectSupervisor *map_object_supervisor = MapMode::CurrentInstance()->GetObjectSupervisor();
     map_object_supervisor->GetGridAxis(_grid_width, _grid_height);
@@ -116,7 +67,25 @@ Minimap::Minimap(const std::string& minimap_image_filename) :
     // If no minimap image is given, we create one.
     if (minimap_image_filename.empty() ||
             !_minimap_image.Load(minimap_image_filename, _grid_width * _box_x_length, _grid_height * _box_y_length)) {
-        _minimap_image = _CreateProcedurally();
+        std::vector<uint8_t> static_collision;
+        map_object_supervisor->GetStaticCollisionGrid(static_collision);
+        uint64_t collision_hash = ComputeDataHash(static_collision);
+        if (collision_hash == 0)
+            collision_hash = 1;
+
+        // Reuse the image of a previous visit when the static collisions are the same.
+        if (generated_minimap && generated_minimap->collision_hash == collision_hash) {
+            _minimap_image = generated_minimap->image;
+        }
+        else {
+            // Release the outdated image first, as the new one uses the same texture name.
+            if (generated_minimap)
+                *generated_minimap = GeneratedMinimap();
+            _minimap_image = _CreateProcedurally(static_collision);
+        }
+
+        if (_minimap_image.GetWidth() > 0.0f)
+            _collision_hash = collision_hash;
     }
 
     //setup the map window, if it isn't already created
@@ -133,84 +102,68 @@ Minimap::Minimap(const std::string& minimap_image_filename) :
     _location_marker.SetFrameIndex(0);
 }
 
-vt_video::StillImage Minimap::_CreateProcedurally()
+GeneratedMinimap Minimap::GetGeneratedMinimap() const
 {
-    ObjectSupervisor *map_object_supervisor = MapMode::CurrentInstance()->GetObjectSupervisor();
-
-    float x, y, width, height;
-    vt_video::VideoManager->GetCurrentViewport(x, y, width, height);
-
-    //create a new SDL surface that is the rendering dimensions we want.
-    SDL_Surface *temp_surface = SDL_CreateRGBSurface(SDL_SWSURFACE,
-                                                     _grid_width * _box_x_length, _grid_height * _box_y_length, 32,
-#if SDL_BYTEORDER == SDL_BIG_ENDIAN
-                                                     0xff000000, 0x00ff0000, 0x0000ff00, 0x000000ff);
-#else
-                                                     0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000);
-#endif
+    GeneratedMinimap generated_minimap;
+    if (_collision_hash != 0) {
+        generated_minimap.collision_hash = _collision_hash;
+        generated_minimap.image = _minimap_image;
+    }
+    return generated_minimap;
+}
 
-    if(!temp_surface) {
-        PRINT_ERROR << "Couldn't create temp_surface for collision map: " << SDL_GetError() << std::endl;
+vt_video::StillImage Minimap::_CreateProcedurally(const std::vector<uint8_t>& static_collision)
+{
+    const uint32_t width = _grid_width * _box_x_length;
+    const uint32_t height = _grid_height * _box_y_length;
+    if (width == 0 || height == 0 || static_collision.size() != _grid_width * _grid_height) {
         MapMode::CurrentInstance()->ShowMinimap(false);
         return vt_video::StillImage();
     }
 
-    //set the basic rect information
-    SDL_Rect r;
-    r.w = _box_x_length;
-    r.h = _box_y_length;
-    r.x = r.y = 0;
-
-    //very simple. Just go through the entire grid, checking the visible-character's
-    //context against the map-grid's collision context. if this is NOT a colidable location
-    //fill that square in with a full alpha block
-    //note that the ordering needs to be transposed for drawing
-    if (!_PrepareSurface(temp_surface)) {
-        SDL_FreeSurface(temp_surface);
+    vt_video::private_video::ImageMemory white_noise;
+    if (!white_noise.LoadImage(MINIMAP_COLLISION_IMAGE) || white_noise.GetBytesPerPixel() != 4) {
+        PRINT_ERROR << "Couldn't load the white noise image for the collision map: "
+                    << MINIMAP_COLLISION_IMAGE << std::endl;
         MapMode::CurrentInstance()->ShowMinimap(false);
         return vt_video::StillImage();
     }
+    const uint32_t noise_width = white_noise.GetWidth();
+    const uint32_t noise_height = white_noise.GetHeight();
+
+    vt_video::private_video::ImageMemory minimap_data;
+    minimap_data.Resize(width, height, false);
+    uint8_t* pixels = minimap_data.GetPixels();
+
+    // Go through the image one pixel row at a time: the white noise is tiled
+    // over the collisions, and the free locations are left fully transparent.
+    for (uint32_t y = 0; y < height; ++y) {
+        const uint8_t* collision_row = &static_collision[(y / _box_y_length) * _grid_width];
+        const uint8_t* noise_row = white_noise.GetPixels() + (y % noise_height) * noise_width * 4;
+        uint8_t* row = pixels + y * width * 4;
+
+        for (uint32_t grid_x = 0; grid_x < _grid_width; ++grid_x) {
+            uint32_t x = grid_x * _box_x_length;
+            const uint32_t box_end = x + _box_x_length;
+
+            if (!collision_row[grid_x]) {
+                memset(row + x * 4, 0, _box_x_length * 4);
+                continue;
+            }
 
-    for(uint32_t row = 0; row < _grid_width; ++row)
-    {
-        r.y = 0;
-        for(uint32_t col = 0; col < _grid_height; ++col)
-        {
-            if(!map_object_supervisor->IsStaticCollision(row, col))
-            {
-
-                if(SDL_FillRect(temp_surface, &r, SDL_MapRGBA(temp_surface->format, 0x00, 0x00, 0x00, 0x00)))
-                {
-                    PRINT_ERROR << "Couldn't fill a rect on temp_surface: " << SDL_GetError() << std::endl;
-                    SDL_FreeSurface(temp_surface);
-                    return vt_video::StillImage();
-                }
-
+            // Copy the white noise up to the box end, or to the noise row end.
+            while (x < box_end) {
+                const uint32_t noise_x = x % noise_width;
+                const uint32_t count = std::min(box_end - x, noise_width - noise_x);
+                memcpy(row + x * 4, noise_row + noise_x * 4, count * 4);
+                x += count;
             }
-            r.y += _box_y_length;
         }
-        r.x += _box_x_length;
-    }
-
-    //TEST: flush the SDL surface. This forces any pending writes onto the surface to complete
-    //SDL_UpdateRect(temp_surface, 0, 0, 0, 0);
-
-    if (!temp_surface) {
-        MapMode::CurrentInstance()->ShowMinimap(false);
-        return vt_video::StillImage();
     }
 
-    SDL_LockSurface(temp_surface);
-
-    // Setup a temporary memory space to copy the SDL data into
-    vt_video::private_video::ImageMemory temp_data(temp_surface);
-
-    SDL_UnlockSurface(temp_surface);
-    // At this point, the screen data is set up. We can get rid of unnecessary data here
-    SDL_FreeSurface(temp_surface);
     // Do the image file creation
     std::string map_name_cmap = MapMode::CurrentInstance()->GetMapScriptFilename() + "_cmap";
-    vt_video::StillImage minimap_image = vt_video::VideoManager->CreateImage(&temp_data, map_name_cmap);
+    vt_video::StillImage minimap_image = vt_video::VideoManager->CreateImage(&minimap_data, map_name_cmap);
 
 #ifdef DEBUG_FEATURES
     // Uncomment and compile this to generate XPM minimaps.
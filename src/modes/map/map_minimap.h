@@ -36,14 +36,31 @@ namespace private_map
 class ObjectSupervisor;
 class VirtualSprite;
 
+//! \brief A procedurally generated minimap image, kept so that later visits can reuse it.
+class GeneratedMinimap {
+public:
+    GeneratedMinimap() :
+        collision_hash(0)
+    {}
+
+    //! \brief The hash of the static collisions the image was generated from, 0 when there is no image.
+    uint64_t collision_hash;
+
+    vt_video::StillImage image;
+};
+
 //! \brief Handles the Collision minimap generation, caching, drawing and updating the minimap
 class Minimap {
 public:
     /** \brief constructor creating the minimap image.
     *** \param minimap_image_filename filename of a pre-made minimap image.
     *** If empty, the minimap is generated using the map script collision map.
+    *** \param generated_minimap An image generated during a previous visit of the map, if any.
+    *** It is used instead of generating the image again when the static collisions didn't change,
+    *** and cleared otherwise.
     **/
-    Minimap(const std::string& minimap_image_filename = std::string());
+    Minimap(const std::string& minimap_image_filename = std::string(),
+            GeneratedMinimap* generated_minimap = nullptr);
 
     ~Minimap() {
         _minimap_image.Clear();
@@ -61,6 +78,10 @@ public:
     **/
     void Draw();
 
+    //! \brief Returns the generated minimap image, with a collision hash of 0 when the image
+    //! was loaded from a file or couldn't be generated.
+    GeneratedMinimap GetGeneratedMinimap() const;
+
 private:
     //! \brief the generated collision map image for this collision map
     vt_video::StillImage _minimap_image;
@@ -94,8 +115,13 @@ private:
     //! \brief specifies the additive alpha we get from the map class
     float _map_alpha_scale;
 
-    //! \brief creates the procedural collision minimap image
-    vt_video::StillImage _CreateProcedurally();
+    //! \brief The hash of the static collisions the image was generated from, 0 when not generated.
+    uint64_t _collision_hash;
+
+    /** \brief creates the procedural collision minimap image in one pass
+    *** \param static_collision The static collision of each grid element, stored at [y * _grid_width + x].
+    **/
+    vt_video::StillImage _CreateProcedurally(const std::vector<uint8_t>& static_collision);
 
 #ifdef DEBUG_FEATURES
     //! \brief Writes a XPM file with the minimap equivalient in it.
@@ -29,6 +29,9 @@
 #include "modes/map/map_sprites/map_enemy_sprite.h"
 #include "modes/map/map_zones.h"
 #include "modes/map/map_tiles.h"
+#include "modes/map/map_data.h"
+#include "modes/map/map_preloader.h"
+#include "modes/map/map_cache.h"
 
 #include "modes/map/map_location.h"
 
@@ -73,6 +76,9 @@ const std::string INACTIVE_ESCAPE_POINT_FILE = "data/entities/map/escape_point/e
 
 // Initialize static class variables
 MapMode *MapMode::_current_instance = nullptr;
+MapPreloader *MapMode::_map_preloader = nullptr;
+MapCache *MapMode::_map_cache = nullptr;
+uint32_t MapMode::_num_instances = 0;
 
 // ****************************************************************************
 // ********** MapMode Public Class Methods
@@ -84,6 +90,7 @@ MapMode::MapMode(const std::string& data_filename, const std::string& script_fil
     _activated(false),
     _map_data_filename(data_filename),
     _map_script_filename(script_filename),
+    _map_data(nullptr),
     _tile_supervisor(nullptr),
     _object_supervisor(nullptr),
     _event_supervisor(nullptr),
@@ -112,6 +119,11 @@ MapMode::MapMode(const std::string& data_filename, const std::string& script_fil
 {
     _current_instance = this;
 
+    if(_num_instances++ == 0) {
+        _map_preloader = new MapPreloader();
+        _map_cache = new MapCache();
+    }
+
     ResetState();
     PushState(STATE_EXPLORE);
 
@@ -159,6 +171,7 @@ MapMode::MapMode(const std::string& data_filename, const std::string& script_fil
 
     // Init the camera position text style
     _debug_camera_position.SetStyle(TextStyle("title22", Color::white, VIDEO_TEXT_SHADOW_DARK));
+    _debug_sorted_objects.SetStyle(TextStyle("title22", Color::white, VIDEO_TEXT_SHADOW_DARK));
 
     if (_auto_save_enabled && permit_autosave) {
         GlobalManager->AutoSave(_map_data_filename, _map_script_filename, _run_stamina,
@@ -172,6 +185,16 @@ MapMode::MapMode(const std::string& data_filename, const std::string& script_fil
 
 MapMode::~MapMode()
 {
+    // Keep the tiles of a successfully loaded map, in case the player comes back soon.
+    if(_map_data) {
+        GeneratedMinimap minimap;
+        if(_minimap)
+            minimap = _minimap->GetGeneratedMinimap();
+        _map_cache->Store(_map_data_filename, *_map_data, _tile_supervisor, minimap);
+        _tile_supervisor = nullptr;
+        delete _map_data;
+    }
+
     delete(_tile_supervisor);
     delete(_object_supervisor);
     delete(_event_supervisor);
@@ -188,6 +211,23 @@ MapMode::~MapMode()
     // Free the map script file when closing the map.
     _map_script.CloseAllTables();
     _map_script.CloseFile();
+
+    if(--_num_instances == 0) {
+        delete _map_preloader;
+        _map_preloader = nullptr;
+        delete _map_cache;
+        _map_cache = nullptr;
+    }
+}
+
+void MapMode::FreeCachedMaps()
+{
+    if(_num_instances == 0)
+        return;
+
+    IF_PRINT_DEBUG(MAP_DEBUG) << "Freeing the cached and preloaded maps" << std::endl;
+    _map_cache->Clear();
+    _map_preloader->Cancel();
 }
 
 void MapMode::Deactivate()
@@ -351,6 +391,8 @@ void MapMode::Update()
 
     _dialogue_icon.Update();
 
+    _map_preloader->Update();
+
     // Call the map script's update function
     if(_update_function.is_valid())
         luabind::call_function<void>(_update_function);
@@ -419,6 +461,11 @@ void MapMode::Update()
     if(!VideoManager->DebugInfoOn())
         return;
 
+    // Objects placed again in the draw order this frame
+    std::ostringstream sorted_txt;
+    sorted_txt << "Sorted objects: " << _object_supervisor->GetNumSortedObjects();
+    _debug_sorted_objects.SetText(sorted_txt.str());
+
     // Camera map coordinates
     VirtualSprite *cam = GetCamera();
     if(!cam)
@@ -511,6 +558,16 @@ void MapMode::DeleteMapObject(private_map::MapObject* object)
     _object_supervisor->DeleteObject(object);
 }
 
+void MapMode::SetMapCollision(uint32_t x, uint32_t y, bool collision)
+{
+    _object_supervisor->SetMapCollision(x, y, collision);
+}
+
+void MapMode::SetHierarchicalPathDistance(uint32_t distance)
+{
+    _object_supervisor->SetHierarchicalPathDistance(distance);
+}
+
 void MapMode::SetCamera(private_map::VirtualSprite *sprite, uint32_t duration)
 {
     if(_camera == sprite) {
@@ -629,41 +686,27 @@ uint16_t MapMode::GetMapHeight() const
 bool MapMode::_Load()
 {
     // Map data
-    // Clear out all old map data if existing.
-    ScriptManager->DropGlobalTable("map_data");
-
-    // Open map script file and read in the basic map properties and tile definitions
-    if(!_map_script.OpenFile(_map_data_filename)) {
-        PRINT_ERROR << "Couldn't open map data file: "
-                    << _map_data_filename << std::endl;
-        return false;
+    MapData map_data;
+    TileSupervisor* cached_tile_supervisor = nullptr;
+    if(_map_cache->Take(_map_data_filename, map_data, cached_tile_supervisor, _cached_minimap)) {
+        // The map was left recently, so its tiles and their textures are still loaded.
+        delete _tile_supervisor;
+        _tile_supervisor = cached_tile_supervisor;
+        _map_preloader->Cancel();
     }
-
-    if(!_map_script.OpenTable("map_data")) {
-        PRINT_ERROR << "Couldn't open table 'map_data' in: "
-                    << _map_data_filename << std::endl;
-        _map_script.CloseFile();
+    else if(!_LoadTiles(map_data)) {
         return false;
     }
 
     // Loads the collision grid
-    if(!_object_supervisor->Load(_map_script)) {
+    if(!_object_supervisor->Load(map_data)) {
         PRINT_ERROR << "Failed to load the collision grid from: "
             << _map_data_filename << std::endl;
-        _map_script.CloseFile();
-        return false;
-    }
-
-    // Instruct the supervisor classes to perform their portion of the load operation
-    if(!_tile_supervisor->Load(_map_script)) {
-        PRINT_ERROR << "Failed to load the tile data from: "
-            << _map_data_filename << std::endl;
-        _map_script.CloseFile();
         return false;
     }
 
-    _map_script.CloseAllTables();
-    _map_script.CloseFile(); // Free the map data file once everyhting is loaded
+    // Keep the map data, so that it can be cached along with the tiles when leaving the map.
+    _map_data = new MapData(std::move(map_data));
 
     // Map script
 
@@ -702,7 +745,7 @@ bool MapMode::_Load()
                              TextStyle("title24"));
 
     std::string map_image_filename = _map_script.ReadString("map_image_filename");
-    if(!map_image_filename.empty() && !_map_image.Load(map_image_filename))
+    if(!map_image_filename.empty() && !_map_image.LoadAsync(map_image_filename))
         PRINT_ERROR << "Failed to load location graphic image: "
                     << map_image_filename << std::endl;
 
@@ -752,6 +795,8 @@ bool MapMode::_Load()
                                   _camera != nullptr ? _camera->GetYPosition() : 0);
     }
 
+    _PreloadTransitionMaps();
+
     return true;
 } // bool MapMode::_Load()
 
@@ -762,7 +807,93 @@ void MapMode::_CreateMinimap()
         _minimap = nullptr;
     }
 
-    _minimap = new Minimap(_minimap_custom_image_file);
+    _minimap = new Minimap(_minimap_custom_image_file, &_cached_minimap);
+
+    // The minimap now holds the image, if it was still valid.
+    _cached_minimap = GeneratedMinimap();
+}
+
+bool MapMode::_LoadTiles(MapData& map_data)
+{
+    // Use the map data preloaded while exploring the previous map, if any,
+    // or else the compiled map data when it was compiled from the current map data file.
+    bool compiled_data_loaded = _map_preloader->ClaimMap(_map_data_filename, map_data);
+    if(!compiled_data_loaded) {
+        uint64_t map_data_hash = 0;
+        bool map_data_hashed = ComputeFileHash(_map_data_filename, map_data_hash);
+        const std::string user_compiled_filename = GetUserCompiledMapDataFilename(_map_data_filename);
+        compiled_data_loaded = map_data_hashed &&
+            LoadCompiledMapData(_map_data_filename, user_compiled_filename, map_data_hash, map_data);
+
+        if(!compiled_data_loaded) {
+            if(!_LoadMapDataScript(map_data)) {
+                TextureManager->ClearPreloadedImages();
+                return false;
+            }
+
+            // Compile the map data once read, so that the next loads don't parse it anymore.
+            if(map_data_hashed)
+                SaveUserCompiledMapData(user_compiled_filename, map_data_hash, map_data);
+        }
+    }
+
+    // Instruct the supervisor classes to perform their portion of the load operation
+    bool tiles_loaded = _tile_supervisor->Load(map_data);
+
+    // Free the preloaded tileset images left unused.
+    TextureManager->ClearPreloadedImages();
+
+    if(!tiles_loaded) {
+        PRINT_ERROR << "Failed to load the tile data from: "
+            << _map_data_filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool MapMode::_LoadMapDataScript(MapData& map_data)
+{
+    // Clear out all old map data if existing.
+    ScriptManager->DropGlobalTable("map_data");
+
+    // Open map script file and read in the basic map properties and tile definitions
+    if(!_map_script.OpenFile(_map_data_filename)) {
+        PRINT_ERROR << "Couldn't open map data file: "
+                    << _map_data_filename << std::endl;
+        return false;
+    }
+
+    if(!_map_script.OpenTable("map_data")) {
+        PRINT_ERROR << "Couldn't open table 'map_data' in: "
+                    << _map_data_filename << std::endl;
+        _map_script.CloseFile();
+        return false;
+    }
+
+    bool loaded = map_data.LoadFromScript(_map_script);
+    if(!loaded) {
+        PRINT_ERROR << "Failed to load the map data from: "
+            << _map_data_filename << std::endl;
+    }
+
+    _map_script.CloseAllTables();
+    _map_script.CloseFile(); // Free the map data file once everyhting is loaded
+    return loaded;
+}
+
+void MapMode::_PreloadTransitionMaps()
+{
+    std::vector<MapEvent*> transition_events;
+    _event_supervisor->GetEventsByType(MAP_TRANSITION_EVENT, transition_events);
+
+    for(uint32_t i = 0; i < transition_events.size(); ++i) {
+        MapTransitionEvent* event = static_cast<MapTransitionEvent*>(transition_events[i]);
+
+        // Don't preload the current map again, nor the maps still cached.
+        const std::string& map_data_filename = event->GetTransitionMapDataFilename();
+        if(map_data_filename != _map_data_filename && !_map_cache->IsCached(map_data_filename))
+            _map_preloader->PreloadMap(map_data_filename);
+    }
 }
 
 void MapMode::_UpdateExplore()
@@ -1313,6 +1444,8 @@ void MapMode::_DrawGUI()
     VideoManager->SetDrawFlags(VIDEO_X_LEFT, VIDEO_Y_CENTER, VIDEO_BLEND, 0);
     VideoManager->Move(10.0f, 10.0f);
     _debug_camera_position.Draw();
+    VideoManager->MoveRelative(0.0f, 25.0f);
+    _debug_sorted_objects.Draw();
     VideoManager->PopState();
 } // void MapMode::_DrawGUI()
 
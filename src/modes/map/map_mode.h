@@ -60,7 +60,10 @@ namespace private_map
 class MapDialogueSupervisor;
 class EventSupervisor;
 class Light;
+class MapData;
+class MapCache;
 class MapObject;
+class MapPreloader;
 class MapSprite;
 class EnemySprite;
 class MapZone;
@@ -161,6 +164,14 @@ public:
     //! \brief Removes an object from memory
     void DeleteMapObject(private_map::MapObject* obj);
 
+    //! \brief Changes whether a collision grid element is a wall.
+    void SetMapCollision(uint32_t x, uint32_t y, bool collision);
+
+    /** \brief Sets the distance from which paths are first searched between the cluster entrances.
+    *** \param distance The distance in collision grid elements, or 0 to always use a plain search.
+    **/
+    void SetHierarchicalPathDistance(uint32_t distance);
+
     //! \brief Vectors containing the save points animations (when the character is in or not).
     std::vector<vt_video::AnimatedImage> active_save_point_animations;
     std::vector<vt_video::AnimatedImage> inactive_save_point_animations;
@@ -175,6 +186,15 @@ public:
         return _current_instance;
     }
 
+    //! \brief Returns the preloader of the next maps, shared by every map mode instance.
+    static private_map::MapPreloader* GetMapPreloader() {
+        return _map_preloader;
+    }
+
+    //! \brief Frees the recently left and the preloaded maps, if any map mode instance exists.
+    //! Used when the system runs low on memory.
+    static void FreeCachedMaps();
+
     const vt_utils::ustring &GetMapHudName() const {
         return _map_hud_name.GetString();
     }
@@ -465,6 +485,17 @@ private:
     **/
     static MapMode* _current_instance;
 
+    //! \brief Preloads the maps the transition events lead to, while exploring the current one.
+    //! Created with the first map mode instance, and deleted along with the last one.
+    static private_map::MapPreloader* _map_preloader;
+
+    //! \brief Keeps the tiles and map data of the recently left maps.
+    //! Created with the first map mode instance, and deleted along with the last one.
+    static private_map::MapCache* _map_cache;
+
+    //! \brief The number of map mode instances alive.
+    static uint32_t _num_instances;
+
     //! Tells whether the mode is activated. It is true by calling Reset(),
     //! and false when calling Deactivate(). This member exists to prevent
     //! the triggering of deactivate more than once.
@@ -497,6 +528,9 @@ private:
 
     // ----- Members : Supervisor Class Objects and Script Functions -----
 
+    //! \brief The map data once the map is loaded, cached with the tiles when leaving the map.
+    private_map::MapData* _map_data;
+
     //! \brief Instance of helper class to map mode. Responsible for tile related operations.
     private_map::TileSupervisor* _tile_supervisor;
 
@@ -548,6 +582,9 @@ private:
     //! \brief the camera position debug text
     vt_video::TextImage _debug_camera_position;
 
+    //! \brief the number of objects sorted this frame debug text
+    vt_video::TextImage _debug_sorted_objects;
+
     //! \brief The direction the camera will move on next update
     vt_common::Position2D _camera_move;
 
@@ -640,6 +677,9 @@ private:
     //! \brief Stores the potential custom minimap image filename
     std::string _minimap_custom_image_file;
 
+    //! \brief The minimap image generated during a previous visit, taken from the map cache.
+    private_map::GeneratedMinimap _cached_minimap;
+
     //! \brief The character party status effects supervisor
     private_map::MapStatusEffectsSupervisor _status_effect_supervisor;
 
@@ -660,6 +700,15 @@ private:
     //! \brief Loads all map data contained in the Lua file that defines the map
     bool _Load();
 
+    //! \brief Reads the map data, from the preloaded or compiled data when possible, and loads the tiles.
+    bool _LoadTiles(private_map::MapData& map_data);
+
+    //! \brief Reads the map data from the map data Lua file, when no up-to-date compiled version exists.
+    bool _LoadMapDataScript(private_map::MapData& map_data);
+
+    //! \brief Starts preloading the maps the map transition events lead to.
+    void _PreloadTransitionMaps();
+
     /** Triggers the minimap creation either by trying to load the minimap file given.
     *** Or by creating a minimap procedurally.
     **/
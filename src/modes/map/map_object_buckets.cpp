@@ -0,0 +1,199 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2016 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See https://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    map_object_buckets.cpp
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Source file for the map object collision buckets.
+*** ***************************************************************************/
+
+#include "modes/map/map_object_buckets.h"
+
+#include "modes/map/map_objects/map_object.h"
+
+#include "utils/exception.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace vt_common;
+
+namespace vt_map
+{
+
+namespace private_map
+{
+
+ObjectBucketGrid::ObjectBucketGrid() :
+    _num_buckets_x(0),
+    _num_buckets_y(0),
+    _query_id(0)
+{
+}
+
+void ObjectBucketGrid::Build(uint16_t grid_width, uint16_t grid_height)
+{
+    Clear();
+
+    if(grid_width == 0 || grid_height == 0)
+        return;
+
+    _num_buckets_x = (grid_width + OBJECT_BUCKET_LENGTH - 1) / OBJECT_BUCKET_LENGTH;
+    _num_buckets_y = (grid_height + OBJECT_BUCKET_LENGTH - 1) / OBJECT_BUCKET_LENGTH;
+    _buckets.resize(_num_buckets_x * _num_buckets_y);
+}
+
+void ObjectBucketGrid::Clear()
+{
+    _buckets.clear();
+    _entries.clear();
+    _num_buckets_x = 0;
+    _num_buckets_y = 0;
+    _query_id = 0;
+}
+
+void ObjectBucketGrid::AddObject(MapObject* object)
+{
+    if(!object || !IsBuilt() || object->GetObjectID() <= 0)
+        return;
+
+    Entry& entry = _GetEntry(object);
+    if(entry.registered)
+        return;
+
+    _GetBucketRange(object->GetGridCollisionRectangle(), entry.left, entry.right, entry.top, entry.bottom);
+    entry.registered = true;
+    _InsertInBuckets(object, entry);
+}
+
+void ObjectBucketGrid::RemoveObject(MapObject* object)
+{
+    if(!object || !IsBuilt() || object->GetObjectID() <= 0)
+        return;
+
+    Entry& entry = _GetEntry(object);
+    if(!entry.registered)
+        return;
+
+    _RemoveFromBuckets(object, entry);
+    entry.registered = false;
+}
+
+void ObjectBucketGrid::UpdateObject(MapObject* object)
+{
+    if(!object || !IsBuilt() || object->GetObjectID() <= 0)
+        return;
+
+    Entry& entry = _GetEntry(object);
+    if(!entry.registered)
+        return;
+
+    uint16_t left, right, top, bottom;
+    _GetBucketRange(object->GetGridCollisionRectangle(), left, right, top, bottom);
+
+    // Most moves stay within the same buckets.
+    if(left == entry.left && right == entry.right && top == entry.top && bottom == entry.bottom)
+        return;
+
+    _RemoveFromBuckets(object, entry);
+    entry.left = left;
+    entry.right = right;
+    entry.top = top;
+    entry.bottom = bottom;
+    _InsertInBuckets(object, entry);
+}
+
+void ObjectBucketGrid::GetObjects(const Rectangle2D& area, std::vector<MapObject*>& objects)
+{
+    objects.clear();
+
+    if(!IsBuilt())
+        return;
+
+    // Reset the query ids once wrapped around, so that no object is wrongly skipped.
+    ++_query_id;
+    if(_query_id == 0) {
+        for(uint32_t i = 0; i < _entries.size(); ++i)
+            _entries[i].query_id = 0;
+        _query_id = 1;
+    }
+
+    uint16_t left, right, top, bottom;
+    _GetBucketRange(area, left, right, top, bottom);
+
+    for(uint16_t y = top; y <= bottom; ++y) {
+        for(uint16_t x = left; x <= right; ++x) {
+            const std::vector<MapObject*>& bucket = _buckets[y * _num_buckets_x + x];
+            for(uint32_t i = 0; i < bucket.size(); ++i) {
+                Entry& entry = _entries[bucket[i]->GetObjectID()];
+                if(entry.query_id == _query_id)
+                    continue;
+
+                entry.query_id = _query_id;
+                objects.push_back(bucket[i]);
+            }
+        }
+    }
+}
+
+void ObjectBucketGrid::_GetBucketRange(const Rectangle2D& area,
+                                       uint16_t& left, uint16_t& right,
+                                       uint16_t& top, uint16_t& bottom) const
+{
+    // The rectangle edges are inclusive, so are the bucket ranges.
+    const float max_x = static_cast<float>(_num_buckets_x - 1);
+    const float max_y = static_cast<float>(_num_buckets_y - 1);
+    left = static_cast<uint16_t>(std::min(max_x, std::max(0.0f, std::floor(area.left / OBJECT_BUCKET_LENGTH))));
+    right = static_cast<uint16_t>(std::min(max_x, std::max(0.0f, std::floor(area.right / OBJECT_BUCKET_LENGTH))));
+    top = static_cast<uint16_t>(std::min(max_y, std::max(0.0f, std::floor(area.top / OBJECT_BUCKET_LENGTH))));
+    bottom = static_cast<uint16_t>(std::min(max_y, std::max(0.0f, std::floor(area.bottom / OBJECT_BUCKET_LENGTH))));
+}
+
+ObjectBucketGrid::Entry& ObjectBucketGrid::_GetEntry(MapObject* object)
+{
+    uint32_t object_id = static_cast<uint32_t>(object->GetObjectID());
+    if(object_id >= _entries.size())
+        _entries.resize(object_id + 1);
+    return _entries[object_id];
+}
+
+void ObjectBucketGrid::_InsertInBuckets(MapObject* object, const Entry& entry)
+{
+    for(uint16_t y = entry.top; y <= entry.bottom; ++y) {
+        for(uint16_t x = entry.left; x <= entry.right; ++x)
+            _buckets[y * _num_buckets_x + x].push_back(object);
+    }
+}
+
+void ObjectBucketGrid::_RemoveFromBuckets(MapObject* object, const Entry& entry)
+{
+    for(uint16_t y = entry.top; y <= entry.bottom; ++y) {
+        for(uint16_t x = entry.left; x <= entry.right; ++x) {
+            std::vector<MapObject*>& bucket = _buckets[y * _num_buckets_x + x];
+            std::vector<MapObject*>::iterator it = std::find(bucket.begin(), bucket.end(), object);
+            if(it != bucket.end())
+                bucket.erase(it);
+        }
+    }
+}
+
+ObjectBucketGrid::ObjectBucketGrid(const ObjectBucketGrid&)
+{
+    throw vt_utils::Exception("Not Implemented!", __FILE__, __LINE__, __FUNCTION__);
+}
+
+ObjectBucketGrid& ObjectBucketGrid::operator=(const ObjectBucketGrid&)
+{
+    throw vt_utils::Exception("Not Implemented!", __FILE__, __LINE__, __FUNCTION__);
+    return *this;
+}
+
+} // namespace private_map
+
+} // namespace vt_map
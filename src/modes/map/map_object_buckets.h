@@ -0,0 +1,135 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2016 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See https://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    map_object_buckets.h
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Header file for the map object collision buckets.
+***
+*** The map is split into square buckets, each one knowing the objects whose
+*** collision rectangle overlaps it. Collision queries then only need to test
+*** the objects found in the few buckets they touch.
+*** ***************************************************************************/
+
+#ifndef __MAP_OBJECT_BUCKETS_HEADER__
+#define __MAP_OBJECT_BUCKETS_HEADER__
+
+#include "common/rectangle_2d.h"
+
+#include <vector>
+#include <cstdint>
+
+namespace vt_map
+{
+
+namespace private_map
+{
+
+class MapObject;
+
+//! \brief The side length of an object bucket, in collision grid elements.
+const uint16_t OBJECT_BUCKET_LENGTH = 4;
+
+/** ****************************************************************************
+*** \brief A uniform grid of buckets referencing the objects of one draw layer.
+***
+*** The objects are stored in every bucket their collision rectangle overlaps,
+*** and must be updated whenever their position or collision size changes.
+*** ***************************************************************************/
+class ObjectBucketGrid
+{
+public:
+    ObjectBucketGrid();
+
+    ~ObjectBucketGrid()
+    {}
+
+    /** \brief Creates the buckets covering the given collision grid size.
+    *** Any previously added object is removed.
+    **/
+    void Build(uint16_t grid_width, uint16_t grid_height);
+
+    //! \brief Removes every object and bucket.
+    void Clear();
+
+    //! \brief Tells whether the buckets have been created.
+    bool IsBuilt() const {
+        return !_buckets.empty();
+    }
+
+    //! \brief Adds the object in the buckets its collision rectangle overlaps.
+    void AddObject(MapObject* object);
+
+    //! \brief Removes the object from every bucket.
+    void RemoveObject(MapObject* object);
+
+    //! \brief Moves the object to the buckets its collision rectangle now overlaps.
+    void UpdateObject(MapObject* object);
+
+    /** \brief Gets the objects stored in the buckets overlapped by the given area.
+    *** \param area The area to look for objects in, in collision grid coordinates.
+    *** \param objects Filled with the objects found, each object being present once.
+    *** \note The objects found may not actually overlap the area, only the buckets it touches.
+    **/
+    void GetObjects(const vt_common::Rectangle2D& area, std::vector<MapObject*>& objects);
+
+private:
+    //! \brief The copy constructor and assignment operator are hidden by design
+    //! to cause compilation errors when attempting to copy or assign this class.
+    ObjectBucketGrid(const ObjectBucketGrid& bucket_grid);
+    ObjectBucketGrid& operator=(const ObjectBucketGrid& bucket_grid);
+
+    //! \brief The buckets an object is stored in.
+    class Entry
+    {
+    public:
+        Entry() : registered(false), left(0), right(0), top(0), bottom(0), query_id(0)
+        {}
+
+        //! \brief Whether the object is currently stored in the buckets.
+        bool registered;
+
+        //! \brief The bucket range overlapped by the object, inclusive.
+        uint16_t left, right, top, bottom;
+
+        //! \brief The last query the object was found in, to avoid returning it twice.
+        uint32_t query_id;
+    };
+
+    //! \brief The number of buckets on each axis.
+    uint16_t _num_buckets_x;
+    uint16_t _num_buckets_y;
+
+    //! \brief The objects of each bucket, stored at [y * _num_buckets_x + x].
+    std::vector<std::vector<MapObject*> > _buckets;
+
+    //! \brief The bucket entry of each object, by object id.
+    std::vector<Entry> _entries;
+
+    //! \brief The current query id, incremented at each GetObjects() call.
+    uint32_t _query_id;
+
+    //! \brief Computes the inclusive bucket range covered by the given area, clamped to the map.
+    void _GetBucketRange(const vt_common::Rectangle2D& area,
+                         uint16_t& left, uint16_t& right,
+                         uint16_t& top, uint16_t& bottom) const;
+
+    //! \brief Returns the entry of the given object, creating it when needed.
+    Entry& _GetEntry(MapObject* object);
+
+    //! \brief Adds or removes the object reference in its entry buckets.
+    void _InsertInBuckets(MapObject* object, const Entry& entry);
+    void _RemoveFromBuckets(MapObject* object, const Entry& entry);
+};
+
+} // namespace private_map
+
+} // namespace vt_map
+
+#endif // __MAP_OBJECT_BUCKETS_HEADER__
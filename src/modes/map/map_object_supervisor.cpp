@@ -26,6 +26,9 @@
 
 #include "utils/utils_numeric.h"
 
+#include <algorithm>
+#include <cmath>
+
 using namespace vt_common;
 
 namespace vt_map
@@ -38,7 +41,13 @@ ObjectSupervisor::ObjectSupervisor() :
     _num_grid_x_axis(0),
     _num_grid_y_axis(0),
     _last_id(1), //! Every object Id must be > 0 since 0 is reserved for speakerless dialogues.
-    _visible_party_member(nullptr)
+    _visible_party_member(nullptr),
+    _collision_grid_version(0),
+    _path_generation(0),
+    _hierarchical_path_distance(DEFAULT_HIERARCHICAL_PATH_DISTANCE),
+    _draw_order_changed(),
+    _max_img_grid_height(),
+    _num_sorted_objects(0)
 {}
 
 ObjectSupervisor::~ObjectSupervisor()
@@ -105,8 +114,42 @@ void ObjectSupervisor::RegisterObject(MapObject* object)
         break;
     case NO_LAYER_OBJECT:
     default: // Nothing to do. the object is registered in all objects only.
-        break;
+        return;
     }
+
+    // The buckets are only available once the collision grid is loaded.
+    _GetObjectBucketsFromDrawLayer(object->GetObjectDrawLayer()).AddObject(object);
+
+    // The new object is placed in the draw order at the next sort.
+    InvalidateDrawOrder(object);
+    UpdateDrawHeight(object);
+}
+
+void ObjectSupervisor::UpdateObjectBuckets(MapObject* object)
+{
+    if(!object || object->GetObjectDrawLayer() == NO_LAYER_OBJECT)
+        return;
+
+    _GetObjectBucketsFromDrawLayer(object->GetObjectDrawLayer()).UpdateObject(object);
+}
+
+void ObjectSupervisor::InvalidateDrawOrder(MapObject* object)
+{
+    if(!object || object->GetObjectDrawLayer() >= NO_LAYER_OBJECT)
+        return;
+
+    object->SetDrawOrderChanged(true);
+    _draw_order_changed[object->GetObjectDrawLayer()] = true;
+}
+
+void ObjectSupervisor::UpdateDrawHeight(MapObject* object)
+{
+    if(!object || object->GetObjectDrawLayer() >= NO_LAYER_OBJECT)
+        return;
+
+    // The height is never lowered, as other objects may still be that tall.
+    float& max_height = _max_img_grid_height[object->GetObjectDrawLayer()];
+    max_height = std::max(max_height, object->GetImgGridHeight());
 }
 
 void ObjectSupervisor::AddAmbientSound(SoundObject* object)
@@ -116,7 +159,7 @@ void ObjectSupervisor::AddAmbientSound(SoundObject* object)
         return;
     }
 
-    _sound_objects.push_back(object);
+    _ambient_sounds.AddSound(object);
 }
 
 void ObjectSupervisor::AddLight(Light* light)
@@ -183,6 +226,9 @@ void ObjectSupervisor::DeleteObject(MapObject* object)
         }
     }
 
+    // The object paths mustn't be computed anymore.
+    _path_requests.CancelRequests(object);
+
     std::vector<MapObject*>::iterator it;
     std::vector<MapObject*>::iterator it_end;
     std::vector<MapObject*>* to_iterate = nullptr;
@@ -214,6 +260,8 @@ void ObjectSupervisor::DeleteObject(MapObject* object)
         return;
     }
 
+    _GetObjectBucketsFromDrawLayer(object->GetObjectDrawLayer()).RemoveObject(object);
+
     for(; it != it_end; ++it) {
         if (*it == object) {
             to_iterate->erase(it);
@@ -225,55 +273,170 @@ void ObjectSupervisor::DeleteObject(MapObject* object)
 
 void ObjectSupervisor::SortObjects()
 {
-    std::sort(_flat_ground_objects.begin(), _flat_ground_objects.end(), MapObject_Ptr_Less());
-    std::sort(_ground_objects.begin(), _ground_objects.end(), MapObject_Ptr_Less());
-    std::sort(_pass_objects.begin(), _pass_objects.end(), MapObject_Ptr_Less());
-    std::sort(_sky_objects.begin(), _sky_objects.end(), MapObject_Ptr_Less());
+    _num_sorted_objects = 0;
+
+    for(uint32_t layer = FLATGROUND_OBJECT; layer < NO_LAYER_OBJECT; ++layer) {
+        if(!_draw_order_changed[layer])
+            continue;
+
+        _SortDrawLayer(_GetObjectsFromDrawLayer(static_cast<MapObjectDrawLayer>(layer)));
+        _draw_order_changed[layer] = false;
+    }
+}
+
+void ObjectSupervisor::_SortDrawLayer(std::vector<MapObject*>& objects)
+{
+    // Take the moved objects out. The other ones keep their order, so they stay sorted.
+    _objects_to_sort.clear();
+    uint32_t num_kept = 0;
+    for(uint32_t i = 0; i < objects.size(); ++i) {
+        MapObject* object = objects[i];
+        if(object->IsDrawOrderChanged()) {
+            object->SetDrawOrderChanged(false);
+            _objects_to_sort.push_back(object);
+        }
+        else {
+            objects[num_kept++] = object;
+        }
+    }
+
+    if(_objects_to_sort.empty())
+        return;
+
+    std::stable_sort(_objects_to_sort.begin(), _objects_to_sort.end(), MapObject_Ptr_Less());
+    _num_sorted_objects += _objects_to_sort.size();
+
+    // Merge the moved objects back, starting from the end so that nothing is overwritten.
+    MapObject_Ptr_Less less;
+    int32_t kept_index = static_cast<int32_t>(num_kept) - 1;
+    int32_t sorted_index = static_cast<int32_t>(_objects_to_sort.size()) - 1;
+    int32_t index = static_cast<int32_t>(objects.size()) - 1;
+    while(sorted_index >= 0) {
+        if(kept_index >= 0 && less(_objects_to_sort[sorted_index], objects[kept_index]))
+            objects[index--] = objects[kept_index--];
+        else
+            objects[index--] = _objects_to_sort[sorted_index--];
+    }
 }
 
-bool ObjectSupervisor::Load(vt_script::ReadScriptDescriptor &map_file)
+bool ObjectSupervisor::Load(const MapData& map_data)
 {
-    if(!map_file.DoesTableExist("map_grid")) {
-        PRINT_ERROR << "No map grid found in map file: " << map_file.GetFilename() << std::endl;
+    if(map_data.collision_grid.empty()) {
+        PRINT_ERROR << "No map grid found in the map data." << std::endl;
         return false;
     }
 
     // Construct the collision grid
-    map_file.OpenTable("map_grid");
-    _num_grid_y_axis = map_file.GetTableSize();
+    _num_grid_x_axis = map_data.grid_width;
+    _num_grid_y_axis = map_data.grid_height;
+    _collision_grid.Resize(_num_grid_x_axis, _num_grid_y_axis);
     for(uint16_t y = 0; y < _num_grid_y_axis; ++y) {
-        _collision_grid.push_back(std::vector<uint32_t>());
-        map_file.ReadUIntVector(y, _collision_grid.back());
+        const uint8_t* grid_row = &map_data.collision_grid[y * _num_grid_x_axis];
+        for(uint16_t x = 0; x < _num_grid_x_axis; ++x) {
+            if(grid_row[x] > 0)
+                _collision_grid.SetCollision(x, y, true);
+        }
+    }
+    _collision_grid.ComputeClearance();
+    ++_collision_grid_version;
+
+    // Allocate the path finding nodes once for the whole map.
+    _path_nodes.assign(_num_grid_x_axis * _num_grid_y_axis, PathNode());
+    _path_generation = 0;
+
+    // Precompute the cluster entrances used to find long paths.
+    _hierarchical_path_finder.Build(&_collision_grid);
+    _chase_flow_fields.Build(&_collision_grid);
+
+    // Create the collision buckets, and add the objects already created.
+    for(uint32_t layer = FLATGROUND_OBJECT; layer < NO_LAYER_OBJECT; ++layer) {
+        MapObjectDrawLayer draw_layer = static_cast<MapObjectDrawLayer>(layer);
+        ObjectBucketGrid& buckets = _GetObjectBucketsFromDrawLayer(draw_layer);
+        buckets.Build(_num_grid_x_axis, _num_grid_y_axis);
+
+        const std::vector<MapObject*>& objects = _GetObjectsFromDrawLayer(draw_layer);
+        for(uint32_t i = 0; i < objects.size(); ++i)
+            buckets.AddObject(objects[i]);
     }
-    map_file.CloseTable();
-    _num_grid_x_axis = _collision_grid[0].size();
     return true;
 }
 
 void ObjectSupervisor::Update()
 {
+    _hierarchical_path_finder.Update();
+
+    // The objects outside of the screen surroundings can skip their updates.
+    Rectangle2D active_area = MapMode::CurrentInstance()->GetMapFrame().screen_edges;
+    active_area.left -= DORMANT_UPDATE_MARGIN;
+    active_area.right += DORMANT_UPDATE_MARGIN;
+    active_area.top -= DORMANT_UPDATE_MARGIN;
+    active_area.bottom += DORMANT_UPDATE_MARGIN;
+
     for(uint32_t i = 0; i < _flat_ground_objects.size(); ++i)
-        _flat_ground_objects[i]->Update();
+        _UpdateObject(_flat_ground_objects[i], active_area);
     for(uint32_t i = 0; i < _ground_objects.size(); ++i)
-        _ground_objects[i]->Update();
+        _UpdateObject(_ground_objects[i], active_area);
 
     // Update map points animation and activeness.
     _UpdateMapPoints();
 
     for(uint32_t i = 0; i < _pass_objects.size(); ++i)
-        _pass_objects[i]->Update();
+        _UpdateObject(_pass_objects[i], active_area);
     for(uint32_t i = 0; i < _sky_objects.size(); ++i)
-        _sky_objects[i]->Update();
+        _UpdateObject(_sky_objects[i], active_area);
     for(uint32_t i = 0; i < _halos.size(); ++i)
-        _halos[i]->Update();
+        _UpdateObject(_halos[i], active_area);
     for(uint32_t i = 0; i < _lights.size(); ++i)
-        _lights[i]->Update();
+        _UpdateObject(_lights[i], active_area);
     for(uint32_t i = 0; i < _zones.size(); ++i)
         _zones[i]->Update();
 
+    // Compute the paths requested by the objects, within the frame budget.
+    _path_requests.Update(this);
+
     _UpdateAmbientSounds();
 }
 
+void ObjectSupervisor::_UpdateObject(MapObject* object, const Rectangle2D& active_area)
+{
+    if(object->CanBeDormant() && !object->GetGridImageRectangle().IntersectsWith(active_area)) {
+        object->UpdateDormant();
+        return;
+    }
+
+    object->WakeUp();
+    object->Update();
+}
+
+//! \brief Compares the object y positions with a y coordinate, to search the sorted draw layers.
+struct MapObject_Ptr_Y_Less {
+    bool operator()(const MapObject* object, float y) const {
+        return object->GetYPosition() < y;
+    }
+
+    bool operator()(float y, const MapObject* object) const {
+        return y < object->GetYPosition();
+    }
+};
+
+void ObjectSupervisor::_GetDrawRange(MapObjectDrawLayer layer, uint32_t& first, uint32_t& end)
+{
+    const std::vector<MapObject*>& objects = _GetObjectsFromDrawLayer(layer);
+    first = 0;
+    end = objects.size();
+
+    // The layer isn't sorted yet, so every object is a candidate.
+    if(_draw_order_changed[layer])
+        return;
+
+    const Rectangle2D& screen_edges = MapMode::CurrentInstance()->GetMapFrame().screen_edges;
+    float top = screen_edges.top - DRAW_RANGE_MARGIN;
+    float bottom = screen_edges.bottom + _max_img_grid_height[layer] + DRAW_RANGE_MARGIN;
+
+    first = std::lower_bound(objects.begin(), objects.end(), top, MapObject_Ptr_Y_Less()) - objects.begin();
+    end = std::upper_bound(objects.begin() + first, objects.end(), bottom, MapObject_Ptr_Y_Less()) - objects.begin();
+}
+
 void ObjectSupervisor::DrawMapPoints()
 {
     for(uint32_t i = 0; i < _save_points.size(); ++i) {
@@ -286,14 +449,18 @@ void ObjectSupervisor::DrawMapPoints()
 
 void ObjectSupervisor::DrawFlatGroundObjects()
 {
-    for(uint32_t i = 0; i < _flat_ground_objects.size(); ++i) {
+    uint32_t first, end;
+    _GetDrawRange(FLATGROUND_OBJECT, first, end);
+    for(uint32_t i = first; i < end; ++i) {
         _flat_ground_objects[i]->Draw();
     }
 }
 
 void ObjectSupervisor::DrawGroundObjects(const bool second_pass)
 {
-    for(uint32_t i = 0; i < _ground_objects.size(); i++) {
+    uint32_t first, end;
+    _GetDrawRange(GROUND_OBJECT, first, end);
+    for(uint32_t i = first; i < end; i++) {
         if(_ground_objects[i]->IsDrawOnSecondPass() == second_pass) {
             _ground_objects[i]->Draw();
         }
@@ -302,14 +469,18 @@ void ObjectSupervisor::DrawGroundObjects(const bool second_pass)
 
 void ObjectSupervisor::DrawPassObjects()
 {
-    for(uint32_t i = 0; i < _pass_objects.size(); i++) {
+    uint32_t first, end;
+    _GetDrawRange(PASS_OBJECT, first, end);
+    for(uint32_t i = first; i < end; i++) {
         _pass_objects[i]->Draw();
     }
 }
 
 void ObjectSupervisor::DrawSkyObjects()
 {
-    for(uint32_t i = 0; i < _sky_objects.size(); i++) {
+    uint32_t first, end;
+    _GetDrawRange(SKY_OBJECT, first, end);
+    for(uint32_t i = first; i < end; i++) {
         _sky_objects[i]->Draw();
     }
 }
@@ -385,39 +556,20 @@ void ObjectSupervisor::_UpdateMapPoints()
 
 void ObjectSupervisor::_UpdateAmbientSounds()
 {
-    // Clear up objects volumes before new update
-    _sound_object_highest_volumes.clear();
-
-    for(std::vector<SoundObject *>::iterator it = _sound_objects.begin();
-            it != _sound_objects.end(); ++it) {
-        (*it)->UpdateVolume();
-
-        // Register the sound as highest if no other sound was already as high.
-        bool found = false;
-        for(auto it2 = _sound_object_highest_volumes.begin();
-                it2 != _sound_object_highest_volumes.end(); ++it2) {
-            if ((*it)->GetSoundDescriptor() == (*it2)->GetSoundDescriptor()) {
-                found = true;
-                // If we found a higher sound, we swap the reference.
-                if ((*it)->GetSoundVolume() > (*it2)->GetSoundVolume())
-                    *it2 = *it;
-            }
-        }
-        if (!found) {
-            // If the sounds wasn't found, we add it.
-            _sound_object_highest_volumes.push_back(*it);
-        }
-    }
+    // The sounds are heard from the screen center.
+    const MapFrame& frame = MapMode::CurrentInstance()->GetMapFrame();
+    Position2D center;
+    center.x = frame.screen_edges.left + (frame.screen_edges.right - frame.screen_edges.left) / 2.0f;
+    center.y = frame.screen_edges.top + (frame.screen_edges.bottom - frame.screen_edges.top) / 2.0f;
 
-    //PRINT_DEBUG << "Number of ambient sounds: " << _sound_objects.size() << std::endl;
-    //PRINT_DEBUG << "Number of selected ambient sounds: " << _sound_object_highest_volumes.size() << std::endl;
+    // Only the sounds which may be heard are updated, and the loudest object of each sound is elected.
+    _ambient_sounds.Update(center, _num_grid_x_axis, _num_grid_y_axis);
 
     // Set the volumes of the elected sounds
     // Since we share sound descriptor instances, all sounds are updated in any case.
-    for(auto it = _sound_object_highest_volumes.begin();
-            it != _sound_object_highest_volumes.end(); ++it) {
-        (*it)->ApplyVolume();
-    }
+    const std::vector<SoundObject*>& elected_sounds = _ambient_sounds.GetElectedSounds();
+    for(uint32_t i = 0; i < elected_sounds.size(); ++i)
+        elected_sounds[i]->ApplyVolume();
 }
 
 void ObjectSupervisor::_DrawMapZones()
@@ -469,6 +621,33 @@ std::vector<MapObject*>& ObjectSupervisor::_GetObjectsFromDrawLayer(MapObjectDra
     }
 }
 
+ObjectBucketGrid& ObjectSupervisor::_GetObjectBucketsFromDrawLayer(MapObjectDrawLayer layer)
+{
+    switch(layer)
+    {
+    case FLATGROUND_OBJECT:
+        return _flat_ground_buckets;
+    default:
+    case GROUND_OBJECT:
+        return _ground_buckets;
+    case PASS_OBJECT:
+        return _pass_buckets;
+    case SKY_OBJECT:
+        return _sky_buckets;
+    }
+}
+
+const std::vector<MapObject*>& ObjectSupervisor::_GetObjectsInArea(MapObjectDrawLayer layer,
+                                                                   const Rectangle2D& area)
+{
+    ObjectBucketGrid& buckets = _GetObjectBucketsFromDrawLayer(layer);
+    if(!buckets.IsBuilt())
+        return _GetObjectsFromDrawLayer(layer);
+
+    buckets.GetObjects(area, _objects_in_area);
+    return _objects_in_area;
+}
+
 MapObject *ObjectSupervisor::FindNearestInteractionObject(const VirtualSprite *sprite, float search_distance)
 {
     if(!sprite)
@@ -497,10 +676,10 @@ MapObject *ObjectSupervisor::FindNearestInteractionObject(const VirtualSprite *s
 
     // A vector to hold objects which are inside the search area (either partially or fully)
     std::vector<MapObject *> valid_objects;
-    // A pointer to the vector of objects to search
-    std::vector<MapObject *>* search_vector = &_GetObjectsFromDrawLayer(sprite->GetObjectDrawLayer());
+    // A pointer to the vector of objects to search, only containing the objects near the search area.
+    const std::vector<MapObject *>* search_vector = &_GetObjectsInArea(sprite->GetObjectDrawLayer(), search_area);
 
-    for(std::vector<MapObject *>::iterator it = (*search_vector).begin(); it != (*search_vector).end(); ++it) {
+    for(std::vector<MapObject *>::const_iterator it = (*search_vector).begin(); it != (*search_vector).end(); ++it) {
         if(*it == sprite)  // Don't allow the sprite itself to be considered in the search
             continue;
 
@@ -606,6 +785,24 @@ COLLISION_TYPE ObjectSupervisor::GetCollisionFromObjectType(MapObject *obj) cons
     return NO_COLLISION;
 }
 
+bool ObjectSupervisor::IsWallCollision(MapObject* object, float x, float y)
+{
+    if(!object)
+        return true;
+
+    Rectangle2D rect = object->GetGridCollisionRectangle(x, y);
+    if(rect.left < 0.0f || rect.right >= static_cast<float>(_num_grid_x_axis) ||
+            rect.top < 0.0f || rect.bottom >= static_cast<float>(_num_grid_y_axis)) {
+        return true;
+    }
+
+    if(object->GetObjectDrawLayer() == vt_map::SKY_OBJECT || !(object->GetCollisionMask() & WALL_COLLISION))
+        return false;
+
+    return _collision_grid.IsAnyCollision(static_cast<uint16_t>(rect.left), static_cast<uint16_t>(rect.top),
+                                          static_cast<uint16_t>(rect.right), static_cast<uint16_t>(rect.bottom));
+}
+
 COLLISION_TYPE ObjectSupervisor::DetectCollision(MapObject* object,
                                                  float x_pos, float y_pos,
                                                  MapObject **collision_object_ptr)
@@ -633,17 +830,14 @@ COLLISION_TYPE ObjectSupervisor::DetectCollision(MapObject* object,
     if(object->GetObjectDrawLayer() != vt_map::SKY_OBJECT && object->GetCollisionMask() & WALL_COLLISION) {
         // Determine if the object's collision rectangle overlaps any unwalkable tiles
         // Note that because the sprite's collision rectangle was previously determined to be within the map bounds,
-        // the map grid tile indeces referenced in this loop are all valid entries and do not need to be checked for out-of-bounds conditions
-        for(uint32_t y = static_cast<uint32_t>(sprite_rect.top); y <= static_cast<uint32_t>(sprite_rect.bottom); ++y) {
-            for(uint32_t x = static_cast<uint32_t>(sprite_rect.left); x <= static_cast<uint32_t>(sprite_rect.right); ++x) {
-                // Checks the collision grid at the row-column at the object's current context
-                if(_collision_grid[y][x] > 0)
-                    return WALL_COLLISION;
-            }
-        }
+        // the map grid elements tested here are all valid and do not need to be checked for out-of-bounds conditions
+        if(_collision_grid.IsAnyCollision(static_cast<uint16_t>(sprite_rect.left), static_cast<uint16_t>(sprite_rect.top),
+                                          static_cast<uint16_t>(sprite_rect.right), static_cast<uint16_t>(sprite_rect.bottom)))
+            return WALL_COLLISION;
     }
 
-    std::vector<MapObject *>* objects = &_GetObjectsFromDrawLayer(object->GetObjectDrawLayer());
+    // Only test the objects near the collision rectangle.
+    const std::vector<MapObject *>* objects = &_GetObjectsInArea(object->GetObjectDrawLayer(), sprite_rect);
 
     std::vector<vt_map::private_map::MapObject *>::const_iterator it, it_end;
     for(it = objects->begin(), it_end = objects->end(); it != it_end; ++it) {
@@ -677,6 +871,158 @@ COLLISION_TYPE ObjectSupervisor::DetectCollision(MapObject* object,
 }
 
 Path ObjectSupervisor::FindPath(VirtualSprite *sprite, const Position2D& destination, uint32_t max_cost)
+{
+    if(!IsWithinMapBounds(sprite)) {
+        IF_PRINT_WARNING(MAP_DEBUG) << "Sprite position is invalid" << std::endl;
+        return Path();
+    }
+
+    return FindPath(sprite, sprite->GetPosition(), destination, max_cost);
+}
+
+Path ObjectSupervisor::FindPath(VirtualSprite *sprite, const Position2D& source,
+                                const Position2D& destination, uint32_t max_cost)
+{
+    if(!IsWithinMapBounds(source.x, source.y)) {
+        IF_PRINT_WARNING(MAP_DEBUG) << "Source position is invalid" << std::endl;
+        return Path();
+    }
+
+    // No path can be shorter than the diagonal distance, so don't search when it is already too costly.
+    if(max_cost > 0) {
+        uint32_t x_delta = static_cast<uint32_t>(std::abs(destination.x - source.x));
+        uint32_t y_delta = static_cast<uint32_t>(std::abs(destination.y - source.y));
+        uint32_t diagonal_moves = std::min(x_delta, y_delta);
+        uint32_t diagonal_cost = 14 * diagonal_moves + 10 * (std::max(x_delta, y_delta) - diagonal_moves);
+        if(diagonal_cost >= max_cost * 10)
+            return Path();
+    }
+
+    // Long paths are first searched between the cluster entrances.
+    if(_hierarchical_path_distance > 0) {
+        float distance = std::max(std::abs(destination.x - source.x),
+                                  std::abs(destination.y - source.y));
+        if(distance >= static_cast<float>(_hierarchical_path_distance)) {
+            Path path = _FindHierarchicalPath(sprite, source, destination, max_cost);
+            if(!path.empty())
+                return path;
+        }
+    }
+
+    return _FindPath(sprite, source, destination, max_cost);
+}
+
+bool ObjectSupervisor::GetChaseDestination(VirtualSprite* sprite, Position2D& destination)
+{
+    VirtualSprite* camera = MapMode::CurrentInstance()->GetCamera();
+    if(!camera || !sprite)
+        return false;
+
+    // The flow fields only make sense for sprites blocked by the collision grid.
+    if(sprite->GetObjectDrawLayer() == SKY_OBJECT || !(sprite->GetCollisionMask() & WALL_COLLISION))
+        return false;
+
+    if(!IsWithinMapBounds(sprite) || !IsWithinMapBounds(camera))
+        return false;
+
+    uint16_t next_x = 0;
+    uint16_t next_y = 0;
+    PathFootprint footprint(sprite->GetCollGridHalfWidth(), sprite->GetCollGridHeight());
+    if(!_chase_flow_fields.GetNextElement(footprint,
+                                          static_cast<uint16_t>(camera->GetXPosition()),
+                                          static_cast<uint16_t>(camera->GetYPosition()),
+                                          static_cast<uint16_t>(sprite->GetXPosition()),
+                                          static_cast<uint16_t>(sprite->GetYPosition()),
+                                          next_x, next_y)) {
+        return false;
+    }
+
+    // Aim at the element center, as the footprints are computed for it.
+    destination.x = static_cast<float>(next_x) + 0.5f;
+    destination.y = static_cast<float>(next_y) + 0.5f;
+    return true;
+}
+
+Path ObjectSupervisor::_FindHierarchicalPath(VirtualSprite *sprite, const Position2D& source,
+                                             const Position2D& destination, uint32_t max_cost)
+{
+    static const uint32_t basic_gcost = 10;
+
+    Path path;
+
+    // The cluster entrances only make sense for sprites blocked by the collision grid.
+    if(sprite->GetObjectDrawLayer() == SKY_OBJECT || !(sprite->GetCollisionMask() & WALL_COLLISION))
+        return path;
+
+    if(!IsWithinMapBounds(destination.x, destination.y))
+        return path;
+
+    std::vector<std::pair<uint16_t, uint16_t> > waypoints;
+    uint32_t waypoints_cost = 0;
+    PathFootprint footprint(sprite->GetCollGridHalfWidth(), sprite->GetCollGridHeight());
+    if(!_hierarchical_path_finder.FindWaypoints(footprint,
+                                                static_cast<uint16_t>(source.x),
+                                                static_cast<uint16_t>(source.y),
+                                                static_cast<uint16_t>(destination.x),
+                                                static_cast<uint16_t>(destination.y),
+                                                waypoints, waypoints_cost)) {
+        return path;
+    }
+
+    // Don't refine a path already too costly between the entrances.
+    // The bounded plain search done instead will find whether a cheaper one exists.
+    if(max_cost > 0 && waypoints_cost >= max_cost * basic_gcost)
+        return path;
+
+    // Keep the destination offset all along, as _FindPath() does.
+    float offset_x = vt_utils::GetFloatFraction(destination.x);
+    float offset_y = vt_utils::GetFloatFraction(destination.y);
+
+    // Refine the path between each waypoint, which also avoids the other sprites.
+    Position2D segment_source = source;
+    for(uint32_t i = 0; i < waypoints.size(); ++i) {
+        // The waypoint may be where the previous segment ended.
+        if(static_cast<uint16_t>(segment_source.x) == waypoints[i].first
+                && static_cast<uint16_t>(segment_source.y) == waypoints[i].second)
+            continue;
+
+        Position2D waypoint(static_cast<float>(waypoints[i].first) + offset_x,
+                            static_cast<float>(waypoints[i].second) + offset_y);
+        if(i == waypoints.size() - 1)
+            waypoint = destination;
+
+        Path segment = _FindPath(sprite, segment_source, waypoint, 0);
+        if(segment.empty()) {
+            path.clear();
+            return path;
+        }
+
+        path.insert(path.end(), segment.begin(), segment.end());
+        segment_source = waypoint;
+    }
+
+    // Apply the maximum cost to the refined path, as avoiding the other sprites can make it longer.
+    if(max_cost > 0) {
+        uint32_t cost = 0;
+        int16_t previous_x = static_cast<int16_t>(source.x);
+        int16_t previous_y = static_cast<int16_t>(source.y);
+        for(uint32_t i = 0; i < path.size(); ++i) {
+            int16_t x = static_cast<int16_t>(path[i].x);
+            int16_t y = static_cast<int16_t>(path[i].y);
+            cost += (x != previous_x && y != previous_y) ? basic_gcost + 4 : basic_gcost;
+            previous_x = x;
+            previous_y = y;
+        }
+
+        if(cost >= max_cost * basic_gcost)
+            path.clear();
+    }
+
+    return path;
+}
+
+Path ObjectSupervisor::_FindPath(VirtualSprite *sprite, const Position2D& source,
+                                 const Position2D& destination, uint32_t max_cost)
 {
     // NOTE: Refer to the implementation of the A* algorithm to understand
     // what all these lists and score values are for.
@@ -686,8 +1032,8 @@ Path ObjectSupervisor::FindPath(VirtualSprite *sprite, const Position2D& destina
     // but we still use integer positions for path finding.
     Path path;
 
-    if(!MapMode::CurrentInstance()->GetObjectSupervisor()->IsWithinMapBounds(sprite)) {
-        IF_PRINT_WARNING(MAP_DEBUG) << "Sprite position is invalid" << std::endl;
+    if(!IsWithinMapBounds(source.x, source.y)) {
+        IF_PRINT_WARNING(MAP_DEBUG) << "Source position is invalid" << std::endl;
         return path;
     }
 
@@ -701,76 +1047,92 @@ Path ObjectSupervisor::FindPath(VirtualSprite *sprite, const Position2D& destina
     }
 
     // The starting node of this path discovery
-    PathNode source_node(static_cast<int16_t>(sprite->GetXPosition()), static_cast<int16_t>(sprite->GetYPosition()));
+    int16_t source_x = static_cast<int16_t>(source.x);
+    int16_t source_y = static_cast<int16_t>(source.y);
     // The ending node.
-    PathNode dest(static_cast<int16_t>(destination.x), static_cast<int16_t>(destination.y));
+    int16_t dest_x = static_cast<int16_t>(destination.x);
+    int16_t dest_y = static_cast<int16_t>(destination.y);
 
     // Check that the source node is not the same as the destination node
-    if(source_node == dest) {
+    if(source_x == dest_x && source_y == dest_y) {
         PRINT_ERROR << "source node coordinates are the same as the destination" << std::endl;
         // return an empty path.
         return path;
     }
 
-    std::vector<PathNode> open_list;
-    std::vector<PathNode> closed_list;
+    if(_path_nodes.size() != static_cast<uint32_t>(_num_grid_x_axis * _num_grid_y_axis)) {
+        PRINT_ERROR << "path finding nodes aren't allocated for the current collision grid" << std::endl;
+        return path;
+    }
+
+    // Invalidate the previous search nodes. They only need to be reset
+    // once the generation counter wraps around.
+    ++_path_generation;
+    if(_path_generation == 0) {
+        for(uint32_t i = 0; i < _path_nodes.size(); ++i)
+            _path_nodes[i].generation = 0;
+        _path_generation = 1;
+    }
+    _path_open_list.Clear();
+
+    const uint32_t source_index = source_y * _num_grid_x_axis + source_x;
+    const uint32_t dest_index = dest_y * _num_grid_x_axis + dest_x;
+
+    PathNode& source_node = _path_nodes[source_index];
+    source_node.generation = _path_generation;
+    source_node.f_score = 0;
+    source_node.g_score = 0;
+    source_node.h_score = 0;
+    source_node.parent = source_index;
+    _path_open_list.Push(_path_nodes, source_index);
 
-    // The current "best node"
-    PathNode best_node;
-    // Used to hold the eight adjacent nodes
-    PathNode nodes[8];
+    // The offsets of the 8 adjacent nodes, lateral ones first.
+    static const int16_t adjacent_offsets[8][2] = {
+        { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 },
+        { -1, -1 }, { -1, 1 }, { 1, -1 }, { 1, 1 }
+    };
 
     // Temporary delta variables used in calculation of a node's heuristic (h score)
     uint32_t x_delta, y_delta;
     // The number to add to a node's g_score, depending on whether it is a lateral or diagonal movement
-    int16_t g_add;
-
-    open_list.push_back(source_node);
+    uint32_t g_add;
 
     // We will try to keep the original offset all along.
     float offset_x = vt_utils::GetFloatFraction(destination.x);
     float offset_y = vt_utils::GetFloatFraction(destination.y);
 
-    while(open_list.empty() == false) {
-        sort(open_list.begin(), open_list.end());
-        best_node = open_list.back();
-        open_list.pop_back();
-        closed_list.push_back(best_node);
+    bool destination_reached = false;
+    while(!_path_open_list.IsEmpty()) {
+        // The best node is moved to the closed list.
+        const uint32_t best_index = _path_open_list.Pop(_path_nodes);
 
         // Check if destination has been reached, and break out of the loop if so
-        if(best_node == dest)
+        if(best_index == dest_index) {
+            destination_reached = true;
             break;
+        }
 
-        // Setup the coordinates of the 8 adjacent nodes to the best node
-        nodes[0].tile_x = best_node.tile_x - 1;
-        nodes[0].tile_y = best_node.tile_y;
-        nodes[1].tile_x = best_node.tile_x + 1;
-        nodes[1].tile_y = best_node.tile_y;
-        nodes[2].tile_x = best_node.tile_x;
-        nodes[2].tile_y = best_node.tile_y - 1;
-        nodes[3].tile_x = best_node.tile_x;
-        nodes[3].tile_y = best_node.tile_y + 1;
-        nodes[4].tile_x = best_node.tile_x - 1;
-        nodes[4].tile_y = best_node.tile_y - 1;
-        nodes[5].tile_x = best_node.tile_x - 1;
-        nodes[5].tile_y = best_node.tile_y + 1;
-        nodes[6].tile_x = best_node.tile_x + 1;
-        nodes[6].tile_y = best_node.tile_y - 1;
-        nodes[7].tile_x = best_node.tile_x + 1;
-        nodes[7].tile_y = best_node.tile_y + 1;
+        const int16_t best_x = best_index % _num_grid_x_axis;
+        const int16_t best_y = best_index / _num_grid_x_axis;
+        const uint32_t best_g_score = _path_nodes[best_index].g_score;
 
         // Check the eight adjacent nodes
         for(uint8_t i = 0; i < 8; ++i) {
+            int16_t node_x = best_x + adjacent_offsets[i][0];
+            int16_t node_y = best_y + adjacent_offsets[i][1];
+
             // ---------- (A): Check if all tiles are walkable
             // Don't use 0.0f here for both since errors at the border between
             // two positions may occure, especially when running.
             COLLISION_TYPE collision_type = DetectCollision(sprite,
-                                            ((float)nodes[i].tile_x) + offset_x,
-                                            ((float)nodes[i].tile_y) + offset_y);
+                                            ((float)node_x) + offset_x,
+                                            ((float)node_y) + offset_y);
 
-            // Can't go through walls.
+            // Can't go through walls, nor out of the map.
             if(collision_type == WALL_COLLISION)
                 continue;
+            if(node_x < 0 || node_y < 0 || node_x >= _num_grid_x_axis || node_y >= _num_grid_y_axis)
+                continue;
 
             // ---------- (B): If this point has been reached, the node is valid for the sprite to move to
             // If this is a lateral adjacent node, g_score is +10, otherwise diagonal adjacent node is +14
@@ -787,46 +1149,45 @@ Path ObjectSupervisor::FindPath(VirtualSprite *sprite, const Position2D& destina
                 g_add += basic_gcost * 2;
 
             // If the path has reached the maximum length requested, we abort the path
-            if (max_cost > 0 && (uint32_t)(best_node.g_score + g_add) >= max_cost * basic_gcost)
+            if (max_cost > 0 && best_g_score + g_add >= max_cost * basic_gcost)
                 return path;
 
-            // ---------- (C): Check if the node is already in the closed list
-            if(find(closed_list.begin(), closed_list.end(), nodes[i]) != closed_list.end())
-                continue;
+            const uint32_t node_index = node_y * _num_grid_x_axis + node_x;
+            PathNode& node = _path_nodes[node_index];
+            const uint32_t g_score = best_g_score + g_add;
 
-            // Set the node's parent and calculate its g_score
-            nodes[i].parent_x = best_node.tile_x;
-            nodes[i].parent_y = best_node.tile_y;
-            nodes[i].g_score = best_node.g_score + g_add;
-
-            // ---------- (D): Check to see if the node is already on the open list and update it if necessary
-            std::vector<PathNode>::iterator iter = std::find(open_list.begin(), open_list.end(), nodes[i]);
-            if(iter != open_list.end()) {
-                // If its G is higher, it means that the path we are on is better, so switch the parent
-                if(iter->g_score > nodes[i].g_score) {
-                    iter->g_score = nodes[i].g_score;
-                    iter->f_score = nodes[i].g_score + iter->h_score;
-                    iter->parent_x = nodes[i].parent_x;
-                    iter->parent_y = nodes[i].parent_y;
-                }
-            }
             // ---------- (E): Add the new node to the open list
-            else {
+            if(node.generation != _path_generation) {
                 // Calculate the H and F score of the new node (the heuristic used is diagonal)
-                x_delta = abs(dest.tile_x - nodes[i].tile_x);
-                y_delta = abs(dest.tile_y - nodes[i].tile_y);
+                x_delta = abs(dest_x - node_x);
+                y_delta = abs(dest_y - node_y);
                 if(x_delta > y_delta)
-                    nodes[i].h_score = 14 * y_delta + 10 * (x_delta - y_delta);
+                    node.h_score = 14 * y_delta + 10 * (x_delta - y_delta);
                 else
-                    nodes[i].h_score = 14 * x_delta + 10 * (y_delta - x_delta);
+                    node.h_score = 14 * x_delta + 10 * (y_delta - x_delta);
 
-                nodes[i].f_score = nodes[i].g_score + nodes[i].h_score;
-                open_list.push_back(nodes[i]);
+                node.generation = _path_generation;
+                node.g_score = g_score;
+                node.f_score = g_score + node.h_score;
+                node.parent = best_index;
+                _path_open_list.Push(_path_nodes, node_index);
+            }
+            // ---------- (C): Check if the node is already in the closed list
+            else if(node.heap_index == PATH_NODE_CLOSED) {
+                continue;
+            }
+            // ---------- (D): The node is already on the open list, update it if necessary
+            // If its G is higher, it means that the path we are on is better, so switch the parent
+            else if(node.g_score > g_score) {
+                node.g_score = g_score;
+                node.f_score = g_score + node.h_score;
+                node.parent = best_index;
+                _path_open_list.DecreaseKey(_path_nodes, node_index);
             }
         } // for (uint8_t i = 0; i < 8; ++i)
-    } // while (open_list.empty() == false)
+    } // while (!_path_open_list.IsEmpty())
 
-    if(open_list.empty()) {
+    if(!destination_reached) {
         IF_PRINT_WARNING(MAP_DEBUG) << "could not find path to destination" << std::endl;
         return path;
     }
@@ -834,20 +1195,11 @@ Path ObjectSupervisor::FindPath(VirtualSprite *sprite, const Position2D& destina
     // Add the destination node to the vector.
     path.push_back(destination);
 
-    // Retain the last node parent, and remove it from the closed list
-    int16_t parent_x = best_node.parent_x;
-    int16_t parent_y = best_node.parent_y;
-    closed_list.pop_back();
-
-    // Go backwards through the closed list following the parent nodes to construct the path
-    for(std::vector<PathNode>::iterator iter = closed_list.end() - 1; iter != closed_list.begin(); --iter) {
-        if(iter->tile_y == parent_y && iter->tile_x == parent_x) {
-            Position2D next_pos(((float)iter->tile_x) + offset_x, ((float)iter->tile_y) + offset_y);
-            path.push_back(next_pos);
-
-            parent_x = iter->parent_x;
-            parent_y = iter->parent_y;
-        }
+    // Follow the parent nodes back to the source node, which isn't part of the path.
+    for(uint32_t index = _path_nodes[dest_index].parent; index != source_index; index = _path_nodes[index].parent) {
+        Position2D next_pos(((float)(index % _num_grid_x_axis)) + offset_x,
+                            ((float)(index / _num_grid_x_axis)) + offset_y);
+        path.push_back(next_pos);
     }
     std::reverse(path.begin(), path.end());
 
@@ -901,7 +1253,7 @@ void ObjectSupervisor::DrawCollisionArea(const MapFrame *frame)
             x < static_cast<uint32_t>((frame->tile_x_start + frame->num_draw_x_axis) * 2); ++x) {
 
             // Draw the collision rectangle.
-            if (_collision_grid[y][x] > 0)
+            if (_collision_grid.IsCollision(x, y))
                 vt_video::VideoManager->DrawRectangle(GRID_LENGTH, GRID_LENGTH,
                                                       vt_video::Color(1.0f, 0.0f, 0.0f, 0.6f));
 
@@ -912,6 +1264,23 @@ void ObjectSupervisor::DrawCollisionArea(const MapFrame *frame)
     } // y
 }
 
+void ObjectSupervisor::SetMapCollision(uint32_t x, uint32_t y, bool collision)
+{
+    if(x >= _num_grid_x_axis || y >= _num_grid_y_axis) {
+        PRINT_WARNING << "Invalid map collision position: (" << x << ", " << y << ")" << std::endl;
+        return;
+    }
+
+    if(_collision_grid.IsCollision(x, y) == collision)
+        return;
+
+    _collision_grid.ChangeCollision(x, y, collision);
+    ++_collision_grid_version;
+    // The affected clusters are recomputed on the next update, once for every change made meanwhile.
+    _hierarchical_path_finder.MarkDirty(x, y);
+    _chase_flow_fields.Build(&_collision_grid);
+}
+
 bool ObjectSupervisor::IsStaticCollision(float x, float y)
 {
     if (!IsWithinMapBounds(x, y))
@@ -921,8 +1290,11 @@ bool ObjectSupervisor::IsStaticCollision(float x, float y)
     if (IsMapCollision(static_cast<uint32_t>(x), static_cast<uint32_t>(y)))
         return true;
 
+    // Only test the objects near the position.
+    const std::vector<MapObject *>& objects = _GetObjectsInArea(GROUND_OBJECT, Rectangle2D(x, x, y, y));
+
     std::vector<vt_map::private_map::MapObject *>::const_iterator it, it_end;
-    for(it = _ground_objects.begin(), it_end = _ground_objects.end(); it != it_end; ++it) {
+    for(it = objects.begin(), it_end = objects.end(); it != it_end; ++it) {
         MapObject *collision_object = *it;
         // Check if the object exists and has the no_collision property enabled
         if(!collision_object || collision_object->GetCollisionMask() == NO_COLLISION)
@@ -942,10 +1314,42 @@ bool ObjectSupervisor::IsStaticCollision(float x, float y)
     return false;
 }
 
+void ObjectSupervisor::GetStaticCollisionGrid(std::vector<uint8_t>& static_collision)
+{
+    static_collision.assign(_num_grid_x_axis * _num_grid_y_axis, 0);
+
+    for(uint16_t y = 0; y < _num_grid_y_axis; ++y) {
+        for(uint16_t x = 0; x < _num_grid_x_axis; ++x) {
+            if(_collision_grid.IsCollision(x, y))
+                static_collision[y * _num_grid_x_axis + x] = 1;
+        }
+    }
+
+    // Add the grid elements covered by the physical objects, as IsStaticCollision() does.
+    for(uint32_t i = 0; i < _ground_objects.size(); ++i) {
+        MapObject* object = _ground_objects[i];
+        if(!object || object->GetCollisionMask() == NO_COLLISION || object->GetObjectType() != PHYSICAL_TYPE)
+            continue;
+
+        // The grid elements whose coordinates are within the rectangle bounds.
+        Rectangle2D rect = object->GetGridCollisionRectangle();
+        int32_t left = std::max(0, static_cast<int32_t>(std::ceil(rect.left)));
+        int32_t top = std::max(0, static_cast<int32_t>(std::ceil(rect.top)));
+        int32_t right = std::min(static_cast<int32_t>(_num_grid_x_axis) - 1, static_cast<int32_t>(std::floor(rect.right)));
+        int32_t bottom = std::min(static_cast<int32_t>(_num_grid_y_axis) - 1, static_cast<int32_t>(std::floor(rect.bottom)));
+
+        for(int32_t y = top; y <= bottom; ++y) {
+            for(int32_t x = left; x <= right; ++x)
+                static_collision[y * _num_grid_x_axis + x] = 1;
+        }
+    }
+}
+
 void ObjectSupervisor::StopSoundObjects()
 {
-    for (uint32_t i = 0; i < _sound_object_highest_volumes.size(); ++i) {
-        vt_audio::SoundDescriptor* sound = _sound_object_highest_volumes[i]->GetSoundDescriptor();
+    const std::vector<SoundObject*>& elected_sounds = _ambient_sounds.GetElectedSounds();
+    for (uint32_t i = 0; i < elected_sounds.size(); ++i) {
+        vt_audio::SoundDescriptor* sound = elected_sounds[i]->GetSoundDescriptor();
         if (sound->GetState() == vt_audio::AUDIO_STATE_PLAYING
                 || sound->GetState() == vt_audio::AUDIO_STATE_FADE_IN) {
             sound->Stop();
@@ -955,8 +1359,9 @@ void ObjectSupervisor::StopSoundObjects()
 
 void ObjectSupervisor::RestartSoundObjects()
 {
-    for (uint32_t i = 0; i < _sound_object_highest_volumes.size(); ++i) {
-        vt_audio::SoundDescriptor* sound = _sound_object_highest_volumes[i]->GetSoundDescriptor();
+    const std::vector<SoundObject*>& elected_sounds = _ambient_sounds.GetElectedSounds();
+    for (uint32_t i = 0; i < elected_sounds.size(); ++i) {
+        vt_audio::SoundDescriptor* sound = elected_sounds[i]->GetSoundDescriptor();
         if (sound->GetState() == vt_audio::AUDIO_STATE_STOPPED)
             sound->FadeIn(1000.0f);
     }
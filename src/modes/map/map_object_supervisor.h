@@ -12,6 +12,13 @@
 #define __MAP_OBJECT_SUPERVISOR_HEADER__
 
 #include "modes/map/map_objects/map_object.h"
+#include "modes/map/map_hierarchical_path.h"
+#include "modes/map/map_object_buckets.h"
+#include "modes/map/map_ambient_sounds.h"
+#include "modes/map/map_collision_grid.h"
+#include "modes/map/map_data.h"
+#include "modes/map/map_flow_field.h"
+#include "modes/map/map_path_requests.h"
 
 #include "script/script_read.h"
 
@@ -27,6 +34,12 @@ class EscapePoint;
 class SoundObject;
 class Light;
 
+//! \brief The distance around the screen, in grid elements, where objects are fully updated.
+const float DORMANT_UPDATE_MARGIN = SCREEN_GRID_Y_LENGTH / 2.0f;
+
+//! \brief The extra distance around the screen, in grid elements, where objects are given a chance to be drawn.
+const float DRAW_RANGE_MARGIN = 1.0f;
+
 /** ****************************************************************************
 *** \brief A helper class to MapMode responsible for management of all object and sprite data
 ***
@@ -76,6 +89,21 @@ public:
     //! This should only be called by the MapObject constructor.
     void RegisterObject(MapObject* object);
 
+    /** \brief Moves the object to the collision buckets overlapped by its collision rectangle.
+    *** This should only be called by the MapObject when its position or collision size changes.
+    **/
+    void UpdateObjectBuckets(MapObject* object);
+
+    /** \brief Marks the object as needing to be moved to its new draw order place.
+    *** This should only be called by the MapObject when its y position changes.
+    **/
+    void InvalidateDrawOrder(MapObject* object);
+
+    /** \brief Keeps the tallest image height of each draw layer up to date, used to find the objects to draw.
+    *** This should only be called by the MapObject when its image height changes.
+    **/
+    void UpdateDrawHeight(MapObject* object);
+
     //! \brief Delete an object from memory.
     void DeleteObject(MapObject* object);
 
@@ -102,20 +130,27 @@ public:
     // Called by the Mazone constructor.
     void AddZone(MapZone* zone);
 
-    //! \brief Sorts objects on all three layers according to their draw order
+    /** \brief Sorts objects on all layers according to their draw order.
+    *** Only the objects which moved since the last call are placed again,
+    *** and the layers without any of those are skipped.
+    **/
     void SortObjects();
 
+    //! \brief Returns the number of objects placed again by the last SortObjects() call.
+    uint32_t GetNumSortedObjects() const {
+        return _num_sorted_objects;
+    }
+
     /** \brief Loads the collision grid data and saved state of all map objects
-    *** \param map_file A reference to the open map script file
+    *** \param map_data The map data, read either from the map data file or its compiled version.
     *** \return Whether the collision data loading was successful.
-    ***
-    *** The file must be open prior to making this call and additionally must
-    *** be at the highest level scope (i.e., there are no actively open tables
-    *** in the script descriptor object).
     **/
-    bool Load(vt_script::ReadScriptDescriptor &map_file);
+    bool Load(const MapData& map_data);
 
-    //! \brief Updates the state of all map zones and objects
+    /** \brief Updates the state of all map zones and objects.
+    *** The objects far from the screen which allow it only accumulate the elapsed time,
+    *** and catch it up once they get close to the screen again.
+    **/
     void Update();
 
     /** \brief Draws the various object layers to the screen
@@ -124,6 +159,7 @@ public:
     *** is already set prior to these function calls (0.0f, SCREEN_COLS, SCREEN_ROWS, 0.0f). These functions do make
     *** modifications to the draw flags and the draw cursor position, which are not restored by the function
     *** upon its return. Take measures to retain this information before calling these functions if necessary.
+    *** \note Only the layer objects whose y position lies around the screen are visited.
     **/
     //@{
     void DrawMapPoints();
@@ -191,10 +227,15 @@ public:
     COLLISION_TYPE DetectCollision(MapObject* object, float x, float y,
                                    MapObject **collision_object_ptr = nullptr);
 
+    /** \brief Tells whether the object would be out of the map or on walls at the given position.
+    *** Only the map bounds are checked for objects without the wall collision mask, or in the sky layer.
+    *** The wall check is a single clearance lookup in most cases.
+    **/
+    bool IsWallCollision(MapObject* object, float x, float y);
+
     /** \brief Finds a path from a sprite's current position to a destination
     *** \param sprite A pointer of the sprite to find the path for
     *** \param dest The destination coordinates
-    *** \param path A vector of PathNode objects storing the path
     *** \param max_cost Tells how far a path node can be computed agains the starting path node.
     *** This is used to avoid heavy computations.
     *** If this param is equal to 0, there is no limitation.
@@ -202,6 +243,12 @@ public:
     *** This algorithm uses the A* algorithm to find a path from a source to a destination.
     *** This function ignores the position of all other objects and only concerns itself with
     *** which map grid elements are walkable.
+    *** The open list is a binary heap, and the node states are stored per grid element
+    *** in _path_nodes, so that no allocation or search is needed while exploring.
+    ***
+    *** When the destination is at least as far as the hierarchical path distance,
+    *** the path is first searched between the collision grid cluster entrances,
+    *** and then refined using A* between each of them.
     ***
     *** \note If an error is detected or a path could not be found, the function will empty the path vector before returning
     **/
@@ -209,6 +256,57 @@ public:
                   const vt_common::Position2D& destination,
                   uint32_t max_cost = 0);
 
+    /** \brief Finds a path for the sprite from another position than its current one.
+    *** \see FindPath()
+    **/
+    Path FindPath(private_map::VirtualSprite *sprite,
+                  const vt_common::Position2D& source,
+                  const vt_common::Position2D& destination,
+                  uint32_t max_cost);
+
+    /** \brief Sets the distance, in collision grid elements, from which paths are searched
+    *** using the precomputed cluster entrances. 0 disables the hierarchical path finding.
+    **/
+    void SetHierarchicalPathDistance(uint32_t distance) {
+        _hierarchical_path_distance = distance;
+    }
+
+    uint32_t GetHierarchicalPathDistance() const {
+        return _hierarchical_path_distance;
+    }
+
+    /** \brief Gives the position to move toward for the sprite to chase the camera sprite.
+    *** The chasing sprites follow a flow field rooted at the camera sprite grid element,
+    *** shared by every sprite of the same collision footprint, and only computed again
+    *** when the camera sprite enters another grid element.
+    *** \return false when the sprite isn't blocked by walls, is on the camera sprite
+    *** grid element, or can't reach it through the flow field. The sprite should then
+    *** head directly toward the camera sprite.
+    **/
+    bool GetChaseDestination(private_map::VirtualSprite* sprite, vt_common::Position2D& destination);
+
+    /** \brief Requests a path, computed in a later frame within a time budget.
+    *** \return The ticket to give to TakePath(), never 0.
+    *** \see FindPath()
+    **/
+    uint32_t RequestPath(private_map::VirtualSprite *sprite,
+                         const vt_common::Position2D& destination,
+                         uint32_t max_cost = 0) {
+        return _path_requests.RequestPath(sprite, destination, max_cost);
+    }
+
+    /** \brief Takes the path computed for the given ticket, which is then released.
+    *** \return false if the path isn't computed yet.
+    **/
+    bool TakePath(uint32_t ticket, Path& path) {
+        return _path_requests.TakePath(ticket, path);
+    }
+
+    //! \brief Cancels the path request of the given ticket.
+    void CancelPathRequest(uint32_t ticket) {
+        _path_requests.CancelRequest(ticket);
+    }
+
     /** \brief Tells the object supervisor that the given sprite pointer
     *** is the party member object.
     *** This later permits to refresh the sprite shown based on the battle
@@ -256,10 +354,26 @@ public:
     //! \return whether the location would be a "wall" for the party or not
     bool IsStaticCollision(float x, float y);
 
+    /** \brief Computes IsStaticCollision() for every grid element at once.
+    *** \param static_collision Filled with one value per grid element, stored at [y * width + x],
+    *** non-zero where there is a static collision.
+    **/
+    void GetStaticCollisionGrid(std::vector<uint8_t>& static_collision);
+
     //! \brief checks if the location on the grid has a simple map collision. This is different from
     //! IsStaticCollision, in that it DOES NOT check static objects, but only the collision value for the map
     bool IsMapCollision(uint32_t x, uint32_t y)
-    { return (_collision_grid[y][x] > 0); }
+    { return _collision_grid.IsCollision(x, y); }
+
+    //! \brief Returns a number changed each time the collision grid is loaded or modified,
+    //! so that the data computed from it can be refreshed.
+    uint32_t GetCollisionGridVersion() const
+    { return _collision_grid_version; }
+
+    /** \brief Changes the map collision value of a grid element at runtime.
+    *** The clearance map is updated around the element, and the long path graphs are recomputed.
+    **/
+    void SetMapCollision(uint32_t x, uint32_t y, bool collision);
 
     //! \brief returns a const reference to the ground objects in
     const std::vector<MapObject *>& GetGroundObjects() const
@@ -289,6 +403,45 @@ private:
     //! \brief Returns the MapObject vector corresponding to the draw layer.
     std::vector<MapObject*>& _GetObjectsFromDrawLayer(MapObjectDrawLayer layer);
 
+    //! \brief Returns the collision buckets corresponding to the draw layer.
+    private_map::ObjectBucketGrid& _GetObjectBucketsFromDrawLayer(MapObjectDrawLayer layer);
+
+    /** \brief Returns the objects of the draw layer that may overlap the given area.
+    *** The collision buckets are used once the collision grid is loaded, and the whole layer before that.
+    *** \note The returned vector is only valid until the next call.
+    **/
+    const std::vector<MapObject*>& _GetObjectsInArea(MapObjectDrawLayer layer,
+                                                     const vt_common::Rectangle2D& area);
+
+    //! \brief Moves the objects of the layer marked by InvalidateDrawOrder() to their draw order place.
+    void _SortDrawLayer(std::vector<MapObject*>& objects);
+
+    //! \brief Updates the object, or only accumulates its update time when it is outside of the active area.
+    void _UpdateObject(MapObject* object, const vt_common::Rectangle2D& active_area);
+
+    /** \brief Gets the range of the layer objects which may be visible on screen.
+    *** Since the objects are sorted by y position and drawn above it, only those between
+    *** the screen top and the screen bottom plus the tallest image height are candidates.
+    *** \param first The index of the first object to draw.
+    *** \param end The index after the last object to draw.
+    **/
+    void _GetDrawRange(MapObjectDrawLayer layer, uint32_t& first, uint32_t& end);
+
+    //! \brief Finds a path from the given source position to a destination using A*.
+    //! \see FindPath()
+    Path _FindPath(private_map::VirtualSprite *sprite,
+                   const vt_common::Position2D& source,
+                   const vt_common::Position2D& destination,
+                   uint32_t max_cost);
+
+    /** \brief Finds a path through the cluster entrances, refining it with _FindPath().
+    *** \return An empty path if the hierarchical search couldn't be used or failed.
+    **/
+    Path _FindHierarchicalPath(private_map::VirtualSprite *sprite,
+                               const vt_common::Position2D& source,
+                               const vt_common::Position2D& destination,
+                               uint32_t max_cost);
+
     /** \brief The number of rows and columns in the collision grid
     *** The number of collision grid rows and columns is always equal to twice
     *** that of the number of rows and columns of tiles (stored in the TileManager).
@@ -305,13 +458,36 @@ private:
     **/
     private_map::MapSprite* _visible_party_member;
 
-    /** \brief A 2D vector indicating which grid element on the map sprites may be occupied by objects.
-    *** Each bit of each element in this grid corresponds to a context. So all together this entire grid
-    *** stores the collision information for all 32 possible map contexts.
-    *** \Note A position in this member is stored like this:
-    *** _collision_grid[y][x]
+    /** \brief The grid elements on the map sprites may not walk on, one bit per element.
+    *** \Note The elements are stored row after row, and tested with _collision_grid.IsCollision(x, y)
     **/
-    std::vector<std::vector<uint32_t> > _collision_grid;
+    private_map::CollisionGrid _collision_grid;
+
+    //! \brief The collision grid version, increased each time the grid is changed.
+    uint32_t _collision_grid_version;
+
+    /** \brief The path finding node of each collision grid element, allocated once the grid is loaded.
+    *** \Note A node is stored at _path_nodes[y * _num_grid_x_axis + x]
+    **/
+    std::vector<private_map::PathNode> _path_nodes;
+
+    //! \brief The path finding open list, kept to reuse its memory between searches.
+    private_map::PathOpenList _path_open_list;
+
+    //! \brief The current path search generation, incremented instead of resetting the nodes.
+    uint32_t _path_generation;
+
+    //! \brief The precomputed cluster entrances used to find long paths.
+    private_map::HierarchicalPathFinder _hierarchical_path_finder;
+
+    //! \brief The flow fields toward the camera sprite, used by the chasing sprites.
+    private_map::FlowFieldSet _chase_flow_fields;
+
+    //! \brief The path requests, computed at each update.
+    private_map::PathRequestQueue _path_requests;
+
+    //! \brief The distance from which the hierarchical path finding is used. 0 disables it.
+    uint32_t _hierarchical_path_distance;
 
     /** \brief A map containing pointers to all of the sprites on a map.
     *** This map does not include a pointer to the _virtual_focus object. The
@@ -345,6 +521,29 @@ private:
     **/
     std::vector<MapObject *> _sky_objects;
 
+    /** \brief The collision buckets of the flat ground, ground, pass and sky object layers.
+    *** They permit to only test the objects near a given area for collisions.
+    **/
+    private_map::ObjectBucketGrid _flat_ground_buckets;
+    private_map::ObjectBucketGrid _ground_buckets;
+    private_map::ObjectBucketGrid _pass_buckets;
+    private_map::ObjectBucketGrid _sky_buckets;
+
+    //! \brief Holds the objects found by the last _GetObjectsInArea() call, to reuse its memory.
+    std::vector<MapObject *> _objects_in_area;
+
+    //! \brief Whether each draw layer has objects to place again in the draw order.
+    bool _draw_order_changed[NO_LAYER_OBJECT];
+
+    //! \brief The tallest image height ever set on each draw layer objects, in grid elements.
+    float _max_img_grid_height[NO_LAYER_OBJECT];
+
+    //! \brief Holds the objects to place again while sorting a layer, to reuse its memory.
+    std::vector<MapObject *> _objects_to_sort;
+
+    //! \brief The number of objects placed again by the last SortObjects() call, shown in the debug info.
+    uint32_t _num_sorted_objects;
+
     //! \brief A container for all of the save points, quite similar as the ground objects container.
     std::vector<SavePoint *> _save_points;
 
@@ -352,13 +551,9 @@ private:
     std::vector<EscapePoint *> _escape_points;
 
     //! \brief Ambient sound objects, that plays a sound with a volume according
-    //! to the distance with the camera.
-    std::vector<SoundObject *> _sound_objects;
-
-    //! \brief Vector used to know at what exact volume a sound should be played
-    //! when there are several instances of the same sound in a MapMode.
-    //! They are also used when restarting the MapMode.
-    std::vector<SoundObject*> _sound_object_highest_volumes;
+    //! to the distance with the camera. The loudest object of each sound is used
+    //! to know at what exact volume the sound should be played, and when restarting the MapMode.
+    private_map::AmbientSoundMixer _ambient_sounds;
 
     //! \brief Containers for all of the map source of light, quite similar as the ground objects container.
     std::vector<Halo *> _halos;
@@ -30,8 +30,7 @@ EscapePoint::EscapePoint(float x, float y):
     _animation(nullptr),
     _is_active(false)
 {
-    _tile_position.x = x;
-    _tile_position.y = y;
+    SetPosition(x, y);
 
     _object_type = ESCAPE_TYPE;
     _collision_mask = NO_COLLISION;
@@ -26,8 +26,7 @@ Halo::Halo(const std::string& filename,
     MapObject(NO_LAYER_OBJECT) // This is a special object
 {
     _color = color;
-    _tile_position.x = x;
-    _tile_position.y = y;
+    SetPosition(x, y);
 
     _object_type = HALO_TYPE;
     _collision_mask = NO_COLLISION;
@@ -60,6 +59,13 @@ void Halo::Update()
         _animation.Update();
 }
 
+void Halo::_CatchUpDormantTime(uint32_t elapsed_time)
+{
+    MapObject::_CatchUpDormantTime(elapsed_time);
+    if(_updatable)
+        _animation.Update(elapsed_time);
+}
+
 void Halo::Draw()
 {
     if(MapObject::ShouldDraw() && _animation.GetCurrentFrame())
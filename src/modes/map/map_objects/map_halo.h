@@ -46,6 +46,9 @@ public:
     void Draw() override;
 
 private:
+    //! \brief Catches up the animation time.
+    void _CatchUpDormantTime(uint32_t elapsed_time) override;
+
     //! \brief A reference to the current map save animation.
     vt_video::AnimatedImage _animation;
 
@@ -34,8 +34,7 @@ Light::Light(const std::string& main_flare_filename,
     _main_color = main_color;
     _secondary_color = secondary_color;
 
-    _tile_position.x = x;
-    _tile_position.y = y;
+    SetPosition(x, y);
 
     _object_type = LIGHT_TYPE;
     _collision_mask = NO_COLLISION;
@@ -144,6 +143,16 @@ void Light::Update()
     _UpdateLightAngle();
 }
 
+void Light::_CatchUpDormantTime(uint32_t elapsed_time)
+{
+    MapObject::_CatchUpDormantTime(elapsed_time);
+    if(!_updatable)
+        return;
+
+    _main_animation.Update(elapsed_time);
+    _secondary_animation.Update(elapsed_time);
+}
+
 void Light::Draw()
 {
     if(!MapObject::ShouldDraw() || !_main_animation.GetCurrentFrame())
@@ -61,6 +61,9 @@ private:
     //! Updates the angle and distance from the camera viewpoint
     void _UpdateLightAngle();
 
+    //! \brief Catches up the animations time.
+    void _CatchUpDormantTime(uint32_t elapsed_time) override;
+
     //! \brief A reference to the current light animation.
     vt_video::AnimatedImage _main_animation;
     vt_video::AnimatedImage _secondary_animation;
@@ -50,7 +50,10 @@ MapObject::MapObject(MapObjectDrawLayer layer) :
     _emote_screen_offset(0.0f, 0.0f),
     _emote_time(0),
     _draw_layer(layer),
-    _grayscale(false)
+    _grayscale(false),
+    _draw_order_changed(false),
+    _dormant_update_allowed(true),
+    _dormant_time(0)
 {
     // Generate the object Id at creation time.
     ObjectSupervisor* obj_sup = MapMode::CurrentInstance()->GetObjectSupervisor();
@@ -70,6 +73,35 @@ void MapObject::Update()
         _interaction_icon->Update();
 }
 
+void MapObject::UpdateDormant()
+{
+    _dormant_time += vt_system::SystemManager->GetUpdateTime();
+}
+
+void MapObject::WakeUp()
+{
+    if(_dormant_time == 0)
+        return;
+
+    _CatchUpDormantTime(_dormant_time);
+    _dormant_time = 0;
+}
+
+void MapObject::_CatchUpDormantTime(uint32_t elapsed_time)
+{
+    if(_interaction_icon)
+        _interaction_icon->Update(elapsed_time);
+
+    if(!_emote_animation)
+        return;
+
+    _emote_time -= static_cast<int32_t>(elapsed_time);
+    if(_emote_time <= 0) {
+        _emote_animation = nullptr;
+        _emote_time = 0;
+    }
+}
+
 bool MapObject::ShouldDraw()
 {
     if(!_visible)
@@ -208,6 +240,31 @@ void MapObject::_DrawEmote()
     _emote_animation->Draw();
 }
 
+void MapObject::_UpdateCollisionBuckets()
+{
+    MapMode* map_mode = MapMode::CurrentInstance();
+    if(map_mode)
+        map_mode->GetObjectSupervisor()->UpdateObjectBuckets(this);
+}
+
+void MapObject::_UpdateDrawHeight()
+{
+    MapMode* map_mode = MapMode::CurrentInstance();
+    if(map_mode)
+        map_mode->GetObjectSupervisor()->UpdateDrawHeight(this);
+}
+
+void MapObject::_InvalidateDrawOrder()
+{
+    // The object is already waiting for the next sort.
+    if(_draw_order_changed)
+        return;
+
+    MapMode* map_mode = MapMode::CurrentInstance();
+    if(map_mode)
+        map_mode->GetObjectSupervisor()->InvalidateDrawOrder(this);
+}
+
 void MapObject::SetInteractionIcon(const std::string& animation_filename)
 {
     if (_interaction_icon)
@@ -124,6 +124,19 @@ public:
     bool ShouldDraw();
     //@}
 
+    /** \brief Tells whether the object can currently skip its updates when far from the screen.
+    *** Derived classes may prevent it while the object is busy, e.g.: when controlled by an event.
+    **/
+    virtual bool CanBeDormant() const {
+        return _dormant_update_allowed;
+    }
+
+    //! \brief Accumulates the update time instead of updating the object, when far from the screen.
+    void UpdateDormant();
+
+    //! \brief Catches up the time accumulated while dormant. Called before the object is updated again.
+    void WakeUp();
+
     //! \brief Retrieves the object type identifier
     MAP_OBJECT_TYPE GetObjectType() const {
         return _object_type;
@@ -183,16 +196,23 @@ public:
     **/
     //@{
     void SetPosition(float x, float y) {
+        if(_tile_position.y != y)
+            _InvalidateDrawOrder();
         _tile_position.x = x;
         _tile_position.y = y;
+        _UpdateCollisionBuckets();
     }
 
     void SetXPosition(float x) {
         _tile_position.x = x;
+        _UpdateCollisionBuckets();
     }
 
     void SetYPosition(float y) {
+        if(_tile_position.y != y)
+            _InvalidateDrawOrder();
         _tile_position.y = y;
+        _UpdateCollisionBuckets();
     }
 
     //! \brief Set the object image half width (in pixels).
@@ -209,18 +229,21 @@ public:
         _img_pixel_height = height;
         _img_screen_height = height * MAP_ZOOM_RATIO;
         _img_grid_height = height / GRID_LENGTH * MAP_ZOOM_RATIO;
+        _UpdateDrawHeight();
     }
 
     void SetCollPixelHalfWidth(float collision) {
         _coll_pixel_half_width = collision;
         _coll_screen_half_width = collision * MAP_ZOOM_RATIO;
         _coll_grid_half_width = collision / GRID_LENGTH * MAP_ZOOM_RATIO;
+        _UpdateCollisionBuckets();
     }
 
     void SetCollPixelHeight(float collision) {
         _coll_pixel_height = collision;
         _coll_screen_height = collision * MAP_ZOOM_RATIO;
         _coll_grid_height = collision / GRID_LENGTH * MAP_ZOOM_RATIO;
+        _UpdateCollisionBuckets();
     }
 
     void SetUpdatable(bool update) {
@@ -240,6 +263,18 @@ public:
         _draw_on_second_pass = pass;
     }
 
+    /** \brief Sets whether the object may skip its updates when far from the screen (default == true).
+    *** Objects controlled by scripts should disable it, so that they keep being fully updated.
+    **/
+    void SetDormantUpdateAllowed(bool allowed) {
+        _dormant_update_allowed = allowed;
+    }
+
+    //! \brief Used by the object supervisor to know which objects to place again in the draw order.
+    void SetDrawOrderChanged(bool changed) {
+        _draw_order_changed = changed;
+    }
+
     //! \brief Tells the draw layer for faster deletion from the object supervisor.
     MapObjectDrawLayer GetObjectDrawLayer() const {
         return _draw_layer;
@@ -270,6 +305,10 @@ public:
         return _img_screen_height;
     }
 
+    float GetImgGridHeight() const {
+        return _img_grid_height;
+    }
+
     float GetCollGridHalfWidth() const {
         return _coll_grid_half_width;
     }
@@ -294,6 +333,14 @@ public:
         return _draw_on_second_pass;
     }
 
+    bool IsDrawOrderChanged() const {
+        return _draw_order_changed;
+    }
+
+    bool IsDormantUpdateAllowed() const {
+        return _dormant_update_allowed;
+    }
+
     MAP_OBJECT_TYPE GetType() const {
         return _object_type;
     }
@@ -417,11 +464,38 @@ protected:
     //! \brief Tells whether the map object sprite and animation should be displayed grayscaled or not.
     bool _grayscale;
 
+    //! \brief Whether the y position changed since the object was last placed in the draw order.
+    bool _draw_order_changed;
+
+    //! \brief Whether the object may skip its updates when far from the screen.
+    bool _dormant_update_allowed;
+
+    //! \brief The update time accumulated while the object was dormant, in milliseconds.
+    uint32_t _dormant_time;
+
+    /** \brief Catches up the time spent while dormant, e.g.: the animation timers.
+    *** Derived classes should call their parent implementation.
+    *** \param elapsed_time The time spent dormant, in milliseconds.
+    **/
+    virtual void _CatchUpDormantTime(uint32_t elapsed_time);
+
     //! \brief Takes care of updating the emote animation and state.
     void _UpdateEmote();
 
     //! \brief Takes care of drawing the emote animation.
     void _DrawEmote();
+
+    //! \brief Tells the object supervisor the collision rectangle has changed,
+    //! so that the object is moved to the right collision buckets.
+    void _UpdateCollisionBuckets();
+
+    //! \brief Tells the object supervisor the y position has changed,
+    //! so that the object is moved to its new place in the draw order.
+    void _InvalidateDrawOrder();
+
+    //! \brief Tells the object supervisor the image height has changed,
+    //! so that the object is still drawn when its image reaches the screen.
+    void _UpdateDrawHeight();
 }; // class MapObject
 
 
@@ -28,8 +28,7 @@ ParticleObject::ParticleObject(const std::string& filename,
                                MapObjectDrawLayer layer):
     MapObject(layer)
 {
-    _tile_position.x = x;
-    _tile_position.y = y;
+    SetPosition(x, y);
 
     _object_type = PARTICLE_TYPE;
     _collision_mask = NO_COLLISION;
@@ -48,6 +48,13 @@ void PhysicalObject::Update()
         _animations[_current_animation_id].Update();
 }
 
+void PhysicalObject::_CatchUpDormantTime(uint32_t elapsed_time)
+{
+    MapObject::_CatchUpDormantTime(elapsed_time);
+    if(!_animations.empty() && _updatable)
+        _animations[_current_animation_id].Update(elapsed_time);
+}
+
 void PhysicalObject::Draw()
 {
     if(_animations.empty() || !MapObject::ShouldDraw())
@@ -111,6 +111,9 @@ protected:
     **/
     std::vector<vt_video::AnimatedImage> _animations;
 
+    //! \brief Catches up the current animation time.
+    virtual void _CatchUpDormantTime(uint32_t elapsed_time) override;
+
 private:
     /** \brief The index to the animations vector that contains the current image to display
     *** When modifying this member, take care not to exceed the bounds of the animations vector
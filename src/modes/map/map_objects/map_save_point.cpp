@@ -30,8 +30,7 @@ SavePoint::SavePoint(float x, float y):
     _animations(nullptr),
     _is_active(false)
 {
-    _tile_position.x = x;
-    _tile_position.y = y;
+    SetPosition(x, y);
 
     _object_type = SAVE_TYPE;
     _collision_mask = NO_COLLISION;
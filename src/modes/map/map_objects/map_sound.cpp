@@ -47,8 +47,7 @@ SoundObject::SoundObject(const std::string& sound_filename, float x, float y, fl
     if (_strength <= 0.2f)
         _strength = 0.0f;
 
-    _tile_position.x = x;
-    _tile_position.y = y;
+    SetPosition(x, y);
 
     _collision_mask = NO_COLLISION;
 
@@ -84,6 +84,11 @@ public:
         return (_activated && _playing) ? _sound_volume : 0.0f;
     }
 
+    //! \brief Gets the maximal distance in map tiles the sound can be heard within.
+    float GetStrength() const {
+        return _strength;
+    }
+
 private:
     //! \brief The sound object reference. Don't delete it.
     vt_audio::SoundDescriptor* _sound;
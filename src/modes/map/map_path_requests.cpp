@@ -0,0 +1,190 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2016 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See https://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    map_path_requests.cpp
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Source file for the queue of path finding requests.
+*** ***************************************************************************/
+
+#include "modes/map/map_path_requests.h"
+
+#include "modes/map/map_object_supervisor.h"
+#include "modes/map/map_sprites/map_virtual_sprite.h"
+
+#include <SDL2/SDL_timer.h>
+
+#include <algorithm>
+
+using namespace vt_common;
+
+namespace vt_map
+{
+
+namespace private_map
+{
+
+uint32_t PathRequestQueue::RequestPath(VirtualSprite* sprite, const Position2D& destination, uint32_t max_cost)
+{
+    ++_last_ticket;
+    if(_last_ticket == 0)
+        _last_ticket = 1;
+    const uint32_t ticket = _last_ticket;
+    _ticket_owners[ticket] = sprite;
+
+    // Share the path of an identical pending request.
+    for(uint32_t i = 0; i < _pending_requests.size(); ++i) {
+        if(_IsSameRequest(_pending_requests[i], sprite, destination, max_cost)) {
+            _pending_requests[i].tickets.push_back(ticket);
+            return ticket;
+        }
+    }
+
+    _pending_requests.push_back(PathRequest());
+    PathRequest& request = _pending_requests.back();
+    request.sprite = sprite;
+    request.source = sprite->GetPosition();
+    request.destination = destination;
+    request.max_cost = max_cost;
+    request.collision_mask = sprite->GetCollisionMask();
+    request.tickets.push_back(ticket);
+    return ticket;
+}
+
+bool PathRequestQueue::TakePath(uint32_t ticket, Path& path)
+{
+    std::map<uint32_t, Path>::iterator it = _results.find(ticket);
+    if(it != _results.end()) {
+        path.swap(it->second);
+        _results.erase(it);
+        _ticket_owners.erase(ticket);
+        return true;
+    }
+
+    for(uint32_t i = 0; i < _pending_requests.size(); ++i) {
+        const std::vector<uint32_t>& tickets = _pending_requests[i].tickets;
+        if(std::find(tickets.begin(), tickets.end(), ticket) != tickets.end())
+            return false;
+    }
+
+    // Unknown tickets have no path.
+    path.clear();
+    return true;
+}
+
+void PathRequestQueue::CancelRequest(uint32_t ticket)
+{
+    _results.erase(ticket);
+    _ticket_owners.erase(ticket);
+
+    for(std::deque<PathRequest>::iterator it = _pending_requests.begin(); it != _pending_requests.end(); ++it) {
+        std::vector<uint32_t>& tickets = it->tickets;
+        std::vector<uint32_t>::iterator ticket_it = std::find(tickets.begin(), tickets.end(), ticket);
+        if(ticket_it == tickets.end())
+            continue;
+
+        tickets.erase(ticket_it);
+        if(tickets.empty())
+            _pending_requests.erase(it);
+        return;
+    }
+}
+
+void PathRequestQueue::CancelRequests(MapObject* object)
+{
+    // Only remove the object tickets, as the other sprites may share its requests.
+    std::deque<PathRequest>::iterator it = _pending_requests.begin();
+    while(it != _pending_requests.end()) {
+        std::vector<uint32_t>& tickets = it->tickets;
+        uint32_t i = 0;
+        while(i < tickets.size()) {
+            if(_ticket_owners[tickets[i]] == object)
+                tickets.erase(tickets.begin() + i);
+            else
+                ++i;
+        }
+
+        if(tickets.empty()) {
+            it = _pending_requests.erase(it);
+            continue;
+        }
+
+        // Compute the path with one of the remaining sprites, which share the same collision properties.
+        if(it->sprite == object)
+            it->sprite = _ticket_owners[tickets.front()];
+        ++it;
+    }
+
+    // Forget the tickets of the object, and the paths computed for them.
+    std::map<uint32_t, VirtualSprite*>::iterator owner_it = _ticket_owners.begin();
+    while(owner_it != _ticket_owners.end()) {
+        if(owner_it->second == object) {
+            _results.erase(owner_it->first);
+            _ticket_owners.erase(owner_it++);
+        } else {
+            ++owner_it;
+        }
+    }
+}
+
+void PathRequestQueue::Clear()
+{
+    _pending_requests.clear();
+    _results.clear();
+    _ticket_owners.clear();
+}
+
+void PathRequestQueue::Update(ObjectSupervisor* object_supervisor)
+{
+    if(_pending_requests.empty())
+        return;
+
+    const uint64_t start_time = SDL_GetPerformanceCounter();
+    const uint64_t budget = static_cast<uint64_t>(SDL_GetPerformanceFrequency() * PATH_REQUEST_TIME_BUDGET / 1000.0f);
+
+    do {
+        PathRequest request = _pending_requests.front();
+        _pending_requests.pop_front();
+
+        // Use the position and collision mask the path was requested with.
+        VirtualSprite* sprite = request.sprite;
+        const uint32_t collision_mask = sprite->GetCollisionMask();
+        sprite->SetCollisionMask(request.collision_mask);
+        Path path = object_supervisor->FindPath(sprite, request.source, request.destination, request.max_cost);
+        sprite->SetCollisionMask(collision_mask);
+
+        for(uint32_t i = 0; i < request.tickets.size(); ++i)
+            _results[request.tickets[i]] = path;
+    } while(!_pending_requests.empty() && SDL_GetPerformanceCounter() - start_time < budget);
+}
+
+bool PathRequestQueue::_IsSameRequest(const PathRequest& request, VirtualSprite* sprite,
+                                      const Position2D& destination, uint32_t max_cost)
+{
+    // The path is the same when starting from the same grid element
+    // with the same collision properties.
+    if(!(request.destination == destination)
+            || request.max_cost != max_cost
+            || request.collision_mask != sprite->GetCollisionMask()
+            || static_cast<int32_t>(request.source.x) != static_cast<int32_t>(sprite->GetXPosition())
+            || static_cast<int32_t>(request.source.y) != static_cast<int32_t>(sprite->GetYPosition()))
+        return false;
+
+    const VirtualSprite* other = request.sprite;
+    if(other == sprite)
+        return true;
+
+    return other->GetObjectDrawLayer() == sprite->GetObjectDrawLayer()
+           && other->GetCollGridHalfWidth() == sprite->GetCollGridHalfWidth()
+           && other->GetCollGridHeight() == sprite->GetCollGridHeight();
+}
+
+} // namespace private_map
+
+} // namespace vt_map
@@ -0,0 +1,127 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2016 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See https://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    map_path_requests.h
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Header file for the queue of path finding requests.
+***
+*** Sprites request their paths and get a ticket, and the paths are computed
+*** later within a time budget per frame, so that several sprites looking for
+*** a path in the same frame don't stall it. Identical requests are computed once.
+*** ***************************************************************************/
+
+#ifndef __MAP_PATH_REQUESTS_HEADER__
+#define __MAP_PATH_REQUESTS_HEADER__
+
+#include "modes/map/map_utils.h"
+
+#include <deque>
+#include <map>
+
+namespace vt_map
+{
+
+namespace private_map
+{
+
+class ObjectSupervisor;
+class MapObject;
+class VirtualSprite;
+
+//! \brief The time spent computing the requested paths each frame, in milliseconds.
+const float PATH_REQUEST_TIME_BUDGET = 2.0f;
+
+/** ****************************************************************************
+*** \brief Computes the requested paths over the next frames.
+***
+*** At least one request is computed each frame, even when it takes longer than the budget.
+*** ***************************************************************************/
+class PathRequestQueue
+{
+public:
+    PathRequestQueue() :
+        _last_ticket(0)
+    {}
+
+    /** \brief Requests a path from the sprite position to the destination.
+    *** The path is computed using the sprite position and collision mask at request time.
+    *** \return The ticket used to get the path, never 0.
+    **/
+    uint32_t RequestPath(VirtualSprite* sprite, const vt_common::Position2D& destination, uint32_t max_cost);
+
+    /** \brief Takes the path computed for the given ticket, which is then released.
+    *** \param path Set to the path, empty if none was found.
+    *** \return false if the path isn't computed yet.
+    **/
+    bool TakePath(uint32_t ticket, Path& path);
+
+    //! \brief Cancels the given request. Does nothing if it is already done and taken.
+    void CancelRequest(uint32_t ticket);
+
+    /** \brief Cancels every request and result of the given object, before it is deleted.
+    *** The paths shared with other sprites are still computed for them.
+    **/
+    void CancelRequests(MapObject* object);
+
+    //! \brief Removes every request and result.
+    void Clear();
+
+    //! \brief Computes the pending requests until the frame time budget is spent.
+    void Update(ObjectSupervisor* object_supervisor);
+
+    uint32_t GetNumPendingRequests() const {
+        return _pending_requests.size();
+    }
+
+private:
+    //! \brief A path to compute, shared by the tickets of identical requests.
+    class PathRequest
+    {
+    public:
+        PathRequest() :
+            sprite(nullptr),
+            max_cost(0),
+            collision_mask(0)
+        {}
+
+        //! \brief The sprite used to compute the path, one of the tickets owners.
+        VirtualSprite* sprite;
+        //! \brief The sprite position at request time, where the path starts.
+        vt_common::Position2D source;
+        vt_common::Position2D destination;
+        uint32_t max_cost;
+        uint32_t collision_mask;
+
+        //! \brief The tickets waiting for that path.
+        std::vector<uint32_t> tickets;
+    };
+
+    //! \brief The requests to compute, the oldest first.
+    std::deque<PathRequest> _pending_requests;
+
+    //! \brief The computed paths not taken yet, by ticket.
+    std::map<uint32_t, Path> _results;
+
+    //! \brief The sprite which requested each pending or computed path, by ticket.
+    std::map<uint32_t, VirtualSprite*> _ticket_owners;
+
+    //! \brief The last ticket given.
+    uint32_t _last_ticket;
+
+    //! \brief Tells whether the request would give the same path as a new one for the given sprite, from its position.
+    static bool _IsSameRequest(const PathRequest& request, VirtualSprite* sprite,
+                               const vt_common::Position2D& destination, uint32_t max_cost);
+};
+
+} // namespace private_map
+
+} // namespace vt_map
+
+#endif // __MAP_PATH_REQUESTS_HEADER__
@@ -0,0 +1,192 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2016 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See https://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    map_preloader.cpp
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Source file for the background preloading of the next maps.
+*** ***************************************************************************/
+
+#include "modes/map/map_preloader.h"
+
+#include "modes/map/map_utils.h"
+
+#include "engine/video/texture_controller.h"
+#include "script/script_read.h"
+
+#include "utils/exception.h"
+
+using namespace vt_script;
+using namespace vt_video;
+using namespace vt_video::private_video;
+
+namespace vt_map
+{
+
+namespace private_map
+{
+
+MapPreloader::MapPreloader() :
+    _worker_pool(vt_system::SystemManager->GetWorkerPool()),
+    _generation(0),
+    _memory_used(0)
+{
+}
+
+MapPreloader::~MapPreloader()
+{
+    _worker_pool->RemoveJobs(this);
+}
+
+void MapPreloader::PreloadMap(const std::string& map_data_filename, bool urgent)
+{
+    // Preloading on the main thread would only slow the current map down.
+    if(_worker_pool->GetNumThreads() == 0 || map_data_filename.empty() || _memory_used >= MAP_PRELOAD_MEMORY_BUDGET)
+        return;
+
+    if(_maps.find(map_data_filename) != _maps.end())
+        return;
+
+    _maps[map_data_filename] = PreloadedMap();
+
+    PreloadJob* job = new PreloadJob();
+    job->map_data_filename = map_data_filename;
+    job->user_compiled_filename = GetUserCompiledMapDataFilename(map_data_filename);
+    _QueueJob(job, urgent);
+}
+
+void MapPreloader::Update()
+{
+    std::vector<vt_system::WorkerJob*> done_jobs;
+    _worker_pool->TakeDoneJobs(this, done_jobs);
+
+    for(uint32_t i = 0; i < done_jobs.size(); ++i) {
+        PreloadJob* job = static_cast<PreloadJob*>(done_jobs[i]);
+        std::map<std::string, PreloadedMap>::iterator it = _maps.find(job->map_data_filename);
+
+        // Drop the results of cancelled jobs.
+        if(job->generation != _generation || it == _maps.end() || !job->succeeded) {
+            delete job;
+            continue;
+        }
+
+        PreloadedMap& preloaded_map = it->second;
+        if(job->image_filename.empty()) {
+            preloaded_map.map_data = std::move(job->map_data);
+            preloaded_map.map_data_loaded = true;
+
+            const MapData& map_data = preloaded_map.map_data;
+            _memory_used += map_data.collision_grid.size();
+            for(uint32_t j = 0; j < map_data.layers.size(); ++j)
+                _memory_used += map_data.layers[j].tiles.size() * sizeof(int16_t);
+
+            _QueueTilesetImages(job->map_data_filename, map_data);
+        }
+        else {
+            size_t image_size = job->image.GetSize2D() * job->image.GetBytesPerPixel();
+            if(_memory_used + image_size <= MAP_PRELOAD_MEMORY_BUDGET) {
+                preloaded_map.images[job->image_filename].Swap(job->image);
+                _memory_used += image_size;
+            }
+        }
+        delete job;
+    }
+}
+
+bool MapPreloader::ClaimMap(const std::string& map_data_filename, MapData& map_data)
+{
+    Update();
+
+    bool claimed = false;
+    std::map<std::string, PreloadedMap>::iterator it = _maps.find(map_data_filename);
+    if(it != _maps.end() && it->second.map_data_loaded) {
+        map_data = std::move(it->second.map_data);
+
+        std::map<std::string, ImageMemory>& images = it->second.images;
+        for(std::map<std::string, ImageMemory>::iterator image = images.begin(); image != images.end(); ++image)
+            TextureManager->AddPreloadedImage(image->first, image->second);
+        claimed = true;
+    }
+
+    // The other maps are now unlikely to be needed soon.
+    Cancel();
+    return claimed;
+}
+
+void MapPreloader::Cancel()
+{
+    ++_generation;
+    _maps.clear();
+    _memory_used = 0;
+
+    // The running jobs are dropped when done, as their generation is outdated.
+    _worker_pool->CancelJobs(this);
+}
+
+void MapPreloader::_QueueJob(PreloadJob* job, bool urgent)
+{
+    job->generation = _generation;
+    _worker_pool->QueueJob(this, job, urgent);
+}
+
+void MapPreloader::_QueueTilesetImages(const std::string& map_data_filename, const MapData& map_data)
+{
+    for(uint32_t i = 0; i < map_data.tileset_filenames.size(); ++i) {
+        if(_memory_used >= MAP_PRELOAD_MEMORY_BUDGET)
+            return;
+
+        // The tileset definition files are small, and Lua can only be used from the main thread.
+        ReadScriptDescriptor tileset_script;
+        if(!tileset_script.OpenFile(map_data.tileset_filenames[i]))
+            continue;
+
+        std::string image_filename;
+        if(tileset_script.OpenTable("tileset"))
+            image_filename = tileset_script.ReadString("image");
+        tileset_script.CloseFile();
+
+        if(image_filename.empty())
+            continue;
+
+        PreloadJob* job = new PreloadJob();
+        job->map_data_filename = map_data_filename;
+        job->image_filename = image_filename;
+        _QueueJob(job, false);
+    }
+}
+
+void MapPreloader::PreloadJob::Run()
+{
+    if(!image_filename.empty()) {
+        succeeded = image.LoadImage(image_filename);
+        return;
+    }
+
+    uint64_t source_hash = 0;
+    succeeded = ComputeFileHash(map_data_filename, source_hash) &&
+        LoadCompiledMapData(map_data_filename, user_compiled_filename, source_hash, map_data);
+
+    IF_PRINT_DEBUG(MAP_DEBUG) << "Map data preloading " << (succeeded ? "succeeded" : "skipped")
+                              << " for: " << map_data_filename << std::endl;
+}
+
+MapPreloader::MapPreloader(const MapPreloader&)
+{
+    throw vt_utils::Exception("Not Implemented!", __FILE__, __LINE__, __FUNCTION__);
+}
+
+MapPreloader& MapPreloader::operator=(const MapPreloader&)
+{
+    throw vt_utils::Exception("Not Implemented!", __FILE__, __LINE__, __FUNCTION__);
+    return *this;
+}
+
+} // namespace private_map
+
+} // namespace vt_map
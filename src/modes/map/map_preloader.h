@@ -0,0 +1,152 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2016 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See https://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    map_preloader.h
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Header file for the background preloading of the next maps.
+***
+*** While exploring a map, the maps its transition events lead to are preloaded
+*** on the worker threads of the system engine: their compiled map data is read and their tileset images
+*** are decoded, so that the next map mode only has to upload them.
+***
+*** Lua isn't thread-safe, so only the maps having an up-to-date compiled map data
+*** file are preloaded, and the tileset definition files are read on the main thread.
+*** Maps get one once loaded from Lua a first time.
+*** ***************************************************************************/
+
+#ifndef __MAP_PRELOADER_HEADER__
+#define __MAP_PRELOADER_HEADER__
+
+#include "modes/map/map_data.h"
+
+#include "engine/video/image_base.h"
+#include "engine/system.h"
+
+#include <map>
+
+namespace vt_map
+{
+
+namespace private_map
+{
+
+//! \brief The memory the preloaded maps may use, in bytes.
+const size_t MAP_PRELOAD_MEMORY_BUDGET = 64 * 1024 * 1024;
+
+/** ****************************************************************************
+*** \brief Preloads the maps the player may go to next, on the worker threads.
+***
+*** Every method must be called from the main thread.
+*** ***************************************************************************/
+class MapPreloader
+{
+public:
+    MapPreloader();
+
+    ~MapPreloader();
+
+    /** \brief Queues the given map for preloading, unless already done.
+    *** \param urgent Whether the map should be preloaded before the other pending ones.
+    **/
+    void PreloadMap(const std::string& map_data_filename, bool urgent = false);
+
+    //! \brief Takes the results of the worker threads, and queues the tileset images of the maps loaded.
+    void Update();
+
+    /** \brief Takes the preloaded data of the given map, and gives its decoded tileset images
+    *** to the texture manager. Every other preloaded map is then freed.
+    *** \return false if the map data wasn't preloaded.
+    **/
+    bool ClaimMap(const std::string& map_data_filename, MapData& map_data);
+
+    //! \brief Cancels every pending preload and frees the preloaded maps.
+    void Cancel();
+
+    //! \brief Returns the memory used by the preloaded maps, in bytes.
+    size_t GetMemoryUsed() const {
+        return _memory_used;
+    }
+
+private:
+    //! \brief The copy constructor and assignment operator are hidden by design
+    //! to cause compilation errors when attempting to copy or assign this class.
+    MapPreloader(const MapPreloader& preloader);
+    MapPreloader& operator=(const MapPreloader& preloader);
+
+    //! \brief A unit of work given to the worker threads, and its result.
+    class PreloadJob : public vt_system::WorkerJob
+    {
+    public:
+        PreloadJob() :
+            generation(0),
+            succeeded(false)
+        {}
+
+        //! \brief Reads the map data or decodes the tileset image, on a worker thread.
+        void Run();
+
+        //! \brief The map the job is done for.
+        std::string map_data_filename;
+
+        //! \brief The compiled map data file written in the user data directory, if any.
+        std::string user_compiled_filename;
+
+        //! \brief The tileset image to decode, or empty to read the map data.
+        std::string image_filename;
+
+        //! \brief The cancellation generation the job was queued in.
+        uint32_t generation;
+
+        //! \brief Whether the job succeeded, and its result.
+        bool succeeded;
+        MapData map_data;
+        vt_video::private_video::ImageMemory image;
+    };
+
+    //! \brief A map preloaded, or being preloaded.
+    class PreloadedMap
+    {
+    public:
+        PreloadedMap() :
+            map_data_loaded(false)
+        {}
+
+        //! \brief Whether the map data has been read.
+        bool map_data_loaded;
+        MapData map_data;
+
+        //! \brief The decoded tileset images, by filename.
+        std::map<std::string, vt_video::private_video::ImageMemory> images;
+    };
+
+    //! \brief The worker threads the jobs are run on, shared with the image decoding.
+    vt_system::WorkerPool* _worker_pool;
+
+    //! \brief Incremented at each cancellation, so that the results of older jobs are dropped.
+    uint32_t _generation;
+
+    //! \brief The maps preloaded or being preloaded, by map data filename.
+    std::map<std::string, PreloadedMap> _maps;
+
+    //! \brief The memory used by the preloaded maps, in bytes.
+    size_t _memory_used;
+
+    //! \brief Queues a job for the worker threads.
+    void _QueueJob(PreloadJob* job, bool urgent);
+
+    //! \brief Reads the tileset definition files of a map, and queues the decoding of their images.
+    void _QueueTilesetImages(const std::string& map_data_filename, const MapData& map_data);
+};
+
+} // namespace private_map
+
+} // namespace vt_map
+
+#endif // __MAP_PRELOADER_HEADER__
@@ -30,7 +30,8 @@ EnemySprite::EnemySprite() :
     _time_to_spawn(STANDARD_ENEMY_FIRST_SPAWN_TIME),
     _time_to_respawn(STANDARD_ENEMY_SPAWN_TIME),
     _is_boss(false),
-    _use_path(false)
+    _use_path(false),
+    _path_request(0)
 {
     _object_type = ENEMY_TYPE;
     _moving = false;
@@ -63,6 +64,7 @@ void EnemySprite::Reset()
     _current_node_id = 0;
     _path.clear();
     _use_path = false;
+    _CancelPathRequest();
 
     // Reset the currently selected way point
     _current_way_point_id = 0;
@@ -127,6 +129,14 @@ void EnemySprite::Update()
     }
 } // void EnemySprite::Update()
 
+void EnemySprite::_CatchUpDormantTime(uint32_t elapsed_time)
+{
+    MapSprite::_CatchUpDormantTime(elapsed_time);
+
+    if(_state == SPAWNING || _state == HOSTILE)
+        _time_elapsed += elapsed_time;
+}
+
 void EnemySprite::ChangeStateDead() {
     Reset();
     if(_zone) _zone->EnemyDead();
@@ -167,13 +177,21 @@ void EnemySprite::_HandleHostileUpdate()
             _collision_mask = WALL_COLLISION | CHARACTER_COLLISION;
             _use_path = false;
         }
+        _CancelPathRequest();
 
         // Check whether we're already colliding, so that even when not moving
         // we can start a battle.
         if (this->IsCollidingWith(camera))
             map_mode->StartEnemyEncounter(this);
 
-        // Make the monster go toward the character
+        // Make the monster go toward the character, following the flow field
+        // shared by the chasing monsters when walls are in the way.
+        Position2D chase_destination;
+        if (map_mode->GetObjectSupervisor()->GetChaseDestination(this, chase_destination)) {
+            xdelta = GetXPosition() - chase_destination.x;
+            ydelta = GetYPosition() - chase_destination.y;
+        }
+
         if(xdelta > -0.5 && xdelta < 0.5 && ydelta < 0)
             SetDirection(SOUTH);
         else if(xdelta > -0.5 && xdelta < 0.5 && ydelta > 0)
@@ -198,6 +216,12 @@ void EnemySprite::_HandleHostileUpdate()
     // Handle monsters with way points.
     if (!_way_points.empty()) {
 
+        // Wait for the path to the next way point to be computed.
+        if (_path_request != 0) {
+            _UpdatePathRequest();
+            return;
+        }
+
         // Update the wait time until next path between two way points.
         if (!_use_path || !_moving)
             _time_elapsed += vt_system::SystemManager->GetUpdateTime();
@@ -244,7 +268,7 @@ void EnemySprite::_HandleHostileUpdate()
             // The sprite is now finding its way back into the zone
             float x_dest;
             float y_dest;
-            _zone->RandomPosition(x_dest, y_dest);
+            _zone->RandomPosition(x_dest, y_dest, this);
             LookAt(x_dest, y_dest);
             _moving = true;
 
@@ -361,13 +385,26 @@ bool EnemySprite::_SetDestination(float destination_x, float destination_y, uint
     if (pos_x == dest_x && pos_y == dest_y)
         return false;
 
-    Position2D dest(destination_x, destination_y);
-    // We set the correct mask before finding the path
+    _destination = Position2D(destination_x, destination_y);
+    // We set the correct mask before requesting the path
     _collision_mask = WALL_COLLISION | CHARACTER_COLLISION;
-    _path = MapMode::CurrentInstance()->GetObjectSupervisor()->FindPath(this, dest, max_cost);
+    _CancelPathRequest();
+    _path_request = MapMode::CurrentInstance()->GetObjectSupervisor()->RequestPath(this, _destination, max_cost);
+    return true;
+}
 
-    if (_path.empty())
-        return false;
+void EnemySprite::_UpdatePathRequest()
+{
+    if (!MapMode::CurrentInstance()->GetObjectSupervisor()->TakePath(_path_request, _path))
+        return;
+    _path_request = 0;
+
+    if (_path.empty()) {
+        // Fall back to simple movement mode
+        SetRandomDirection();
+        _moving = true;
+        return;
+    }
 
     // But remove wall collision afterward to avoid making it stuck in corners.
     // Note: this function is only called when hostile, son we don't deal with
@@ -376,13 +413,20 @@ bool EnemySprite::_SetDestination(float destination_x, float destination_y, uint
 
     _current_node_id = 0;
     _last_node_position = GetPosition();
-    _destination = dest;
 
     _current_node = _path[_current_node_id];
 
     _moving = true;
     _use_path = true;
-    return true;
+}
+
+void EnemySprite::_CancelPathRequest()
+{
+    if (_path_request == 0)
+        return;
+
+    MapMode::CurrentInstance()->GetObjectSupervisor()->CancelPathRequest(_path_request);
+    _path_request = 0;
 }
 
 void EnemySprite::_SetSpritePathDirection()
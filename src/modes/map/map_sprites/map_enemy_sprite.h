@@ -272,6 +272,9 @@ private:
     //! \brief Holds the path needed to traverse from source to destination
     Path _path;
 
+    //! \brief The ticket of the path being computed, or 0 when none is pending.
+    uint32_t _path_request;
+
     //! \brief Way points used by the enemy when not hostile
     std::vector<vt_common::Position2D> _way_points;
     uint32_t _current_way_point_id;
@@ -281,9 +284,17 @@ private:
     //! \param destination_y The pixel y destination to find a path to.
     //! \param max_cost More or less the path max length in nodes or 0 if no limitations.
     //! Use this to avoid heavy computations.
-    //! \return whether it failed.
+    //! The path is computed later, and set up by _UpdatePathRequest().
+    //! \return whether a path was requested.
     bool _SetDestination(float destination_x, float destination_y, uint32_t max_cost = 20);
 
+    //! \brief Starts following the requested path once it is computed.
+    //! Falls back to a random direction when no path was found.
+    void _UpdatePathRequest();
+
+    //! \brief Cancels the pending path request, if any.
+    void _CancelPathRequest();
+
     //! \brief Set the actual sprite direction according to the current path node.
     void _SetSpritePathDirection();
 
@@ -297,6 +308,9 @@ private:
     //! \brief Handles behavior when the enemy is in hostile state (seeking for characters)
     void _HandleHostileUpdate();
 
+    //! \brief Catches up the spawning and destination timers along with the animations.
+    void _CatchUpDormantTime(uint32_t elapsed_time) override;
+
 };
 
 } // namespace private_map
@@ -378,6 +378,21 @@ void MapSprite::SetGrayscale(bool grayscale) {
     }
 }
 
+void MapSprite::_CatchUpDormantTime(uint32_t elapsed_time)
+{
+    VirtualSprite::_CatchUpDormantTime(elapsed_time);
+
+    if(_custom_animation_on && _current_custom_animation) {
+        if(!_infinite_custom_animation)
+            _custom_animation_time -= static_cast<int32_t>(elapsed_time);
+        _current_custom_animation->Update(elapsed_time);
+        return;
+    }
+
+    if(_animation)
+        _animation->at(_current_anim_direction).Update(elapsed_time);
+}
+
 void MapSprite::Update()
 {
     // Stores the last value of moved_position to determine when a change in sprite movement between calls to this function occurs
@@ -234,6 +234,9 @@ public:
     //@}
 
 protected:
+    //! \brief Catches up the current and custom animations time.
+    virtual void _CatchUpDormantTime(uint32_t elapsed_time) override;
+
     //! \brief The name of the sprite, as seen by the player in the game.
     vt_utils::ustring _name;
 
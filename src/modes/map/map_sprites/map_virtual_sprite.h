@@ -107,6 +107,11 @@ public:
         return _control_event;
     }
 
+    //! \brief Sprites controlled by an event are always fully updated.
+    virtual bool CanBeDormant() const override {
+        return MapObject::CanBeDormant() && !_control_event;
+    }
+
     /** \brief Saves the state of the sprite
     *** Attributes saved: direction, speed, moving state
     **/
@@ -20,6 +20,7 @@
 #include "modes/map/map_mode.h"
 
 #include "engine/video/video.h"
+#include "engine/video/image_batch.h"
 
 using namespace vt_utils;
 using namespace vt_script;
@@ -49,6 +50,8 @@ TileSupervisor::TileSupervisor() :
 
 TileSupervisor::~TileSupervisor()
 {
+    _ClearTileBatches();
+
     // Delete all objects in _tile_images but *not* _animated_tile_images.
     // This is because _animated_tile_images is a subset of _tile_images.
     for(uint32_t i = 0; i < _tile_images.size(); i++)
@@ -59,21 +62,28 @@ TileSupervisor::~TileSupervisor()
     _animated_tile_images.clear();
 }
 
-bool TileSupervisor::Load(ReadScriptDescriptor &map_file)
+size_t TileSupervisor::GetMemorySize() const
+{
+    // The tile images use 32-bit texels.
+    size_t memory_size = _tile_images.size() * TILE_LENGTH * TILE_LENGTH * 4;
+    for(uint32_t i = 0; i < _tile_grid.size(); ++i)
+        memory_size += _tile_grid[i].tiles.size() * sizeof(int16_t);
+    return memory_size;
+}
+
+bool TileSupervisor::Load(const MapData& map_data)
 {
     // Load the map dimensions and do some basic sanity checks
-    _num_tile_on_y_axis = map_file.ReadInt("num_tile_rows");
-    _num_tile_on_x_axis = map_file.ReadInt("num_tile_cols");
+    _num_tile_on_y_axis = map_data.num_tile_rows;
+    _num_tile_on_x_axis = map_data.num_tile_cols;
 
     // Load all of the tileset images that are used by this map
 
-    // Contains all of the tileset filenames used (string does not contain path information or file extensions)
-    std::vector<std::string> tileset_filenames;
+    // Contains all of the tileset filenames used
+    const std::vector<std::string>& tileset_filenames = map_data.tileset_filenames;
     // Temporarily retains all tile images loaded for each tileset. Each inner vector contains 256 StillImage objects
     std::vector<std::vector<StillImage> > tileset_images;
 
-    map_file.ReadStringVector("tileset_filenames", tileset_filenames);
-
     for(uint32_t i = 0; i < tileset_filenames.size(); i++) {
         std::string tileset_file = tileset_filenames[i];
 
@@ -105,81 +115,38 @@ bool TileSupervisor::Load(ReadScriptDescriptor &map_file)
         }
     }
 
-    if(!map_file.DoesTableExist("layers")) {
-        PRINT_ERROR << "No 'layers' table in the map file." << std::endl;
-        return false;
-    }
-
-    // Read in the map tile indeces from all tile layers.
-    // The indeces stored for the map layers in this file directly correspond to a location within a tileset. Tilesets contain a total of 256 tiles
+    // The indeces stored for the map layers directly correspond to a location within a tileset. Tilesets contain a total of 256 tiles
     // each, so 0-255 correspond to the first tileset, 256-511 the second, etc. The tile location within the tileset is also determined by the index,
     // where the first 16 indeces in the tileset range are the tiles of the first row (left to right), and so on.
 
     // Clears out the tiles grid
     _tile_grid.clear();
 
-    std::vector<int32_t> table_x_indeces; // Used to temporarily store a row of table indeces
+    uint32_t layers_number = map_data.layers.size();
+    _tile_grid.resize(layers_number);
 
-    map_file.OpenTable("layers");
-
-    uint32_t layers_number = map_file.GetTableSize();
-
-    // layers[0]-[n]
     for(uint32_t layer_id = 0; layer_id < layers_number; ++layer_id) {
-        // Opens the sub-table: layers[layer_id]
-        if(!map_file.DoesTableExist(layer_id))
+        const MapLayerData& layer_data = map_data.layers[layer_id];
+        if(layer_data.type.empty())
             continue;
 
-        map_file.OpenTable(layer_id);
-
-        // Add a layer for the base context
-        _tile_grid.resize(layer_id + 1);
-
-        LAYER_TYPE layer_type = StringToLayerType(map_file.ReadString("type"));
+        LAYER_TYPE layer_type = StringToLayerType(layer_data.type);
 
         if(layer_type == INVALID_LAYER) {
-            PRINT_WARNING << "Ignoring unexisting layer type: " << layer_type
-                          << " in file: " << map_file.GetFilename() << std::endl;
-            map_file.CloseTable(); // layers[i]
+            PRINT_WARNING << "Ignoring unexisting layer type: " << layer_data.type << std::endl;
             continue;
         }
 
-        _tile_grid[layer_id].layer_type = layer_type;
-
-        // Add the new tile rows (y axis)
-        _tile_grid[layer_id].tiles.resize(_num_tile_on_y_axis);
-
-        // Read the tile data
-        for(uint32_t y = 0; y < _num_tile_on_y_axis; ++y) {
-            table_x_indeces.clear();
-
-            // Check to make sure tables are of the proper size
-            if(!map_file.DoesTableExist(y)) {
-                PRINT_ERROR << "the layers[" << layer_id << "] table size was not equal to the number of tile rows specified by the map, "
-                            " first missing row: " << y << std::endl;
-                return false;
-            }
-
-            map_file.ReadIntVector(y, table_x_indeces);
-
-            // Check the number of columns
-            if(table_x_indeces.size() != _num_tile_on_x_axis) {
-                PRINT_ERROR << "the layers[" << layer_id << "][" << y << "] table size was not equal to the number of tile columns specified by the map, "
-                            "should have " << _num_tile_on_x_axis << " values." << std::endl;
-                return false;
-            }
-
-            // Prepare the columns (x axis)
-            _tile_grid[layer_id].tiles[y].resize(_num_tile_on_x_axis);
-
-            for(uint32_t x = 0; x < _num_tile_on_x_axis; ++x) {
-                _tile_grid[layer_id].tiles[y][x] = table_x_indeces[x];
-            }
+        if(layer_data.tiles.size() != _num_tile_on_x_axis * _num_tile_on_y_axis) {
+            PRINT_ERROR << "the layers[" << layer_id << "] tile count was not equal to the map size." << std::endl;
+            return false;
         }
-        map_file.CloseTable(); // layers[layer_id]
-    }
 
-    map_file.CloseTable(); // layers
+        _tile_grid[layer_id].layer_type = layer_type;
+        _tile_grid[layer_id].width = _num_tile_on_x_axis;
+        _tile_grid[layer_id].height = _num_tile_on_y_axis;
+        _tile_grid[layer_id].tiles = layer_data.tiles;
+    }
 
     // Determine which tiles in each tileset are referenced in this map
 
@@ -191,11 +158,10 @@ bool TileSupervisor::Load(ReadScriptDescriptor &map_file)
     // For each layer
     for(uint32_t layer_id = 0; layer_id < layers_number; ++layer_id) {
         // For each tile id
-        for(uint32_t y = 0; y < _num_tile_on_y_axis; ++y) {
-            for(uint32_t x = 0; x < _num_tile_on_x_axis; ++x) {
-                if(_tile_grid[layer_id].tiles[y][x] >= 0)
-                    tile_references[_tile_grid[layer_id].tiles[y][x] ] = 0;
-            }
+        const std::vector<int16_t>& tiles = _tile_grid[layer_id].tiles;
+        for(uint32_t i = 0; i < tiles.size(); ++i) {
+            if(tiles[i] >= 0)
+                tile_references[tiles[i]] = 0;
         }
     }
 
@@ -219,11 +185,10 @@ bool TileSupervisor::Load(ReadScriptDescriptor &map_file)
     // For each layer
     for(uint32_t layer_id = 0; layer_id < layers_number; ++layer_id) {
         // For each tile id
-        for(uint32_t y = 0; y < _num_tile_on_y_axis; ++y) {
-            for(uint32_t x = 0; x < _num_tile_on_x_axis; ++x) {
-                if(_tile_grid[layer_id].tiles[y][x] >= 0)
-                    _tile_grid[layer_id].tiles[y][x] = tile_references[_tile_grid[layer_id].tiles[y][x] ];
-            }
+        std::vector<int16_t>& tiles = _tile_grid[layer_id].tiles;
+        for(uint32_t i = 0; i < tiles.size(); ++i) {
+            if(tiles[i] >= 0)
+                tiles[i] = tile_references[tiles[i]];
         }
     }
 
@@ -310,6 +275,8 @@ bool TileSupervisor::Load(ReadScriptDescriptor &map_file)
     // Remove all tileset images. Any tiles which were not added to _tile_images will no longer exist in memory
     tileset_images.clear();
 
+    _BuildTileBatches();
+
     return true;
 }
 
@@ -329,35 +296,220 @@ void TileSupervisor::DrawLayers(const MapFrame *frame, const LAYER_TYPE &layer_t
     uint32_t y_end = static_cast<uint32_t>(frame->tile_y_start + frame->num_draw_y_axis);
     uint32_t x_end = static_cast<uint32_t>(frame->tile_x_start + frame->num_draw_x_axis);
 
+    // The chunks overlapping the map frame
+    uint32_t chunk_x_start = static_cast<uint32_t>(frame->tile_x_start) / TILE_CHUNK_LENGTH;
+    uint32_t chunk_y_start = static_cast<uint32_t>(frame->tile_y_start) / TILE_CHUNK_LENGTH;
+    uint32_t chunk_x_end = (x_end + TILE_CHUNK_LENGTH - 1) / TILE_CHUNK_LENGTH;
+    uint32_t chunk_y_end = (y_end + TILE_CHUNK_LENGTH - 1) / TILE_CHUNK_LENGTH;
+
+    // The screen position of the map top-left tile.
+    // We substract 0.5 horizontally and 1.0 vertically here
+    // because the video engine will display the map tiles using their
+    // top left coordinates to avoid a position computation flaw when specifying the tile
+    // coordinates from the bottom center point, as the engine does for everything else.
+    float origin_x = GRID_LENGTH * (frame->tile_offset.x - 1.0f) - frame->tile_x_start * TILE_LENGTH;
+    float origin_y = GRID_LENGTH * (frame->tile_offset.y - 2.0f) - frame->tile_y_start * TILE_LENGTH;
+
     uint32_t layer_number = _tile_grid.size();
     for(uint32_t layer_id = 0; layer_id < layer_number; ++layer_id) {
 
-        const Layer &layer = _tile_grid.at(layer_id);
+        Layer &layer = _tile_grid.at(layer_id);
         if(layer.layer_type != layer_type)
             continue;
 
-        // We substract 0.5 horizontally and 1.0 vertically here
-        // because the video engine will display the map tiles using their
-        // top left coordinates to avoid a position computation flaw when specifying the tile
-        // coordinates from the bottom center point, as the engine does for everything else.
-        VideoManager->Move(GRID_LENGTH * (frame->tile_offset.x - 1.0f),
-                           GRID_LENGTH * (frame->tile_offset.y - 2.0f));
-        for(uint32_t y = static_cast<uint32_t>(frame->tile_y_start); y < y_end; ++y) {
-            for(uint32_t x = static_cast<uint32_t>(frame->tile_x_start); x < x_end; ++x) {
-                // Draw a tile image if it exists at this location
-                if(layer.tiles[y][x] >= 0)
-                    _tile_images[ layer.tiles[y][x] ]->Draw();
-
-                VideoManager->MoveRelative(TILE_LENGTH, 0.0f);
+        for(uint32_t y = chunk_y_start; y < chunk_y_end && y < layer.chunks.size(); ++y) {
+            for(uint32_t x = chunk_x_start; x < chunk_x_end && x < layer.chunks[y].size(); ++x) {
+                const TileChunk &chunk = layer.chunks[y][x];
+
+                VideoManager->Move(origin_x, origin_y);
+                for(uint32_t i = 0; i < chunk.batches.size(); ++i)
+                    chunk.batches[i]->Draw();
+
+                for(uint32_t i = 0; i < chunk.unbatched_tiles.size(); ++i)
+                    _DrawUnbatchedTile(chunk.unbatched_tiles[i], origin_x, origin_y);
             } // x
-            VideoManager->MoveRelative(-static_cast<float>(frame->num_draw_x_axis) * TILE_LENGTH, TILE_LENGTH);
         } // y
+
+        // Only send the animated tiles which frame changed since the last draw.
+        VideoManager->Move(origin_x, origin_y);
+        for(uint32_t i = 0; i < layer.animated_batches.size(); ++i) {
+            AnimatedTileBatch &animated_batch = layer.animated_batches[i];
+            for(uint32_t j = 0; j < animated_batch.quads.size(); ++j) {
+                AnimatedTileQuad &quad = animated_batch.quads[j];
+                uint32_t frame_index = quad.animation->GetCurrentFrameIndex();
+                if(frame_index == quad.frame_index)
+                    continue;
+
+                animated_batch.batch->UpdateImage(quad.quad_index, *quad.animation->GetFrame(frame_index));
+                quad.frame_index = frame_index;
+            }
+            animated_batch.batch->Draw();
+        }
+
+        for(uint32_t i = 0; i < layer.unbatched_animated_tiles.size(); ++i)
+            _DrawUnbatchedTile(layer.unbatched_animated_tiles[i], origin_x, origin_y);
     } // layer_id
 
     // Restore the previous draw flags.
     VideoManager->SetDrawFlags(VIDEO_BLEND, VIDEO_X_CENTER, VIDEO_Y_BOTTOM, 0);
 }
 
+void TileSupervisor::_BuildTileBatches()
+{
+    _ClearTileBatches();
+
+    // The tiles are placed using the same coordinate system and draw flags as when drawing them.
+    VideoManager->PushState();
+    VideoManager->SetStandardCoordSys();
+    VideoManager->SetDrawFlags(VIDEO_BLEND, VIDEO_X_LEFT, VIDEO_Y_TOP, 0);
+
+    uint32_t num_chunks_x = (_num_tile_on_x_axis + TILE_CHUNK_LENGTH - 1) / TILE_CHUNK_LENGTH;
+    uint32_t num_chunks_y = (_num_tile_on_y_axis + TILE_CHUNK_LENGTH - 1) / TILE_CHUNK_LENGTH;
+
+    for(uint32_t layer_id = 0; layer_id < _tile_grid.size(); ++layer_id) {
+        Layer &layer = _tile_grid[layer_id];
+        if(layer.tiles.empty())
+            continue;
+
+        layer.chunks.assign(num_chunks_y, std::vector<TileChunk>(num_chunks_x));
+
+        std::vector<ImageBatch *> animated_batches;
+        std::vector<std::vector<AnimatedTileQuad> > animated_quads;
+
+        for(uint32_t y = 0; y < layer.height; ++y) {
+            for(uint32_t x = 0; x < layer.width; ++x) {
+                int16_t tile_id = layer.GetTile(x, y);
+                if(tile_id < 0)
+                    continue;
+
+                // The tile position relative to the map top-left corner.
+                float tile_x = static_cast<float>(x * TILE_LENGTH);
+                float tile_y = static_cast<float>(y * TILE_LENGTH);
+
+                AnimatedImage *animation = dynamic_cast<AnimatedImage *>(_tile_images[tile_id]);
+                if(animation == nullptr) {
+                    TileChunk &chunk = layer.chunks[y / TILE_CHUNK_LENGTH][x / TILE_CHUNK_LENGTH];
+                    StillImage *image = static_cast<StillImage *>(_tile_images[tile_id]);
+                    if(_AddToBatches(chunk.batches, *image, tile_x, tile_y) < 0)
+                        chunk.unbatched_tiles.push_back(UnbatchedTile(x, y, tile_id));
+                    continue;
+                }
+
+                int32_t batch_id = _AddToBatches(animated_batches, *animation, tile_x, tile_y);
+                if(batch_id < 0) {
+                    layer.unbatched_animated_tiles.push_back(UnbatchedTile(x, y, tile_id));
+                    continue;
+                }
+
+                animated_quads.resize(animated_batches.size());
+                AnimatedTileQuad quad;
+                quad.animation = animation;
+                quad.quad_index = animated_batches[batch_id]->GetNumberOfImages() - 1;
+                quad.frame_index = animation->GetCurrentFrameIndex();
+                animated_quads[batch_id].push_back(quad);
+            } // x
+        } // y
+
+        // Send everything to the GPU
+        for(uint32_t y = 0; y < layer.chunks.size(); ++y) {
+            for(uint32_t x = 0; x < layer.chunks[y].size(); ++x) {
+                std::vector<ImageBatch *> &batches = layer.chunks[y][x].batches;
+                for(uint32_t i = 0; i < batches.size(); ++i)
+                    batches[i]->Finalize();
+            }
+        }
+
+        for(uint32_t i = 0; i < animated_batches.size(); ++i) {
+            animated_batches[i]->Finalize(true);
+
+            AnimatedTileBatch animated_batch;
+            animated_batch.batch = animated_batches[i];
+            animated_batch.quads = animated_quads[i];
+            layer.animated_batches.push_back(animated_batch);
+        }
+    } // layer_id
+
+    VideoManager->PopState();
+}
+
+void TileSupervisor::_ClearTileBatches()
+{
+    for(uint32_t layer_id = 0; layer_id < _tile_grid.size(); ++layer_id) {
+        Layer &layer = _tile_grid[layer_id];
+
+        for(uint32_t y = 0; y < layer.chunks.size(); ++y) {
+            for(uint32_t x = 0; x < layer.chunks[y].size(); ++x) {
+                std::vector<ImageBatch *> &batches = layer.chunks[y][x].batches;
+                for(uint32_t i = 0; i < batches.size(); ++i)
+                    delete batches[i];
+            }
+        }
+        layer.chunks.clear();
+
+        for(uint32_t i = 0; i < layer.animated_batches.size(); ++i)
+            delete layer.animated_batches[i].batch;
+        layer.animated_batches.clear();
+
+        layer.unbatched_animated_tiles.clear();
+    }
+}
+
+int32_t TileSupervisor::_AddToBatches(std::vector<ImageBatch *>& batches,
+                                      const StillImage& image, float x, float y)
+{
+    for(uint32_t i = 0; i < batches.size(); ++i) {
+        if(batches[i]->AddImage(image, x, y))
+            return static_cast<int32_t>(i);
+    }
+
+    ImageBatch *batch = new ImageBatch();
+    if(!batch->AddImage(image, x, y)) {
+        delete batch;
+        return -1;
+    }
+
+    batches.push_back(batch);
+    return static_cast<int32_t>(batches.size() - 1);
+}
+
+int32_t TileSupervisor::_AddToBatches(std::vector<ImageBatch *>& batches,
+                                      const AnimatedImage& animation, float x, float y)
+{
+    // Blended animations draw two frames at once and can't be batched.
+    if(animation.GetNumFrames() == 0 || animation.GetAnimationBlended())
+        return -1;
+
+    const StillImage &current_frame = *animation.GetCurrentFrame();
+
+    for(uint32_t i = 0; i < batches.size(); ++i) {
+        bool compatible = true;
+        for(uint32_t j = 0; j < animation.GetNumFrames() && compatible; ++j)
+            compatible = batches[i]->IsCompatible(*animation.GetFrame(j));
+
+        if(compatible && batches[i]->AddImage(current_frame, x, y))
+            return static_cast<int32_t>(i);
+    }
+
+    ImageBatch *batch = new ImageBatch();
+    bool compatible = batch->AddImage(current_frame, x, y);
+    for(uint32_t j = 0; j < animation.GetNumFrames() && compatible; ++j)
+        compatible = batch->IsCompatible(*animation.GetFrame(j));
+
+    if(!compatible) {
+        delete batch;
+        return -1;
+    }
+
+    batches.push_back(batch);
+    return static_cast<int32_t>(batches.size() - 1);
+}
+
+void TileSupervisor::_DrawUnbatchedTile(const UnbatchedTile& tile, float origin_x, float origin_y)
+{
+    VideoManager->Move(origin_x + tile.x * TILE_LENGTH, origin_y + tile.y * TILE_LENGTH);
+    _tile_images[tile.tile_id]->Draw();
+}
+
 } // namespace private_map
 
 } // namespace vt_map
@@ -22,12 +22,15 @@
 #define __MAP_TILES_HEADER__
 
 #include "modes/map/map_utils.h"
+#include "modes/map/map_data.h"
 
 #include "script/script_read.h"
 
 namespace vt_video {
 class ImageDescriptor;
+class StillImage;
 class AnimatedImage;
+class ImageBatch;
 }
 
 namespace vt_map
@@ -45,16 +48,95 @@ enum LAYER_TYPE {
     INVALID_LAYER = 2
 };
 
+//! \brief The number of tiles on each side of a tile chunk.
+const uint16_t TILE_CHUNK_LENGTH = 16;
+
+//! \brief A tile drawn on its own, because it couldn't be part of any image batch.
+class UnbatchedTile
+{
+public:
+    //! \brief The tile coordinates in the layer.
+    uint16_t x, y;
+
+    //! \brief The tile image index.
+    int16_t tile_id;
+
+    UnbatchedTile(uint16_t tile_x, uint16_t tile_y, int16_t id):
+        x(tile_x),
+        y(tile_y),
+        tile_id(id)
+    {}
+};
+
+/** \brief A square area of TILE_CHUNK_LENGTH x TILE_CHUNK_LENGTH tiles of a layer.
+*** The chunk still tiles are stored on the GPU using one image batch per texture sheet,
+*** so that a visible chunk only costs a few draw calls.
+**/
+class TileChunk
+{
+public:
+    //! \brief One batch per texture sheet used by the chunk tiles.
+    std::vector<vt_video::ImageBatch *> batches;
+
+    //! \brief The chunk tiles that couldn't be batched.
+    std::vector<UnbatchedTile> unbatched_tiles;
+};
+
+//! \brief An animated tile stored in a dynamic image batch.
+class AnimatedTileQuad
+{
+public:
+    //! \brief The animation displayed by the tile.
+    vt_video::AnimatedImage *animation;
+
+    //! \brief The index of the tile quad in its batch.
+    uint32_t quad_index;
+
+    //! \brief The animation frame currently stored in the batch.
+    uint32_t frame_index;
+};
+
+//! \brief A dynamic image batch containing animated tiles, which texture coordinates follow the animations.
+class AnimatedTileBatch
+{
+public:
+    vt_video::ImageBatch *batch;
+
+    std::vector<AnimatedTileQuad> quads;
+};
+
 class Layer
 {
 public:
     LAYER_TYPE layer_type;
-    // Represents the tile indeces: i.e: tiles[y][x] = tile_id at (x,y)
-    std::vector< std::vector<int16_t> > tiles;
+
+    //! \brief The layer size, in tiles.
+    uint32_t width;
+    uint32_t height;
+
+    //! \brief The tile indeces, row after row: i.e: tiles[y * width + x] = tile_id at (x,y)
+    std::vector<int16_t> tiles;
+
+    //! \brief The layer still tiles: i.e: chunks[y][x] contains the tiles
+    //! from (x * TILE_CHUNK_LENGTH, y * TILE_CHUNK_LENGTH).
+    std::vector< std::vector<TileChunk> > chunks;
+
+    //! \brief The layer animated tiles.
+    std::vector<AnimatedTileBatch> animated_batches;
+
+    //! \brief The animated tiles that couldn't be batched.
+    std::vector<UnbatchedTile> unbatched_animated_tiles;
 
     Layer():
-        layer_type(GROUND_LAYER)
+        layer_type(GROUND_LAYER),
+        width(0),
+        height(0)
     {}
+
+    //! \brief Returns the tile index at (x,y). The position must be within the layer.
+    int16_t GetTile(uint32_t x, uint32_t y) const {
+        return tiles[y * width + x];
+    }
 };
 
 /** ****************************************************************************
@@ -76,11 +158,10 @@ public:
 
     ~TileSupervisor();
 
-    /** \brief Handles all operations on loading tilesets and tile images from the map data file
-    *** \param map_file A reference to the Lua file containing the map data
-    *** \note The map file should already be opened with no Lua tables open
+    /** \brief Handles all operations on loading tilesets and tile images from the map data
+    *** \param map_data The map data, read either from the map data file or its compiled version.
     **/
-    bool Load(vt_script::ReadScriptDescriptor &map_file);
+    bool Load(const MapData& map_data);
 
     //! \brief Updates all animated tile images
     void Update();
@@ -99,6 +180,9 @@ public:
     void DrawLayers(const MapFrame *frame, const LAYER_TYPE &layer_type);
     //@}
 
+    //! \brief Returns an estimate of the memory used by the tile layers and images, in bytes.
+    size_t GetMemorySize() const;
+
 private:
     /** \brief The number of columns of tiles in the map.
     *** This number must be greater than or equal to 32 for the map to be valid.
@@ -121,6 +205,34 @@ private:
     *** _tile_images vector, which contains both still and animated images.
     **/
     std::vector<vt_video::AnimatedImage *> _animated_tile_images;
+
+    /** \brief Stores the tiles of every layer into image batches.
+    *** Still tiles are sent once to the GPU, split into chunks so that only the visible ones are drawn.
+    *** Animated tiles are stored in dynamic batches only updated when their animation frame changes.
+    **/
+    void _BuildTileBatches();
+
+    //! \brief Frees the image batches of every layer.
+    void _ClearTileBatches();
+
+    /** \brief Adds an image to the first batch accepting it, or to a new one.
+    *** \return The batch index, or -1 if the image can't be batched at all.
+    **/
+    static int32_t _AddToBatches(std::vector<vt_video::ImageBatch *>& batches,
+                                 const vt_video::StillImage& image, float x, float y);
+
+    /** \brief Adds an animated tile to the first batch compatible with all of its frames, or to a new one.
+    *** \return The batch index, or -1 if the animation can't be batched at all.
+    **/
+    static int32_t _AddToBatches(std::vector<vt_video::ImageBatch *>& batches,
+                                 const vt_video::AnimatedImage& animation, float x, float y);
+
+    /** \brief Draws a tile image alone.
+    *** \param tile The tile to draw.
+    *** \param origin_x The x screen position of the layer top-left corner.
+    *** \param origin_y The y screen position of the layer top-left corner.
+    **/
+    void _DrawUnbatchedTile(const UnbatchedTile& tile, float origin_x, float origin_y);
 }; // class TileSupervisor
 
 } // namespace private_map
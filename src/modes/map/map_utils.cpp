@@ -59,6 +59,77 @@ uint16_t GetOppositeDirection(const uint16_t direction)
     }
 }
 
+void PathOpenList::Push(std::vector<PathNode>& nodes, uint32_t index)
+{
+    nodes[index].heap_index = _heap.size();
+    _heap.push_back(index);
+    _SiftUp(nodes, _heap.size() - 1);
+}
+
+uint32_t PathOpenList::Pop(std::vector<PathNode>& nodes)
+{
+    uint32_t best_index = _heap.front();
+    nodes[best_index].heap_index = PATH_NODE_CLOSED;
+
+    _heap.front() = _heap.back();
+    _heap.pop_back();
+    if(!_heap.empty()) {
+        nodes[_heap.front()].heap_index = 0;
+        _SiftDown(nodes, 0);
+    }
+
+    return best_index;
+}
+
+void PathOpenList::DecreaseKey(std::vector<PathNode>& nodes, uint32_t index)
+{
+    _SiftUp(nodes, nodes[index].heap_index);
+}
+
+void PathOpenList::_SiftUp(std::vector<PathNode>& nodes, uint32_t position)
+{
+    uint32_t index = _heap[position];
+    while(position > 0) {
+        uint32_t parent_position = (position - 1) / 2;
+        uint32_t parent_index = _heap[parent_position];
+        if(!_IsBetter(nodes[index], nodes[parent_index]))
+            break;
+
+        _heap[position] = parent_index;
+        nodes[parent_index].heap_index = position;
+        position = parent_position;
+    }
+
+    _heap[position] = index;
+    nodes[index].heap_index = position;
+}
+
+void PathOpenList::_SiftDown(std::vector<PathNode>& nodes, uint32_t position)
+{
+    uint32_t index = _heap[position];
+    uint32_t size = _heap.size();
+    while(true) {
+        uint32_t child_position = position * 2 + 1;
+        if(child_position >= size)
+            break;
+
+        // Pick the best of both children.
+        if(child_position + 1 < size && _IsBetter(nodes[_heap[child_position + 1]], nodes[_heap[child_position]]))
+            ++child_position;
+
+        uint32_t child_index = _heap[child_position];
+        if(!_IsBetter(nodes[child_index], nodes[index]))
+            break;
+
+        _heap[position] = child_index;
+        nodes[child_index].heap_index = position;
+        position = child_position;
+    }
+
+    _heap[position] = index;
+    nodes[index].heap_index = position;
+}
+
 } // namespace private_map
 
 } // namespace vt_map
@@ -253,58 +253,93 @@ public:
 /** ****************************************************************************
 *** \brief A container class for node information in pathfinding.
 ***
-*** This class is used in the MapMode#_FindPath function to find an optimal
+*** This class is used in the ObjectSupervisor#FindPath function to find an optimal
 *** path from a given source to a destination. The path finding algorithm
 *** employed is A* and thus many members of this class are particular to the
 *** implementation of that algorithm.
+***
+*** There is one node per collision grid element, allocated once per map.
+*** A node is only meaningful when its generation matches the one of the current
+*** search, which avoids clearing every node before each search.
 *** ***************************************************************************/
 class PathNode
 {
 public:
-    /** \brief The grid coordinates for this node
-    *** These coordinates correspond to the collision grid, where each element
-    *** is a 16x16 pixel space on the map.
-    **/
-    int16_t tile_x, tile_y;
+    //! \brief The path search generation this node was last reached in.
+    uint32_t generation;
 
     //! \name Path Scoring Members
     //@{
     //! \brief The total score for this node (f = g + h).
-    int16_t f_score;
+    uint32_t f_score;
 
     //! \brief The score for this node relative to the source.
-    int16_t g_score;
+    uint32_t g_score;
 
-    //! \brief The Manhattan distance from this node to the destination.
-    int16_t h_score;
+    //! \brief The diagonal distance from this node to the destination.
+    uint32_t h_score;
     //@}
 
-    //! \brief The grid coordinates for the parent of this node
-    int16_t parent_x, parent_y;
+    //! \brief The grid index (y * width + x) of the parent of this node.
+    uint32_t parent;
 
-    // ---------- Methods
+    /** \brief The position of this node in the open list heap,
+    *** or PATH_NODE_CLOSED once the node has been moved to the closed list.
+    **/
+    uint32_t heap_index;
 
-    PathNode() : tile_x(-1), tile_y(-1), f_score(0), g_score(0), h_score(0), parent_x(0), parent_y(0)
+    PathNode() : generation(0), f_score(0), g_score(0), h_score(0), parent(0), heap_index(0)
     {}
+}; // class PathNode
 
-    PathNode(int16_t x_, int16_t y_) : tile_x(x_), tile_y(y_), f_score(0), g_score(0), h_score(0), parent_x(0), parent_y(0)
+//! \brief The heap index of the nodes already moved to the closed list.
+const uint32_t PATH_NODE_CLOSED = 0xFFFFFFFF;
+
+/** ****************************************************************************
+*** \brief The A* open list, kept as a binary min-heap of node indices.
+***
+*** The nodes are ordered by f score, and then by h score so that the nodes
+*** closer to the destination are preferred. Each node stores its position
+*** in the heap, permitting to update its score without searching for it.
+*** ***************************************************************************/
+class PathOpenList
+{
+public:
+    PathOpenList()
     {}
 
-    //! \brief Overloaded comparison operator, only checks that the tile_x and tile_y members are equal
-    bool operator==(const PathNode &that) const {
-        return ((this->tile_x == that.tile_x) && (this->tile_y == that.tile_y));
+    void Clear() {
+        _heap.clear();
     }
 
-    //! \brief Overloaded comparison operator, only checks that the tile_x or tile_y members are unequal
-    bool operator!=(const PathNode &that) const {
-        return ((this->tile_x != that.tile_x) || (this->tile_y != that.tile_y));
+    bool IsEmpty() const {
+        return _heap.empty();
     }
 
-    //! \brief Overloaded comparison operator only used for path finding, compares the two f_scores
-    bool operator<(const PathNode &that) const {
-        return this->f_score > that.f_score;
+    //! \brief Adds the node at the given grid index to the open list.
+    void Push(std::vector<PathNode>& nodes, uint32_t index);
+
+    //! \brief Removes the best node from the open list, marks it as closed and returns its grid index.
+    uint32_t Pop(std::vector<PathNode>& nodes);
+
+    //! \brief Moves back an open node into place after its f score was lowered.
+    void DecreaseKey(std::vector<PathNode>& nodes, uint32_t index);
+
+private:
+    //! \brief The grid indices of the open nodes.
+    std::vector<uint32_t> _heap;
+
+    //! \brief Tells whether the first node should be explored before the second one.
+    static bool _IsBetter(const PathNode& first, const PathNode& second) {
+        if(first.f_score != second.f_score)
+            return first.f_score < second.f_score;
+        return first.h_score < second.h_score;
     }
-}; // class PathNode
+
+    //! \brief Moves the node at the given heap position up or down until the heap is ordered.
+    void _SiftUp(std::vector<PathNode>& nodes, uint32_t position);
+    void _SiftDown(std::vector<PathNode>& nodes, uint32_t position);
+}; // class PathOpenList
 
 typedef std::vector<vt_common::Position2D> Path;
 
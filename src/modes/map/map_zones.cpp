@@ -21,6 +21,8 @@
 
 #include "utils/utils_random.h"
 
+#include <algorithm>
+
 using namespace vt_utils;
 using namespace vt_common;
 
@@ -70,6 +72,9 @@ void MapZone::AddSection(uint16_t left_col, uint16_t right_col, uint16_t top_row
     }
 
     _sections.push_back(Rectangle2D(left_col, right_col, top_row, bottom_row));
+
+    // The walkable cells must be computed again.
+    _walkable_cells.clear();
 }
 
 bool MapZone::IsInsideZone(float pos_x, float pos_y) const
@@ -102,14 +107,113 @@ void MapZone::Draw()
     }
 }
 
-void MapZone::RandomPosition(float& x, float& y)
+void MapZone::RandomPosition(float& x, float& y, MapObject* object)
 {
-    // Select a random ZoneSection
-    uint16_t i = RandomBoundedInteger(0, _sections.size() - 1);
+    // Number of times to try finding a position free of walls
+    const uint32_t WALL_RETRIES = 20;
+
+    bool check_walls = object && (object->GetCollisionMask() & WALL_COLLISION);
+    ObjectSupervisor* object_supervisor = MapMode::CurrentInstance()->GetObjectSupervisor();
+
+    for(uint32_t tries = 0; tries < WALL_RETRIES; ++tries) {
+        // Select a random ZoneSection
+        uint16_t i = RandomBoundedInteger(0, _sections.size() - 1);
+
+        // Select a random x and y position inside that section
+        x = (float)RandomBoundedInteger(_sections[i].left, _sections[i].right);
+        y = (float)RandomBoundedInteger(_sections[i].top, _sections[i].bottom);
 
-    // Select a random x and y position inside that section
-    x = (float)RandomBoundedInteger(_sections[i].left, _sections[i].right);
-    y = (float)RandomBoundedInteger(_sections[i].top, _sections[i].bottom);
+        if(!check_walls || !object_supervisor->IsWallCollision(object, x, y))
+            return;
+    }
+}
+
+bool MapZone::RandomFreePosition(float& x, float& y, MapObject* object)
+{
+    // Number of random cells tested before checking them all
+    const uint32_t RANDOM_TRIES = 4;
+
+    const std::vector<Position2D>& cells = _GetWalkableCells(object);
+    if(cells.empty())
+        return false;
+
+    ObjectSupervisor* object_supervisor = MapMode::CurrentInstance()->GetObjectSupervisor();
+
+    // Most of the time, a random cell is free.
+    for(uint32_t tries = 0; tries < RANDOM_TRIES; ++tries) {
+        const Position2D& cell = cells[RandomBoundedInteger(0, cells.size() - 1)];
+        if(object_supervisor->DetectCollision(object, cell.x, cell.y) == NO_COLLISION) {
+            x = cell.x;
+            y = cell.y;
+            return true;
+        }
+    }
+
+    // Otherwise, check every cell from a random one, so that a free one is always found.
+    const uint32_t start = RandomBoundedInteger(0, cells.size() - 1);
+    for(uint32_t i = 0; i < cells.size(); ++i) {
+        const Position2D& cell = cells[(start + i) % cells.size()];
+        if(object_supervisor->DetectCollision(object, cell.x, cell.y) == NO_COLLISION) {
+            x = cell.x;
+            y = cell.y;
+            return true;
+        }
+    }
+    return false;
+}
+
+const std::vector<Position2D>& MapZone::_GetWalkableCells(MapObject* object)
+{
+    ObjectSupervisor* object_supervisor = MapMode::CurrentInstance()->GetObjectSupervisor();
+    const float coll_half_width = object->GetCollGridHalfWidth();
+    const float coll_height = object->GetCollGridHeight();
+    const bool check_walls = object->GetObjectDrawLayer() != SKY_OBJECT
+                             && (object->GetCollisionMask() & WALL_COLLISION);
+
+    WalkableCells* walkable_cells = nullptr;
+    for(uint32_t i = 0; i < _walkable_cells.size(); ++i) {
+        if(_walkable_cells[i].coll_half_width == coll_half_width
+                && _walkable_cells[i].coll_height == coll_height
+                && _walkable_cells[i].check_walls == check_walls) {
+            walkable_cells = &_walkable_cells[i];
+            break;
+        }
+    }
+
+    if(walkable_cells) {
+        if(walkable_cells->collision_grid_version == object_supervisor->GetCollisionGridVersion())
+            return walkable_cells->cells;
+    }
+    else {
+        _walkable_cells.push_back(WalkableCells());
+        walkable_cells = &_walkable_cells.back();
+        walkable_cells->coll_half_width = coll_half_width;
+        walkable_cells->coll_height = coll_height;
+        walkable_cells->check_walls = check_walls;
+    }
+
+    walkable_cells->collision_grid_version = object_supervisor->GetCollisionGridVersion();
+    std::vector<Position2D>& cells = walkable_cells->cells;
+    cells.clear();
+
+    // The sections may overlap, so the cells are gathered from their bounding box.
+    if(_sections.empty())
+        return cells;
+    Rectangle2D bounds = _sections[0];
+    for(uint32_t i = 1; i < _sections.size(); ++i) {
+        bounds.left = std::min(bounds.left, _sections[i].left);
+        bounds.right = std::max(bounds.right, _sections[i].right);
+        bounds.top = std::min(bounds.top, _sections[i].top);
+        bounds.bottom = std::max(bounds.bottom, _sections[i].bottom);
+    }
+
+    for(float y = bounds.top; y <= bounds.bottom; y += 1.0f) {
+        for(float x = bounds.left; x <= bounds.right; x += 1.0f) {
+            if(IsInsideZone(x, y) && !object_supervisor->IsWallCollision(object, x, y))
+                cells.push_back(Position2D(x, y));
+        }
+    }
+    return cells;
 }
 
 void MapZone::SetInteractionIcon(const std::string& animation_filename)
@@ -340,12 +444,6 @@ void EnemyZone::EnemyDead()
 
 void EnemyZone::Update()
 {
-    // When spawning an enemy in a random zone location, sometimes it is occupied by another
-    // object or that section is unwalkable. We try only a few different spawn locations before
-    // giving up and waiting for the next call to Update(). Otherwise this function could
-    // potentially take a noticable amount of time to complete
-    const int8_t SPAWN_RETRIES = 50;
-
     // Don't update when the zone is disabled.
     if (!_enabled)
         return;
@@ -396,10 +494,6 @@ void EnemyZone::Update()
     // Used to retain random position coordinates in the zone
     float x = 0.0f;
     float y = 0.0f;
-    // Number of times to try finding a valid spawning location
-    int8_t retries = SPAWN_RETRIES;
-    // Holds the result of a collision detection check
-    uint32_t collision = NO_COLLISION;
 
     // Select a random position inside the zone to place the spawning enemy
     _enemies[index]->SetCollisionMask(WALL_COLLISION | CHARACTER_COLLISION);
@@ -409,18 +503,10 @@ void EnemyZone::Update()
     } else {
         spawning_zone = _spawn_zone;
     }
-    // If there is a collision, retry a different location
-    do {
-        spawning_zone->RandomPosition(x, y);
+
+    // Spawn the enemy where nothing is in the way, and reset the spawn timer
+    if (spawning_zone->RandomFreePosition(x, y, _enemies[index])) {
         _enemies[index]->SetPosition(x, y);
-        collision = MapMode::CurrentInstance()->GetObjectSupervisor()->DetectCollision(_enemies[index],
-                    _enemies[index]->GetXPosition(),
-                    _enemies[index]->GetYPosition(),
-                    nullptr);
-    } while (collision != NO_COLLISION && --retries > 0);
-
-    // Otherwise, spawn the enemy and reset the spawn timer
-    if (collision == NO_COLLISION) {
         // Set the correct timer duration to whether do a quick first spawn,
         // or a longer standard spawn time from the second time.
         _dead_timer.Reset();
@@ -430,8 +516,8 @@ void EnemyZone::Update()
         _enemies[index]->ChangeStateSpawning();
         ++_active_enemies;
     } else {
-        PRINT_WARNING << "Couldn't spawn a monster within " << SPAWN_RETRIES
-                      << " tries. Check the enemy zones of map script:"
+        PRINT_WARNING << "Couldn't find a free position to spawn a monster."
+                      << " Check the enemy zones of map script:"
                       << MapMode::CurrentInstance()->GetMapScriptFilename() << std::endl;
     }
 } // void EnemyZone::Update()
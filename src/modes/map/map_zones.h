@@ -95,8 +95,18 @@ public:
     /** \brief Returns random x, y position coordinates within the zone
     *** \param x A reference where to store the value of the x position
     *** \param y A reference where to store the value of the y position
+    *** \param object When given with the wall collision mask, positions where
+    *** the object would stand on walls are avoided as much as possible.
     **/
-    void RandomPosition(float &x, float &y);
+    void RandomPosition(float &x, float &y, MapObject* object = nullptr);
+
+    /** \brief Returns random x, y position coordinates within the zone where the object
+    *** doesn't collide with anything.
+    *** The grid elements where the object would be free of walls are computed once
+    *** for each collision size, so that only the other map objects are tested here.
+    *** \return false when no such position currently exists.
+    **/
+    bool RandomFreePosition(float &x, float &y, MapObject* object);
 
     //! \brief Loads the current animation file as the new interaction icon of the object.
     void SetInteractionIcon(const std::string& animation_filename);
@@ -115,6 +125,34 @@ protected:
     bool _ShouldDraw(const vt_common::Rectangle2D& section);
 
 private:
+    //! \brief The grid elements of the zone where a collision size is free of walls.
+    class WalkableCells
+    {
+    public:
+        WalkableCells() :
+            coll_half_width(0.0f),
+            coll_height(0.0f),
+            check_walls(false),
+            collision_grid_version(0)
+        {}
+
+        //! \brief The collision size and whether walls are taken into account.
+        float coll_half_width;
+        float coll_height;
+        bool check_walls;
+
+        //! \brief The collision grid version the cells were computed with.
+        uint32_t collision_grid_version;
+
+        std::vector<vt_common::Position2D> cells;
+    };
+
+    //! \brief The walkable cells computed so far, one entry per collision size.
+    std::vector<WalkableCells> _walkable_cells;
+
+    //! \brief Returns the walkable cells for the object collision size, computing them when needed.
+    const std::vector<vt_common::Position2D>& _GetWalkableCells(MapObject* object);
+
     //
     // The copy constructor and assignment operator are hidden by design
     // to cause compilation errors when attempting to copy or assign this class.
@@ -101,6 +101,8 @@ void BindModeCode()
             .def("SetRunningEnabled", &MapMode::SetRunningEnabled)
 
             .def("DeleteMapObject", &MapMode::DeleteMapObject)
+            .def("SetMapCollision", &MapMode::SetMapCollision)
+            .def("SetHierarchicalPathDistance", &MapMode::SetHierarchicalPathDistance)
 
             .def("SetCamera", (void(MapMode:: *)(private_map::VirtualSprite *))&MapMode::SetCamera)
             .def("SetCamera", (void(MapMode:: *)(private_map::VirtualSprite *, uint32_t))&MapMode::SetCamera)
@@ -221,6 +223,7 @@ void BindModeCode()
             .def("SetVisible", &MapObject::SetVisible)
             .def("SetCollisionMask", &MapObject::SetCollisionMask)
             .def("SetDrawOnSecondPass", &MapObject::SetDrawOnSecondPass)
+            .def("SetDormantUpdateAllowed", &MapObject::SetDormantUpdateAllowed)
             .def("GetObjectID", &MapObject::GetObjectID)
             .def("GetXPosition", &MapObject::GetXPosition)
             .def("GetYPosition", &MapObject::GetYPosition)
@@ -232,6 +235,7 @@ void BindModeCode()
             .def("IsVisible", &MapObject::IsVisible)
             .def("GetCollisionMask", &MapObject::GetCollisionMask)
             .def("IsDrawOnSecondPass", &MapObject::IsDrawOnSecondPass)
+            .def("IsDormantUpdateAllowed", &MapObject::IsDormantUpdateAllowed)
             .def("Emote", &MapObject::Emote)
             .def("SetGrayscale", &MapObject::SetGrayscale)
             .def("IsGrayscale", &MapObject::IsGrayscale)
@@ -511,20 +515,27 @@ void BindModeCode()
             .def("StartEvent", (void(EventSupervisor:: *)(const std::string &, uint32_t))&EventSupervisor::StartEvent)
             .def("StartEvent", (void(EventSupervisor:: *)(MapEvent *))&EventSupervisor::StartEvent)
             .def("StartEvent", (void(EventSupervisor:: *)(MapEvent *, uint32_t))&EventSupervisor::StartEvent)
+            .def("StartEventByHandle", (void(EventSupervisor:: *)(uint32_t))&EventSupervisor::StartEventByHandle)
+            .def("StartEventByHandle", (void(EventSupervisor:: *)(uint32_t, uint32_t))&EventSupervisor::StartEventByHandle)
             .def("EndEvent", (void(EventSupervisor:: *)(const std::string &, bool))&EventSupervisor::EndEvent)
             .def("EndEvent", (void(EventSupervisor:: *)(MapEvent *, bool))&EventSupervisor::EndEvent)
             .def("EndAllEvents", &EventSupervisor::EndAllEvents)
-            .def("IsEventActive", &EventSupervisor::IsEventActive)
+            .def("IsEventActive", (bool(EventSupervisor:: *)(const std::string &) const)&EventSupervisor::IsEventActive)
+            .def("IsEventActive", (bool(EventSupervisor:: *)(const MapEvent *) const)&EventSupervisor::IsEventActive)
+            .def("IsEventActiveByHandle", &EventSupervisor::IsEventActiveByHandle)
             .def("HasActiveEvent", &EventSupervisor::HasActiveEvent)
             .def("HasActiveDelayedEvent", &EventSupervisor::HasActiveDelayedEvent)
             .def("GetEvent", &EventSupervisor::GetEvent)
             .def("DoesEventExist", &EventSupervisor::DoesEventExist)
+            .def("GetEventHandle", &EventSupervisor::GetEventHandle)
+            .def("GetEventByHandle", &EventSupervisor::GetEventByHandle)
         ];
 
         luabind::module(vt_script::ScriptManager->GetGlobalState(), "vt_map")
         [
             luabind::class_<MapEvent>("MapEvent")
             .def("GetEventID", &MapEvent::GetEventID)
+            .def("GetEventHandle", &MapEvent::GetEventHandle)
             .def("AddEventLinkAtStart", (void(MapEvent:: *)(const std::string &))&MapEvent::AddEventLinkAtStart)
             .def("AddEventLinkAtStart", (void(MapEvent:: *)(const std::string &, uint32_t))&MapEvent::AddEventLinkAtStart)
             .def("AddEventLinkAtEnd", (void(MapEvent:: *)(const std::string &))&MapEvent::AddEventLinkAtEnd)
@@ -0,0 +1,123 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2016 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See https://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    image_kernels_benchmark.cpp
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Times the image pixel conversion kernels against plain loops
+***
+*** Usage: image_kernels_benchmark [iterations]
+*** Each conversion is run on a 1024x1024 image, the given number of times.
+*** ***************************************************************************/
+
+#include "engine/video/image_kernels.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace vt_video::private_video;
+
+//! \brief The benchmarked image size, in pixels.
+const size_t BENCHMARK_IMAGE_LENGTH = 1024;
+
+//! \brief The plain ARGB row conversion the kernel is compared to.
+static void ScalarConvertARGBRow(const uint8_t *src, uint8_t *dst, size_t num_pixels, bool swap_red_blue)
+{
+    for(size_t i = 0; i < num_pixels; ++i) {
+        const uint8_t *src_pixel = src + i * 4;
+        uint8_t *dst_pixel = dst + i * 4;
+        if(src_pixel[3] == 0) {
+            dst_pixel[0] = dst_pixel[1] = dst_pixel[2] = dst_pixel[3] = 0;
+            continue;
+        }
+
+        dst_pixel[0] = src_pixel[swap_red_blue ? 2 : 0];
+        dst_pixel[1] = src_pixel[1];
+        dst_pixel[2] = src_pixel[swap_red_blue ? 0 : 2];
+        dst_pixel[3] = src_pixel[3];
+    }
+}
+
+//! \brief The plain grayscale conversion the kernel is compared to.
+static void ScalarConvertPixelsToGrayscale(uint8_t *pixels, size_t num_pixels, uint32_t bytes_per_pixel)
+{
+    for(size_t i = 0; i < num_pixels; ++i) {
+        uint8_t *pixel = pixels + i * bytes_per_pixel;
+        uint32_t sum = (30 * pixel[0]) + (59 * pixel[1]) + (11 * pixel[2]);
+        uint8_t value = static_cast<uint8_t>(sum * 0.01f);
+        pixel[0] = pixel[1] = pixel[2] = value;
+    }
+}
+
+//! \brief Returns the elapsed time since the given start, in milliseconds.
+static double GetElapsedTime(const std::chrono::steady_clock::time_point& start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t iterations = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 50;
+    if(iterations == 0)
+        iterations = 1;
+
+    std::vector<uint8_t> src(BENCHMARK_IMAGE_LENGTH * BENCHMARK_IMAGE_LENGTH * 4);
+    for(size_t i = 0; i < src.size(); ++i)
+        src[i] = static_cast<uint8_t>(rand() & 0xFF);
+    std::vector<uint8_t> dst(src.size());
+
+    std::cout << "Image kernels: " << GetImageKernelsName() << ", "
+              << BENCHMARK_IMAGE_LENGTH << "x" << BENCHMARK_IMAGE_LENGTH << " pixels, "
+              << iterations << " iterations" << std::endl;
+
+    // The ARGB conversion is done row by row, as when loading images.
+    const size_t row_size = BENCHMARK_IMAGE_LENGTH * 4;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(uint32_t i = 0; i < iterations; ++i) {
+        for(size_t y = 0; y < BENCHMARK_IMAGE_LENGTH; ++y)
+            ScalarConvertARGBRow(&src[y * row_size], &dst[y * row_size], BENCHMARK_IMAGE_LENGTH, true);
+    }
+    double scalar_time = GetElapsedTime(start);
+
+    start = std::chrono::steady_clock::now();
+    for(uint32_t i = 0; i < iterations; ++i) {
+        for(size_t y = 0; y < BENCHMARK_IMAGE_LENGTH; ++y)
+            ConvertARGBRow(&src[y * row_size], &dst[y * row_size], BENCHMARK_IMAGE_LENGTH, true);
+    }
+    double kernel_time = GetElapsedTime(start);
+
+    std::cout << "ARGB rows: scalar " << scalar_time / iterations << " ms, kernel "
+              << kernel_time / iterations << " ms" << std::endl;
+
+    // Start each iteration from the same colored pixels.
+    for(uint32_t bytes_per_pixel = 3; bytes_per_pixel <= 4; ++bytes_per_pixel) {
+        const size_t num_pixels = BENCHMARK_IMAGE_LENGTH * BENCHMARK_IMAGE_LENGTH;
+        scalar_time = 0.0;
+        kernel_time = 0.0;
+        for(uint32_t i = 0; i < iterations; ++i) {
+            dst = src;
+            start = std::chrono::steady_clock::now();
+            ScalarConvertPixelsToGrayscale(&dst[0], num_pixels, bytes_per_pixel);
+            scalar_time += GetElapsedTime(start);
+
+            dst = src;
+            start = std::chrono::steady_clock::now();
+            ConvertPixelsToGrayscale(&dst[0], num_pixels, bytes_per_pixel);
+            kernel_time += GetElapsedTime(start);
+        }
+
+        std::cout << "Grayscale, " << bytes_per_pixel << " bytes per pixel: scalar "
+                  << scalar_time / iterations << " ms, kernel " << kernel_time / iterations
+                  << " ms" << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
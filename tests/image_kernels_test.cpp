@@ -0,0 +1,147 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2016 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See https://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    image_kernels_test.cpp
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Checks the image pixel conversion kernels against plain loops
+***
+*** The rows are filled with random pixels, with every length up to a few
+*** vector widths and unaligned starts, so that the vector loops and their
+*** scalar tails are both exercised.
+*** ***************************************************************************/
+
+#include "engine/video/image_kernels.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace vt_video::private_video;
+
+//! \brief The reference ARGB row conversion, one pixel at a time.
+static void ReferenceConvertARGBRow(const uint8_t *src, uint8_t *dst, size_t num_pixels, bool swap_red_blue)
+{
+    for(size_t i = 0; i < num_pixels; ++i) {
+        const uint8_t *src_pixel = src + i * 4;
+        uint8_t *dst_pixel = dst + i * 4;
+        if(src_pixel[3] == 0) {
+            dst_pixel[0] = dst_pixel[1] = dst_pixel[2] = dst_pixel[3] = 0;
+            continue;
+        }
+
+        dst_pixel[0] = src_pixel[swap_red_blue ? 2 : 0];
+        dst_pixel[1] = src_pixel[1];
+        dst_pixel[2] = src_pixel[swap_red_blue ? 0 : 2];
+        dst_pixel[3] = src_pixel[3];
+    }
+}
+
+//! \brief The reference grayscale conversion, one pixel at a time, scaling the sum as a float.
+static void ReferenceConvertPixelsToGrayscale(uint8_t *pixels, size_t num_pixels, uint32_t bytes_per_pixel)
+{
+    for(size_t i = 0; i < num_pixels; ++i) {
+        uint8_t *pixel = pixels + i * bytes_per_pixel;
+        uint32_t sum = (30 * pixel[0]) + (59 * pixel[1]) + (11 * pixel[2]);
+        uint8_t value = static_cast<uint8_t>(sum * 0.01f);
+        pixel[0] = pixel[1] = pixel[2] = value;
+    }
+}
+
+//! \brief Fills the pixels with random values, a quarter of them being fully transparent.
+static void FillRandomPixels(std::vector<uint8_t>& pixels, uint32_t bytes_per_pixel)
+{
+    for(size_t i = 0; i < pixels.size(); ++i)
+        pixels[i] = static_cast<uint8_t>(rand() & 0xFF);
+
+    if(bytes_per_pixel == 4) {
+        for(size_t i = 3; i < pixels.size(); i += 4) {
+            if(rand() % 4 == 0)
+                pixels[i] = 0;
+        }
+    }
+}
+
+static bool TestConvertARGBRow()
+{
+    // The extra byte lets the rows start at an unaligned address.
+    for(size_t num_pixels = 0; num_pixels <= 67; ++num_pixels) {
+        for(uint32_t offset = 0; offset < 2; ++offset) {
+            for(uint32_t swap = 0; swap < 2; ++swap) {
+                std::vector<uint8_t> src(num_pixels * 4 + 1);
+                FillRandomPixels(src, 4);
+                std::vector<uint8_t> expected(num_pixels * 4 + 1, 0xCD);
+                std::vector<uint8_t> result(num_pixels * 4 + 1, 0xCD);
+
+                ReferenceConvertARGBRow(&src[offset], &expected[offset], num_pixels, swap != 0);
+                ConvertARGBRow(&src[offset], &result[offset], num_pixels, swap != 0);
+
+                if(result != expected) {
+                    std::cerr << "ConvertARGBRow() differs for " << num_pixels << " pixels, offset "
+                              << offset << ", swap " << swap << std::endl;
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+static bool TestConvertPixelsToGrayscale()
+{
+    for(uint32_t bytes_per_pixel = 3; bytes_per_pixel <= 4; ++bytes_per_pixel) {
+        for(size_t num_pixels = 0; num_pixels <= 67; ++num_pixels) {
+            for(uint32_t offset = 0; offset < 2; ++offset) {
+                std::vector<uint8_t> expected(num_pixels * bytes_per_pixel + 1);
+                FillRandomPixels(expected, bytes_per_pixel);
+                std::vector<uint8_t> result = expected;
+
+                ReferenceConvertPixelsToGrayscale(&expected[offset], num_pixels, bytes_per_pixel);
+                ConvertPixelsToGrayscale(&result[offset], num_pixels, bytes_per_pixel);
+
+                if(result != expected) {
+                    std::cerr << "ConvertPixelsToGrayscale() differs for " << num_pixels << " pixels of "
+                              << bytes_per_pixel << " bytes, offset " << offset << std::endl;
+                    return false;
+                }
+            }
+        }
+    }
+
+    // Every possible channel sum, where the integer division must match the float one.
+    std::vector<uint8_t> expected(256 * 256 * 4);
+    for(uint32_t i = 0; i < 256 * 256; ++i) {
+        expected[i * 4] = static_cast<uint8_t>(i & 0xFF);
+        expected[i * 4 + 1] = static_cast<uint8_t>(i >> 8);
+        expected[i * 4 + 2] = static_cast<uint8_t>((i * 7) & 0xFF);
+        expected[i * 4 + 3] = 0xFF;
+    }
+    std::vector<uint8_t> result = expected;
+    ReferenceConvertPixelsToGrayscale(&expected[0], 256 * 256, 4);
+    ConvertPixelsToGrayscale(&result[0], 256 * 256, 4);
+    if(result != expected) {
+        std::cerr << "ConvertPixelsToGrayscale() differs on the channel combinations" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+int main()
+{
+    srand(1);
+
+    std::cout << "Testing the " << GetImageKernelsName() << " image kernels" << std::endl;
+
+    bool succeeded = TestConvertARGBRow();
+    succeeded = TestConvertPixelsToGrayscale() && succeeded;
+
+    std::cout << (succeeded ? "Passed" : "Failed") << std::endl;
+    return succeeded ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,39 @@
+#!/bin/sh
+
+# Compiles every map data file found in the given directories (data/story by
+# default), so that the game doesn't have to parse them when loading maps.
+# The compiled files are written next to the map data files, and are ignored
+# by the game as soon as the corresponding map data file changes.
+#
+# Usage: tools/compile-maps.sh [game binary] [directories...]
+# Run it from the game data root directory.
+
+EXIT_FAILURE=1
+game=${1:-./valyriatear}
+
+if test ! -x "$game"
+then
+    >&2 echo "$game is not an executable file!"
+    exit $EXIT_FAILURE
+fi
+
+if test $# -gt 0
+then
+    shift
+fi
+
+if test $# -eq 0
+then
+    set -- data/story
+fi
+
+files=$(find "$@" -name '*_map.lua' | sort)
+
+if test -z "$files"
+then
+    >&2 echo "No map data file found."
+    exit $EXIT_FAILURE
+fi
+
+# The map data filenames don't contain spaces.
+"$game" --compile-maps $files